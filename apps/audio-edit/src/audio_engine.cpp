@@ -0,0 +1,314 @@
+#include "audio_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include "../../shared/utils/include/metrics.h"
+
+namespace xeno::audio {
+
+namespace {
+
+constexpr int64_t kFeedBlockFrames = 4096;     // Frames per read on the feeder thread
+constexpr int64_t kExportBlockFrames = 65536;  // Frames per read/write when exporting
+constexpr double kRingSeconds = 0.5;           // Audio buffered ahead of the callback
+
+// Looked up at startup so the callback never takes the registry's lock. Spans are not used
+// there: traced spans go through a mutex.
+utils::Histogram& render_latency = utils::Metrics::getInstance().histogram("audio.render");
+utils::Counter& xruns = utils::Metrics::getInstance().counter("audio.xruns");          // Reported by the device
+utils::Counter& underruns = utils::Metrics::getInstance().counter("audio.underruns");  // Ring ran dry mid-file
+
+} // namespace
+
+AudioEngine::AudioEngine() {
+    PaError result = Pa_Initialize();
+    portaudio_ready = result == paNoError;
+    if (!portaudio_ready) {
+        error_message = Pa_GetErrorText(result);
+    }
+}
+
+AudioEngine::~AudioEngine() {
+    close();
+    if (portaudio_ready) {
+        Pa_Terminate();
+    }
+}
+
+bool AudioEngine::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        error_message = file.lastError();
+        return false;
+    }
+    file_path = path;
+    
+    size_t ring_frames = std::max<size_t>(kFeedBlockFrames * 4, static_cast<size_t>(sampleRate() * kRingSeconds));
+    ring = std::make_unique<utils::SpscRingBuffer<float>>(ring_frames * channels());
+    // Files with more channels than the chain supports still play, just without effects
+    effects.prepare(sampleRate(), channels());
+    
+    // A missing output device only disables playback; the file can still be exported
+    if (portaudio_ready) {
+        PaError result = Pa_OpenDefaultStream(&stream, 0, channels(), paFloat32, sampleRate(),
+                                              paFramesPerBufferUnspecified, &AudioEngine::streamCallback, this);
+        if (result != paNoError) {
+            stream = nullptr;
+            error_message = Pa_GetErrorText(result);
+        }
+    }
+    return true;
+}
+
+void AudioEngine::close() {
+    stopStream();
+    if (stream) {
+        Pa_CloseStream(stream);
+        stream = nullptr;
+    }
+    file.close();
+    file_path.clear();
+    ring.reset();
+    played_frames = 0;
+    finished = false;
+}
+
+double AudioEngine::duration() const {
+    return sampleRate() > 0 ? static_cast<double>(frames()) / sampleRate() : 0.0;
+}
+
+bool AudioEngine::play() {
+    if (!file.isOpen()) {
+        error_message = "No audio loaded";
+        return false;
+    }
+    if (!stream) {
+        error_message = "No audio output device available";
+        return false;
+    }
+    if (isPlaying()) {
+        return true;
+    }
+    
+    // A stream that completed on its own still has to be stopped before restarting
+    stopStream();
+    int64_t start = played_frames.load();
+    if (start >= frames()) {
+        start = 0;
+    }
+    if (!file.seek(start)) {
+        error_message = file.lastError();
+        return false;
+    }
+    
+    ring->reset();
+    effects.reset();
+    source_drained = false;
+    finished = false;
+    played_frames = start;
+    
+    // Prefill so the first callbacks do not underrun
+    std::vector<float> block(kFeedBlockFrames * channels());
+    while (feedBlock(block.data())) {
+    }
+    
+    feeding = true;
+    feeder = std::thread(&AudioEngine::feed, this);
+    
+    PaError result = Pa_StartStream(stream);
+    if (result != paNoError) {
+        error_message = Pa_GetErrorText(result);
+        stopStream();
+        return false;
+    }
+    return true;
+}
+
+void AudioEngine::pause() {
+    // Frames still in the device buffers are discarded, so resume from what was heard
+    int64_t audible = static_cast<int64_t>(position() * sampleRate());
+    stopStream();
+    played_frames = audible;
+}
+
+void AudioEngine::stop() {
+    stopStream();
+    played_frames = 0;
+    finished = false;
+}
+
+bool AudioEngine::seek(double seconds) {
+    if (!file.isOpen()) {
+        return false;
+    }
+    
+    int64_t frame = std::clamp<int64_t>(static_cast<int64_t>(seconds * sampleRate()), 0, frames());
+    bool was_playing = isPlaying();
+    stopStream();
+    played_frames = frame;
+    finished = false;
+    return was_playing ? play() : true;
+}
+
+bool AudioEngine::isPlaying() const {
+    return stream && !finished.load(std::memory_order_acquire) && Pa_IsStreamActive(stream) == 1;
+}
+
+double AudioEngine::position() const {
+    if (sampleRate() <= 0) {
+        return 0.0;
+    }
+    
+    double seconds = static_cast<double>(played_frames.load(std::memory_order_acquire)) / sampleRate();
+    if (isPlaying()) {
+        seconds -= static_cast<double>(effects.latency()) / sampleRate();
+        if (const PaStreamInfo* info = Pa_GetStreamInfo(stream)) {
+            seconds -= info->outputLatency;
+        }
+    }
+    return std::clamp(seconds, 0.0, duration());
+}
+
+bool AudioEngine::exportTo(const std::string& destination, const dsp::EffectSettings& settings,
+                           const ExportProgress& progress, std::string& error) const {
+    if (file_path.empty()) {
+        error = "No audio loaded";
+        return false;
+    }
+    
+    std::error_code ignored;
+    if (std::filesystem::equivalent(file_path, destination, ignored)) {
+        error = "Cannot export over the file being edited";
+        return false;
+    }
+    
+    AudioFile source;
+    if (!source.open(file_path)) {
+        error = source.lastError();
+        return false;
+    }
+    AudioFile output;
+    if (!output.create(destination, source.sampleRate(), source.channels())) {
+        error = output.lastError();
+        return false;
+    }
+    
+    dsp::EffectChain chain;
+    chain.apply(settings);
+    bool processed = chain.prepare(source.sampleRate(), source.channels());
+    size_t channel_count = static_cast<size_t>(source.channels());
+    // The chain's delay is trimmed from the start and flushed out with silence at the end
+    int64_t skip = processed ? static_cast<int64_t>(chain.latency()) : 0;
+    int64_t flush = skip;
+    
+    std::vector<float> block(kExportBlockFrames * channel_count);
+    int64_t written = 0;
+    bool cancelled = false;
+    while (true) {
+        int64_t count = source.read(block.data(), kExportBlockFrames);
+        if (count < kExportBlockFrames && flush > 0) {
+            int64_t padding = std::min(flush, kExportBlockFrames - count);
+            std::fill(block.begin() + count * channel_count, block.begin() + (count + padding) * channel_count, 0.0f);
+            count += padding;
+            flush -= padding;
+        }
+        if (count == 0) {
+            break;
+        }
+        
+        chain.processInterleaved(block.data(), static_cast<size_t>(count));
+        int64_t dropped = std::min(skip, count);
+        skip -= dropped;
+        int64_t kept = count - dropped;
+        if (kept > 0 && output.write(block.data() + dropped * channel_count, kept) != kept) {
+            error = "Failed to write " + destination;
+            break;
+        }
+        written += kept;
+        double fraction = source.frames() > 0 ? std::min(1.0, static_cast<double>(written) / source.frames()) : 1.0;
+        if (progress && !progress(fraction)) {
+            cancelled = true;
+            error = "Export cancelled";
+            break;
+        }
+    }
+    output.close();
+    
+    if (cancelled || !error.empty()) {
+        std::filesystem::remove(destination, ignored);
+        return false;
+    }
+    return true;
+}
+
+int AudioEngine::streamCallback(const void*, void* output, unsigned long frame_count,
+                                const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags flags, void* user_data) {
+    if (flags & paOutputUnderflow) {
+        xruns.add();
+    }
+    return static_cast<AudioEngine*>(user_data)->render(static_cast<float*>(output), frame_count);
+}
+
+int AudioEngine::render(float* output, unsigned long frame_count) {
+    // Real-time thread: no allocation, locking or I/O below this point
+    auto started = std::chrono::steady_clock::now();
+    size_t channel_count = static_cast<size_t>(channels());
+    size_t wanted = frame_count * channel_count;
+    size_t copied = ring->read(output, wanted);
+    std::fill(output + copied, output + wanted, 0.0f);
+    effects.processInterleaved(output, frame_count);
+    played_frames.fetch_add(static_cast<int64_t>(copied / channel_count), std::memory_order_release);
+    render_latency.record(std::chrono::steady_clock::now() - started);
+    
+    if (copied < wanted) {
+        if (source_drained.load(std::memory_order_acquire) && ring->readAvailable() == 0) {
+            finished.store(true, std::memory_order_release);
+            return paComplete;
+        }
+        underruns.add();
+    }
+    return paContinue;
+}
+
+bool AudioEngine::feedBlock(float* block) {
+    size_t channel_count = static_cast<size_t>(channels());
+    if (source_drained.load(std::memory_order_relaxed) ||
+        ring->writeAvailable() < static_cast<size_t>(kFeedBlockFrames) * channel_count) {
+        return false;
+    }
+    
+    int64_t count = file.read(block, kFeedBlockFrames);
+    if (count <= 0) {
+        source_drained.store(true, std::memory_order_release);
+        return false;
+    }
+    ring->write(block, static_cast<size_t>(count) * channel_count);
+    return true;
+}
+
+void AudioEngine::feed() {
+    std::vector<float> block(kFeedBlockFrames * channels());
+    while (feeding.load(std::memory_order_acquire)) {
+        if (!feedBlock(block.data())) {
+            if (source_drained.load(std::memory_order_relaxed)) {
+                return;
+            }
+            // Ring is full; it holds far more audio than one wait
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+void AudioEngine::stopStream() {
+    if (stream && Pa_IsStreamStopped(stream) == 0) {
+        Pa_AbortStream(stream);
+    }
+    feeding = false;
+    if (feeder.joinable()) {
+        feeder.join();
+    }
+}
+
+} // namespace xeno::audio
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "audio_file.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <portaudio.h>
+
+#include "../../shared/audio-dsp/include/audio_dsp.h"
+#include "../../shared/utils/include/spsc_ring_buffer.h"
+
+namespace xeno::audio {
+
+/**
+ * @brief Streaming playback and export for one audio file
+ *
+ * A feeder thread reads the file in blocks into a lock-free ring buffer, and
+ * the PortAudio callback only copies out of that ring, so the callback never
+ * allocates, locks or touches the disk. position() is the audio clock: the
+ * frames the callback has handed to the device, less the output latency.
+ * The callback runs the effect chain on each buffer after copying it out.
+ *
+ * All methods except the callback are meant for the UI thread; exportTo()
+ * uses its own file handle and may run on any thread during playback.
+ */
+class AudioEngine {
+public:
+    // Receives the fraction done; returning false cancels the export
+    using ExportProgress = std::function<bool(double fraction)>;
+    
+    AudioEngine();
+    ~AudioEngine();
+    
+    AudioEngine(const AudioEngine&) = delete;
+    AudioEngine& operator=(const AudioEngine&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& path() const { return file_path; }
+    int sampleRate() const { return file.sampleRate(); }
+    int channels() const { return file.channels(); }
+    int64_t frames() const { return file.frames(); }
+    double duration() const;
+    const std::string& lastError() const { return error_message; }
+    
+    bool play();
+    void pause();
+    // Pauses and rewinds to the start
+    void stop();
+    bool seek(double seconds);
+    
+    // False once playback reaches the end of the file
+    bool isPlaying() const;
+    // Seconds into the file that are audible right now
+    double position() const;
+    
+    // Safe to call during playback; the callback picks new settings up on its next buffer
+    void setEffects(const dsp::EffectSettings& settings) { effects.apply(settings); }
+    dsp::EffectSettings effectSettings() const { return effects.settings(); }
+    
+    // Streams the file through a fresh effect chain to destination in blocks
+    bool exportTo(const std::string& destination, const dsp::EffectSettings& settings,
+                  const ExportProgress& progress, std::string& error) const;
+
+private:
+    static int streamCallback(const void* input, void* output, unsigned long frame_count,
+                              const PaStreamCallbackTimeInfo* time_info, PaStreamCallbackFlags status_flags,
+                              void* user_data);
+    int render(float* output, unsigned long frame_count);
+    // Moves one block from the file into the ring; false at the end of the file or when the ring is full
+    bool feedBlock(float* block);
+    void feed();
+    void stopStream();
+    
+    AudioFile file; // Read only by the feeder thread while playing
+    std::string file_path;
+    std::string error_message;
+    bool portaudio_ready = false;
+    PaStream* stream = nullptr;
+    
+    std::unique_ptr<utils::SpscRingBuffer<float>> ring;
+    dsp::EffectChain effects; // Processed only by the callback while playing
+    std::thread feeder;
+    std::atomic<bool> feeding{false};
+    std::atomic<bool> source_drained{false}; // Feeder reached the end of the file
+    std::atomic<bool> finished{false};       // Callback played everything
+    std::atomic<int64_t> played_frames{0};   // Next frame the callback will hand out
+};
+
+} // namespace xeno::audio
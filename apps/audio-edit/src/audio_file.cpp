@@ -0,0 +1,90 @@
+#include "audio_file.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace xeno::audio {
+
+namespace {
+
+int formatForPath(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    
+    if (extension == ".flac") {
+        return SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+    }
+    if (extension == ".ogg") {
+        return SF_FORMAT_OGG | SF_FORMAT_VORBIS;
+    }
+    if (extension == ".wav") {
+        return SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+    }
+    return 0;
+}
+
+} // namespace
+
+AudioFile::~AudioFile() {
+    close();
+}
+
+bool AudioFile::open(const std::string& path) {
+    close();
+    info = SF_INFO{};
+    file = sf_open(path.c_str(), SFM_READ, &info);
+    if (!file) {
+        error_message = sf_strerror(nullptr);
+        return false;
+    }
+    error_message.clear();
+    return true;
+}
+
+bool AudioFile::create(const std::string& path, int sample_rate, int channels) {
+    close();
+    info = SF_INFO{};
+    info.samplerate = sample_rate;
+    info.channels = channels;
+    info.format = formatForPath(path);
+    if (info.format == 0 || !sf_format_check(&info)) {
+        error_message = "Unsupported output format: " + path;
+        return false;
+    }
+    
+    file = sf_open(path.c_str(), SFM_WRITE, &info);
+    if (!file) {
+        error_message = sf_strerror(nullptr);
+        return false;
+    }
+    // Float input outside [-1, 1] is clipped instead of wrapping around in integer formats
+    sf_command(file, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+    error_message.clear();
+    return true;
+}
+
+void AudioFile::close() {
+    if (file) {
+        sf_close(file);
+        file = nullptr;
+    }
+}
+
+bool AudioFile::seek(int64_t frame) {
+    if (!file || sf_seek(file, frame, SEEK_SET) < 0) {
+        error_message = file ? sf_strerror(file) : "No file open";
+        return false;
+    }
+    return true;
+}
+
+int64_t AudioFile::read(float* interleaved, int64_t count) {
+    return file ? sf_readf_float(file, interleaved, count) : 0;
+}
+
+int64_t AudioFile::write(const float* interleaved, int64_t count) {
+    return file ? sf_writef_float(file, interleaved, count) : 0;
+}
+
+} // namespace xeno::audio
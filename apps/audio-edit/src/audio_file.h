@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sndfile.h>
+
+namespace xeno::audio {
+
+/**
+ * @brief Chunked access to an audio file through libsndfile
+ *
+ * Samples are read or written as interleaved floats, a block at a time, so
+ * files of any length are streamed rather than loaded. One instance must
+ * only be used from one thread at a time; open a second instance to read
+ * the same file elsewhere.
+ */
+class AudioFile {
+public:
+    AudioFile() = default;
+    ~AudioFile();
+    
+    AudioFile(const AudioFile&) = delete;
+    AudioFile& operator=(const AudioFile&) = delete;
+    
+    bool open(const std::string& path);
+    // Creates a file for writing; the container is chosen from the extension (.wav, .flac, .ogg)
+    bool create(const std::string& path, int sample_rate, int channels);
+    void close();
+    
+    bool isOpen() const { return file != nullptr; }
+    int channels() const { return info.channels; }
+    int sampleRate() const { return info.samplerate; }
+    int64_t frames() const { return info.frames; }
+    const std::string& lastError() const { return error_message; }
+    
+    bool seek(int64_t frame);
+    // Reads up to count frames from the current position; returns the frames read, 0 at the end
+    int64_t read(float* interleaved, int64_t count);
+    // Returns the frames written
+    int64_t write(const float* interleaved, int64_t count);
+
+private:
+    SNDFILE* file = nullptr;
+    SF_INFO info{};
+    std::string error_message;
+};
+
+} // namespace xeno::audio
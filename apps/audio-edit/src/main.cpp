@@ -14,71 +14,199 @@
 #include <QGroupBox>
 #include <QWidget>
 #include <QPainter>
+#include <QPainterPath>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QWheelEvent>
 #include <QComboBox>
 #include <QSpinBox>
+#include <QTimer>
+#include <QPointer>
+#include <QFileInfo>
+#include <QDir>
+#include <QSignalBlocker>
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
 
+#include "audio_engine.h"
+#include "waveform_peaks.h"
+
+#include "../../shared/ai-integration/include/ai_broker.h"
 #include "../../shared/ai-integration/include/ai_integration.h"
 #include "../../shared/utils/include/utils.h"
 
-// Simple waveform widget for audio visualization
+/**
+ * @brief Waveform view drawn from a precomputed peak summary
+ *
+ * Each channel is one filled min/max outline plus an RMS band, rebuilt only
+ * when the size, zoom or summary changes. The wheel zooms around the cursor.
+ * Moving the playhead repaints just the strips it leaves and enters.
+ */
 class WaveformWidget : public QWidget {
     Q_OBJECT
 
 public:
     WaveformWidget(QWidget *parent = nullptr) : QWidget(parent) {
         setMinimumHeight(200);
-        generateDummyWaveform();
+    }
+    
+    // nullptr clears the view, e.g. while a summary is being built
+    void setPeaks(std::shared_ptr<const xeno::audio::WaveformPeaks> summary) {
+        peaks = std::move(summary);
+        view_start = 0;
+        view_frames = peaks ? peaks->frames() : 0;
+        paths_valid = false;
+        update();
+    }
+    
+    void setStatusText(const QString& text) {
+        status_text = text;
+        update();
     }
 
 protected:
     void paintEvent(QPaintEvent *event) override {
         QPainter painter(this);
-        painter.setRenderHint(QPainter::Antialiasing);
+        painter.fillRect(event->rect(), QColor(40, 44, 52));
         
-        // Draw background
-        painter.fillRect(rect(), QColor(40, 44, 52));
-        
-        // Draw waveform
-        painter.setPen(QPen(QColor(52, 152, 219), 2));
-        
-        int width = this->width();
-        int height = this->height();
-        int center = height / 2;
-        
-        for (int i = 0; i < width - 1; i++) {
-            float t1 = (float)i / width;
-            float t2 = (float)(i + 1) / width;
-            
-            int y1 = center + (int)(waveform_data[i % waveform_data.size()] * center * 0.8);
-            int y2 = center + (int)(waveform_data[(i + 1) % waveform_data.size()] * center * 0.8);
-            
-            painter.drawLine(i, y1, i + 1, y2);
+        if (peaks && view_frames > 0) {
+            if (!paths_valid) {
+                rebuildPaths();
+            }
+            painter.setRenderHint(QPainter::Antialiasing);
+            for (const auto& channel : channel_paths) {
+                painter.fillPath(channel.peak, QColor(52, 152, 219));
+                painter.fillPath(channel.rms, QColor(133, 193, 233));
+            }
+        } else if (!status_text.isEmpty()) {
+            painter.setPen(QColor(170, 170, 170));
+            painter.drawText(rect(), Qt::AlignCenter, status_text);
         }
         
         // Draw playhead
         painter.setPen(QPen(QColor(255, 255, 255), 2));
-        int playhead_x = width * playhead_position;
-        painter.drawLine(playhead_x, 0, playhead_x, height);
+        int playhead_x = playheadX();
+        painter.drawLine(playhead_x, 0, playhead_x, height());
+    }
+    
+    void resizeEvent(QResizeEvent *event) override {
+        QWidget::resizeEvent(event);
+        paths_valid = false;
+    }
+    
+    void wheelEvent(QWheelEvent *event) override {
+        if (!peaks || view_frames <= 0 || width() <= 0) {
+            return;
+        }
+        
+        // Keeps the frame under the cursor in place
+        double anchor = event->position().x() / width();
+        double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+        int64_t anchor_frame = view_start + static_cast<int64_t>(anchor * view_frames);
+        int64_t frames = std::clamp<int64_t>(static_cast<int64_t>(view_frames * factor),
+                                             std::min<int64_t>(width(), peaks->frames()), peaks->frames());
+        view_start = std::clamp<int64_t>(anchor_frame - static_cast<int64_t>(anchor * frames), 0,
+                                         peaks->frames() - frames);
+        view_frames = frames;
+        paths_valid = false;
+        update();
+        event->accept();
     }
 
 public slots:
     void setPlayheadPosition(float position) {
+        int old_x = playheadX();
         playhead_position = position;
-        update();
+        int new_x = playheadX();
+        if (new_x != old_x) {
+            update(QRect(old_x - 2, 0, 4, height()));
+            update(QRect(new_x - 2, 0, 4, height()));
+        }
     }
 
 private:
-    void generateDummyWaveform() {
-        waveform_data.clear();
-        for (int i = 0; i < 1000; i++) {
-            float t = (float)i / 100.0f;
-            float value = sin(t) * 0.5 + sin(t * 2.3) * 0.3 + sin(t * 5.7) * 0.2;
-            waveform_data.push_back(value);
+    struct ChannelPaths {
+        QPainterPath peak;
+        QPainterPath rms;
+    };
+    
+    int playheadX() const {
+        if (!peaks || view_frames <= 0) {
+            return static_cast<int>(width() * playhead_position);
         }
+        double frame = playhead_position * peaks->frames();
+        return static_cast<int>((frame - view_start) / view_frames * width());
     }
-
-    std::vector<float> waveform_data;
+    
+    void rebuildPaths() {
+        paths_valid = true;
+        int channels = peaks->channels();
+        int pixels = width();
+        channel_paths.assign(channels, ChannelPaths{});
+        if (channels <= 0 || pixels <= 0) {
+            return;
+        }
+        
+        double frames_per_pixel = static_cast<double>(view_frames) / pixels;
+        const auto& level = peaks->levelFor(frames_per_pixel);
+        int64_t bucket_count = static_cast<int64_t>(level.bucketCount(channels));
+        double lane_height = static_cast<double>(height()) / channels;
+        
+        for (int c = 0; c < channels; c++) {
+            double center = lane_height * (c + 0.5);
+            double scale = lane_height * 0.45;
+            QPolygonF outline;
+            QPolygonF lower;
+            QPolygonF rms_outline;
+            QPolygonF rms_lower;
+            
+            for (int x = 0; x < pixels; x++) {
+                int64_t first = (view_start + static_cast<int64_t>(x * frames_per_pixel)) / level.frames_per_bucket;
+                int64_t last = (view_start + static_cast<int64_t>((x + 1) * frames_per_pixel)) / level.frames_per_bucket;
+                last = std::min(std::max(last, first + 1), bucket_count);
+                if (first >= bucket_count) {
+                    break;
+                }
+                
+                float low = 1.0f;
+                float high = -1.0f;
+                float rms = 0.0f;
+                for (int64_t b = first; b < last; b++) {
+                    const auto& bucket = level.buckets[b * channels + c];
+                    low = std::min(low, bucket.min);
+                    high = std::max(high, bucket.max);
+                    rms = std::max(rms, bucket.rms);
+                }
+                low = std::clamp(low, -1.0f, 1.0f);
+                high = std::clamp(high, low, 1.0f);
+                rms = std::min(rms, std::max(-low, high));
+                
+                outline << QPointF(x, center - high * scale);
+                lower << QPointF(x, center - low * scale);
+                rms_outline << QPointF(x, center - rms * scale);
+                rms_lower << QPointF(x, center + rms * scale);
+            }
+            
+            // One closed outline per channel: maxima left to right, minima back
+            std::reverse(lower.begin(), lower.end());
+            std::reverse(rms_lower.begin(), rms_lower.end());
+            outline << lower;
+            rms_outline << rms_lower;
+            channel_paths[c].peak.addPolygon(outline);
+            channel_paths[c].peak.closeSubpath();
+            channel_paths[c].rms.addPolygon(rms_outline);
+            channel_paths[c].rms.closeSubpath();
+        }
+    }
+    
+    std::shared_ptr<const xeno::audio::WaveformPeaks> peaks;
+    int64_t view_start = 0;  // First frame shown
+    int64_t view_frames = 0; // Frames across the widget's width
+    std::vector<ChannelPaths> channel_paths;
+    bool paths_valid = false;
+    QString status_text;
     float playhead_position = 0.0f;
 };
 
@@ -102,18 +230,41 @@ public:
         
         statusBar()->showMessage("Ready - AI audio editing with Xeno Labs integration");
     }
+    
+    ~AudioEditWindow() override {
+        export_cancelled = true;
+        if (export_thread.joinable()) {
+            export_thread.join();
+        }
+        peaks_cancelled = true;
+        if (peaks_thread.joinable()) {
+            peaks_thread.join();
+        }
+    }
 
 private slots:
     void openAudio() {
         QString filename = QFileDialog::getOpenFileName(this,
             "Open Audio", "", "Audio Files (*.wav *.mp3 *.flac *.aac *.ogg)");
         
-        if (!filename.isEmpty()) {
-            current_audio_path = filename;
-            statusBar()->showMessage("Audio loaded: " + filename);
-            // In production, load actual audio data and update waveform
-            waveform_widget->update();
+        if (filename.isEmpty()) {
+            return;
+        }
+        
+        stopAudio();
+        if (!audio_engine.open(filename.toStdString())) {
+            current_audio_path.clear();
+            QMessageBox::critical(this, "Error",
+                QString("Failed to open audio: %1").arg(QString::fromStdString(audio_engine.lastError())));
+            return;
         }
+        
+        current_audio_path = filename;
+        position_slider->setRange(0, static_cast<int>(audio_engine.duration() * 1000));
+        updatePlayhead();
+        statusBar()->showMessage(QString("Audio loaded: %1 (%2 Hz, %3 channels)")
+            .arg(filename).arg(audio_engine.sampleRate()).arg(audio_engine.channels()));
+        buildWaveform(filename.toStdString());
     }
     
     void saveAudio() {
@@ -122,37 +273,101 @@ private slots:
             return;
         }
         
+        if (export_running) {
+            QMessageBox::information(this, "Save", "An export is already in progress.");
+            return;
+        }
+        
         QString filename = QFileDialog::getSaveFileName(this,
-            "Save Audio", "", "Audio Files (*.wav *.mp3 *.flac)");
+            "Save Audio", "", "Audio Files (*.wav *.flac *.ogg)");
+        
+        if (filename.isEmpty()) {
+            return;
+        }
         
-        if (!filename.isEmpty()) {
-            QMessageBox::information(this, "Save", 
-                QString("Audio would be saved to: %1").arg(filename));
+        if (export_thread.joinable()) {
+            export_thread.join();
         }
+        
+        auto progress = new QProgressDialog("Exporting audio...", "Cancel", 0, 100, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
+        connect(progress, &QProgressDialog::canceled, this, [this]() { export_cancelled = true; });
+        
+        // The engine streams the file in blocks on this thread while playback continues
+        QPointer<QProgressDialog> dialog(progress);
+        export_cancelled = false;
+        export_running = true;
+        export_thread = std::thread([this, dialog, destination = filename.toStdString(), settings = effect_settings]() {
+            int last_percent = -1;
+            std::string error;
+            bool success = audio_engine.exportTo(destination, settings, [&](double fraction) {
+                int percent = static_cast<int>(fraction * 100);
+                if (percent != last_percent) {
+                    last_percent = percent;
+                    QMetaObject::invokeMethod(this, [dialog, percent]() {
+                        if (dialog) {
+                            dialog->setValue(percent);
+                        }
+                    }, Qt::QueuedConnection);
+                }
+                return !export_cancelled.load();
+            }, error);
+            
+            QMetaObject::invokeMethod(this, [this, dialog, success, error, destination]() {
+                export_running = false;
+                if (dialog) {
+                    dialog->close();
+                }
+                if (success) {
+                    statusBar()->showMessage("Audio saved: " + QString::fromStdString(destination));
+                } else if (!export_cancelled) {
+                    QMessageBox::critical(this, "Error",
+                        QString("Failed to save audio: %1").arg(QString::fromStdString(error)));
+                }
+            }, Qt::QueuedConnection);
+        });
     }
     
     void playPause() {
         if (is_playing) {
-            is_playing = false;
-            play_pause_btn->setText("Play");
-            statusBar()->showMessage("Playback stopped");
-        } else {
-            is_playing = true;
-            play_pause_btn->setText("Pause");
+            audio_engine.pause();
+            setPlaying(false);
+            statusBar()->showMessage("Playback paused");
+        } else if (audio_engine.play()) {
+            setPlaying(true);
             statusBar()->showMessage("Playing audio");
-            // Simulate playback
-            startPlaybackSimulation();
+        } else {
+            QMessageBox::warning(this, "Playback",
+                QString("Cannot play audio: %1").arg(QString::fromStdString(audio_engine.lastError())));
         }
     }
     
     void stopAudio() {
-        is_playing = false;
-        play_pause_btn->setText("Play");
-        position_slider->setValue(0);
-        waveform_widget->setPlayheadPosition(0.0f);
+        audio_engine.stop();
+        setPlaying(false);
+        updatePlayhead();
         statusBar()->showMessage("Stopped");
     }
     
+    // Follows the audio clock while playing
+    void updatePlayhead() {
+        if (is_playing && !audio_engine.isPlaying()) {
+            setPlaying(false);
+            statusBar()->showMessage("Playback finished");
+        }
+        
+        double position = audio_engine.position();
+        double duration = audio_engine.duration();
+        if (!position_slider->isSliderDown()) {
+            QSignalBlocker blocker(position_slider);
+            position_slider->setValue(static_cast<int>(position * 1000));
+            waveform_widget->setPlayheadPosition(duration > 0 ? static_cast<float>(position / duration) : 0.0f);
+        }
+        time_label->setText(formatTime(position) + " / " + formatTime(duration));
+    }
+    
     void applyVoiceClone() {
         if (current_audio_path.isEmpty()) {
             QMessageBox::warning(this, "Warning", "Please load an audio file first!");
@@ -167,29 +382,71 @@ private slots:
             return;
         }
         
-        QProgressDialog progress("Applying AI Voice Cloning...", "Cancel", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
-        
-        for (int i = 0; i <= 100; i += 5) {
-            progress.setValue(i);
-            QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                return;
-            }
-            QThread::msleep(100);
-        }
+        auto progress = new QProgressDialog("Applying AI Voice Cloning...", "Cancel", 0, 0, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
         
         xeno::ai::AIIntegration::AIRequest request;
         request.prompt = "Clone voice characteristics from audio sample";
         request.operation_type = "voice_clone";
         
-        auto response = ai_integration->processAudio(request);
+        // The source is uploaded in chunks and the result streamed next to it on disk
+        xeno::ai::AIIntegration::MediaFiles files;
+        files.source_path = current_audio_path.toStdString();
+        QFileInfo source_info(current_audio_path);
+        files.result_path = source_info.dir().filePath(
+            source_info.completeBaseName() + "_voice_clone." + source_info.suffix()).toStdString();
+        if (voice_clone_transfer_source == current_audio_path) {
+            files.transfer_id = voice_clone_transfer_id.toStdString(); // Resume the upload that failed last time
+        }
+        
+        QPointer<QProgressDialog> dialog(progress);
+        auto last_percent = std::make_shared<int>(-1);
+        auto on_progress = [this, dialog, last_percent](uint64_t done, uint64_t total) {
+            int percent = total > 0 ? static_cast<int>(done * 100 / total) : 0;
+            if (percent != *last_percent) {
+                *last_percent = percent;
+                QMetaObject::invokeMethod(this, [dialog, percent]() {
+                    if (dialog) {
+                        dialog->setRange(0, 100);
+                        dialog->setValue(percent);
+                    }
+                }, Qt::QueuedConnection);
+            }
+            return true;
+        };
+        auto task = ai_integration->processAudioFileAsync(request, files, on_progress,
+            xeno::ai::AIIntegration::AIProvider::Auto,
+            [this, dialog, source = current_audio_path](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, dialog, source, response]() {
+                    if (dialog) {
+                        dialog->close();
+                    }
+                    voice_clone_transfer_source = source;
+                    voice_clone_transfer_id = QString::fromStdString(response.metadata.value("transfer_id", std::string()));
+                    if (response.success) {
+                        voice_clone_transfer_id.clear();
+                    }
+                    finishVoiceClone(response);
+                }, Qt::QueuedConnection);
+            });
+        
+        connect(progress, &QProgressDialog::canceled, this, [task]() { task.cancel(); });
+    }
+    
+    void finishVoiceClone(const xeno::ai::AIIntegration::AIResponse& response) {
+        if (response.metadata.value("cancelled", false)) {
+            statusBar()->showMessage("Voice cloning cancelled");
+            return;
+        }
         
         if (response.success) {
             statusBar()->showMessage(QString("Voice cloning applied - %1 credits used")
                 .arg(response.credits_used));
-            QMessageBox::information(this, "Success", "AI voice cloning completed!");
+            updateCreditDisplay();
+            QMessageBox::information(this, "Success", QString("AI voice cloning completed!\nSaved to %1")
+                .arg(QString::fromStdString(response.metadata.value("result_path", std::string()))));
         } else {
             QMessageBox::critical(this, "AI Error", 
                 QString("Failed to apply voice cloning: %1").arg(QString::fromStdString(response.error_message)));
@@ -197,22 +454,12 @@ private slots:
     }
     
     void reduceNoise() {
-        if (current_audio_path.isEmpty()) {
-            QMessageBox::warning(this, "Warning", "Please load an audio file first!");
-            return;
-        }
-        
-        int required_credits = 2;
-        if (!ai_integration->validateCredits(required_credits)) {
-            QMessageBox::warning(this, "Insufficient Credits", 
-                QString("Noise reduction requires %1 credits.").arg(required_credits));
-            return;
-        }
-        
-        ai_integration->deductCredits(required_credits);
-        statusBar()->showMessage(QString("Noise reduction applied - %1 credits used").arg(required_credits));
-        QMessageBox::information(this, "Success", "AI noise reduction completed!");
-        updateCreditDisplay();
+        // Runs locally in the effect chain, so it costs no credits
+        effect_settings.noise_reduction = effect_settings.noise_reduction > 0.0f ? 0.0f : 1.0f;
+        bool enabled = effect_settings.noise_reduction > 0.0f;
+        noise_reduce_btn->setChecked(enabled);
+        applyEffects();
+        statusBar()->showMessage(enabled ? "Noise reduction on" : "Noise reduction off");
     }
     
     void enhanceAudio() {
@@ -259,7 +506,7 @@ private:
         position_slider = new QSlider(Qt::Horizontal);
         position_slider->setRange(0, 100);
         
-        auto time_label = new QLabel("00:00 / 00:00");
+        time_label = new QLabel("00:00 / 00:00");
         
         controls_layout->addWidget(play_pause_btn);
         controls_layout->addWidget(stop_btn);
@@ -281,7 +528,8 @@ private:
         auto ai_tools_layout = new QVBoxLayout(ai_group);
         
         auto voice_clone_btn = new QPushButton("Voice Clone (5 credits)");
-        auto noise_reduce_btn = new QPushButton("Noise Reduction (2 credits)");
+        noise_reduce_btn = new QPushButton("Noise Reduction (local)");
+        noise_reduce_btn->setCheckable(true);
         auto enhance_btn = new QPushButton("AI Enhance (3 credits)");
         auto transcribe_btn = new QPushButton("Transcribe (1 credit)");
         
@@ -306,9 +554,9 @@ private:
         volume_slider->setRange(0, 200);
         volume_slider->setValue(100);
         
-        auto pitch_label = new QLabel("Pitch:");
+        auto pitch_label = new QLabel("Pitch: 0 st");
         auto pitch_slider = new QSlider(Qt::Horizontal);
-        pitch_slider->setRange(-50, 50);
+        pitch_slider->setRange(-12, 12);
         pitch_slider->setValue(0);
         
         traditional_layout->addWidget(volume_label);
@@ -333,6 +581,15 @@ private:
         connect(stop_btn, &QPushButton::clicked, this, &AudioEditWindow::stopAudio);
         connect(voice_clone_btn, &QPushButton::clicked, this, &AudioEditWindow::applyVoiceClone);
         connect(noise_reduce_btn, &QPushButton::clicked, this, &AudioEditWindow::reduceNoise);
+        connect(volume_slider, &QSlider::valueChanged, this, [this](int value) {
+            effect_settings.gain = value / 100.0f;
+            applyEffects();
+        });
+        connect(pitch_slider, &QSlider::valueChanged, this, [this, pitch_label](int value) {
+            pitch_label->setText(QString("Pitch: %1%2 st").arg(value > 0 ? "+" : "").arg(value));
+            effect_settings.semitones = static_cast<float>(value);
+            applyEffects();
+        });
         connect(enhance_btn, &QPushButton::clicked, this, &AudioEditWindow::enhanceAudio);
         
         updateCreditDisplay();
@@ -366,17 +623,40 @@ private:
     }
     
     void setupConnections() {
-        connect(position_slider, &QSlider::valueChanged, [this](int value) {
-            float position = (float)value / 100.0f;
-            waveform_widget->setPlayheadPosition(position);
+        // Dragging moves only the playhead; the stream seeks once on release
+        connect(position_slider, &QSlider::sliderMoved, this, [this](int value) {
+            int maximum = position_slider->maximum();
+            waveform_widget->setPlayheadPosition(maximum > 0 ? (float)value / maximum : 0.0f);
         });
+        connect(position_slider, &QSlider::valueChanged, this, [this](int value) {
+            if (!position_slider->isSliderDown()) {
+                audio_engine.seek(value / 1000.0);
+                updatePlayhead();
+            }
+        });
+        connect(position_slider, &QSlider::sliderReleased, this, [this]() {
+            audio_engine.seek(position_slider->value() / 1000.0);
+            updatePlayhead();
+        });
+        
+        playhead_timer = new QTimer(this);
+        playhead_timer->setInterval(30);
+        connect(playhead_timer, &QTimer::timeout, this, &AudioEditWindow::updatePlayhead);
     }
     
     void loadConfiguration() {
+        // With the launcher running, AI requests and credits go through its shared service and the
+        // config here only takes over if the launcher quits
+        ai_integration->connectToBroker(xeno::ai::AIBroker::defaultAddress());
         std::string config_path = xeno::utils::Platform::getAppDataPath() + "/config.json";
         ai_integration->loadConfigFromFile(config_path);
     }
     
+    void applyEffects() {
+        // Playback hears the change on its next buffer; exports take a copy when they start
+        audio_engine.setEffects(effect_settings);
+    }
+    
     void updateCreditDisplay() {
         int balance = ai_integration->getCreditBalance();
         credit_status->setText(QString("Credits: %1").arg(balance));
@@ -388,37 +668,84 @@ private:
         }
     }
     
-    void startPlaybackSimulation() {
-        // Simple simulation of audio playback
-        QTimer *timer = new QTimer(this);
-        connect(timer, &QTimer::timeout, [this, timer]() {
-            if (!is_playing) {
-                timer->stop();
-                timer->deleteLater();
+    // Loads or builds the peak summary off the UI thread; a newer file supersedes it
+    void buildWaveform(const std::string& path) {
+        peaks_cancelled = true;
+        if (peaks_thread.joinable()) {
+            peaks_thread.join();
+        }
+        peaks_cancelled = false;
+        
+        waveform_widget->setPeaks(nullptr);
+        waveform_widget->setStatusText("Building waveform...");
+        uint64_t generation = ++peaks_generation;
+        peaks_thread = std::thread([this, path, generation]() {
+            auto summary = std::make_shared<xeno::audio::WaveformPeaks>();
+            bool success = summary->loadOrBuild(path, [this](double) { return !peaks_cancelled.load(); });
+            if (peaks_cancelled) {
                 return;
             }
             
-            int current_pos = position_slider->value();
-            current_pos += 1;
-            if (current_pos > 100) {
-                current_pos = 0;
-            }
-            position_slider->setValue(current_pos);
-            waveform_widget->setPlayheadPosition((float)current_pos / 100.0f);
+            QMetaObject::invokeMethod(this, [this, summary, success, generation]() {
+                if (generation != peaks_generation) {
+                    return;
+                }
+                if (success) {
+                    waveform_widget->setPeaks(summary);
+                } else {
+                    waveform_widget->setStatusText(
+                        QString("Waveform unavailable: %1").arg(QString::fromStdString(summary->lastError())));
+                }
+            }, Qt::QueuedConnection);
         });
-        timer->start(100);
+    }
+    
+    void setPlaying(bool playing) {
+        is_playing = playing;
+        play_pause_btn->setText(playing ? "Pause" : "Play");
+        if (playing) {
+            playhead_timer->start();
+        } else {
+            playhead_timer->stop();
+        }
+    }
+    
+    static QString formatTime(double seconds) {
+        int total = static_cast<int>(seconds);
+        QString text = QString("%1:%2").arg(total / 60 % 60, 2, 10, QChar('0')).arg(total % 60, 2, 10, QChar('0'));
+        return total >= 3600 ? QString("%1:%2").arg(total / 3600).arg(text) : text;
     }
 
 private:
     std::unique_ptr<xeno::ai::AIIntegration> ai_integration;
+    xeno::audio::AudioEngine audio_engine;
     QString current_audio_path;
+    
+    // Upload to resume if the last voice clone job failed part way
+    QString voice_clone_transfer_source;
+    QString voice_clone_transfer_id;
+    
     bool is_playing = false;
     
+    // Export runs on its own thread; joined before the engine is destroyed
+    std::thread export_thread;
+    std::atomic<bool> export_cancelled{false};
+    bool export_running = false;
+    
+    std::thread peaks_thread;
+    std::atomic<bool> peaks_cancelled{false};
+    uint64_t peaks_generation = 0; // Identifies the latest build; older results are dropped
+    
+    xeno::dsp::EffectSettings effect_settings;
+    
     // UI elements
     WaveformWidget* waveform_widget;
     QPushButton* play_pause_btn;
+    QPushButton* noise_reduce_btn;
     QSlider* position_slider;
+    QLabel* time_label;
     QLabel* credit_status;
+    QTimer* playhead_timer;
 };
 
 int main(int argc, char *argv[]) {
@@ -428,6 +755,12 @@ int main(int argc, char *argv[]) {
     QApplication::setApplicationVersion("1.0.0");
     QApplication::setOrganizationName("Xeno AI");
     
+    // Log to <app data>/logs/audio-edit.log as well as the console
+    xeno::utils::Logger::Options log_options;
+    log_options.file_name = "audio-edit";
+    xeno::utils::Logger::getInstance().configure(log_options);
+    // Edits to config.json apply without a restart
+    xeno::utils::ConfigManager::getInstance().watch();
     xeno::utils::Logger::getInstance().info("Starting Xeno Audio Edit");
     
     AudioEditWindow window;
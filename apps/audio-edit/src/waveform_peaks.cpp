@@ -0,0 +1,244 @@
+#include "waveform_peaks.h"
+#include "audio_file.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "../../shared/utils/include/utils.h"
+
+namespace xeno::audio {
+
+namespace {
+
+constexpr int64_t kReadBlockFrames = 65536;
+constexpr char kSidecarMagic[4] = {'X', 'P', 'K', 'S'};
+constexpr uint32_t kSidecarVersion = 1;
+
+struct SidecarHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_modified;
+    int32_t channels;
+    int32_t sample_rate;
+    int64_t frames;
+    uint32_t level_count;
+};
+
+// Identifies the version of the source a sidecar was built from
+bool fingerprint(const std::string& path, uint64_t& size, int64_t& modified) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+WaveformPeaks::Bucket emptyBucket() {
+    return {FLT_MAX, -FLT_MAX, 0.0f};
+}
+
+} // namespace
+
+bool WaveformPeaks::loadOrBuild(const std::string& path, const Progress& progress) {
+    if (loadSidecar(path)) {
+        return true;
+    }
+    if (!build(path, progress)) {
+        return false;
+    }
+    saveSidecar(path); // A missing cache only costs a rescan next time
+    return true;
+}
+
+bool WaveformPeaks::build(const std::string& path, const Progress& progress) {
+    levels.clear();
+    
+    AudioFile file;
+    if (!file.open(path)) {
+        error_message = file.lastError();
+        return false;
+    }
+    channel_count = file.channels();
+    sample_rate = file.sampleRate();
+    frame_count = file.frames();
+    
+    Level base;
+    base.frames_per_bucket = kBaseFramesPerBucket;
+    base.buckets.reserve(static_cast<size_t>((frame_count + kBaseFramesPerBucket - 1) / kBaseFramesPerBucket) *
+                         channel_count);
+    
+    std::vector<float> block(kReadBlockFrames * channel_count);
+    std::vector<Bucket> current(channel_count, emptyBucket());
+    std::vector<double> sum_squares(channel_count, 0.0);
+    int64_t in_bucket = 0;
+    int64_t scanned = 0;
+    
+    auto flush = [&]() {
+        for (int c = 0; c < channel_count; ++c) {
+            current[c].rms = static_cast<float>(std::sqrt(sum_squares[c] / in_bucket));
+            base.buckets.push_back(current[c]);
+            current[c] = emptyBucket();
+            sum_squares[c] = 0.0;
+        }
+        in_bucket = 0;
+    };
+    
+    while (int64_t count = file.read(block.data(), kReadBlockFrames)) {
+        const float* samples = block.data();
+        for (int64_t f = 0; f < count; ++f) {
+            for (int c = 0; c < channel_count; ++c) {
+                float value = *samples++;
+                current[c].min = std::min(current[c].min, value);
+                current[c].max = std::max(current[c].max, value);
+                sum_squares[c] += static_cast<double>(value) * value;
+            }
+            if (++in_bucket == kBaseFramesPerBucket) {
+                flush();
+            }
+        }
+        
+        scanned += count;
+        if (progress && !progress(frame_count > 0 ? static_cast<double>(scanned) / frame_count : 1.0)) {
+            error_message = "Cancelled";
+            return false;
+        }
+    }
+    if (in_bucket > 0) {
+        flush();
+    }
+    levels.push_back(std::move(base));
+    
+    // Each coarser level merges kLevelFactor buckets of the previous one
+    for (int l = 1; l < kLevelCount; ++l) {
+        const Level& below = levels.back();
+        size_t count = below.bucketCount(channel_count);
+        
+        Level next;
+        next.frames_per_bucket = below.frames_per_bucket * kLevelFactor;
+        next.buckets.reserve((count + kLevelFactor - 1) / kLevelFactor * channel_count);
+        for (size_t b = 0; b < count; b += kLevelFactor) {
+            size_t end = std::min(count, b + kLevelFactor);
+            for (int c = 0; c < channel_count; ++c) {
+                Bucket merged = emptyBucket();
+                double squares = 0.0;
+                for (size_t i = b; i < end; ++i) {
+                    const Bucket& source = below.buckets[i * channel_count + c];
+                    merged.min = std::min(merged.min, source.min);
+                    merged.max = std::max(merged.max, source.max);
+                    squares += static_cast<double>(source.rms) * source.rms;
+                }
+                merged.rms = static_cast<float>(std::sqrt(squares / (end - b)));
+                next.buckets.push_back(merged);
+            }
+        }
+        levels.push_back(std::move(next));
+    }
+    error_message.clear();
+    return true;
+}
+
+const WaveformPeaks::Level& WaveformPeaks::levelFor(double frames_per_pixel) const {
+    size_t index = 0;
+    while (index + 1 < levels.size() && levels[index + 1].frames_per_bucket <= frames_per_pixel) {
+        ++index;
+    }
+    return levels[index];
+}
+
+std::string WaveformPeaks::sidecarPath(const std::string& path) {
+    std::error_code error;
+    std::string absolute = std::filesystem::absolute(path, error).string();
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(absolute) << ".peaks";
+    return (std::filesystem::path(utils::Platform::getAppDataPath()) / "waveform-cache" / name.str()).string();
+}
+
+bool WaveformPeaks::loadSidecar(const std::string& path) {
+    uint64_t size = 0;
+    int64_t modified = 0;
+    if (!fingerprint(path, size, modified)) {
+        return false;
+    }
+    
+    std::ifstream input(sidecarPath(path), std::ios::binary);
+    SidecarHeader header{};
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        !std::equal(std::begin(kSidecarMagic), std::end(kSidecarMagic), header.magic) ||
+        header.version != kSidecarVersion || header.source_size != size || header.source_modified != modified ||
+        header.channels <= 0 || header.frames < 0 || header.level_count != kLevelCount) {
+        return false;
+    }
+    
+    std::vector<Level> loaded(header.level_count);
+    int64_t frames_per_bucket = kBaseFramesPerBucket;
+    for (auto& level : loaded) {
+        uint64_t count = 0;
+        if (!input.read(reinterpret_cast<char*>(&level.frames_per_bucket), sizeof(level.frames_per_bucket)) ||
+            !input.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+            return false;
+        }
+        // Rejects truncated or foreign files before allocating
+        uint64_t expected = static_cast<uint64_t>((header.frames + frames_per_bucket - 1) / frames_per_bucket) *
+                            header.channels;
+        if (level.frames_per_bucket != frames_per_bucket || count != expected) {
+            return false;
+        }
+        level.buckets.resize(count);
+        if (!input.read(reinterpret_cast<char*>(level.buckets.data()), count * sizeof(Bucket))) {
+            return false;
+        }
+        frames_per_bucket *= kLevelFactor;
+    }
+    
+    levels = std::move(loaded);
+    channel_count = header.channels;
+    sample_rate = header.sample_rate;
+    frame_count = header.frames;
+    return true;
+}
+
+bool WaveformPeaks::saveSidecar(const std::string& path) const {
+    SidecarHeader header{};
+    std::copy(std::begin(kSidecarMagic), std::end(kSidecarMagic), header.magic);
+    header.version = kSidecarVersion;
+    if (!fingerprint(path, header.source_size, header.source_modified)) {
+        return false;
+    }
+    header.channels = channel_count;
+    header.sample_rate = sample_rate;
+    header.frames = frame_count;
+    header.level_count = static_cast<uint32_t>(levels.size());
+    
+    std::filesystem::path target = sidecarPath(path);
+    std::error_code error;
+    std::filesystem::create_directories(target.parent_path(), error);
+    
+    // Written beside the target and renamed, so a reader never sees a partial file
+    std::filesystem::path temporary = target;
+    temporary += ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& level : levels) {
+            uint64_t count = level.buckets.size();
+            output.write(reinterpret_cast<const char*>(&level.frames_per_bucket), sizeof(level.frames_per_bucket));
+            output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            output.write(reinterpret_cast<const char*>(level.buckets.data()), count * sizeof(Bucket));
+        }
+        if (!output) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, target, error);
+    return !error;
+}
+
+} // namespace xeno::audio
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace xeno::audio {
+
+/**
+ * @brief Min/max/RMS summary of an audio file at several resolutions
+ *
+ * Level 0 summarises 256 frames per bucket, and each further level merges
+ * 16 buckets of the one below (4096, then 65536 frames). Drawing at any zoom
+ * then reads at most a few buckets per pixel instead of the samples.
+ * Summaries are cached in a sidecar file keyed on the source's size and
+ * modification time, so a file is only scanned once.
+ */
+class WaveformPeaks {
+public:
+    struct Bucket {
+        float min = 0.0f;
+        float max = 0.0f;
+        float rms = 0.0f;
+    };
+    
+    struct Level {
+        int64_t frames_per_bucket = 0;
+        std::vector<Bucket> buckets; // Interleaved by channel: bucket * channels + channel
+        
+        size_t bucketCount(int channels) const { return channels > 0 ? buckets.size() / channels : 0; }
+    };
+    
+    static constexpr int64_t kBaseFramesPerBucket = 256;
+    static constexpr int kLevelFactor = 16;
+    static constexpr int kLevelCount = 3;
+    
+    // Receives the fraction scanned; returning false cancels the build
+    using Progress = std::function<bool(double fraction)>;
+    
+    // Loads the cached summary of path, or scans the file and writes the cache
+    bool loadOrBuild(const std::string& path, const Progress& progress = nullptr);
+    bool build(const std::string& path, const Progress& progress = nullptr);
+    
+    bool empty() const { return levels.empty(); }
+    int channels() const { return channel_count; }
+    int sampleRate() const { return sample_rate; }
+    int64_t frames() const { return frame_count; }
+    const std::string& lastError() const { return error_message; }
+    
+    // Coarsest level with at most frames_per_pixel frames per bucket
+    const Level& levelFor(double frames_per_pixel) const;
+    const Level& level(size_t index) const { return levels[index]; }
+    size_t levelCount() const { return levels.size(); }
+    
+    // Where the summary of path is cached
+    static std::string sidecarPath(const std::string& path);
+
+private:
+    bool loadSidecar(const std::string& path);
+    bool saveSidecar(const std::string& path) const;
+    
+    std::vector<Level> levels;
+    int channel_count = 0;
+    int sample_rate = 0;
+    int64_t frame_count = 0;
+    std::string error_message;
+};
+
+} // namespace xeno::audio
@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image_engine.h"
+
+#include "../../shared/ai-integration/include/ai_broker.h"
+#include "../../shared/ai-integration/include/ai_integration.h"
+#include "../../shared/utils/include/utils.h"
+
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: xeno-image-batch --recipe <recipe.json> --output <directory> [options] <image>...\n"
+              << "\n"
+              << "Options:\n"
+              << "  --list <file>       Read input paths from a file, one per line\n"
+              << "  --threads <n>       Compute threads (default: one per core)\n"
+              << "  --in-flight <n>     Images held in memory at once (default: 8)\n"
+              << "  --batch <n>         Files per AI batch request (default: 8)\n";
+}
+
+bool parseCount(const char* text, size_t& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0) {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto& logger = xeno::utils::Logger::getInstance();
+    
+    std::string recipe_path;
+    std::string output_directory;
+    std::vector<std::string> inputs;
+    xeno::image::ImageEngine::Options options;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if (argument == "--help" || argument == "-h") {
+            printUsage();
+            return 0;
+        } else if (argument == "--recipe" && has_value) {
+            recipe_path = argv[++i];
+        } else if (argument == "--output" && has_value) {
+            output_directory = argv[++i];
+        } else if (argument == "--list" && has_value) {
+            std::ifstream list(argv[++i]);
+            if (!list.is_open()) {
+                logger.error("Cannot open file list: ", argv[i]);
+                return 2;
+            }
+            for (std::string line; std::getline(list, line);) {
+                if (!line.empty()) {
+                    inputs.push_back(line);
+                }
+            }
+        } else if (argument == "--threads" && has_value) {
+            if (!parseCount(argv[++i], options.compute_threads)) {
+                printUsage();
+                return 2;
+            }
+        } else if (argument == "--in-flight" && has_value) {
+            if (!parseCount(argv[++i], options.max_in_flight)) {
+                printUsage();
+                return 2;
+            }
+        } else if (argument == "--batch" && has_value) {
+            if (!parseCount(argv[++i], options.ai_batch_size)) {
+                printUsage();
+                return 2;
+            }
+        } else if (!argument.empty() && argument[0] != '-') {
+            inputs.push_back(argument);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    
+    if (recipe_path.empty() || output_directory.empty() || inputs.empty()) {
+        printUsage();
+        return 2;
+    }
+    
+    xeno::image::Recipe recipe;
+    if (!recipe.loadFromFile(recipe_path)) {
+        logger.error("Invalid recipe: ", recipe_path);
+        return 2;
+    }
+    
+    std::error_code error;
+    std::filesystem::create_directories(output_directory, error);
+    if (error) {
+        logger.error("Cannot create output directory ", output_directory, ": ", error.message());
+        return 2;
+    }
+    
+    std::vector<xeno::image::ImageEngine::Job> jobs;
+    for (const auto& input : inputs) {
+        auto output = std::filesystem::path(output_directory) / std::filesystem::path(input).filename();
+        jobs.push_back({input, output.string()});
+    }
+    
+    xeno::ai::AIIntegration ai_integration;
+    if (recipe.needsAI()) {
+        // Spends the launcher's credits and shares its cache when it is running
+        ai_integration.connectToBroker(xeno::ai::AIBroker::defaultAddress());
+        ai_integration.loadConfigFromFile(xeno::utils::Platform::getAppDataPath() + "/config.json");
+    }
+    
+    xeno::image::ImageEngine engine(ai_integration, options);
+    auto start = std::chrono::steady_clock::now();
+    auto results = engine.run(recipe, jobs, [&](const auto& result, size_t finished, size_t total) {
+        if (result.success) {
+            logger.info("[", finished, "/", total, "] ", result.input, " -> ", result.output);
+        } else {
+            logger.error("[", finished, "/", total, "] ", result.input, ": ", result.error_message);
+        }
+    });
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    size_t failed = 0;
+    int credits = 0;
+    for (const auto& result : results) {
+        failed += result.success ? 0 : 1;
+        credits += result.credits_used;
+    }
+    
+    std::cout << "Processed " << results.size() - failed << " of " << results.size() << " images in "
+              << elapsed << " s";
+    if (credits > 0) {
+        std::cout << " (" << credits << " credits)";
+    }
+    std::cout << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+#include "image_engine.h"
+#include "image_operations.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <semaphore>
+#include <set>
+#include <thread>
+
+#include "../../shared/utils/include/bounded_queue.h"
+
+namespace xeno::image {
+
+namespace {
+
+const std::set<std::string> kKnownOperations = {"enhance", "brightness_contrast", "inpaint", "generative_fill"};
+constexpr const char* kDefaultFillPrompt = "Apply generative fill to enhance image";
+
+// One image moving through the pipeline
+struct Frame {
+    size_t index = 0;
+    cv::Mat image;
+    std::string error_message;
+    int credits_used = 0;
+};
+
+} // namespace
+
+bool Recipe::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    auto json = nlohmann::json::parse(file, nullptr, false);
+    return !json.is_discarded() && loadFromJSON(json);
+}
+
+bool Recipe::loadFromJSON(const nlohmann::json& json) {
+    if (!json.is_object() || !json.contains("steps") || !json["steps"].is_array()) {
+        return false;
+    }
+    
+    std::vector<Step> parsed;
+    for (const auto& item : json["steps"]) {
+        if (!item.is_object() || !item.contains("op") || !item["op"].is_string() ||
+            !kKnownOperations.count(item["op"].get<std::string>())) {
+            return false;
+        }
+        Step step;
+        step.operation = item["op"].get<std::string>();
+        step.parameters = item;
+        step.parameters.erase("op");
+        parsed.push_back(std::move(step));
+    }
+    steps = std::move(parsed);
+    return true;
+}
+
+bool Recipe::needsAI() const {
+    return std::any_of(steps.begin(), steps.end(), [](const Step& step) {
+        return step.operation == "generative_fill";
+    });
+}
+
+ImageEngine::ImageEngine(ai::AIIntegration& ai_integration, const Options& options)
+    : ai_integration(ai_integration), options(options) {}
+
+std::vector<Operation> ImageEngine::buildOperations(const Recipe& recipe, cv::Size size) {
+    std::vector<Operation> operations;
+    for (const auto& step : recipe.steps) {
+        const auto& parameters = step.parameters;
+        if (step.operation == "enhance") {
+            operations.push_back(ops::enhance());
+        } else if (step.operation == "brightness_contrast") {
+            operations.push_back(ops::brightnessContrast(parameters.value("brightness", 0),
+                                                         parameters.value("contrast", 0)));
+        } else if (step.operation == "inpaint") {
+            cv::Point center(parameters.value("x", size.width / 2), parameters.value("y", size.height / 2));
+            operations.push_back(ops::inpaintCircle(center, parameters.value("radius", 50)));
+        } else if (step.operation == "generative_fill") {
+            operations.push_back(ops::generativeFill());
+        }
+    }
+    return operations;
+}
+
+cv::Mat ImageEngine::apply(const cv::Mat& image, const std::vector<Operation>& operations) {
+    // Two buffers ping-pong between steps; the input is never written
+    cv::Mat buffers[2];
+    cv::Mat current = image;
+    size_t next = 0;
+    for (const auto& operation : operations) {
+        applyOperation(operation, current, buffers[next]);
+        current = buffers[next];
+        next ^= 1;
+    }
+    return current.data == image.data ? image.clone() : current;
+}
+
+std::vector<ImageEngine::Result> ImageEngine::run(const Recipe& recipe, const std::vector<Job>& jobs,
+                                                  ProgressCallback on_progress) {
+    std::vector<Result> results(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        results[i].input = jobs[i].input;
+        results[i].output = jobs[i].output;
+    }
+    if (jobs.empty()) {
+        return results;
+    }
+    
+    size_t in_flight = std::max<size_t>(options.max_in_flight, 1);
+    size_t compute_threads = options.compute_threads > 0 ? options.compute_threads
+                                                         : std::max(1u, std::thread::hardware_concurrency());
+    bool needs_ai = recipe.needsAI();
+    
+    // A slot is taken before a file is decoded and returned once it is written, which
+    // caps the images in memory; the queues are sized so pushes never wait on top of that
+    std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(in_flight));
+    utils::BoundedQueue<Frame> decoded(in_flight);
+    utils::BoundedQueue<Frame> ready(in_flight);
+    utils::BoundedQueue<Frame> processed(in_flight);
+    std::atomic<size_t> next_job{0};
+    std::atomic<size_t> finished{0};
+    std::mutex progress_mutex;
+    
+    auto decode = [&]() {
+        while (true) {
+            slots.acquire();
+            size_t index = next_job.fetch_add(1);
+            if (index >= jobs.size()) {
+                slots.release();
+                return;
+            }
+            
+            Frame frame;
+            frame.index = index;
+            try {
+                frame.image = cv::imread(jobs[index].input);
+            } catch (const cv::Exception& e) {
+                frame.error_message = e.what();
+            }
+            if (frame.image.empty() && frame.error_message.empty()) {
+                frame.error_message = "Failed to decode " + jobs[index].input;
+            }
+            decoded.push(std::move(frame));
+        }
+    };
+    
+    auto requestAI = [&](std::vector<Frame>& batch) {
+        std::vector<ai::AIIntegration::AIRequest> requests;
+        std::vector<size_t> owners;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].error_message.empty()) {
+                continue;
+            }
+            for (const auto& step : recipe.steps) {
+                if (step.operation != "generative_fill") {
+                    continue;
+                }
+                ai::AIIntegration::AIRequest request;
+                request.prompt = step.parameters.value("prompt", kDefaultFillPrompt);
+                request.operation_type = "generative_fill";
+                request.parameters["source"] = jobs[batch[i].index].input; // Keeps cache entries per file
+                requests.push_back(std::move(request));
+                owners.push_back(i);
+            }
+        }
+        if (requests.empty()) {
+            return;
+        }
+        
+        auto responses = ai_integration.generateImageBatch(requests);
+        for (size_t k = 0; k < responses.size(); ++k) {
+            Frame& frame = batch[owners[k]];
+            frame.credits_used += responses[k].credits_used;
+            if (!responses[k].success && frame.error_message.empty()) {
+                frame.error_message = "Generative fill failed: " + responses[k].error_message;
+            }
+        }
+    };
+    
+    // Gathers whatever has been decoded, up to one AI batch, and sends it as one call
+    auto batchAI = [&]() {
+        while (auto frame = decoded.pop()) {
+            std::vector<Frame> batch;
+            batch.push_back(std::move(*frame));
+            while (needs_ai && batch.size() < options.ai_batch_size) {
+                auto more = decoded.tryPop();
+                if (!more) {
+                    break;
+                }
+                batch.push_back(std::move(*more));
+            }
+            if (needs_ai) {
+                requestAI(batch);
+            }
+            for (auto& item : batch) {
+                ready.push(std::move(item));
+            }
+        }
+    };
+    
+    auto compute = [&]() {
+        while (auto frame = ready.pop()) {
+            if (frame->error_message.empty()) {
+                try {
+                    frame->image = apply(frame->image, buildOperations(recipe, frame->image.size()));
+                } catch (const cv::Exception& e) {
+                    frame->error_message = e.what();
+                }
+            }
+            processed.push(std::move(*frame));
+        }
+    };
+    
+    auto encode = [&]() {
+        while (auto frame = processed.pop()) {
+            Result& result = results[frame->index];
+            result.credits_used = frame->credits_used;
+            result.error_message = frame->error_message;
+            if (result.error_message.empty()) {
+                try {
+                    result.success = cv::imwrite(result.output, frame->image);
+                } catch (const cv::Exception& e) {
+                    result.error_message = e.what();
+                }
+                if (!result.success && result.error_message.empty()) {
+                    result.error_message = "Failed to encode " + result.output;
+                }
+            }
+            frame->image.release();
+            slots.release();
+            
+            size_t done = ++finished;
+            if (on_progress) {
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                on_progress(result, done, jobs.size());
+            }
+        }
+    };
+    
+    auto launch = [](size_t count, const std::function<void()>& stage) {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < std::max<size_t>(count, 1); ++i) {
+            threads.emplace_back(stage);
+        }
+        return threads;
+    };
+    auto join = [](std::vector<std::thread>& threads) {
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+    
+    auto decoders = launch(options.decode_threads, decode);
+    auto batcher = launch(1, batchAI);
+    auto workers = launch(compute_threads, compute);
+    auto encoders = launch(options.encode_threads, encode);
+    
+    // Each stage ends once its input is closed and drained
+    join(decoders);
+    decoded.close();
+    join(batcher);
+    ready.close();
+    join(workers);
+    processed.close();
+    join(encoders);
+    return results;
+}
+
+} // namespace xeno::image
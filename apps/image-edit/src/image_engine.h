@@ -0,0 +1,84 @@
+#pragma once
+
+#include "image_graph.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../../shared/ai-integration/include/ai_integration.h"
+
+namespace xeno::image {
+
+/**
+ * @brief Ordered list of edits applied to every file of a batch
+ *
+ * JSON form: {"steps": [{"op": "enhance"}, {"op": "inpaint", "radius": 50}, ...]}.
+ * Operations: "enhance", "brightness_contrast" (brightness, contrast),
+ * "inpaint" (x, y, radius; centred by default) and "generative_fill"
+ * (prompt), which needs a successful AI call per file.
+ */
+struct Recipe {
+    struct Step {
+        std::string operation;
+        nlohmann::json parameters = nlohmann::json::object();
+    };
+    
+    std::vector<Step> steps;
+    
+    bool loadFromFile(const std::string& path);
+    bool loadFromJSON(const nlohmann::json& json);
+    bool needsAI() const;
+};
+
+/**
+ * @brief GUI-free image processing for batch and headless use
+ *
+ * run() is a pipeline of decode, AI, compute and encode stages joined by
+ * bounded queues, so file I/O overlaps with processing. At most
+ * max_in_flight images are held in memory at any time. AI steps for
+ * several files are sent through AIIntegration as one batch.
+ */
+class ImageEngine {
+public:
+    struct Options {
+        size_t decode_threads = 2;
+        size_t compute_threads = 0;   // 0 = one per hardware thread
+        size_t encode_threads = 2;
+        size_t max_in_flight = 8;     // Decoded images alive at once
+        size_t ai_batch_size = 8;     // Files whose AI steps share one batch call
+    };
+    
+    struct Job {
+        std::string input;
+        std::string output;
+    };
+    
+    struct Result {
+        std::string input;
+        std::string output;
+        bool success = false;
+        std::string error_message;
+        int credits_used = 0;
+    };
+    
+    // Called on a pipeline thread as each file finishes
+    using ProgressCallback = std::function<void(const Result& result, size_t finished, size_t total)>;
+    
+    ImageEngine(ai::AIIntegration& ai_integration, const Options& options);
+    
+    // Operations for one image of the given size; unknown steps are skipped
+    static std::vector<Operation> buildOperations(const Recipe& recipe, cv::Size size);
+    // Applies operations in order to a copy of image
+    static cv::Mat apply(const cv::Mat& image, const std::vector<Operation>& operations);
+    
+    // Processes every job; results are in job order
+    std::vector<Result> run(const Recipe& recipe, const std::vector<Job>& jobs, ProgressCallback on_progress = nullptr);
+
+private:
+    ai::AIIntegration& ai_integration;
+    Options options;
+};
+
+} // namespace xeno::image
@@ -0,0 +1,240 @@
+#include "image_graph.h"
+#include "../../shared/utils/include/metrics.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace xeno::image {
+
+namespace {
+
+cv::Rect unite(const cv::Rect& a, const cv::Rect& b) {
+    if (a.empty()) {
+        return b;
+    }
+    if (b.empty()) {
+        return a;
+    }
+    return a | b;
+}
+
+} // namespace
+
+void applyOperation(const Operation& operation, const cv::Mat& input, cv::Mat& output) {
+    if (!operation.apply) {
+        input.copyTo(output);
+        return;
+    }
+    
+    cv::Rect bounds(0, 0, input.cols, input.rows);
+    cv::Rect region = operation.region.empty() ? bounds : operation.region & bounds;
+    output.create(input.size(), input.type());
+    if (region.size() != input.size()) {
+        input.copyTo(output);
+    }
+    processTiles(input, output, region, operation.halo, operation.apply);
+}
+
+ImageGraph::ImageGraph(size_t cache_budget) : cache_budget(cache_budget) {
+    nodes.emplace_back();
+    nodes.back().id = next_id++;
+    nodes.back().operation.name = "adjustment";
+}
+
+void ImageGraph::setSource(const cv::Mat& image) {
+    source = image.clone();
+    Node adjustment;
+    adjustment.id = next_id++;
+    adjustment.operation.name = "adjustment";
+    nodes.clear();
+    nodes.push_back(std::move(adjustment));
+    history.clear();
+    history_position = 0;
+    changed_region = cv::Rect();
+}
+
+ImageGraph::NodeId ImageGraph::addNode(Operation operation) {
+    Node node;
+    node.id = next_id++;
+    node.operation = std::move(operation);
+    node.enabled = false; // Enabled by the command below
+    nodes.insert(nodes.end() - 1, std::move(node));
+    
+    size_t index = nodes.size() - 2;
+    pushCommand({Command::Kind::Add, index, {}, {}});
+    return nodes[index].id;
+}
+
+void ImageGraph::setAdjustment(Operation operation, bool merge) {
+    size_t index = nodes.size() - 1;
+    if (merge && canUndo() && !canRedo() && history.back().kind == Command::Kind::Adjust) {
+        // Keep the step's original "before" so one undo reverts the whole drag
+        Command& last = history.back();
+        cv::Rect region = unite(resolve(last.after.region), resolve(operation.region));
+        last.after = operation;
+        nodes[index].operation = std::move(operation);
+        nodeChanged(index, region);
+        return;
+    }
+    pushCommand({Command::Kind::Adjust, index, nodes[index].operation, std::move(operation)});
+}
+
+void ImageGraph::pushCommand(Command command) {
+    // A new edit discards the redo steps; nodes they would re-enable are disabled and can go
+    size_t restored = 0;
+    for (size_t i = history_position; i < history.size(); ++i) {
+        if (history[i].kind == Command::Kind::Add) {
+            ++restored;
+        }
+    }
+    history.erase(history.begin() + history_position, history.end());
+    if (restored > 0) {
+        // Undone additions are always the newest edit nodes, right before the node the
+        // new command targets (a just added node, or the adjustment)
+        nodes.erase(nodes.begin() + (command.node - restored), nodes.begin() + command.node);
+        command.node -= restored;
+    }
+    
+    history.push_back(std::move(command));
+    apply(history.back(), true);
+    ++history_position;
+}
+
+bool ImageGraph::undo() {
+    if (!canUndo()) {
+        return false;
+    }
+    --history_position;
+    apply(history[history_position], false);
+    return true;
+}
+
+bool ImageGraph::redo() {
+    if (!canRedo()) {
+        return false;
+    }
+    apply(history[history_position], true);
+    ++history_position;
+    return true;
+}
+
+void ImageGraph::apply(const Command& command, bool forward) {
+    if (command.kind == Command::Kind::Add) {
+        Node& node = nodes[command.node];
+        node.enabled = forward;
+        nodeChanged(command.node, resolve(node.operation.region));
+        return;
+    }
+    
+    // Edits added since are inserted before the adjustment, so it is addressed as the last node
+    cv::Rect region = unite(resolve(command.before.region), resolve(command.after.region));
+    nodes.back().operation = forward ? command.after : command.before;
+    nodeChanged(nodes.size() - 1, region);
+}
+
+cv::Rect ImageGraph::resolve(const cv::Rect& region) const {
+    cv::Rect bounds(0, 0, source.cols, source.rows);
+    return region.empty() ? bounds : region & bounds;
+}
+
+void ImageGraph::nodeChanged(size_t index, const cv::Rect& region) {
+    for (size_t i = index; i < nodes.size(); ++i) {
+        nodes[i].valid = false;
+    }
+    
+    // Follow the change downstream: a node spreads it by its halo, but only within its own region
+    cv::Rect changed = region;
+    for (size_t i = index + 1; i < nodes.size() && !changed.empty(); ++i) {
+        const Node& node = nodes[i];
+        if (!node.enabled || !node.operation.apply) {
+            continue;
+        }
+        cv::Rect node_region = resolve(node.operation.region);
+        cv::Rect reach = node.operation.halo < 0
+            ? ((changed & node_region).empty() ? cv::Rect() : node_region)
+            : cv::Rect(changed.x - node.operation.halo, changed.y - node.operation.halo,
+                       changed.width + 2 * node.operation.halo, changed.height + 2 * node.operation.halo) & node_region;
+        changed = unite(changed, reach);
+    }
+    changed_region = unite(changed_region, changed);
+}
+
+void ImageGraph::evaluateNode(Node& node, const cv::Mat& input) {
+    if (!node.enabled || !node.operation.apply) {
+        node.buffer.release();
+        node.result = input;
+        node.valid = true;
+        return;
+    }
+    
+    static xeno::utils::Histogram& node_latency = xeno::utils::Metrics::getInstance().histogram("image.node");
+    xeno::utils::TraceSpan span(node_latency);
+    applyOperation(node.operation, input, node.buffer);
+    node.result = node.buffer;
+    node.valid = true;
+}
+
+const cv::Mat& ImageGraph::output() {
+    if (nodes.back().valid) {
+        return nodes.back().result;
+    }
+    
+    // Only renders that run at least one node are timed; a current output costs nothing
+    static xeno::utils::Histogram& render_latency = xeno::utils::Metrics::getInstance().histogram("image.render");
+    xeno::utils::TraceSpan span(render_latency);
+    
+    // Resume from the newest result that is still current
+    size_t start = nodes.size();
+    while (start > 0 && !nodes[start - 1].valid) {
+        --start;
+    }
+    for (size_t i = start; i < nodes.size(); ++i) {
+        evaluateNode(nodes[i], i == 0 ? source : nodes[i - 1].result);
+    }
+    enforceBudget();
+    return nodes.back().result;
+}
+
+cv::Rect ImageGraph::takeChangedRegion() {
+    cv::Rect region = changed_region;
+    changed_region = cv::Rect();
+    return region;
+}
+
+void ImageGraph::enforceBudget() {
+    // The newest results are the likeliest to be resumed from (slider drags, undo of the
+    // last edit), so caches are kept from the output backwards until the budget runs out.
+    // Pass-through nodes share their input's pixels and cost nothing extra.
+    std::unordered_set<const uchar*> counted;
+    size_t total = 0;
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        if (!node.valid || node.result.empty() || !counted.insert(node.result.data).second) {
+            continue;
+        }
+        if (node.result.data == source.data) {
+            continue;
+        }
+        size_t bytes = node.result.total() * node.result.elemSize();
+        if (i + 1 < nodes.size() && total + bytes > cache_budget) {
+            node.buffer.release();
+            node.result.release();
+            node.valid = false;
+            continue;
+        }
+        total += bytes;
+    }
+}
+
+size_t ImageGraph::cachedBytes() const {
+    std::unordered_set<const uchar*> counted;
+    size_t total = 0;
+    for (const auto& node : nodes) {
+        if (node.valid && !node.result.empty() && node.result.data != source.data &&
+            counted.insert(node.result.data).second) {
+            total += node.result.total() * node.result.elemSize();
+        }
+    }
+    return total;
+}
+
+} // namespace xeno::image
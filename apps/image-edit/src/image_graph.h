@@ -0,0 +1,103 @@
+#pragma once
+
+#include "tiled_image.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xeno::image {
+
+/**
+ * @brief One edit in an ImageGraph
+ *
+ * Operations never modify their input; they are re-run from cached results
+ * whenever something upstream of them changes.
+ */
+struct Operation {
+    std::string name;
+    std::map<std::string, double> parameters; // Values the operation was built from, e.g. slider positions
+    cv::Rect region;                          // Pixels the operation changes; empty means the whole image
+    int halo = 0;                             // Neighbouring pixels each tile reads; -1 processes region in one piece
+    TiledImage::HaloOp apply;                 // Empty for an operation that leaves the image unchanged
+};
+
+// Writes operation applied to input into output, reusing output's buffer when it fits;
+// output must not share input's pixels
+void applyOperation(const Operation& operation, const cv::Mat& input, cv::Mat& output);
+
+/**
+ * @brief Non-destructive edit history, evaluated lazily
+ *
+ * The source image flows through a chain of operation nodes followed by one
+ * adjustment node driven by the brightness/contrast sliders. Each node caches
+ * its output, so a change re-runs only the nodes downstream of it; caches are
+ * dropped oldest-first once they exceed the memory budget. Undo and redo
+ * toggle nodes or swap adjustment parameters, so no image copies are kept
+ * for history.
+ */
+class ImageGraph {
+public:
+    using NodeId = uint64_t;
+    
+    static constexpr size_t kDefaultCacheBudget = size_t(1) << 30; // 1 GiB of cached node outputs
+    
+    explicit ImageGraph(size_t cache_budget = kDefaultCacheBudget);
+    
+    // Starts a new graph; clears nodes and history
+    void setSource(const cv::Mat& image);
+    bool empty() const { return source.empty(); }
+    
+    // Appends an operation before the adjustment node
+    NodeId addNode(Operation operation);
+    // Replaces the adjustment; merge folds the change into the previous
+    // adjustment step so a slider drag is undone in one go
+    void setAdjustment(Operation operation, bool merge = false);
+    const Operation& adjustment() const { return nodes.back().operation; }
+    
+    bool canUndo() const { return history_position > 0; }
+    bool canRedo() const { return history_position < history.size(); }
+    bool undo();
+    bool redo();
+    
+    // Result of all enabled nodes; recomputes only what changed since the last call
+    const cv::Mat& output();
+    // Part of output() that changed since the last call
+    cv::Rect takeChangedRegion();
+    
+    size_t cachedBytes() const;
+
+private:
+    struct Node {
+        NodeId id = 0;
+        Operation operation;
+        bool enabled = true;
+        cv::Mat buffer; // Owned output pixels, reused across evaluations
+        cv::Mat result; // buffer, or the input when the node passes it through
+        bool valid = false;
+    };
+    
+    struct Command {
+        enum class Kind { Add, Adjust } kind;
+        size_t node = 0;
+        Operation before;
+        Operation after;
+    };
+    
+    void pushCommand(Command command);
+    void apply(const Command& command, bool forward);
+    void nodeChanged(size_t index, const cv::Rect& region);
+    cv::Rect resolve(const cv::Rect& region) const;
+    void evaluateNode(Node& node, const cv::Mat& input);
+    void enforceBudget();
+    
+    cv::Mat source;
+    std::vector<Node> nodes; // Edits in order; the adjustment node is always last
+    NodeId next_id = 1;
+    std::vector<Command> history;
+    size_t history_position = 0;
+    cv::Rect changed_region;
+    size_t cache_budget;
+};
+
+} // namespace xeno::image
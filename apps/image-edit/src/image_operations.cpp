@@ -0,0 +1,93 @@
+#include "image_operations.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/photo.hpp>
+
+#include "../../shared/media-kernels/include/media_kernels.h"
+
+namespace xeno::image::ops {
+
+namespace {
+
+// Runs an 8-bit kernel over matching rows of views that need not be contiguous
+template <typename Kernel>
+void forEachRow(const cv::Mat& source, cv::Mat& result, Kernel kernel) {
+    result.create(source.size(), source.type());
+    size_t row_bytes = source.cols * source.elemSize();
+    for (int y = 0; y < source.rows; ++y) {
+        kernel(source.ptr<uint8_t>(y), result.ptr<uint8_t>(y), row_bytes, y);
+    }
+}
+
+// Contrast, brightness and gamma folded into one table lookup per byte
+Operation linear(const std::string& name, double alpha, double beta) {
+    Operation operation;
+    operation.name = name;
+    operation.parameters = {{"alpha", alpha}, {"beta", beta}};
+    operation.apply = [lut = xeno::media::makeLut(alpha, beta)](const cv::Mat& source, const cv::Rect& tile,
+                                                                cv::Mat& result) {
+        forEachRow(source(tile), result, [&](const uint8_t* in, uint8_t* out, size_t bytes, int) {
+            xeno::media::applyLut(in, out, bytes, lut);
+        });
+    };
+    return operation;
+}
+
+} // namespace
+
+Operation brightnessContrast(int brightness, int contrast) {
+    Operation operation = linear("brightness_contrast", 1.0 + contrast / 100.0, brightness);
+    operation.parameters["brightness"] = brightness;
+    operation.parameters["contrast"] = contrast;
+    if (brightness == 0 && contrast == 0) {
+        operation.apply = nullptr; // Identity; the node passes its input through
+    }
+    return operation;
+}
+
+Operation enhance() {
+    return linear("enhance", 1.2, 30); // alpha=1.2 (contrast), beta=30 (brightness)
+}
+
+Operation generativeFill() {
+    Operation operation;
+    operation.name = "generative_fill";
+    operation.halo = 7; // The 15x15 kernel reaches 7 pixels past each tile
+    operation.apply = [](const cv::Mat& source, const cv::Rect& tile, cv::Mat& result) {
+        cv::Mat filtered;
+        cv::GaussianBlur(source, filtered, cv::Size(15, 15), 0);
+        cv::Mat blurred = filtered(tile);
+        forEachRow(source(tile), result, [&](const uint8_t* in, uint8_t* out, size_t bytes, int y) {
+            xeno::media::blend(in, blurred.ptr<uint8_t>(y), out, bytes, 0.7f);
+        });
+    };
+    return operation;
+}
+
+Operation inpaintCircle(cv::Point center, int radius, int inpaint_radius) {
+    Operation operation;
+    operation.name = "inpaint";
+    operation.parameters["x"] = center.x;
+    operation.parameters["y"] = center.y;
+    operation.parameters["radius"] = radius;
+    
+    // The hole plus the band inpainting reads from, processed in one piece
+    int reach = radius + inpaint_radius + 1;
+    operation.region = cv::Rect(center.x - reach, center.y - reach, 2 * reach, 2 * reach);
+    operation.halo = -1;
+    operation.apply = [center, radius, inpaint_radius](const cv::Mat& source, const cv::Rect& tile, cv::Mat& result) {
+        // source is a view of the (clamped) region; find where it sits in the image
+        cv::Size whole;
+        cv::Point offset;
+        source.locateROI(whole, offset);
+        
+        cv::Mat mask = cv::Mat::zeros(source.size(), CV_8UC1);
+        cv::circle(mask, center - offset, radius, cv::Scalar(255), -1);
+        
+        cv::Mat filled;
+        cv::inpaint(source, mask, filled, inpaint_radius, cv::INPAINT_TELEA);
+        filled(tile).copyTo(result);
+    };
+    return operation;
+}
+
+} // namespace xeno::image::ops
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "image_graph.h"
+
+namespace xeno::image::ops {
+
+// Slider-driven brightness (-100..100, pixel offset) and contrast (-100..100, percent gain)
+Operation brightnessContrast(int brightness, int contrast);
+
+// One-click enhancement used by "AI Enhance"
+Operation enhance();
+
+// Local stand-in for the generative fill result: a soft Gaussian blend
+Operation generativeFill();
+
+// Fills a circular hole from its surroundings; only the hole's neighbourhood is processed
+Operation inpaintCircle(cv::Point center, int radius, int inpaint_radius = 3);
+
+} // namespace xeno::image::ops
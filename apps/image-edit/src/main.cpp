@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QAction>
 #include <QMainWindow>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -6,7 +7,8 @@
 #include <QLabel>
 #include <QGraphicsView>
 #include <QGraphicsScene>
-#include <QGraphicsPixmapItem>
+#include <QGraphicsItem>
+#include <QPainter>
 #include <QFileDialog>
 #include <QMenuBar>
 #include <QToolBar>
@@ -17,12 +19,49 @@
 #include <QSpinBox>
 #include <QGroupBox>
 #include <QSlider>
+#include <QPointer>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QSignalBlocker>
 #include <opencv2/opencv.hpp>
+#include <cmath>
+#include <map>
 #include <memory>
 
+#include "image_graph.h"
+#include "image_operations.h"
+#include "tiled_image.h"
+
+#include "../../shared/ai-integration/include/ai_broker.h"
 #include "../../shared/ai-integration/include/ai_integration.h"
 #include "../../shared/utils/include/utils.h"
 
+/**
+ * @brief Displays one tile straight from the display pyramid
+ *
+ * The QImage wraps the tile's BGRA pixels in place; on little-endian hosts
+ * that is Qt's native ARGB32 layout, so painting needs no conversion and
+ * an edit only has to schedule a repaint.
+ */
+class TileItem : public QGraphicsItem {
+public:
+    explicit TileItem(const cv::Mat& pixels)
+        : image(pixels.data, pixels.cols, pixels.rows, static_cast<qsizetype>(pixels.step),
+                QImage::Format_ARGB32_Premultiplied) {}
+    
+    QRectF boundingRect() const override {
+        return QRectF(0, 0, image.width(), image.height());
+    }
+    
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*) override {
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawImage(QPointF(0, 0), image);
+    }
+
+private:
+    QImage image; // Read-only view; the pixels stay owned by the TiledImage
+};
+
 class ImageEditWindow : public QMainWindow {
     Q_OBJECT
 
@@ -45,6 +84,19 @@ public:
         statusBar()->showMessage("Ready - Integrate with Xeno Labs credit wallet");
     }
 
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        // Wheel zooms the view; the pyramid level follows the zoom
+        if (watched == graphics_view->viewport() && event->type() == QEvent::Wheel) {
+            auto wheel = static_cast<QWheelEvent*>(event);
+            double factor = std::pow(1.25, wheel->angleDelta().y() / 120.0);
+            graphics_view->scale(factor, factor);
+            updateImageDisplay();
+            return true;
+        }
+        return QMainWindow::eventFilter(watched, event);
+    }
+
 private slots:
     void openImage() {
         QString filename = QFileDialog::getOpenFileName(this,
@@ -56,7 +108,7 @@ private slots:
     }
     
     void saveImage() {
-        if (current_image.empty()) {
+        if (image.empty()) {
             QMessageBox::warning(this, "Warning", "No image to save!");
             return;
         }
@@ -65,13 +117,13 @@ private slots:
             "Save Image", "", "Images (*.png *.jpg *.jpeg *.bmp *.tiff)");
         
         if (!filename.isEmpty()) {
-            cv::imwrite(filename.toStdString(), current_image);
+            cv::imwrite(filename.toStdString(), graph.output());
             statusBar()->showMessage("Image saved successfully");
         }
     }
     
     void applyGenerativeFill() {
-        if (current_image.empty()) {
+        if (image.empty()) {
             QMessageBox::warning(this, "Warning", "Please load an image first!");
             return;
         }
@@ -85,34 +137,42 @@ private slots:
             return;
         }
         
-        QProgressDialog progress("Applying AI Generative Fill...", "Cancel", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
-        
-        // Simulate AI processing
-        for (int i = 0; i <= 100; i += 10) {
-            progress.setValue(i);
-            QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                return;
-            }
-            QThread::msleep(100);
-        }
+        auto progress = new QProgressDialog("Applying AI Generative Fill...", "Cancel", 0, 0, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
         
-        // Make AI API call
+        // Make AI API call off the UI thread; the result is applied back on it
         xeno::ai::AIIntegration::AIRequest request;
         request.prompt = "Apply generative fill to enhance image";
         request.operation_type = "generative_fill";
         
-        auto response = ai_integration->generateImage(request);
+        QPointer<QProgressDialog> dialog(progress);
+        auto task = ai_integration->generateImageAsync(request, xeno::ai::AIIntegration::AIProvider::Auto,
+            [this, dialog](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, dialog, response]() {
+                    if (dialog) {
+                        dialog->close();
+                    }
+                    finishGenerativeFill(response);
+                }, Qt::QueuedConnection);
+            });
+        
+        connect(progress, &QProgressDialog::canceled, this, [task]() { task.cancel(); });
+    }
+    
+    void finishGenerativeFill(const xeno::ai::AIIntegration::AIResponse& response) {
+        if (response.metadata.value("cancelled", false)) {
+            statusBar()->showMessage("Generative fill cancelled");
+            return;
+        }
         
         if (response.success) {
             // Apply a simple filter as simulation (in production, this would be the AI result)
-            cv::Mat filtered;
-            cv::GaussianBlur(current_image, filtered, cv::Size(15, 15), 0);
-            cv::addWeighted(current_image, 0.7, filtered, 0.3, 0, current_image);
+            graph.addNode(xeno::image::ops::generativeFill());
             
-            updateImageDisplay();
+            renderGraph();
+            updateCreditDisplay();
             statusBar()->showMessage(QString("Generative fill applied - %1 credits used")
                 .arg(response.credits_used));
         } else {
@@ -122,7 +182,7 @@ private slots:
     }
     
     void removeObject() {
-        if (current_image.empty()) {
+        if (image.empty()) {
             QMessageBox::warning(this, "Warning", "Please load an image first!");
             return;
         }
@@ -135,14 +195,10 @@ private slots:
         }
         
         // Simulate object removal with inpainting
-        cv::Mat mask = cv::Mat::zeros(current_image.size(), CV_8UC1);
-        cv::circle(mask, cv::Point(current_image.cols/2, current_image.rows/2), 50, cv::Scalar(255), -1);
+        cv::Point center(image.size().width / 2, image.size().height / 2);
+        graph.addNode(xeno::image::ops::inpaintCircle(center, 50));
         
-        cv::Mat result;
-        cv::inpaint(current_image, mask, result, 3, cv::INPAINT_TELEA);
-        current_image = result;
-        
-        updateImageDisplay();
+        renderGraph();
         
         // Deduct credits
         ai_integration->deductCredits(required_credits);
@@ -150,19 +206,44 @@ private slots:
     }
     
     void enhanceImage() {
-        if (current_image.empty()) {
+        if (image.empty()) {
             QMessageBox::warning(this, "Warning", "Please load an image first!");
             return;
         }
         
         // Apply basic enhancement (contrast, brightness)
-        cv::Mat enhanced;
-        current_image.convertTo(enhanced, -1, 1.2, 30); // alpha=1.2 (contrast), beta=30 (brightness)
-        current_image = enhanced;
+        graph.addNode(xeno::image::ops::enhance());
         
-        updateImageDisplay();
+        renderGraph();
         statusBar()->showMessage("Image enhanced");
     }
+    
+    void applyAdjustments() {
+        if (graph.empty()) {
+            return;
+        }
+        
+        // Every step of a slider drag after the first folds into one undo step
+        auto adjustment = xeno::image::ops::brightnessContrast(brightness_slider->value(), contrast_slider->value());
+        graph.setAdjustment(std::move(adjustment), adjustment_drag_open);
+        adjustment_drag_open = brightness_slider->isSliderDown() || contrast_slider->isSliderDown();
+        
+        renderGraph();
+    }
+    
+    void undo() {
+        if (graph.undo()) {
+            syncAdjustmentSliders();
+            renderGraph();
+        }
+    }
+    
+    void redo() {
+        if (graph.redo()) {
+            syncAdjustmentSliders();
+            renderGraph();
+        }
+    }
 
 private:
     void setupUI() {
@@ -176,6 +257,8 @@ private:
         graphics_scene = new QGraphicsScene;
         graphics_view->setScene(graphics_scene);
         graphics_view->setDragMode(QGraphicsView::ScrollHandDrag);
+        graphics_view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+        graphics_view->viewport()->installEventFilter(this);
         
         main_layout->addWidget(graphics_view, 3);
         
@@ -209,12 +292,12 @@ private:
         auto traditional_layout = new QVBoxLayout(traditional_group);
         
         auto brightness_label = new QLabel("Brightness:");
-        auto brightness_slider = new QSlider(Qt::Horizontal);
+        brightness_slider = new QSlider(Qt::Horizontal);
         brightness_slider->setRange(-100, 100);
         brightness_slider->setValue(0);
         
         auto contrast_label = new QLabel("Contrast:");
-        auto contrast_slider = new QSlider(Qt::Horizontal);
+        contrast_slider = new QSlider(Qt::Horizontal);
         contrast_slider->setRange(-100, 100);
         contrast_slider->setValue(0);
         
@@ -239,6 +322,13 @@ private:
         connect(object_removal_btn, &QPushButton::clicked, this, &ImageEditWindow::removeObject);
         connect(enhance_btn, &QPushButton::clicked, this, &ImageEditWindow::enhanceImage);
         
+        // Sliders drive the graph's adjustment node; a new drag starts a new undo step
+        for (auto slider : {brightness_slider, contrast_slider}) {
+            connect(slider, &QSlider::valueChanged, this, &ImageEditWindow::applyAdjustments);
+            connect(slider, &QSlider::sliderPressed, this, [this]() { adjustment_drag_open = false; });
+            connect(slider, &QSlider::sliderReleased, this, [this]() { adjustment_drag_open = false; });
+        }
+        
         // Update credit display
         updateCreditDisplay();
     }
@@ -251,8 +341,9 @@ private:
         file_menu->addAction("&Quit", this, &QWidget::close, QKeySequence::Quit);
         
         auto edit_menu = menuBar()->addMenu("&Edit");
-        edit_menu->addAction("&Undo", []() { /* TODO */ }, QKeySequence::Undo);
-        edit_menu->addAction("&Redo", []() { /* TODO */ }, QKeySequence::Redo);
+        undo_action = edit_menu->addAction("&Undo", this, &ImageEditWindow::undo, QKeySequence::Undo);
+        redo_action = edit_menu->addAction("&Redo", this, &ImageEditWindow::redo, QKeySequence::Redo);
+        updateEditActions();
         
         auto ai_menu = menuBar()->addMenu("&AI Tools");
         ai_menu->addAction("Generative Fill", this, &ImageEditWindow::applyGenerativeFill);
@@ -270,39 +361,128 @@ private:
     }
     
     void setupConnections() {
-        // Additional connections can be added here
+        // Panning brings new tiles into view
+        connect(graphics_view->horizontalScrollBar(), &QScrollBar::valueChanged, this, &ImageEditWindow::updateImageDisplay);
+        connect(graphics_view->verticalScrollBar(), &QScrollBar::valueChanged, this, &ImageEditWindow::updateImageDisplay);
     }
     
     void loadConfiguration() {
+        // With the launcher running, AI requests and credits go through its shared service and the
+        // config here only takes over if the launcher quits
+        ai_integration->connectToBroker(xeno::ai::AIBroker::defaultAddress());
         std::string config_path = xeno::utils::Platform::getAppDataPath() + "/config.json";
         ai_integration->loadConfigFromFile(config_path);
     }
     
     void loadImage(const QString& filename) {
-        current_image = cv::imread(filename.toStdString());
-        if (current_image.empty()) {
+        cv::Mat loaded = cv::imread(filename.toStdString());
+        if (loaded.empty()) {
             QMessageBox::critical(this, "Error", "Failed to load image!");
             return;
         }
         
+        // Display tiles are opaque BGRA so Qt can paint them without converting
+        cv::Mat display;
+        cv::cvtColor(loaded, display, cv::COLOR_BGR2BGRA);
+        image.assign(std::move(display));
+        graph.setSource(loaded);
+        syncAdjustmentSliders();
+        updateEditActions();
+        clearTiles();
+        graphics_scene->setSceneRect(0, 0, loaded.cols, loaded.rows);
+        graphics_view->fitInView(graphics_scene->sceneRect(), Qt::KeepAspectRatio);
+        
         updateImageDisplay();
         statusBar()->showMessage("Image loaded: " + filename);
     }
     
+    void renderGraph() {
+        // Only the part of the result that changed is written into the display tiles
+        const cv::Mat& result = graph.output();
+        cv::Rect changed = graph.takeChangedRegion();
+        image.editRegion(changed, [&](cv::Mat& pixels) { cv::cvtColor(result(changed), pixels, cv::COLOR_BGR2BGRA); });
+        
+        updateImageDisplay();
+        updateEditActions();
+    }
+    
+    void syncAdjustmentSliders() {
+        const auto& parameters = graph.adjustment().parameters;
+        auto value = [&](const char* name) {
+            auto it = parameters.find(name);
+            return it != parameters.end() ? static_cast<int>(it->second) : 0;
+        };
+        
+        QSignalBlocker brightness_blocker(brightness_slider);
+        QSignalBlocker contrast_blocker(contrast_slider);
+        brightness_slider->setValue(value("brightness"));
+        contrast_slider->setValue(value("contrast"));
+    }
+    
+    void updateEditActions() {
+        undo_action->setEnabled(graph.canUndo());
+        redo_action->setEnabled(graph.canRedo());
+    }
+    
     void updateImageDisplay() {
-        if (current_image.empty()) return;
+        if (image.empty()) return;
         
-        // Convert OpenCV Mat to QPixmap
-        cv::Mat rgb_image;
-        cv::cvtColor(current_image, rgb_image, cv::COLOR_BGR2RGB);
+        // Render the pyramid level matching the zoom; switching levels drops the old tiles
+        int level = image.levelForScale(graphics_view->transform().m11());
+        if (level != display_level) {
+            clearTiles();
+            display_level = level;
+        }
+        
+        // Edited tiles on screen already show the new pixels; they only need repainting
+        const cv::Mat& pixels = image.level(level);
+        for (const auto& tile : image.takeDirtyTiles(level)) {
+            auto it = tile_items.find(tile);
+            if (it != tile_items.end()) {
+                it->second->update();
+            }
+        }
         
-        QImage qimg(rgb_image.data, rgb_image.cols, rgb_image.rows, rgb_image.step, QImage::Format_RGB888);
-        QPixmap pixmap = QPixmap::fromImage(qimg);
+        // Keep only the tiles in view; scene coordinates are full-resolution pixels
+        double factor = std::ldexp(1.0, level);
+        double span = xeno::image::TiledImage::kTileSize * factor;
+        QRectF visible = graphics_view->mapToScene(graphics_view->viewport()->rect()).boundingRect();
+        int first_col = std::max(0, static_cast<int>(std::floor(visible.left() / span)));
+        int last_col = std::min(image.tileCols(level) - 1, static_cast<int>(std::floor(visible.right() / span)));
+        int first_row = std::max(0, static_cast<int>(std::floor(visible.top() / span)));
+        int last_row = std::min(image.tileRows(level) - 1, static_cast<int>(std::floor(visible.bottom() / span)));
+        
+        for (auto it = tile_items.begin(); it != tile_items.end();) {
+            const auto& tile = it->first;
+            if (tile.col < first_col || tile.col > last_col || tile.row < first_row || tile.row > last_row) {
+                delete it->second;
+                it = tile_items.erase(it);
+            } else {
+                ++it;
+            }
+        }
         
-        graphics_scene->clear();
-        graphics_scene->addPixmap(pixmap);
-        graphics_scene->setSceneRect(pixmap.rect());
-        graphics_view->fitInView(graphics_scene->itemsBoundingRect(), Qt::KeepAspectRatio);
+        for (int row = first_row; row <= last_row; ++row) {
+            for (int col = first_col; col <= last_col; ++col) {
+                xeno::image::TileId tile{level, col, row};
+                if (tile_items.count(tile)) {
+                    continue;
+                }
+                auto item = new TileItem(pixels(image.tileRect(tile)));
+                graphics_scene->addItem(item);
+                item->setScale(factor);
+                item->setPos(col * span, row * span);
+                tile_items[tile] = item;
+            }
+        }
+    }
+    
+    void clearTiles() {
+        for (const auto& [tile, item] : tile_items) {
+            delete item;
+        }
+        tile_items.clear();
+        display_level = -1;
     }
     
     void updateCreditDisplay() {
@@ -318,12 +498,20 @@ private:
 
 private:
     std::unique_ptr<xeno::ai::AIIntegration> ai_integration;
-    cv::Mat current_image;
+    xeno::image::TiledImage image;
+    std::map<xeno::image::TileId, TileItem*> tile_items; // Tiles of display_level in view
+    int display_level = -1;
+    xeno::image::ImageGraph graph;
+    bool adjustment_drag_open = false; // Next slider change merges into the current undo step
     
     // UI elements
     QGraphicsView* graphics_view;
     QGraphicsScene* graphics_scene;
     QLabel* credit_status;
+    QSlider* brightness_slider;
+    QSlider* contrast_slider;
+    QAction* undo_action;
+    QAction* redo_action;
 };
 
 int main(int argc, char *argv[]) {
@@ -333,6 +521,12 @@ int main(int argc, char *argv[]) {
     QApplication::setApplicationVersion("1.0.0");
     QApplication::setOrganizationName("Xeno AI");
     
+    // Log to <app data>/logs/image-edit.log as well as the console
+    xeno::utils::Logger::Options log_options;
+    log_options.file_name = "image-edit";
+    xeno::utils::Logger::getInstance().configure(log_options);
+    // Edits to config.json apply without a restart
+    xeno::utils::ConfigManager::getInstance().watch();
     xeno::utils::Logger::getInstance().info("Starting Xeno Image Edit");
     
     ImageEditWindow window;
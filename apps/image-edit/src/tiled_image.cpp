@@ -0,0 +1,191 @@
+#include "tiled_image.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace xeno::image {
+
+namespace {
+
+int tileCount(int pixels) {
+    return (pixels + TiledImage::kTileSize - 1) / TiledImage::kTileSize;
+}
+
+// Region of the next level covering a region of this one, rounded outwards
+cv::Rect halveRegion(const cv::Rect& region, const cv::Size& next_size) {
+    int x0 = region.x / 2;
+    int y0 = region.y / 2;
+    int x1 = std::min((region.x + region.width + 1) / 2, next_size.width);
+    int y1 = std::min((region.y + region.height + 1) / 2, next_size.height);
+    return cv::Rect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+}
+
+} // namespace
+
+TiledImage::TiledImage(cv::Mat image) {
+    assign(std::move(image));
+}
+
+void TiledImage::assign(cv::Mat image) {
+    levels.clear();
+    pending_regions.clear();
+    dirty_tiles.clear();
+    if (image.empty()) {
+        return;
+    }
+    
+    // Tiles are views into one contiguous buffer, so whole-image operations stay cheap
+    levels.push_back(image.isContinuous() ? image : image.clone());
+    cv::Size size = image.size();
+    while (std::max(size.width, size.height) > kTileSize) {
+        size = cv::Size((size.width + 1) / 2, (size.height + 1) / 2);
+        levels.emplace_back(size, image.type());
+    }
+    markDirty(cv::Rect(0, 0, image.cols, image.rows));
+}
+
+cv::Rect TiledImage::clampRegion(cv::Rect region) const {
+    cv::Rect bounds(0, 0, levels[0].cols, levels[0].rows);
+    if (region.empty()) {
+        return bounds;
+    }
+    return region & bounds;
+}
+
+void TiledImage::editRegion(const cv::Rect& region, const RegionOp& op) {
+    if (empty() || region.empty()) {
+        return;
+    }
+    cv::Rect clamped = clampRegion(region);
+    if (clamped.empty()) {
+        return;
+    }
+    cv::Mat view = levels[0](clamped);
+    op(view);
+    markDirty(clamped);
+}
+
+void TiledImage::markDirty(const cv::Rect& region) {
+    if (empty() || region.empty()) {
+        return;
+    }
+    cv::Rect clamped = clampRegion(region);
+    if (clamped.empty()) {
+        return;
+    }
+    pending_regions.push_back(clamped);
+    
+    cv::Rect level_region = clamped;
+    for (int index = 0; index < levelCount(); ++index) {
+        if (index > 0) {
+            level_region = halveRegion(level_region, levels[index].size());
+        }
+        if (level_region.empty()) {
+            break;
+        }
+        for (int row = level_region.y / kTileSize; row < tileCount(level_region.y + level_region.height); ++row) {
+            for (int col = level_region.x / kTileSize; col < tileCount(level_region.x + level_region.width); ++col) {
+                dirty_tiles.insert({index, col, row});
+            }
+        }
+    }
+}
+
+void TiledImage::updatePyramid() {
+    // Each level is downsampled from the one above it, restricted to the edited regions
+    for (const auto& region : pending_regions) {
+        cv::Rect source_region = region;
+        for (int index = 1; index < levelCount(); ++index) {
+            const cv::Mat& source = levels[index - 1];
+            cv::Rect target_region = halveRegion(source_region, levels[index].size());
+            if (target_region.empty()) {
+                break;
+            }
+            cv::Rect from(target_region.x * 2, target_region.y * 2,
+                          std::min(target_region.width * 2, source.cols - target_region.x * 2),
+                          std::min(target_region.height * 2, source.rows - target_region.y * 2));
+            cv::Mat target = levels[index](target_region);
+            cv::resize(source(from), target, target_region.size(), 0, 0, cv::INTER_AREA);
+            source_region = target_region;
+        }
+    }
+    pending_regions.clear();
+}
+
+const cv::Mat& TiledImage::level(int index) {
+    if (!pending_regions.empty()) {
+        updatePyramid();
+    }
+    return levels[std::clamp(index, 0, levelCount() - 1)];
+}
+
+int TiledImage::levelForScale(double view_scale) const {
+    if (empty() || view_scale <= 0.0) {
+        return 0;
+    }
+    // Level k holds one pixel per 2^k image pixels
+    int index = static_cast<int>(std::floor(std::log2(1.0 / view_scale)));
+    return std::clamp(index, 0, levelCount() - 1);
+}
+
+int TiledImage::tileCols(int level) const {
+    return tileCount(levels[level].cols);
+}
+
+int TiledImage::tileRows(int level) const {
+    return tileCount(levels[level].rows);
+}
+
+cv::Rect TiledImage::tileRect(const TileId& tile) const {
+    const cv::Mat& mat = levels[tile.level];
+    cv::Rect rect(tile.col * kTileSize, tile.row * kTileSize, kTileSize, kTileSize);
+    return rect & cv::Rect(0, 0, mat.cols, mat.rows);
+}
+
+std::vector<TileId> TiledImage::takeDirtyTiles(int level) {
+    std::vector<TileId> tiles;
+    auto first = dirty_tiles.lower_bound({level, 0, 0});
+    auto last = dirty_tiles.lower_bound({level + 1, 0, 0});
+    tiles.assign(first, last);
+    dirty_tiles.erase(first, last);
+    return tiles;
+}
+
+void processTiles(const cv::Mat& source, cv::Mat& destination, const cv::Rect& region, int halo,
+                  const TiledImage::HaloOp& op) {
+    cv::Rect bounds(0, 0, source.cols, source.rows);
+    cv::Rect clamped = region & bounds;
+    if (clamped.empty()) {
+        return;
+    }
+    
+    std::vector<cv::Rect> rects;
+    if (halo < 0) {
+        rects.push_back(clamped);
+        halo = 0;
+    } else {
+        for (int row = clamped.y / TiledImage::kTileSize; row < tileCount(clamped.y + clamped.height); ++row) {
+            for (int col = clamped.x / TiledImage::kTileSize; col < tileCount(clamped.x + clamped.width); ++col) {
+                cv::Rect tile(col * TiledImage::kTileSize, row * TiledImage::kTileSize,
+                              TiledImage::kTileSize, TiledImage::kTileSize);
+                rects.push_back(tile & clamped);
+            }
+        }
+    }
+    
+    cv::parallel_for_(cv::Range(0, static_cast<int>(rects.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            cv::Rect source_rect = cv::Rect(rects[i].x - halo, rects[i].y - halo,
+                                            rects[i].width + 2 * halo, rects[i].height + 2 * halo) & bounds;
+            cv::Mat target = destination(rects[i]);
+            cv::Mat result = target;
+            op(source(source_rect), rects[i] - source_rect.tl(), result);
+            // Ops normally write straight into the tile; copy if one allocated its own output
+            if (result.data != target.data && result.size() == target.size() && result.type() == target.type()) {
+                result.copyTo(target);
+            }
+        }
+    });
+}
+
+} // namespace xeno::image
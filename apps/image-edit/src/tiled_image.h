@@ -0,0 +1,97 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <functional>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace xeno::image {
+
+/**
+ * @brief Identifies one tile of one pyramid level
+ */
+struct TileId {
+    int level;
+    int col;
+    int row;
+    
+    bool operator<(const TileId& other) const {
+        return std::tie(level, row, col) < std::tie(other.level, other.row, other.col);
+    }
+};
+
+/**
+ * @brief Full-resolution image split into fixed-size tiles, with a mipmap pyramid
+ *
+ * Level 0 is the full image; each further level halves both dimensions until
+ * the image fits in one tile. Edits mark only the tiles they touch, so a
+ * local edit rebuilds only the matching pyramid regions and only those tiles
+ * have to be redisplayed.
+ *
+ * Not thread-safe.
+ */
+class TiledImage {
+public:
+    static constexpr int kTileSize = 512;
+    
+    // Edit applied to a view of the image in place
+    using RegionOp = std::function<void(cv::Mat& pixels)>;
+    // Tile operation: reads source (the tile plus a halo), writes the tile into destination
+    using HaloOp = std::function<void(const cv::Mat& source, const cv::Rect& tile_in_source, cv::Mat& destination)>;
+    
+    TiledImage() = default;
+    explicit TiledImage(cv::Mat image);
+    
+    bool empty() const { return levels.empty(); }
+    cv::Size size() const { return empty() ? cv::Size() : levels[0].size(); }
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    
+    // Full-resolution image; a tiled view, not a copy
+    const cv::Mat& image() const { return levels[0]; }
+    
+    // Replaces the whole image. A contiguous image is adopted without a copy, so the
+    // caller must not keep writing through its own handle.
+    void assign(cv::Mat image);
+    
+    // Applies op to the region's pixels in place and marks it dirty
+    void editRegion(const cv::Rect& region, const RegionOp& op);
+    
+    // Records an edit made directly to image() pixels
+    void markDirty(const cv::Rect& region);
+    
+    // Pyramid level, with pending edits propagated down to it first
+    const cv::Mat& level(int index);
+    
+    // Coarsest level that still has at least one image pixel per screen pixel at this zoom
+    int levelForScale(double view_scale) const;
+    
+    int tileCols(int level) const;
+    int tileRows(int level) const;
+    // Tile bounds in the level's own pixel coordinates
+    cv::Rect tileRect(const TileId& tile) const;
+    
+    // Tiles of a level edited since the last call, for redisplay
+    std::vector<TileId> takeDirtyTiles(int level);
+
+private:
+    cv::Rect clampRegion(cv::Rect region) const;
+    void updatePyramid();
+    
+    std::vector<cv::Mat> levels;
+    std::vector<cv::Rect> pending_regions; // Level 0 regions not yet propagated to the pyramid
+    std::set<TileId> dirty_tiles;
+};
+
+/**
+ * @brief Runs op over the tiles of region in parallel, reading source and writing destination
+ *
+ * source and destination have the same size and type and must not share
+ * pixels; destination outside region is left untouched. Each tile reads
+ * halo extra pixels around it; a negative halo processes the region as one
+ * piece, for operations that cannot be split.
+ */
+void processTiles(const cv::Mat& source, cv::Mat& destination, const cv::Rect& region, int halo,
+                  const TiledImage::HaloOp& op);
+
+} // namespace xeno::image
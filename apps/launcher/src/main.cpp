@@ -7,6 +7,8 @@
 #include <QFrame>
 #include <QGridLayout>
 #include <QProcess>
+#include <QProcessEnvironment>
+#include <QDir>
 #include <QMessageBox>
 #include <QTimer>
 #include <QProgressBar>
@@ -16,9 +18,12 @@
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QStringList>
 #include <memory>
 
+#include "../../shared/ai-integration/include/ai_broker.h"
 #include "../../shared/ai-integration/include/ai_integration.h"
+#include "../../shared/utils/include/metrics.h"
 #include "../../shared/utils/include/utils.h"
 
 class XenoLauncher : public QMainWindow {
@@ -32,15 +37,22 @@ public:
         // Initialize AI integration
         ai_integration = std::make_unique<xeno::ai::AIIntegration>();
         loadConfiguration();
+        startBroker();
         
         setupUI();
         setupConnections();
         updateCreditBalance();
         
-        // Update credit balance every 30 seconds
+        // Update credit balance and provider health every 30 seconds
         auto timer = new QTimer(this);
         connect(timer, &QTimer::timeout, this, &XenoLauncher::updateCreditBalance);
+        connect(timer, &QTimer::timeout, this, &XenoLauncher::updateProviderStatus);
         timer->start(30000);
+        
+        // Latency figures are cheap to read and change by the second
+        auto metrics_timer = new QTimer(this);
+        connect(metrics_timer, &QTimer::timeout, this, &XenoLauncher::updateMetrics);
+        metrics_timer->start(2000);
     }
 
 private slots:
@@ -137,6 +149,10 @@ private:
         status_layout->addWidget(open_router_status);
         status_layout->addWidget(ollama_status);
         
+        metrics_label = new QLabel("No AI requests yet");
+        metrics_label->setStyleSheet("color: gray; font-family: monospace;");
+        status_layout->addWidget(metrics_label);
+        
         main_layout->addWidget(status_group);
         
         // Control buttons
@@ -193,53 +209,96 @@ private:
         // Try to load configuration from app data directory
         std::string config_path = xeno::utils::Platform::getAppDataPath() + "/config.json";
         if (!ai_integration->loadConfigFromFile(config_path)) {
-            xeno::utils::Logger::getInstance().warning("Could not load configuration from " + config_path);
+            xeno::utils::Logger::getInstance().warning("Could not load configuration from ", config_path);
         }
         
         // Check provider availability
         updateProviderStatus();
     }
     
+    void startBroker() {
+        // The suite apps reach this launcher's connections, cache, router and wallet through the broker
+        ai_broker = std::make_unique<xeno::ai::AIBroker>(*ai_integration);
+        if (!ai_broker->start()) {
+            xeno::utils::Logger::getInstance().warning("AI service not shared with the apps: ",
+                                                       ai_broker->errorMessage());
+        }
+    }
+    
     void updateProviderStatus() {
-        // Update status labels based on provider availability
-        if (ai_integration->isProviderAvailable(xeno::ai::AIIntegration::AIProvider::XenoCloud)) {
-            xeno_cloud_status->setText("Xeno AI Cloud: ✅ Connected");
-            xeno_cloud_status->setStyleSheet("color: green;");
-        } else {
-            xeno_cloud_status->setText("Xeno AI Cloud: ❌ Not configured");
-            xeno_cloud_status->setStyleSheet("color: red;");
+        // Update status labels based on provider availability; the tooltip carries recent latency
+        auto showStatus = [this](QLabel* label, xeno::ai::AIIntegration::AIProvider provider, const QString& name,
+                                 const QString& available, const QString& missing_color) {
+            QString status = QString::fromStdString(ai_integration->getProviderStatus(provider));
+            label->setToolTip(status);
+            if (ai_integration->isProviderAvailable(provider)) {
+                label->setText(name + ": ✅ " + available);
+                label->setStyleSheet("color: green;");
+            } else {
+                label->setText(name + ": ❌ " + status);
+                label->setStyleSheet("color: " + missing_color + ";");
+            }
+        };
+        showStatus(xeno_cloud_status, xeno::ai::AIIntegration::AIProvider::XenoCloud, "Xeno AI Cloud", "Connected",
+                   "red");
+        showStatus(open_router_status, xeno::ai::AIIntegration::AIProvider::OpenRouter, "Open Router", "Connected",
+                   "orange");
+        showStatus(ollama_status, xeno::ai::AIIntegration::AIProvider::Ollama, "Ollama", "Available", "orange");
+    }
+    
+    void updateMetrics() {
+        // Requests from the apps sharing the broker run here, so these cover them as well
+        auto snapshot = xeno::utils::Metrics::getInstance().snapshot();
+        QStringList lines;
+        for (const auto& [name, summary] : snapshot.histograms) {
+            if (summary.count > 0 && name.rfind("ai.", 0) == 0) {
+                lines << QString("%1: p50 %2 ms, p99 %3 ms (%4 calls)")
+                             .arg(QString::fromStdString(name.substr(3)))
+                             .arg(summary.p50_us / 1000.0, 0, 'f', 1)
+                             .arg(summary.p99_us / 1000.0, 0, 'f', 1)
+                             .arg(summary.count);
+            }
         }
-        
-        if (ai_integration->isProviderAvailable(xeno::ai::AIIntegration::AIProvider::OpenRouter)) {
-            open_router_status->setText("Open Router: ✅ Connected");
-            open_router_status->setStyleSheet("color: green;");
-        } else {
-            open_router_status->setText("Open Router: ❌ Not configured");
-            open_router_status->setStyleSheet("color: orange;");
+        uint64_t hits = snapshot.counters["ai.cache.hits"];
+        uint64_t lookups = hits + snapshot.counters["ai.cache.misses"];
+        if (lookups > 0) {
+            lines << QString("Response cache: %1% hits").arg(100.0 * hits / lookups, 0, 'f', 0);
         }
-        
-        if (ai_integration->isProviderAvailable(xeno::ai::AIIntegration::AIProvider::Ollama)) {
-            ollama_status->setText("Ollama: ✅ Available");
-            ollama_status->setStyleSheet("color: green;");
-        } else {
-            ollama_status->setText("Ollama: ❌ Not available");
-            ollama_status->setStyleSheet("color: orange;");
+        if (ai_broker->isRunning()) {
+            lines << QString("Apps sharing the AI service: %1").arg(ai_broker->clientCount());
+        }
+        if (!lines.isEmpty()) {
+            metrics_label->setText(lines.join("\n"));
         }
     }
     
     void launchApplication(const QString& app_name, const QString& executable) {
-        // For now, show a message since we haven't built the other apps yet
-        QMessageBox::information(this, "Launch " + app_name, 
-            QString("Launching %1...\n\nNote: This will execute '%2' when the application is built.")
-            .arg(app_name, executable));
-            
-        // In production, this would use QProcess:
-        // auto process = new QProcess(this);
-        // process->start(executable);
+        // The apps are installed next to the launcher
+        QString program = QDir(QCoreApplication::applicationDirPath()).filePath(executable);
+#ifdef Q_OS_WIN
+        program += ".exe";
+#endif
+        QProcess process;
+        process.setProgram(program);
+        process.setWorkingDirectory(QCoreApplication::applicationDirPath());
+        // Naming the broker lets the app connect at once, and skip setting up providers of its own
+        if (ai_broker->isRunning()) {
+            auto environment = QProcessEnvironment::systemEnvironment();
+            environment.insert(xeno::ai::AIBroker::kAddressVariable, QString::fromStdString(ai_broker->address()));
+            process.setProcessEnvironment(environment);
+        }
+        // Detached, so an app keeps running (on its own providers) after the launcher closes
+        if (!process.startDetached()) {
+            QMessageBox::warning(this, "Launch " + app_name,
+                QString("Could not start %1: %2 was not found or is not executable.").arg(app_name, program));
+            return;
+        }
+        xeno::utils::Logger::getInstance().info("Launched ", executable.toStdString());
     }
 
 private:
     std::unique_ptr<xeno::ai::AIIntegration> ai_integration;
+    std::unique_ptr<xeno::ai::AIBroker> ai_broker;  // Declared after ai_integration, so it stops first
     
     // UI elements
     QLabel* credit_label;
@@ -250,6 +309,7 @@ private:
     QLabel* xeno_cloud_status;
     QLabel* open_router_status;
     QLabel* ollama_status;
+    QLabel* metrics_label;
 };
 
 int main(int argc, char *argv[]) {
@@ -260,7 +320,12 @@ int main(int argc, char *argv[]) {
     QApplication::setApplicationVersion("1.0.0");
     QApplication::setOrganizationName("Xeno AI");
     
-    // Initialize logging
+    // Log to <app data>/logs/launcher.log as well as the console
+    xeno::utils::Logger::Options log_options;
+    log_options.file_name = "launcher";
+    xeno::utils::Logger::getInstance().configure(log_options);
+    // Edits to config.json apply without a restart
+    xeno::utils::ConfigManager::getInstance().watch();
     xeno::utils::Logger::getInstance().info("Starting Xeno Software Suite Launcher");
     
     // Create and show main window
@@ -0,0 +1,375 @@
+#include "frame_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+#include "../../shared/utils/include/metrics.h"
+#include "../../shared/utils/include/utils.h"
+
+namespace xeno::video {
+
+namespace {
+
+constexpr int kPacketsPerProgress = 256;
+
+std::string errorText(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, text, sizeof(text));
+    return text;
+}
+
+} // namespace
+
+struct FrameCache::Decoder {
+    AVFormatContext* format = nullptr;
+    AVCodecContext* codec = nullptr;
+    SwsContext* scaler = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+    int stream_index = -1;
+    int64_t last_pts = AV_NOPTS_VALUE; // Last frame decoded; none after a seek or at the end
+    int64_t seek_keyframe = AV_NOPTS_VALUE;
+    
+    ~Decoder() {
+        sws_freeContext(scaler);
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&codec);
+        avformat_close_input(&format);
+    }
+};
+
+FrameCache::FrameCache(const Options& options, FrameReady on_ready)
+    : options(options), on_ready(std::move(on_ready)) {}
+
+FrameCache::~FrameCache() {
+    {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        stop = true;
+    }
+    request_ready.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool FrameCache::open(const std::string& path, const Progress& progress) {
+    if (decoder) {
+        error_message = "The cache is already open";
+        return false;
+    }
+    
+    auto state = std::make_unique<Decoder>();
+    int code = avformat_open_input(&state->format, path.c_str(), nullptr, nullptr);
+    if (code < 0) {
+        error_message = "Cannot open " + path + ": " + errorText(code);
+        return false;
+    }
+    code = avformat_find_stream_info(state->format, nullptr);
+    if (code < 0) {
+        error_message = "Cannot read streams of " + path + ": " + errorText(code);
+        return false;
+    }
+    
+    const AVCodec* codec = nullptr;
+    state->stream_index = av_find_best_stream(state->format, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (state->stream_index < 0 || !codec) {
+        error_message = "No decodable video stream in " + path;
+        return false;
+    }
+    AVStream* stream = state->format->streams[state->stream_index];
+    for (unsigned i = 0; i < state->format->nb_streams; i++) {
+        if (static_cast<int>(i) != state->stream_index) {
+            state->format->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    
+    // Reads the container once; packets carry the timestamps and keyframe flags
+    state->packet = av_packet_alloc();
+    int64_t total = avio_size(state->format->pb);
+    int64_t packet_count = 0;
+    while (av_read_frame(state->format, state->packet) >= 0) {
+        AVPacket* packet = state->packet;
+        if (packet->stream_index == state->stream_index) {
+            int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE) {
+                frame_pts.push_back(pts);
+                if (packet->flags & AV_PKT_FLAG_KEY) {
+                    keyframe_pts.push_back(pts);
+                }
+            }
+        }
+        int64_t position = packet->pos;
+        av_packet_unref(packet);
+        
+        if (progress && total > 0 && position >= 0 && ++packet_count % kPacketsPerProgress == 0 &&
+            !progress(static_cast<double>(position) / total)) {
+            error_message = "Indexing cancelled";
+            frame_pts.clear();
+            keyframe_pts.clear();
+            return false;
+        }
+    }
+    
+    std::sort(frame_pts.begin(), frame_pts.end());
+    frame_pts.erase(std::unique(frame_pts.begin(), frame_pts.end()), frame_pts.end());
+    std::sort(keyframe_pts.begin(), keyframe_pts.end());
+    if (frame_pts.empty() || keyframe_pts.empty()) {
+        error_message = "No video frames in " + path;
+        frame_pts.clear();
+        keyframe_pts.clear();
+        return false;
+    }
+    time_base = av_q2d(stream->time_base);
+    
+    state->codec = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(state->codec, stream->codecpar);
+    state->codec->pkt_timebase = stream->time_base;
+    // Frame threads each hold a frame back, which every seek would wait for; slices do not
+    state->codec->thread_count = 0;
+    state->codec->thread_type = FF_THREAD_SLICE;
+    code = avcodec_open2(state->codec, codec, nullptr);
+    if (code < 0) {
+        error_message = std::string("Cannot open the ") + codec->name + " decoder: " + errorText(code);
+        return false;
+    }
+    state->frame = av_frame_alloc();
+    source_width = stream->codecpar->width;
+    source_height = stream->codecpar->height;
+    
+    decoder = std::move(state);
+    worker = std::thread(&FrameCache::workerLoop, this);
+    return true;
+}
+
+FrameCache::FramePtr FrameCache::request(double seconds, int direction) {
+    if (frame_pts.empty()) {
+        return nullptr;
+    }
+    
+    // The frame showing at a time is the last one starting at or before it
+    int64_t wanted = frame_pts.front() + std::llround(std::max(seconds, 0.0) / time_base);
+    auto next = std::upper_bound(frame_pts.begin(), frame_pts.end(), wanted);
+    int64_t pts = next == frame_pts.begin() ? *next : *std::prev(next);
+    
+    FramePtr frame = lookup(pts);
+    static utils::Counter& hits = utils::Metrics::getInstance().counter("video.scrub.hits");
+    static utils::Counter& misses = utils::Metrics::getInstance().counter("video.scrub.misses");
+    (frame ? hits : misses).add();
+    {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        requested_pts = pts;
+        requested_direction = direction;
+        waiting = !frame;
+        latest_generation = ++request_generation;
+    }
+    request_ready.notify_one();
+    return frame;
+}
+
+double FrameCache::duration() const {
+    return frame_pts.empty() ? 0.0 : (frame_pts.back() - frame_pts.front()) * time_base;
+}
+
+std::string FrameCache::proxyPath(const std::string& path) {
+    std::error_code error;
+    std::string absolute = std::filesystem::absolute(path, error).string();
+    uint64_t size = std::filesystem::file_size(path, error);
+    auto modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    
+    std::ostringstream key;
+    key << absolute << '|' << size << '|' << modified;
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(key.str()) << ".mp4";
+    return (std::filesystem::path(utils::Platform::getAppDataPath()) / "video-proxies" / name.str()).string();
+}
+
+void FrameCache::workerLoop() {
+    uint64_t handled = 0;
+    while (true) {
+        int64_t target = 0;
+        int direction = 0;
+        bool deliver = false;
+        {
+            std::unique_lock<std::mutex> lock(request_mutex);
+            request_ready.wait(lock, [&]() { return stop || request_generation != handled; });
+            if (stop) {
+                return;
+            }
+            target = requested_pts;
+            direction = requested_direction;
+            deliver = waiting;
+            waiting = false;
+            handled = request_generation;
+        }
+        
+        if (deliver) {
+            // Finished even if the playhead moves on, so a fast scrub keeps showing frames
+            FramePtr frame = lookup(target);
+            if (!frame) {
+                frame = decodeTo(target, 0);
+            }
+            if (frame && on_ready) {
+                on_ready(frame);
+            }
+        }
+        prefetch(target, direction, handled);
+    }
+}
+
+FrameCache::FramePtr FrameCache::decodeTo(int64_t target, uint64_t generation) {
+    static utils::Histogram& seek_latency = utils::Metrics::getInstance().histogram("video.seek");
+    utils::TraceSpan span(seek_latency);
+    Decoder& state = *decoder;
+    int64_t keyframe = keyframeBefore(target);
+    
+    // Decoding on from the last frame beats a seek unless a keyframe nearer the target lies between
+    bool on_the_way = state.last_pts != AV_NOPTS_VALUE && state.last_pts < target && keyframe <= state.last_pts;
+    if (!on_the_way) {
+        if (av_seek_frame(state.format, state.stream_index, keyframe, AVSEEK_FLAG_BACKWARD) < 0) {
+            return nullptr;
+        }
+        avcodec_flush_buffers(state.codec);
+        state.last_pts = AV_NOPTS_VALUE;
+        state.seek_keyframe = keyframe;
+    }
+    
+    while (true) {
+        if (generation != 0 && superseded(generation)) {
+            return nullptr;
+        }
+        
+        int code = avcodec_receive_frame(state.codec, state.frame);
+        if (code == 0) {
+            int64_t pts = state.frame->best_effort_timestamp;
+            state.last_pts = pts;
+            FramePtr frame;
+            // Open-GOP leading frames reference the GOP before the seek point and decode broken
+            if (pts >= state.seek_keyframe) {
+                frame = lookup(pts);
+                if (!frame) {
+                    frame = convert(pts);
+                    if (frame) {
+                        insert(frame);
+                    }
+                }
+            }
+            av_frame_unref(state.frame);
+            if (pts >= target) {
+                return frame;
+            }
+            continue;
+        }
+        if (code != AVERROR(EAGAIN)) {
+            // End of stream or a decode error; the next request seeks afresh
+            state.last_pts = AV_NOPTS_VALUE;
+            return nullptr;
+        }
+        
+        code = av_read_frame(state.format, state.packet);
+        if (code == AVERROR_EOF) {
+            avcodec_send_packet(state.codec, nullptr);
+            continue;
+        }
+        if (code < 0) {
+            state.last_pts = AV_NOPTS_VALUE;
+            return nullptr;
+        }
+        if (state.packet->stream_index == state.stream_index) {
+            avcodec_send_packet(state.codec, state.packet);
+        }
+        av_packet_unref(state.packet);
+    }
+}
+
+void FrameCache::prefetch(int64_t target, int direction, uint64_t generation) {
+    size_t position = std::lower_bound(frame_pts.begin(), frame_pts.end(), target) - frame_pts.begin();
+    size_t count = static_cast<size_t>(std::max(options.prefetch_frames, 0));
+    
+    // Nearest frames first; each decode also caches the frames between its keyframe and target
+    if (direction >= 0) {
+        size_t end = std::min(frame_pts.size(), position + 1 + count);
+        for (size_t i = position + 1; i < end; i++) {
+            if (!lookup(frame_pts[i]) && !decodeTo(frame_pts[i], generation)) {
+                return;
+            }
+        }
+    } else {
+        size_t begin = position > count ? position - count : 0;
+        for (size_t i = position; i-- > begin;) {
+            if (!lookup(frame_pts[i]) && !decodeTo(frame_pts[i], generation)) {
+                return;
+            }
+        }
+    }
+}
+
+FrameCache::FramePtr FrameCache::convert(int64_t pts) {
+    Decoder& state = *decoder;
+    const AVFrame* source = state.frame;
+    
+    int width = source->width;
+    int height = source->height;
+    if (options.max_height > 0 && height > options.max_height) {
+        width = std::max(1, static_cast<int>(static_cast<int64_t>(width) * options.max_height / height));
+        height = options.max_height;
+    }
+    state.scaler = sws_getCachedContext(state.scaler, source->width, source->height,
+                                        static_cast<AVPixelFormat>(source->format), width, height,
+                                        AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!state.scaler) {
+        return nullptr;
+    }
+    
+    auto frame = std::make_shared<Frame>();
+    frame->pts = pts;
+    frame->seconds = (pts - frame_pts.front()) * time_base;
+    frame->width = width;
+    frame->height = height;
+    frame->pixels.resize(static_cast<size_t>(width) * height * 4);
+    uint8_t* planes[4] = {frame->pixels.data(), nullptr, nullptr, nullptr};
+    int strides[4] = {width * 4, 0, 0, 0};
+    sws_scale(state.scaler, source->data, source->linesize, 0, source->height, planes, strides);
+    return frame;
+}
+
+FrameCache::FramePtr FrameCache::lookup(int64_t pts) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto entry = entries.find(pts);
+    if (entry == entries.end()) {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, entry->second);
+    return *entry->second;
+}
+
+void FrameCache::insert(FramePtr frame) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (entries.count(frame->pts)) {
+        return;
+    }
+    cached_bytes += frame->pixels.size();
+    lru.push_front(std::move(frame));
+    entries[lru.front()->pts] = lru.begin();
+    
+    while (cached_bytes > options.capacity_bytes && lru.size() > 1) {
+        cached_bytes -= lru.back()->pixels.size();
+        entries.erase(lru.back()->pts);
+        lru.pop_back();
+    }
+}
+
+int64_t FrameCache::keyframeBefore(int64_t pts) const {
+    auto next = std::upper_bound(keyframe_pts.begin(), keyframe_pts.end(), pts);
+    return next == keyframe_pts.begin() ? keyframe_pts.front() : *std::prev(next);
+}
+
+} // namespace xeno::video
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace xeno::video {
+
+/**
+ * @brief Decoded frames around the playhead, for frame-accurate scrubbing
+ *
+ * Opening a file reads every video packet once, without decoding, to index
+ * the presentation time of each frame and which of them are keyframes. A
+ * request snaps to the frame showing at that time, returns it at once when
+ * it is cached, and otherwise decodes it on the worker thread: from the
+ * current decoder position when that is on the way, else from the keyframe
+ * before it. Every frame decoded on the way is kept in a least-recently-used
+ * cache, and once the requested frame is delivered the worker fills the
+ * cache further in the direction of the scrub.
+ *
+ * Long-GOP sources can need dozens of decodes per seek; proxyPath() names an
+ * intra-only, low-resolution copy which decodes any frame on its own. Proxies
+ * keep the source's timestamps, so a cache opened on one serves the same
+ * frames.
+ */
+class FrameCache {
+public:
+    struct Options {
+        size_t capacity_bytes = size_t(512) * 1024 * 1024;
+        int max_height = 720;     // Frames are scaled down to this for display
+        int prefetch_frames = 30; // Cached ahead of the playhead in the scrub direction
+    };
+    
+    struct Frame {
+        int64_t pts = 0;
+        double seconds = 0.0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels; // RGBA, rows packed without padding
+    };
+    
+    using FramePtr = std::shared_ptr<const Frame>;
+    // Called on the worker thread with the frame a request was waiting for
+    using FrameReady = std::function<void(FramePtr frame)>;
+    // Receives the fraction indexed; returning false cancels the open
+    using Progress = std::function<bool(double fraction)>;
+    
+    FrameCache(const Options& options, FrameReady on_ready);
+    ~FrameCache();
+    
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+    
+    bool open(const std::string& path, const Progress& progress = nullptr);
+    
+    // The frame showing seconds after the first one if cached; otherwise nullptr, and
+    // on_ready receives it once decoded. direction is +1 or -1 while scrubbing, 0 when parked.
+    FramePtr request(double seconds, int direction);
+    
+    int sourceWidth() const { return source_width; }
+    int sourceHeight() const { return source_height; }
+    double duration() const;
+    size_t frameCount() const { return frame_pts.size(); }
+    size_t keyframeCount() const { return keyframe_pts.size(); }
+    const std::string& lastError() const { return error_message; }
+    
+    // Where the proxy of path is kept; the name covers the source's size and modification time
+    static std::string proxyPath(const std::string& path);
+
+private:
+    struct Decoder;
+    
+    void workerLoop();
+    // Decodes up to target, caching every frame on the way. A non-zero generation
+    // gives up as soon as a newer request arrives.
+    FramePtr decodeTo(int64_t target, uint64_t generation);
+    void prefetch(int64_t target, int direction, uint64_t generation);
+    // The decoder's current frame, scaled for display
+    FramePtr convert(int64_t pts);
+    FramePtr lookup(int64_t pts);
+    void insert(FramePtr frame);
+    int64_t keyframeBefore(int64_t pts) const;
+    bool superseded(uint64_t generation) const { return latest_generation.load() != generation; }
+    
+    Options options;
+    FrameReady on_ready;
+    std::unique_ptr<Decoder> decoder; // Used only by the worker after open()
+    
+    // Sorted presentation timestamps, in the stream's time base
+    std::vector<int64_t> frame_pts;
+    std::vector<int64_t> keyframe_pts;
+    double time_base = 0.0;
+    int source_width = 0;
+    int source_height = 0;
+    std::string error_message;
+    
+    // Least recently used at the back
+    std::mutex cache_mutex;
+    std::list<FramePtr> lru;
+    std::unordered_map<int64_t, std::list<FramePtr>::iterator> entries;
+    size_t cached_bytes = 0;
+    
+    // Latest request, handed to the worker
+    std::mutex request_mutex;
+    std::condition_variable request_ready;
+    int64_t requested_pts = 0;
+    int requested_direction = 0;
+    uint64_t request_generation = 0;
+    bool waiting = false; // The requested frame was not cached and must be delivered
+    std::atomic<uint64_t> latest_generation{0};
+    bool stop = false;
+    std::thread worker;
+};
+
+} // namespace xeno::video
@@ -7,9 +7,13 @@
 #include <QSlider>
 #include <QMediaPlayer>
 #include <QVideoWidget>
+#include <QVideoSink>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
 #include <QFileDialog>
 #include <QMenuBar>
 #include <QToolBar>
+#include <QAction>
 #include <QStatusBar>
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -17,10 +21,24 @@
 #include <QListWidget>
 #include <QSpinBox>
 #include <QComboBox>
+#include <QPointer>
+#include <QFileInfo>
+#include <QDir>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <functional>
 #include <memory>
+#include <thread>
 
+#include "../../shared/ai-integration/include/ai_broker.h"
 #include "../../shared/ai-integration/include/ai_integration.h"
 #include "../../shared/utils/include/utils.h"
+#include "frame_cache.h"
+#include "timeline.h"
+#include "timeline_renderer.h"
+#include "video_analysis.h"
+#include "video_pipeline.h"
 
 class VideoEditWindow : public QMainWindow {
     Q_OBJECT
@@ -38,6 +56,8 @@ public:
         video_widget = new QVideoWidget;
         media_player->setVideoOutput(video_widget);
         
+        video_track = timeline.addTrack("Video 1");
+        
         setupUI();
         setupMenus();
         setupToolbars();
@@ -47,6 +67,21 @@ public:
         
         statusBar()->showMessage("Ready - AI video editing with Xeno Labs integration");
     }
+    
+    ~VideoEditWindow() override {
+        export_cancelled = true;
+        if (export_thread.joinable()) {
+            export_thread.join();
+        }
+        media_cancelled = true;
+        if (media_thread.joinable()) {
+            media_thread.join();
+        }
+        analysis_cancelled = true;
+        if (analysis_thread.joinable()) {
+            analysis_thread.join();
+        }
+    }
 
 private slots:
     void openVideo() {
@@ -57,6 +92,9 @@ private slots:
             media_player->setSource(QUrl::fromLocalFile(filename));
             statusBar()->showMessage("Video loaded: " + filename);
             current_video_path = filename;
+            // Appended to the timeline once the player knows the duration
+            pending_timeline_source = filename;
+            prepareScrubbing(filename.toStdString());
         }
     }
     
@@ -89,31 +127,72 @@ private slots:
             return;
         }
         
-        QProgressDialog progress("Applying AI Auto-Edit...", "Cancel", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
+        auto progress = new QProgressDialog("Applying AI Auto-Edit...", "Cancel", 0, 0, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
         
-        // Simulate AI processing
-        for (int i = 0; i <= 100; i += 5) {
-            progress.setValue(i);
-            QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                return;
-            }
-            QThread::msleep(200);
-        }
-        
-        // Make AI API call
+        // Make AI API call off the UI thread
         xeno::ai::AIIntegration::AIRequest request;
         request.prompt = "Apply intelligent auto-editing to enhance video flow";
         request.operation_type = "auto_edit";
         
-        auto response = ai_integration->processVideo(request);
+        // The source is uploaded in chunks and the result streamed next to it on disk
+        xeno::ai::AIIntegration::MediaFiles files;
+        files.source_path = current_video_path.toStdString();
+        QFileInfo source_info(current_video_path);
+        files.result_path = source_info.dir().filePath(
+            source_info.completeBaseName() + "_auto_edit." + source_info.suffix()).toStdString();
+        if (auto_edit_transfer_source == current_video_path) {
+            files.transfer_id = auto_edit_transfer_id.toStdString(); // Resume the upload that failed last time
+        }
+        
+        QPointer<QProgressDialog> dialog(progress);
+        auto last_percent = std::make_shared<int>(-1);
+        auto on_progress = [this, dialog, last_percent](uint64_t done, uint64_t total) {
+            int percent = total > 0 ? static_cast<int>(done * 100 / total) : 0;
+            if (percent != *last_percent) {
+                *last_percent = percent;
+                QMetaObject::invokeMethod(this, [dialog, percent]() {
+                    if (dialog) {
+                        dialog->setRange(0, 100);
+                        dialog->setValue(percent);
+                    }
+                }, Qt::QueuedConnection);
+            }
+            return true;
+        };
+        auto task = ai_integration->processVideoFileAsync(request, files, on_progress,
+            xeno::ai::AIIntegration::AIProvider::Auto,
+            [this, dialog, source = current_video_path](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, dialog, source, response]() {
+                    if (dialog) {
+                        dialog->close();
+                    }
+                    auto_edit_transfer_source = source;
+                    auto_edit_transfer_id = QString::fromStdString(response.metadata.value("transfer_id", std::string()));
+                    if (response.success) {
+                        auto_edit_transfer_id.clear();
+                    }
+                    finishAutoEdit(response);
+                }, Qt::QueuedConnection);
+            });
+        
+        connect(progress, &QProgressDialog::canceled, this, [task]() { task.cancel(); });
+    }
+    
+    void finishAutoEdit(const xeno::ai::AIIntegration::AIResponse& response) {
+        if (response.metadata.value("cancelled", false)) {
+            statusBar()->showMessage("Auto-edit cancelled");
+            return;
+        }
         
         if (response.success) {
             statusBar()->showMessage(QString("Auto-edit applied - %1 credits used")
                 .arg(response.credits_used));
-            QMessageBox::information(this, "Success", "AI auto-editing completed!");
+            updateCreditDisplay();
+            QMessageBox::information(this, "Success", QString("AI auto-editing completed!\nSaved to %1")
+                .arg(QString::fromStdString(response.metadata.value("result_path", std::string()))));
         } else {
             QMessageBox::critical(this, "AI Error", 
                 QString("Failed to apply auto-edit: %1").arg(QString::fromStdString(response.error_message)));
@@ -126,29 +205,93 @@ private slots:
             return;
         }
         
-        int required_credits = 5;
-        if (!ai_integration->validateCredits(required_credits)) {
-            QMessageBox::warning(this, "Insufficient Credits", 
-                QString("Video stabilization requires %1 credits.").arg(required_credits));
-            return;
-        }
-        
-        QProgressDialog progress("Stabilizing video...", "Cancel", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
-        
-        for (int i = 0; i <= 100; i += 10) {
-            progress.setValue(i);
-            QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                return;
+        // Runs on this machine, so no credits are spent
+        std::string source = current_video_path.toStdString();
+        QFileInfo info(current_video_path);
+        std::string output = info.dir().filePath(info.completeBaseName() + "_stabilized.mp4").toStdString();
+        runAnalysis("Stabilizing video...", [this, source, output](const AnalysisProgress& report) {
+            xeno::video::VideoAnalysis analysis(xeno::video::VideoAnalysis::Options{});
+            auto motion = analysis.analyzeMotion(source, [&](double fraction) { return report(fraction * 0.5); });
+            xeno::video::VideoPipeline::Result result;
+            if (motion.success) {
+                xeno::video::VideoPipeline::Options options;
+                options.process_frame = analysis.stabilizer(motion);
+                result = xeno::video::VideoPipeline(options).transcode(source, output, [&](double fraction) {
+                    return report(0.5 + fraction * 0.5);
+                });
+                if (!result.success) {
+                    std::error_code ignored;
+                    std::filesystem::remove(output, ignored);
+                }
+            } else {
+                result.error_message = motion.error_message;
             }
-            QThread::msleep(150);
+            
+            return std::function<void()>([this, source, output, result, opencl = motion.used_opencl]() {
+                if (!result.success) {
+                    if (!analysis_cancelled) {
+                        QMessageBox::critical(this, "Error", QString("Video stabilization failed: %1")
+                            .arg(QString::fromStdString(result.error_message)));
+                    }
+                    return;
+                }
+                // Clips keep their timing and now play the stabilized copy
+                for (const auto& track : timeline.tracks()) {
+                    for (const auto* clip : timeline.clips(track.id)) {
+                        if (clip->source_path == source) {
+                            timeline.setSource(clip->id, output);
+                        }
+                    }
+                }
+                refreshClipList(0);
+                statusBar()->showMessage(QString("Video stabilized with %1: %2")
+                    .arg(opencl ? QString("OpenCL") : QString("the CPU")).arg(QString::fromStdString(output)));
+            });
+        });
+    }
+    
+    void detectSmartCuts() {
+        if (current_video_path.isEmpty()) {
+            QMessageBox::warning(this, "Warning", "Please load a video first!");
+            return;
         }
         
-        ai_integration->deductCredits(required_credits);
-        statusBar()->showMessage(QString("Video stabilized - %1 credits used").arg(required_credits));
-        QMessageBox::information(this, "Success", "Video stabilization completed!");
+        std::string source = current_video_path.toStdString();
+        runAnalysis("Detecting scene cuts...", [this, source](const AnalysisProgress& report) {
+            auto result = xeno::video::VideoAnalysis(xeno::video::VideoAnalysis::Options{}).detectCuts(source, report);
+            
+            return std::function<void()>([this, source, result]() {
+                if (!result.success) {
+                    if (!analysis_cancelled) {
+                        QMessageBox::critical(this, "Error", QString("Smart cut detection failed: %1")
+                            .arg(QString::fromStdString(result.error_message)));
+                    }
+                    return;
+                }
+                // Splits every clip of the source at each cut inside it
+                int splits = 0;
+                for (double cut : result.cuts) {
+                    std::vector<uint64_t> targets;
+                    for (const auto& track : timeline.tracks()) {
+                        for (const auto* clip : timeline.clips(track.id)) {
+                            if (clip->source_path == source && clip->source_in + kMinimumClipSeconds < cut &&
+                                cut < clip->source_out - kMinimumClipSeconds) {
+                                targets.push_back(clip->id);
+                            }
+                        }
+                    }
+                    for (uint64_t id : targets) {
+                        const xeno::video::Clip* clip = timeline.clip(id);
+                        if (timeline.splitClip(id, clip->start + (cut - clip->source_in)) != 0) {
+                            splits++;
+                        }
+                    }
+                }
+                refreshClipList(0);
+                statusBar()->showMessage(QString("Smart cuts: %1 scene changes found, %2 clips split")
+                    .arg(result.cuts.size()).arg(splits));
+            });
+        });
     }
     
     void enhanceQuality() {
@@ -171,22 +314,287 @@ private slots:
     }
     
     void exportVideo() {
-        if (current_video_path.isEmpty()) {
-            QMessageBox::warning(this, "Warning", "No video to export!");
+        if (timeline.empty()) {
+            QMessageBox::warning(this, "Warning", "No clips on the timeline to export!");
+            return;
+        }
+        
+        if (export_running) {
+            QMessageBox::information(this, "Export", "An export is already in progress.");
             return;
         }
         
         QString filename = QFileDialog::getSaveFileName(this,
-            "Export Video", "", "Videos (*.mp4 *.avi *.mov)");
+            "Export Video", "", "Videos (*.mp4 *.mov *.mkv)");
         
-        if (!filename.isEmpty()) {
-            QMessageBox::information(this, "Export", 
-                QString("Video would be exported to: %1\n\nNote: Export functionality requires FFmpeg integration.")
-                .arg(filename));
+        if (filename.isEmpty()) {
+            return;
+        }
+        
+        if (export_thread.joinable()) {
+            export_thread.join();
+        }
+        
+        auto progress = new QProgressDialog("Exporting video...", "Cancel", 0, 100, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
+        connect(progress, &QProgressDialog::canceled, this, [this]() { export_cancelled = true; });
+        
+        // Renders a snapshot, so editing can go on while the export runs
+        QPointer<QProgressDialog> dialog(progress);
+        export_cancelled = false;
+        export_running = true;
+        export_thread = std::thread([this, dialog, snapshot = timeline, destination = filename.toStdString()]() {
+            int last_percent = -1;
+            xeno::video::TimelineRenderer::Options options;
+            options.cache_directory = xeno::utils::Platform::getAppDataPath() + "/render-cache";
+            xeno::video::TimelineRenderer renderer(options);
+            auto result = renderer.render(snapshot, destination, [&](double fraction) {
+                int percent = static_cast<int>(fraction * 100);
+                if (percent != last_percent) {
+                    last_percent = percent;
+                    QMetaObject::invokeMethod(this, [dialog, percent]() {
+                        if (dialog) {
+                            dialog->setValue(percent);
+                        }
+                    }, Qt::QueuedConnection);
+                }
+                return !export_cancelled.load();
+            });
+            
+            QMetaObject::invokeMethod(this, [this, dialog, result, destination]() {
+                export_running = false;
+                if (dialog) {
+                    dialog->close();
+                }
+                if (result.success) {
+                    statusBar()->showMessage(QString("Video exported: %1 (%2 of %3 segments re-encoded)")
+                        .arg(QString::fromStdString(destination)).arg(result.encoded).arg(result.segments));
+                } else if (!export_cancelled) {
+                    QMessageBox::critical(this, "Error",
+                        QString("Failed to export video: %1").arg(QString::fromStdString(result.error_message)));
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+    
+    void trimSelectedClip(bool set_in) {
+        auto item = clip_list->currentItem();
+        const xeno::video::Clip* clip = item ? timeline.clip(item->data(Qt::UserRole).toULongLong()) : nullptr;
+        if (!clip) {
+            QMessageBox::warning(this, "Trim", "Select a clip on the timeline first.");
+            return;
+        }
+        if (QString::fromStdString(clip->source_path) != current_video_path) {
+            QMessageBox::warning(this, "Trim", "Open the clip's source video to trim it at the playhead.");
+            return;
+        }
+        
+        double playhead = media_player->position() / 1000.0;
+        double source_in = set_in ? playhead : clip->source_in;
+        double source_out = set_in ? clip->source_out : playhead;
+        if (source_out - source_in < kMinimumClipSeconds) {
+            QMessageBox::warning(this, "Trim", "The in point must come before the out point.");
+            return;
+        }
+        
+        // Ripple: later clips on the track follow the clip's end, so no gap opens up
+        uint64_t id = clip->id;
+        double old_end = clip->end();
+        double delta = (source_out - source_in) - clip->duration();
+        std::vector<std::pair<uint64_t, double>> moves;
+        for (const auto* other : timeline.clips(clip->track)) {
+            if (other->id != id && other->start >= old_end - kMinimumClipSeconds) {
+                moves.emplace_back(other->id, other->start + delta);
+            }
+        }
+        if (delta > 0.0) {
+            // Make room from the far end first
+            for (auto move = moves.rbegin(); move != moves.rend(); ++move) {
+                timeline.moveClip(move->first, move->second);
+            }
+            timeline.trimClip(id, source_in, source_out);
+        } else {
+            timeline.trimClip(id, source_in, source_out);
+            for (const auto& [other, start] : moves) {
+                timeline.moveClip(other, start);
+            }
+        }
+        refreshClipList(id);
+    }
+    
+    void removeSelectedClip() {
+        auto item = clip_list->currentItem();
+        if (item && timeline.removeClip(item->data(Qt::UserRole).toULongLong())) {
+            refreshClipList(0);
         }
     }
 
 private:
+    // Indexes the video for the frame cache, then for 4K and larger sources builds or
+    // reuses an intra-only proxy and switches the cache over to it
+    void prepareScrubbing(const std::string& path) {
+        media_cancelled = true;
+        if (media_thread.joinable()) {
+            media_thread.join();
+        }
+        media_cancelled = false;
+        frame_cache.reset();
+        
+        uint64_t generation = ++media_generation;
+        bool use_proxies = proxy_action->isChecked();
+        media_thread = std::thread([this, path, generation, use_proxies]() {
+            auto keep_going = [this](double) { return !media_cancelled.load(); };
+            auto cache = makeFrameCache(generation);
+            if (!cache->open(path, keep_going)) {
+                if (!media_cancelled) {
+                    xeno::utils::Logger::getInstance().warning("Frame cache unavailable: ", cache->lastError());
+                }
+                return;
+            }
+            int source_height = cache->sourceHeight();
+            useFrameCache(cache, generation, "Frame index ready");
+            if (!use_proxies || source_height < kProxyMinimumHeight) {
+                return;
+            }
+            
+            std::string proxy = xeno::video::FrameCache::proxyPath(path);
+            std::error_code ignored;
+            if (!std::filesystem::exists(proxy, ignored)) {
+                QMetaObject::invokeMethod(this, [this, generation]() {
+                    if (generation == media_generation) {
+                        statusBar()->showMessage("Building scrubbing proxy...");
+                    }
+                }, Qt::QueuedConnection);
+                
+                xeno::video::VideoPipeline::Options proxy_options;
+                proxy_options.max_height = kProxyHeight;
+                proxy_options.keyframe_interval = 1;
+                proxy_options.bit_rate = kProxyBitRate;
+                // Written under a temporary name so an interrupted build is never mistaken for a proxy
+                std::string partial = proxy.substr(0, proxy.size() - 4) + ".part.mp4";
+                std::filesystem::create_directories(std::filesystem::path(proxy).parent_path(), ignored);
+                auto result = xeno::video::VideoPipeline(proxy_options).transcode(path, partial, keep_going);
+                if (!result.success) {
+                    if (!media_cancelled) {
+                        xeno::utils::Logger::getInstance().warning("Proxy build failed: ", result.error_message);
+                    }
+                    return;
+                }
+                std::filesystem::rename(partial, proxy, ignored);
+            }
+            
+            auto proxy_cache = makeFrameCache(generation);
+            if (proxy_cache->open(proxy, keep_going)) {
+                useFrameCache(proxy_cache, generation, "Scrubbing from proxy");
+            }
+        });
+    }
+    
+    using AnalysisProgress = std::function<bool(double fraction)>;
+    
+    // Runs work on the analysis thread behind a progress dialog. Work reports through the
+    // callback it is given, which returns false once cancelled, and returns what to run
+    // on the GUI thread when it is done.
+    void runAnalysis(const QString& label, std::function<std::function<void()>(const AnalysisProgress&)> work) {
+        if (analysis_running) {
+            QMessageBox::information(this, "Analysis", "A video analysis is already in progress.");
+            return;
+        }
+        if (analysis_thread.joinable()) {
+            analysis_thread.join();
+        }
+        
+        auto progress = new QProgressDialog(label, "Cancel", 0, 100, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
+        connect(progress, &QProgressDialog::canceled, this, [this]() { analysis_cancelled = true; });
+        
+        QPointer<QProgressDialog> dialog(progress);
+        analysis_cancelled = false;
+        analysis_running = true;
+        analysis_thread = std::thread([this, dialog, work = std::move(work)]() {
+            int last_percent = -1;
+            auto finish = work([&](double fraction) {
+                int percent = static_cast<int>(fraction * 100);
+                if (percent != last_percent) {
+                    last_percent = percent;
+                    QMetaObject::invokeMethod(this, [dialog, percent]() {
+                        if (dialog) {
+                            dialog->setValue(percent);
+                        }
+                    }, Qt::QueuedConnection);
+                }
+                return !analysis_cancelled.load();
+            });
+            
+            QMetaObject::invokeMethod(this, [this, dialog, finish]() {
+                analysis_running = false;
+                if (dialog) {
+                    dialog->close();
+                }
+                finish();
+            }, Qt::QueuedConnection);
+        });
+    }
+    
+    void refreshClipList(uint64_t selected) {
+        clip_list->clear();
+        for (const auto& track : timeline.tracks()) {
+            for (const auto* clip : timeline.clips(track.id)) {
+                auto item = new QListWidgetItem(QString("%1: %2  [%3s - %4s] at %5s")
+                    .arg(QString::fromStdString(track.name))
+                    .arg(QFileInfo(QString::fromStdString(clip->source_path)).fileName())
+                    .arg(clip->source_in, 0, 'f', 2)
+                    .arg(clip->source_out, 0, 'f', 2)
+                    .arg(clip->start, 0, 'f', 2));
+                item->setData(Qt::UserRole, QVariant::fromValue<qulonglong>(clip->id));
+                clip_list->addItem(item);
+                if (clip->id == selected) {
+                    clip_list->setCurrentItem(item);
+                }
+            }
+        }
+    }
+    
+    std::shared_ptr<xeno::video::FrameCache> makeFrameCache(uint64_t generation) {
+        return std::make_shared<xeno::video::FrameCache>(xeno::video::FrameCache::Options{},
+            [this, generation](xeno::video::FrameCache::FramePtr frame) {
+                QMetaObject::invokeMethod(this, [this, frame, generation]() {
+                    if (generation == media_generation && time_slider->isSliderDown()) {
+                        showFrame(*frame);
+                    }
+                }, Qt::QueuedConnection);
+            });
+    }
+    
+    void useFrameCache(std::shared_ptr<xeno::video::FrameCache> cache, uint64_t generation, const QString& message) {
+        QMetaObject::invokeMethod(this, [this, cache, generation, message]() {
+            if (generation == media_generation) {
+                frame_cache = cache;
+                statusBar()->showMessage(QString("%1 - %2 frames, %3 keyframes")
+                    .arg(message).arg(cache->frameCount()).arg(cache->keyframeCount()));
+            }
+        }, Qt::QueuedConnection);
+    }
+    
+    void showFrame(const xeno::video::FrameCache::Frame& frame) {
+        QVideoFrame video_frame(QVideoFrameFormat(QSize(frame.width, frame.height),
+                                                  QVideoFrameFormat::Format_RGBA8888));
+        if (!video_frame.map(QVideoFrame::WriteOnly)) {
+            return;
+        }
+        size_t row_bytes = static_cast<size_t>(frame.width) * 4;
+        for (int y = 0; y < frame.height; ++y) {
+            std::memcpy(video_frame.bits(0) + y * video_frame.bytesPerLine(0), frame.pixels.data() + y * row_bytes,
+                        row_bytes);
+        }
+        video_frame.unmap();
+        video_widget->videoSink()->setVideoFrame(video_frame);
+    }
+    
     void setupUI() {
         auto central_widget = new QWidget;
         setCentralWidget(central_widget);
@@ -212,9 +620,9 @@ private:
         auto ai_tools_layout = new QVBoxLayout(ai_group);
         
         auto auto_edit_btn = new QPushButton("AI Auto-Edit (8 credits)");
-        auto stabilize_btn = new QPushButton("Stabilize Video (5 credits)");
+        auto stabilize_btn = new QPushButton("Stabilize Video (local)");
         auto enhance_btn = new QPushButton("Enhance Quality (6 credits)");
-        auto smart_cut_btn = new QPushButton("Smart Cut Detection (3 credits)");
+        auto smart_cut_btn = new QPushButton("Smart Cut Detection (local)");
         
         auto_edit_btn->setStyleSheet("background-color: #3498db; color: white; font-weight: bold; padding: 12px;");
         stabilize_btn->setStyleSheet("background-color: #9b59b6; color: white; font-weight: bold; padding: 12px;");
@@ -233,12 +641,23 @@ private:
         auto timeline_layout = new QVBoxLayout(timeline_group);
         
         clip_list = new QListWidget;
-        clip_list->addItem("Track 1: Video");
-        clip_list->addItem("Track 2: Audio");
-        clip_list->addItem("Track 3: Effects");
-        
         timeline_layout->addWidget(clip_list);
         
+        auto trim_layout = new QHBoxLayout;
+        auto set_in_btn = new QPushButton("Set In");
+        auto set_out_btn = new QPushButton("Set Out");
+        auto remove_clip_btn = new QPushButton("Remove");
+        set_in_btn->setToolTip("Trim the selected clip to start at the playhead");
+        set_out_btn->setToolTip("Trim the selected clip to end at the playhead");
+        trim_layout->addWidget(set_in_btn);
+        trim_layout->addWidget(set_out_btn);
+        trim_layout->addWidget(remove_clip_btn);
+        timeline_layout->addLayout(trim_layout);
+        
+        connect(set_in_btn, &QPushButton::clicked, this, [this]() { trimSelectedClip(true); });
+        connect(set_out_btn, &QPushButton::clicked, this, [this]() { trimSelectedClip(false); });
+        connect(remove_clip_btn, &QPushButton::clicked, this, &VideoEditWindow::removeSelectedClip);
+        
         ai_layout->addWidget(timeline_group);
         
         // Credit status
@@ -275,6 +694,7 @@ private:
         connect(auto_edit_btn, &QPushButton::clicked, this, &VideoEditWindow::applyAutoEdit);
         connect(stabilize_btn, &QPushButton::clicked, this, &VideoEditWindow::stabilizeVideo);
         connect(enhance_btn, &QPushButton::clicked, this, &VideoEditWindow::enhanceQuality);
+        connect(smart_cut_btn, &QPushButton::clicked, this, &VideoEditWindow::detectSmartCuts);
         
         updateCreditDisplay();
     }
@@ -294,7 +714,13 @@ private:
         auto ai_menu = menuBar()->addMenu("&AI Tools");
         ai_menu->addAction("Auto-Edit", this, &VideoEditWindow::applyAutoEdit);
         ai_menu->addAction("Stabilize", this, &VideoEditWindow::stabilizeVideo);
+        ai_menu->addAction("Smart Cut Detection", this, &VideoEditWindow::detectSmartCuts);
         ai_menu->addAction("Enhance Quality", this, &VideoEditWindow::enhanceQuality);
+        
+        auto view_menu = menuBar()->addMenu("&View");
+        proxy_action = view_menu->addAction("Scrub 4K+ Sources from Proxies");
+        proxy_action->setCheckable(true);
+        proxy_action->setChecked(true);
     }
     
     void setupToolbars() {
@@ -308,11 +734,46 @@ private:
     
     void setupConnections() {
         connect(media_player, &QMediaPlayer::durationChanged, time_slider, &QSlider::setMaximum);
+        connect(media_player, &QMediaPlayer::durationChanged, this, [this](qint64 duration) {
+            if (pending_timeline_source.isEmpty() || duration <= 0) {
+                return;
+            }
+            uint64_t id = timeline.addClip(video_track, pending_timeline_source.toStdString(), 0.0,
+                                           duration / 1000.0, timeline.duration());
+            pending_timeline_source.clear();
+            refreshClipList(id);
+        });
         connect(media_player, &QMediaPlayer::positionChanged, time_slider, &QSlider::setValue);
-        connect(time_slider, &QSlider::sliderMoved, media_player, &QMediaPlayer::setPosition);
+        
+        // Dragging shows frames from the cache; the player seeks once, on release
+        connect(time_slider, &QSlider::sliderPressed, this, [this]() {
+            resume_after_scrub = media_player->playbackState() == QMediaPlayer::PlayingState;
+            if (resume_after_scrub) {
+                media_player->pause();
+            }
+            scrub_position = time_slider->value();
+        });
+        connect(time_slider, &QSlider::sliderMoved, this, [this](int value) {
+            int direction = value > scrub_position ? 1 : (value < scrub_position ? -1 : 0);
+            scrub_position = value;
+            if (!frame_cache) {
+                media_player->setPosition(value);
+            } else if (auto frame = frame_cache->request(value / 1000.0, direction)) {
+                showFrame(*frame);
+            }
+        });
+        connect(time_slider, &QSlider::sliderReleased, this, [this]() {
+            media_player->setPosition(time_slider->value());
+            if (resume_after_scrub) {
+                media_player->play();
+            }
+        });
     }
     
     void loadConfiguration() {
+        // With the launcher running, AI requests and credits go through its shared service and the
+        // config here only takes over if the launcher quits
+        ai_integration->connectToBroker(xeno::ai::AIBroker::defaultAddress());
         std::string config_path = xeno::utils::Platform::getAppDataPath() + "/config.json";
         ai_integration->loadConfigFromFile(config_path);
     }
@@ -334,11 +795,43 @@ private:
     QVideoWidget* video_widget;
     QString current_video_path;
     
+    // Upload to resume if the last auto-edit job failed part way
+    QString auto_edit_transfer_source;
+    QString auto_edit_transfer_id;
+    
+    // Export runs on its own thread; joined before the window is destroyed
+    std::thread export_thread;
+    std::atomic<bool> export_cancelled{false};
+    bool export_running = false;
+    
+    // Stabilization and cut detection; joined like the export thread
+    std::thread analysis_thread;
+    std::atomic<bool> analysis_cancelled{false};
+    bool analysis_running = false;
+    
+    // Clips to export; the list widget shows them
+    static constexpr double kMinimumClipSeconds = 0.001;
+    xeno::video::Timeline timeline;
+    uint64_t video_track = 0;
+    QString pending_timeline_source;
+    
+    // Frame index and proxy preparation for scrubbing
+    static constexpr int kProxyMinimumHeight = 2160;
+    static constexpr int kProxyHeight = 540;
+    static constexpr int64_t kProxyBitRate = 12'000'000; // Intra-only needs more bits than long-GOP
+    std::thread media_thread;
+    std::atomic<bool> media_cancelled{false};
+    uint64_t media_generation = 0; // Identifies the latest video; older results are dropped
+    std::shared_ptr<xeno::video::FrameCache> frame_cache;
+    int scrub_position = 0;
+    bool resume_after_scrub = false;
+    
     // UI elements
     QPushButton* play_pause_btn;
     QSlider* time_slider;
     QListWidget* clip_list;
     QLabel* credit_status;
+    QAction* proxy_action;
 };
 
 int main(int argc, char *argv[]) {
@@ -348,6 +841,12 @@ int main(int argc, char *argv[]) {
     QApplication::setApplicationVersion("1.0.0");
     QApplication::setOrganizationName("Xeno AI");
     
+    // Log to <app data>/logs/video-edit.log as well as the console
+    xeno::utils::Logger::Options log_options;
+    log_options.file_name = "video-edit";
+    xeno::utils::Logger::getInstance().configure(log_options);
+    // Edits to config.json apply without a restart
+    xeno::utils::ConfigManager::getInstance().watch();
     xeno::utils::Logger::getInstance().info("Starting Xeno Video Edit");
     
     VideoEditWindow window;
@@ -0,0 +1,197 @@
+#include "timeline.h"
+#include <algorithm>
+
+namespace xeno::video {
+
+uint64_t Timeline::addTrack(const std::string& name) {
+    Track track;
+    track.id = next_id++;
+    track.name = name;
+    track_list.push_back(track);
+    track_clips.emplace_back();
+    return track.id;
+}
+
+bool Timeline::setTrackEnabled(uint64_t track, bool enabled) {
+    int index = trackIndex(track);
+    if (index < 0) {
+        return false;
+    }
+    track_list[index].enabled = enabled;
+    return true;
+}
+
+uint64_t Timeline::addClip(uint64_t track, const std::string& source_path, double source_in, double source_out,
+                           double start) {
+    int index = trackIndex(track);
+    double end = start + (source_out - source_in);
+    if (index < 0 || source_in < 0.0 || start < 0.0 || !(source_in < source_out) || !fits(index, start, end, 0)) {
+        return 0;
+    }
+    
+    Clip clip;
+    clip.id = next_id++;
+    clip.track = track;
+    clip.source_path = source_path;
+    clip.source_in = source_in;
+    clip.source_out = source_out;
+    clip.start = start;
+    track_clips[index].insert(clip.start, clip.end(), clip.id);
+    clip_map.emplace(clip.id, std::move(clip));
+    return next_id - 1;
+}
+
+bool Timeline::moveClip(uint64_t id, double start) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end() || start < 0.0) {
+        return false;
+    }
+    Clip& clip = entry->second;
+    int index = trackIndex(clip.track);
+    if (!fits(index, start, start + clip.duration(), id)) {
+        return false;
+    }
+    track_clips[index].erase(clip.start, id);
+    clip.start = start;
+    track_clips[index].insert(clip.start, clip.end(), id);
+    return true;
+}
+
+bool Timeline::trimClip(uint64_t id, double source_in, double source_out) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end() || source_in < 0.0 || !(source_in < source_out)) {
+        return false;
+    }
+    Clip& clip = entry->second;
+    int index = trackIndex(clip.track);
+    if (!fits(index, clip.start, clip.start + (source_out - source_in), id)) {
+        return false;
+    }
+    track_clips[index].erase(clip.start, id);
+    clip.source_in = source_in;
+    clip.source_out = source_out;
+    track_clips[index].insert(clip.start, clip.end(), id);
+    return true;
+}
+
+bool Timeline::setEffects(uint64_t id, std::vector<Effect> effects) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end()) {
+        return false;
+    }
+    entry->second.effects = std::move(effects);
+    return true;
+}
+
+bool Timeline::setSource(uint64_t id, const std::string& source_path) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end()) {
+        return false;
+    }
+    entry->second.source_path = source_path;
+    return true;
+}
+
+uint64_t Timeline::splitClip(uint64_t id, double time) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end() || !(entry->second.start < time) || !(time < entry->second.end())) {
+        return 0;
+    }
+    Clip& clip = entry->second;
+    int index = trackIndex(clip.track);
+    double split = clip.source_in + (time - clip.start);
+    
+    // Both halves replace the original directly; rounding could make a fits() check fail at the join
+    Clip rest = clip;
+    rest.id = next_id++;
+    rest.source_in = split;
+    rest.start = time;
+    track_clips[index].erase(clip.start, id);
+    clip.source_out = split;
+    track_clips[index].insert(clip.start, clip.end(), id);
+    track_clips[index].insert(rest.start, rest.end(), rest.id);
+    clip_map.emplace(rest.id, std::move(rest));
+    return next_id - 1;
+}
+
+bool Timeline::removeClip(uint64_t id) {
+    auto entry = clip_map.find(id);
+    if (entry == clip_map.end()) {
+        return false;
+    }
+    track_clips[trackIndex(entry->second.track)].erase(entry->second.start, id);
+    clip_map.erase(entry);
+    return true;
+}
+
+const Clip* Timeline::clip(uint64_t id) const {
+    auto entry = clip_map.find(id);
+    return entry != clip_map.end() ? &entry->second : nullptr;
+}
+
+std::vector<const Clip*> Timeline::clips(uint64_t track) const {
+    std::vector<const Clip*> result;
+    int index = trackIndex(track);
+    if (index < 0) {
+        return result;
+    }
+    const auto& tree = track_clips[index];
+    tree.visitOverlapping(0.0, tree.maxEnd(0.0), [&](double, double, uint64_t id) {
+        result.push_back(&clip_map.at(id));
+    });
+    return result;
+}
+
+const Clip* Timeline::topClipAt(double time) const {
+    for (size_t i = track_list.size(); i-- > 0;) {
+        if (!track_list[i].enabled) {
+            continue;
+        }
+        const Clip* found = nullptr;
+        track_clips[i].visitAt(time, [&](double, double, uint64_t id) { found = &clip_map.at(id); });
+        if (found) {
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<double> Timeline::edges() const {
+    std::vector<double> result;
+    for (const auto& [id, clip] : clip_map) {
+        if (track_list[trackIndex(clip.track)].enabled) {
+            result.push_back(clip.start);
+            result.push_back(clip.end());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+double Timeline::duration() const {
+    double end = 0.0;
+    for (const auto& tree : track_clips) {
+        end = std::max(end, tree.maxEnd(0.0));
+    }
+    return end;
+}
+
+int Timeline::trackIndex(uint64_t track) const {
+    for (size_t i = 0; i < track_list.size(); i++) {
+        if (track_list[i].id == track) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool Timeline::fits(size_t track_index, double start, double end, uint64_t ignore) const {
+    bool free = true;
+    track_clips[track_index].visitOverlapping(start, end, [&](double, double, uint64_t id) {
+        free = free && id == ignore;
+    });
+    return free;
+}
+
+} // namespace xeno::video
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../shared/utils/include/interval_tree.h"
+
+namespace xeno::video {
+
+struct Effect {
+    std::string name;
+    std::map<std::string, double> parameters;
+};
+
+struct Clip {
+    uint64_t id = 0;
+    uint64_t track = 0;
+    std::string source_path;
+    double source_in = 0.0;  // Seconds into the source
+    double source_out = 0.0;
+    double start = 0.0;      // Seconds into the timeline
+    std::vector<Effect> effects;
+    
+    double duration() const { return source_out - source_in; }
+    double end() const { return start + duration(); }
+};
+
+struct Track {
+    uint64_t id = 0;
+    std::string name;
+    bool enabled = true;
+};
+
+/**
+ * @brief Tracks of clips placed on a shared time axis
+ *
+ * Each track keeps its clips in an interval tree keyed on timeline position,
+ * so finding what plays at a time is O(log n) per track whatever the length
+ * of the project. Clips on one track never overlap; where tracks overlap,
+ * the later track covers the earlier ones.
+ */
+class Timeline {
+public:
+    uint64_t addTrack(const std::string& name);
+    bool setTrackEnabled(uint64_t track, bool enabled);
+    
+    // Returns the new clip's ID, or 0 if the track is unknown, the range empty or the place taken
+    uint64_t addClip(uint64_t track, const std::string& source_path, double source_in, double source_out,
+                     double start);
+    bool moveClip(uint64_t clip, double start);
+    // Keeps the clip's start; fails if the longer clip would run into the next one
+    bool trimClip(uint64_t clip, double source_in, double source_out);
+    bool setEffects(uint64_t clip, std::vector<Effect> effects);
+    // Points the clip at another file with the same timing, such as a processed copy
+    bool setSource(uint64_t clip, const std::string& source_path);
+    // Ends the clip at a timeline time in it and adds the rest as a new clip with the same
+    // effects; returns the new clip's ID, or 0 if time is not inside the clip
+    uint64_t splitClip(uint64_t clip, double time);
+    bool removeClip(uint64_t clip);
+    
+    const Clip* clip(uint64_t id) const;
+    const std::vector<Track>& tracks() const { return track_list; }
+    // The clips of one track in time order
+    std::vector<const Clip*> clips(uint64_t track) const;
+    // The clip on the topmost enabled track playing at time, or nullptr
+    const Clip* topClipAt(double time) const;
+    // Every clip start and end on enabled tracks, sorted and unique
+    std::vector<double> edges() const;
+    double duration() const;
+    bool empty() const { return clip_map.empty(); }
+
+private:
+    // Position of the track in track_list, or -1
+    int trackIndex(uint64_t track) const;
+    bool fits(size_t track_index, double start, double end, uint64_t ignore) const;
+    
+    std::vector<Track> track_list;
+    std::vector<utils::IntervalTree<double, uint64_t>> track_clips; // Parallel to track_list
+    std::unordered_map<uint64_t, Clip> clip_map;
+    uint64_t next_id = 1;
+};
+
+} // namespace xeno::video
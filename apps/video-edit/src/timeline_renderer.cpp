@@ -0,0 +1,324 @@
+#include "timeline_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace xeno::video {
+
+namespace {
+
+constexpr double kTimeEpsilon = 1e-6; // Below any frame duration
+// Matroska accepts nearly any codec, so segments keep whatever audio the source had
+constexpr const char* kSegmentExtension = ".mkv";
+
+std::string errorText(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, text, sizeof(text));
+    return text;
+}
+
+void applyBrightness(AVFrame& frame, double amount) {
+    const AVPixFmtDescriptor* format = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame.format));
+    if (!format || (format->flags & AV_PIX_FMT_FLAG_RGB) || format->comp[0].depth != 8) {
+        return;
+    }
+    int offset = static_cast<int>(std::lround(std::clamp(amount, -1.0, 1.0) * 255.0));
+    for (int y = 0; y < frame.height; y++) {
+        uint8_t* row = frame.data[0] + static_cast<ptrdiff_t>(y) * frame.linesize[0];
+        for (int x = 0; x < frame.width; x++) {
+            row[x] = static_cast<uint8_t>(std::clamp(row[x] + offset, 0, 255));
+        }
+    }
+}
+
+void applyEffect(AVFrame& frame, const Effect& effect) {
+    if (effect.name == "brightness") {
+        auto amount = effect.parameters.find("amount");
+        applyBrightness(frame, amount != effect.parameters.end() ? amount->second : 0.0);
+    }
+}
+
+} // namespace
+
+TimelineRenderer::TimelineRenderer(const Options& options) : options(options) {
+    if (!(this->options.segment_seconds > 0.0)) {
+        this->options.segment_seconds = Options{}.segment_seconds;
+    }
+}
+
+std::vector<TimelineRenderer::Segment> TimelineRenderer::plan(const Timeline& timeline) const {
+    std::vector<Segment> segments;
+    std::vector<double> edges = timeline.edges();
+    double step = options.segment_seconds;
+    
+    size_t i = 0;
+    while (i + 1 < edges.size()) {
+        const Clip* clip = timeline.topClipAt((edges[i] + edges[i + 1]) / 2.0);
+        size_t j = i + 1;
+        // Neighbouring spans showing the same clip form one run
+        while (clip && j + 1 < edges.size() && timeline.topClipAt((edges[j] + edges[j + 1]) / 2.0) == clip) {
+            j++;
+        }
+        
+        if (clip) {
+            double run_start = clip->source_in + (edges[i] - clip->start);
+            double run_end = clip->source_in + (edges[j] - clip->start);
+            double cut = run_start;
+            while (run_end - cut > kTimeEpsilon) {
+                double next = (std::floor(cut / step + kTimeEpsilon) + 1.0) * step;
+                if (next > run_end - kTimeEpsilon) {
+                    next = run_end;
+                }
+                
+                Segment segment;
+                segment.clip = clip->id;
+                segment.source_path = clip->source_path;
+                segment.source_start = cut;
+                segment.source_end = next;
+                segment.timeline_start = edges[i] + (cut - run_start);
+                segment.effects = clip->effects;
+                segment.key = segmentKey(segment);
+                segments.push_back(std::move(segment));
+                cut = next;
+            }
+        }
+        i = j;
+    }
+    return segments;
+}
+
+TimelineRenderer::Result TimelineRenderer::render(const Timeline& timeline, const std::string& output,
+                                                  const Progress& progress) {
+    Result result;
+    std::vector<Segment> segments = plan(timeline);
+    result.segments = segments.size();
+    if (segments.empty()) {
+        result.error_message = "The timeline is empty";
+        return result;
+    }
+    for (const auto& segment : segments) {
+        for (const auto& effect : segment.effects) {
+            if (!supportsEffect(effect.name)) {
+                result.error_message = "Unsupported effect: " + effect.name;
+                return result;
+            }
+        }
+    }
+    
+    double total = 0.0;
+    for (const auto& segment : segments) {
+        total += segment.duration();
+    }
+    double done = 0.0;
+    for (const auto& segment : segments) {
+        std::error_code ignored;
+        if (!std::filesystem::exists(segmentPath(segment), ignored)) {
+            auto segment_progress = [&](double fraction) {
+                return !progress || progress((done + fraction * segment.duration()) / total);
+            };
+            if (!encodeSegment(segment, segment_progress, result.error_message)) {
+                return result;
+            }
+            result.encoded++;
+        }
+        done += segment.duration();
+        if (progress && !progress(done / total)) {
+            result.error_message = "Export cancelled";
+            return result;
+        }
+    }
+    
+    result.success = join(segments, output, result.error_message);
+    return result;
+}
+
+std::string TimelineRenderer::segmentPath(const Segment& segment) const {
+    return (std::filesystem::path(options.cache_directory) / (segment.key + kSegmentExtension)).string();
+}
+
+bool TimelineRenderer::supportsEffect(const std::string& name) {
+    return name == "brightness";
+}
+
+std::string TimelineRenderer::segmentKey(const Segment& segment) const {
+    std::error_code error;
+    std::ostringstream key;
+    key << std::filesystem::absolute(segment.source_path, error).string() << '|'
+        << std::filesystem::file_size(segment.source_path, error) << '|'
+        << std::filesystem::last_write_time(segment.source_path, error).time_since_epoch().count() << '|'
+        << std::llround(segment.source_start / kTimeEpsilon) << '|' << std::llround(segment.source_end / kTimeEpsilon);
+    for (const auto& effect : segment.effects) {
+        key << '|' << effect.name;
+        for (const auto& [name, value] : effect.parameters) {
+            key << ':' << name << '=' << value;
+        }
+    }
+    const VideoPipeline::Options& encode = options.encode;
+    key << '|' << encode.codec << '|' << encode.bit_rate << '|' << encode.max_height << '|' << encode.keyframe_interval;
+    
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(key.str());
+    return name.str();
+}
+
+bool TimelineRenderer::encodeSegment(const Segment& segment, const Progress& progress, std::string& error) {
+    VideoPipeline::Options encode = options.encode;
+    encode.start_seconds = segment.source_start;
+    encode.end_seconds = segment.source_end;
+    if (!segment.effects.empty()) {
+        encode.process_frame = [effects = segment.effects](AVFrame* frame) {
+            for (const auto& effect : effects) {
+                applyEffect(*frame, effect);
+            }
+        };
+    }
+    
+    // Written under a temporary name so an interrupted export never leaves a bad cache entry
+    std::string path = segmentPath(segment);
+    std::string partial =
+        (std::filesystem::path(options.cache_directory) / (segment.key + ".part" + kSegmentExtension)).string();
+    std::error_code fs_error;
+    std::filesystem::create_directories(options.cache_directory, fs_error);
+    
+    auto result = VideoPipeline(encode).transcode(segment.source_path, partial, progress);
+    if (!result.success) {
+        error = result.error_message;
+        return false;
+    }
+    std::filesystem::rename(partial, path, fs_error);
+    if (fs_error) {
+        error = "Cannot store rendered segment: " + fs_error.message();
+        return false;
+    }
+    return true;
+}
+
+bool TimelineRenderer::join(const std::vector<Segment>& segments, const std::string& output, std::string& error) {
+    AVFormatContext* target = nullptr;
+    int code = avformat_alloc_output_context2(&target, nullptr, nullptr, output.c_str());
+    if (code < 0 || !target) {
+        error = "Unsupported output format for " + output;
+        return false;
+    }
+    AVPacket* packet = av_packet_alloc();
+    std::vector<int64_t> last_dts;
+    bool header_written = false;
+    
+    auto finish = [&](bool success) {
+        if (header_written && success) {
+            code = av_write_trailer(target);
+            if (code < 0) {
+                error = "Finishing " + output + " failed: " + errorText(code);
+                success = false;
+            }
+        }
+        if (target->pb && !(target->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&target->pb);
+        }
+        avformat_free_context(target);
+        av_packet_free(&packet);
+        if (!success && header_written) {
+            std::error_code ignored;
+            std::filesystem::remove(output, ignored);
+        }
+        return success;
+    };
+    
+    for (const auto& segment : segments) {
+        AVFormatContext* source = nullptr;
+        std::string path = segmentPath(segment);
+        code = avformat_open_input(&source, path.c_str(), nullptr, nullptr);
+        if (code >= 0) {
+            code = avformat_find_stream_info(source, nullptr);
+        }
+        if (code < 0) {
+            avformat_close_input(&source);
+            error = "Cannot read rendered segment " + path + ": " + errorText(code);
+            return finish(false);
+        }
+        
+        if (!header_written) {
+            // The first segment decides the output streams
+            for (unsigned i = 0; i < source->nb_streams; i++) {
+                AVStream* stream = avformat_new_stream(target, nullptr);
+                avcodec_parameters_copy(stream->codecpar, source->streams[i]->codecpar);
+                stream->codecpar->codec_tag = 0;
+                stream->time_base = source->streams[i]->time_base;
+            }
+            code = 0;
+            if (!(target->oformat->flags & AVFMT_NOFILE)) {
+                code = avio_open(&target->pb, output.c_str(), AVIO_FLAG_WRITE);
+            }
+            if (code >= 0) {
+                code = avformat_write_header(target, nullptr);
+            }
+            if (code < 0) {
+                avformat_close_input(&source);
+                error = "Cannot write " + output + ": " + errorText(code);
+                return finish(false);
+            }
+            header_written = true;
+            last_dts.assign(target->nb_streams, AV_NOPTS_VALUE);
+        } else {
+            bool matches = source->nb_streams == target->nb_streams;
+            for (unsigned i = 0; matches && i < source->nb_streams; i++) {
+                const AVCodecParameters* a = source->streams[i]->codecpar;
+                const AVCodecParameters* b = target->streams[i]->codecpar;
+                matches = a->codec_id == b->codec_id && a->width == b->width && a->height == b->height &&
+                          a->sample_rate == b->sample_rate;
+            }
+            if (!matches) {
+                avformat_close_input(&source);
+                error = "Clip " + segment.source_path +
+                        " differs in resolution or audio format from the first clip; convert it before exporting";
+                return finish(false);
+            }
+        }
+        
+        int64_t offset = std::llround(segment.timeline_start * AV_TIME_BASE);
+        while ((code = av_read_frame(source, packet)) >= 0) {
+            AVStream* from = source->streams[packet->stream_index];
+            AVStream* to = target->streams[packet->stream_index];
+            av_packet_rescale_ts(packet, from->time_base, to->time_base);
+            int64_t shift = av_rescale_q(offset, AV_TIME_BASE_Q, to->time_base);
+            packet->pts = packet->pts != AV_NOPTS_VALUE ? packet->pts + shift : packet->pts;
+            packet->dts = packet->dts != AV_NOPTS_VALUE ? packet->dts + shift : packet->dts;
+            
+            // Reordered frames give each segment a first DTS slightly before its start;
+            // nudge it past the previous segment's last one so DTS keeps rising
+            int64_t& last = last_dts[packet->stream_index];
+            if (packet->dts != AV_NOPTS_VALUE && last != AV_NOPTS_VALUE && packet->dts <= last) {
+                packet->dts = last + 1;
+                if (packet->pts != AV_NOPTS_VALUE && packet->pts < packet->dts) {
+                    packet->pts = packet->dts;
+                }
+            }
+            if (packet->dts != AV_NOPTS_VALUE) {
+                last = packet->dts;
+            }
+            packet->pos = -1;
+            
+            code = av_interleaved_write_frame(target, packet);
+            if (code < 0) {
+                avformat_close_input(&source);
+                error = "Writing " + output + " failed: " + errorText(code);
+                return finish(false);
+            }
+        }
+        avformat_close_input(&source);
+        if (code != AVERROR_EOF) {
+            error = "Reading rendered segment " + path + " failed: " + errorText(code);
+            return finish(false);
+        }
+    }
+    return finish(true);
+}
+
+} // namespace xeno::video
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "timeline.h"
+#include "video_pipeline.h"
+
+namespace xeno::video {
+
+/**
+ * @brief Renders a Timeline to one file, re-encoding only what an edit changed
+ *
+ * The timeline is cut wherever the visible clip changes, and each run of one
+ * clip is cut again at fixed steps of source time. Every segment is encoded
+ * on its own, starting with a keyframe, into a cache file named after the
+ * segment's content: its source file, source range, effects and the encoder
+ * settings, but not its place on the timeline. Export then only encodes
+ * segments with no cache file and joins all of them with a stream copy.
+ *
+ * Because steps are anchored in source time, trimming a clip's in point only
+ * changes its first segment, and moving clips changes none. Time where no
+ * track has a clip holds the previous frame.
+ *
+ * Supported effects: "brightness" with "amount" in [-1, 1], applied to the
+ * luma plane of 8-bit frames.
+ */
+class TimelineRenderer {
+public:
+    struct Options {
+        std::string cache_directory;
+        VideoPipeline::Options encode;
+        double segment_seconds = 4.0;
+    };
+    
+    struct Segment {
+        uint64_t clip = 0;
+        std::string source_path;
+        double source_start = 0.0;
+        double source_end = 0.0;
+        double timeline_start = 0.0;
+        std::vector<Effect> effects;
+        std::string key; // Names the cache file
+        
+        double duration() const { return source_end - source_start; }
+    };
+    
+    struct Result {
+        bool success = false;
+        std::string error_message;
+        size_t segments = 0;
+        size_t encoded = 0; // Segments that were not cached
+    };
+    
+    // Receives the fraction of the timeline done; returning false cancels
+    using Progress = std::function<bool(double fraction)>;
+    
+    explicit TimelineRenderer(const Options& options);
+    
+    std::vector<Segment> plan(const Timeline& timeline) const;
+    Result render(const Timeline& timeline, const std::string& output, const Progress& progress = nullptr);
+    
+    std::string segmentPath(const Segment& segment) const;
+    static bool supportsEffect(const std::string& name);
+
+private:
+    std::string segmentKey(const Segment& segment) const;
+    bool encodeSegment(const Segment& segment, const Progress& progress, std::string& error);
+    // Stream-copies the segment files into output, each at its timeline position
+    bool join(const std::vector<Segment>& segments, const std::string& output, std::string& error);
+    
+    Options options;
+};
+
+} // namespace xeno::video
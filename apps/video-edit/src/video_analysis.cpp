@@ -0,0 +1,540 @@
+#include "video_analysis.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+namespace xeno::video {
+
+namespace {
+
+constexpr double kMinRangeSeconds = 2.0; // Shorter ranges spend more on seeking than they save
+constexpr auto kProgressInterval = std::chrono::milliseconds(50);
+constexpr int kMaxFeatures = 200;
+constexpr double kFeatureQuality = 0.01;
+constexpr double kFeatureDistance = 20.0;
+constexpr size_t kMinFeatures = 10;
+constexpr int kHistogramBins = 32;
+constexpr int kPeakRadius = 5;   // Frames each side a cut must stand out from
+constexpr double kPeakRatio = 3.0;
+constexpr double kPi = 3.14159265358979323846;
+
+std::string errorText(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, text, sizeof(text));
+    return text;
+}
+
+// Decodes the video stream of a file to 8-bit luma frames of a fixed width
+class LumaReader {
+public:
+    ~LumaReader() {
+        sws_freeContext(scaler);
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&codec);
+        avformat_close_input(&format);
+    }
+    
+    bool open(const std::string& path, int max_width, std::string& error) {
+        int code = avformat_open_input(&format, path.c_str(), nullptr, nullptr);
+        if (code < 0) {
+            error = "Cannot open " + path + ": " + errorText(code);
+            return false;
+        }
+        code = avformat_find_stream_info(format, nullptr);
+        if (code < 0) {
+            error = "Cannot read streams of " + path + ": " + errorText(code);
+            return false;
+        }
+        const AVCodec* decoder = nullptr;
+        stream_index = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+        if (stream_index < 0 || !decoder) {
+            error = "No decodable video stream in " + path;
+            return false;
+        }
+        for (unsigned i = 0; i < format->nb_streams; i++) {
+            if (static_cast<int>(i) != stream_index) {
+                format->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+        AVStream* stream = format->streams[stream_index];
+        
+        codec = avcodec_alloc_context3(decoder);
+        avcodec_parameters_to_context(codec, stream->codecpar);
+        codec->pkt_timebase = stream->time_base;
+        // Ranges already run one per core, so each decoder stays on its own thread
+        codec->thread_count = 1;
+        code = avcodec_open2(codec, decoder, nullptr);
+        if (code < 0) {
+            error = std::string("Cannot open the ") + decoder->name + " decoder: " + errorText(code);
+            return false;
+        }
+        
+        int source_width = stream->codecpar->width;
+        int source_height = stream->codecpar->height;
+        if (source_width <= 0 || source_height <= 0) {
+            error = "The video stream of " + path + " has no frame size";
+            return false;
+        }
+        width = std::min(source_width, std::max(max_width, 16)) & ~1;
+        double scaled_height = static_cast<double>(width) * source_height / source_width;
+        height = std::max(2, static_cast<int>(std::lround(scaled_height / 2.0)) * 2);
+        
+        time_base = av_q2d(stream->time_base);
+        origin_pts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        if (format->duration > 0) {
+            duration = static_cast<double>(format->duration) / AV_TIME_BASE;
+        } else if (stream->duration > 0) {
+            duration = stream->duration * time_base;
+        }
+        AVRational rate = av_guess_frame_rate(format, stream, nullptr);
+        frame_rate = rate.num > 0 && rate.den > 0 ? av_q2d(rate) : 25.0;
+        
+        packet = av_packet_alloc();
+        frame = av_frame_alloc();
+        return true;
+    }
+    
+    // Moves to the keyframe at or before seconds, so next() may return earlier frames first
+    bool seek(double seconds) {
+        int64_t target = toPts(seconds);
+        if (av_seek_frame(format, stream_index, target, AVSEEK_FLAG_BACKWARD) < 0) {
+            return false;
+        }
+        avcodec_flush_buffers(codec);
+        flushed = false;
+        return true;
+    }
+    
+    // Decodes the next frame in presentation order; false at the end or on an error
+    bool next(cv::Mat& luma, int64_t& pts) {
+        while (true) {
+            int code = avcodec_receive_frame(codec, frame);
+            if (code == 0) {
+                pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+                bool converted = convert(luma);
+                av_frame_unref(frame);
+                if (!converted) {
+                    return false;
+                }
+                if (pts == AV_NOPTS_VALUE) {
+                    continue;
+                }
+                return true;
+            }
+            if (code != AVERROR(EAGAIN) || flushed) {
+                return false;
+            }
+            if (av_read_frame(format, packet) < 0) {
+                avcodec_send_packet(codec, nullptr);
+                flushed = true;
+                continue;
+            }
+            if (packet->stream_index == stream_index) {
+                avcodec_send_packet(codec, packet);
+            }
+            av_packet_unref(packet);
+        }
+    }
+    
+    int64_t toPts(double seconds) const { return origin_pts + std::llround(seconds / time_base); }
+    
+    int width = 0;
+    int height = 0;
+    double duration = 0.0;
+    double frame_rate = 25.0;
+    double time_base = 0.0;
+    int64_t origin_pts = 0;
+
+private:
+    bool convert(cv::Mat& luma) {
+        scaler = sws_getCachedContext(scaler, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                      width, height, AV_PIX_FMT_GRAY8, SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (!scaler) {
+            return false;
+        }
+        luma.create(height, width, CV_8UC1);
+        uint8_t* planes[4] = {luma.data, nullptr, nullptr, nullptr};
+        int strides[4] = {static_cast<int>(luma.step), 0, 0, 0};
+        sws_scale(scaler, frame->data, frame->linesize, 0, frame->height, planes, strides);
+        return true;
+    }
+    
+    AVFormatContext* format = nullptr;
+    AVCodecContext* codec = nullptr;
+    SwsContext* scaler = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+    int stream_index = -1;
+    bool flushed = false;
+};
+
+struct ScanInfo {
+    int width = 0;
+    int height = 0;
+    double frame_rate = 25.0;
+    double time_base = 0.0;
+    int64_t origin_pts = 0;
+};
+
+// Receives a frame and the one before it (nullptr for the first frame of the file)
+using PairVisitor = std::function<void(size_t range, const cv::Mat* previous, const cv::Mat& current, int64_t pts)>;
+
+// Splits the file into at most threads time ranges and decodes each on its own
+// thread, calling visit for every frame. Each range calls visit in pts order.
+bool scanFrames(const std::string& path, int width, int threads, const PairVisitor& visit,
+                const VideoAnalysis::Progress& progress, ScanInfo& info, std::string& error) {
+    double duration = 0.0;
+    {
+        LumaReader probe;
+        if (!probe.open(path, width, error)) {
+            return false;
+        }
+        duration = probe.duration;
+        info.width = probe.width;
+        info.height = probe.height;
+        info.frame_rate = probe.frame_rate;
+        info.time_base = probe.time_base;
+        info.origin_pts = probe.origin_pts;
+    }
+    
+    // An unknown duration cannot be split, so one range reads the whole file
+    size_t range_count = static_cast<size_t>(std::clamp(static_cast<int>(duration / kMinRangeSeconds), 1, threads));
+    double range_seconds = duration / static_cast<double>(range_count);
+    
+    std::atomic<bool> cancelled{false};
+    std::atomic<int64_t> frames_done{0};
+    std::atomic<size_t> running{range_count};
+    std::mutex error_mutex;
+    std::string range_error;
+    
+    std::vector<std::thread> workers;
+    workers.reserve(range_count);
+    for (size_t range = 0; range < range_count; range++) {
+        workers.emplace_back([&, range]() {
+            LumaReader reader;
+            std::string open_error;
+            bool last = range + 1 == range_count;
+            double start = range_seconds * static_cast<double>(range);
+            // Seeking a frame early makes sure the frame before the range is decoded too
+            if (!reader.open(path, width, open_error) ||
+                (range > 0 && !reader.seek(start - 1.0 / reader.frame_rate))) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                range_error = open_error.empty() ? "Cannot seek in " + path : open_error;
+                cancelled = true;
+                running--;
+                return;
+            }
+            int64_t start_pts = range > 0 ? reader.toPts(start) : INT64_MIN;
+            int64_t end_pts = last ? INT64_MAX : reader.toPts(start + range_seconds);
+            
+            // The frame before the range start is only the previous frame of the first one in it
+            cv::Mat previous;
+            cv::Mat current;
+            bool have_previous = false;
+            int64_t pts = 0;
+            while (!cancelled && reader.next(current, pts)) {
+                if (pts >= end_pts) {
+                    break;
+                }
+                if (pts >= start_pts) {
+                    visit(range, have_previous ? &previous : nullptr, current, pts);
+                    frames_done++;
+                }
+                std::swap(previous, current);
+                have_previous = true;
+            }
+            running--;
+        });
+    }
+    
+    double expected = std::max(1.0, duration * info.frame_rate);
+    while (running > 0) {
+        std::this_thread::sleep_for(kProgressInterval);
+        if (progress && !cancelled && !progress(std::min(0.99, frames_done / expected))) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            cancelled = true;
+            range_error = "Analysis cancelled";
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    if (cancelled) {
+        error = range_error;
+        return false;
+    }
+    if (frames_done == 0) {
+        error = "No video frames in " + path;
+        return false;
+    }
+    if (progress) {
+        progress(1.0);
+    }
+    return true;
+}
+
+// Similarity transform from previous to current as (dx, dy, angle); zero when tracking fails
+void estimateMotion(const cv::Mat& previous, const cv::Mat& current, VideoAnalysis::Correction& step) {
+    cv::UMat from_image;
+    cv::UMat to_image;
+    previous.copyTo(from_image);
+    current.copyTo(to_image);
+    
+    std::vector<cv::Point2f> features;
+    cv::goodFeaturesToTrack(from_image, features, kMaxFeatures, kFeatureQuality, kFeatureDistance);
+    if (features.size() < kMinFeatures) {
+        return;
+    }
+    std::vector<cv::Point2f> tracked;
+    std::vector<uchar> status;
+    std::vector<float> tracking_error;
+    cv::calcOpticalFlowPyrLK(from_image, to_image, features, tracked, status, tracking_error);
+    
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    for (size_t i = 0; i < status.size(); i++) {
+        if (status[i]) {
+            from.push_back(features[i]);
+            to.push_back(tracked[i]);
+        }
+    }
+    if (from.size() < kMinFeatures) {
+        return;
+    }
+    cv::Mat fit = cv::estimateAffinePartial2D(from, to);
+    if (fit.empty()) {
+        return;
+    }
+    step.dx = fit.at<double>(0, 2);
+    step.dy = fit.at<double>(1, 2);
+    step.angle = std::atan2(fit.at<double>(1, 0), fit.at<double>(0, 0));
+}
+
+// Average of values[i - radius, i + radius], clipped at the ends
+std::vector<double> movingAverage(const std::vector<double>& values, size_t radius) {
+    std::vector<double> sums(values.size() + 1, 0.0);
+    for (size_t i = 0; i < values.size(); i++) {
+        sums[i + 1] = sums[i] + values[i];
+    }
+    std::vector<double> result(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        size_t low = i > radius ? i - radius : 0;
+        size_t high = std::min(values.size(), i + radius + 1);
+        result[i] = (sums[high] - sums[low]) / static_cast<double>(high - low);
+    }
+    return result;
+}
+
+cv::Mat lumaHistogram(const cv::Mat& luma) {
+    int channels[] = {0};
+    int bins[] = {kHistogramBins};
+    float range[] = {0.0f, 256.0f};
+    const float* ranges[] = {range};
+    cv::Mat histogram;
+    cv::calcHist(&luma, 1, channels, cv::Mat(), histogram, 1, bins, ranges);
+    cv::normalize(histogram, histogram, 1.0, 0.0, cv::NORM_L1);
+    return histogram;
+}
+
+double cutScore(const cv::Mat& previous, const cv::Mat& current) {
+    double difference = cv::norm(previous, current, cv::NORM_L1) / (static_cast<double>(current.total()) * 255.0);
+    double distance = cv::compareHist(lumaHistogram(previous), lumaHistogram(current), cv::HISTCMP_BHATTACHARYYA);
+    return 0.5 * difference + 0.5 * distance;
+}
+
+int threadCount(int requested) {
+    return requested > 0 ? requested : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+template <typename Entry>
+std::vector<Entry> mergeRanges(std::vector<std::vector<Entry>>& ranges) {
+    std::vector<Entry> merged;
+    for (auto& range : ranges) {
+        merged.insert(merged.end(), range.begin(), range.end());
+    }
+    std::sort(merged.begin(), merged.end(), [](const Entry& a, const Entry& b) { return a.pts < b.pts; });
+    return merged;
+}
+
+} // namespace
+
+VideoAnalysis::VideoAnalysis(const Options& options) : options(options) {}
+
+VideoAnalysis::MotionResult VideoAnalysis::analyzeMotion(const std::string& path, const Progress& progress) {
+    MotionResult result;
+    result.used_opencl = cv::ocl::useOpenCL();
+    
+    // Ranges are sized once the file is opened; the visitor only ever touches its own range
+    std::vector<std::vector<Correction>> steps(threadCount(options.threads));
+    auto visit = [&steps](size_t range, const cv::Mat* previous, const cv::Mat& current, int64_t pts) {
+        Correction step;
+        step.pts = pts;
+        if (previous) {
+            estimateMotion(*previous, current, step);
+        }
+        steps[range].push_back(step);
+    };
+    ScanInfo info;
+    if (!scanFrames(path, options.motion_width, static_cast<int>(steps.size()), visit, progress, info,
+                    result.error_message)) {
+        return result;
+    }
+    std::vector<Correction> motion = mergeRanges(steps);
+    
+    // The camera path is the running sum of frame-to-frame motion
+    std::vector<double> path_x(motion.size());
+    std::vector<double> path_y(motion.size());
+    std::vector<double> path_angle(motion.size());
+    double x = 0.0;
+    double y = 0.0;
+    double angle = 0.0;
+    for (size_t i = 0; i < motion.size(); i++) {
+        x += motion[i].dx;
+        y += motion[i].dy;
+        angle += motion[i].angle;
+        path_x[i] = x;
+        path_y[i] = y;
+        path_angle[i] = angle;
+    }
+    size_t radius = static_cast<size_t>(std::max(1L, std::lround(options.smoothing_seconds * info.frame_rate)));
+    std::vector<double> smooth_x = movingAverage(path_x, radius);
+    std::vector<double> smooth_y = movingAverage(path_y, radius);
+    std::vector<double> smooth_angle = movingAverage(path_angle, radius);
+    
+    result.corrections.resize(motion.size());
+    for (size_t i = 0; i < motion.size(); i++) {
+        Correction& correction = result.corrections[i];
+        correction.pts = motion[i].pts;
+        correction.dx = (smooth_x[i] - path_x[i]) / info.width;
+        correction.dy = (smooth_y[i] - path_y[i]) / info.height;
+        correction.angle = smooth_angle[i] - path_angle[i];
+    }
+    result.success = true;
+    return result;
+}
+
+VideoAnalysis::CutResult VideoAnalysis::detectCuts(const std::string& path, const Progress& progress) {
+    struct Score {
+        int64_t pts = 0;
+        double value = 0.0;
+    };
+    
+    CutResult result;
+    std::vector<std::vector<Score>> scores(threadCount(options.threads));
+    auto visit = [&scores](size_t range, const cv::Mat* previous, const cv::Mat& current, int64_t pts) {
+        scores[range].push_back({pts, previous ? cutScore(*previous, current) : 0.0});
+    };
+    ScanInfo info;
+    if (!scanFrames(path, options.cut_width, static_cast<int>(scores.size()), visit, progress, info,
+                    result.error_message)) {
+        return result;
+    }
+    std::vector<Score> merged = mergeRanges(scores);
+    
+    double last_cut = -options.min_shot_seconds;
+    double last_score = 0.0;
+    for (size_t i = 1; i < merged.size(); i++) {
+        double score = merged[i].value;
+        if (score <= options.cut_threshold) {
+            continue;
+        }
+        double around = 0.0;
+        size_t count = 0;
+        for (size_t j = i > kPeakRadius ? i - kPeakRadius : 1; j <= std::min(merged.size() - 1, i + kPeakRadius); j++) {
+            if (j != i) {
+                around += merged[j].value;
+                count++;
+            }
+        }
+        if (count > 0 && score < kPeakRatio * around / static_cast<double>(count)) {
+            continue;
+        }
+        
+        double seconds = (merged[i].pts - info.origin_pts) * info.time_base;
+        if (seconds <= 0.0) {
+            continue;
+        }
+        if (!result.cuts.empty() && seconds - last_cut < options.min_shot_seconds) {
+            if (score > last_score) {
+                result.cuts.back() = seconds;
+                last_cut = seconds;
+                last_score = score;
+            }
+            continue;
+        }
+        result.cuts.push_back(seconds);
+        last_cut = seconds;
+        last_score = score;
+    }
+    result.success = true;
+    return result;
+}
+
+std::function<void(AVFrame*)> VideoAnalysis::stabilizer(const MotionResult& motion) const {
+    auto corrections = std::make_shared<const std::vector<Correction>>(motion.corrections);
+    double zoom = options.border_zoom;
+    
+    return [corrections, zoom](AVFrame* frame) {
+        const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+        if (!descriptor || corrections->empty() || frame->pts == AV_NOPTS_VALUE ||
+            (descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL) || descriptor->comp[0].depth != 8 ||
+            !(descriptor->flags & (AV_PIX_FMT_FLAG_PLANAR | AV_PIX_FMT_FLAG_RGB))) {
+            return;
+        }
+        
+        auto found = std::lower_bound(corrections->begin(), corrections->end(), frame->pts,
+                                      [](const Correction& correction, int64_t pts) { return correction.pts < pts; });
+        if (found == corrections->end()) {
+            found = std::prev(found);
+        }
+        const Correction& correction = *found;
+        bool rgb = descriptor->flags & AV_PIX_FMT_FLAG_RGB;
+        
+        for (int plane = 0; plane < 4 && frame->data[plane]; plane++) {
+            // Bytes per pixel in this plane, and whether it is a subsampled chroma plane
+            int channels = 0;
+            bool chroma = false;
+            for (int c = 0; c < descriptor->nb_components; c++) {
+                if (descriptor->comp[c].plane == plane) {
+                    channels = std::max(channels, descriptor->comp[c].step);
+                    chroma = chroma || (!rgb && (c == 1 || c == 2));
+                }
+            }
+            if (channels == 0 || channels > 4) {
+                continue;
+            }
+            int width = chroma ? AV_CEIL_RSHIFT(frame->width, descriptor->log2_chroma_w) : frame->width;
+            int height = chroma ? AV_CEIL_RSHIFT(frame->height, descriptor->log2_chroma_h) : frame->height;
+            
+            cv::Mat image(height, width, CV_8UC(channels), frame->data[plane], frame->linesize[plane]);
+            cv::Mat transform = cv::getRotationMatrix2D(cv::Point2f(width / 2.0f, height / 2.0f),
+                                                        -correction.angle * 180.0 / kPi, zoom);
+            transform.at<double>(0, 2) += correction.dx * width;
+            transform.at<double>(1, 2) += correction.dy * height;
+            cv::Mat warped;
+            cv::warpAffine(image, warped, transform, image.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+            warped.copyTo(image);
+        }
+    };
+}
+
+} // namespace xeno::video
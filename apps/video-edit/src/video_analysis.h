@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C" {
+struct AVFrame;
+}
+
+namespace xeno::video {
+
+/**
+ * @brief Local stabilization and scene-cut analysis of a video file
+ *
+ * The source is split into time ranges, one per core, and each range is
+ * decoded by its own thread straight to small 8-bit luma frames. Ranges
+ * start one frame early so every frame is compared with the one before it,
+ * and the per-range results are merged in timestamp order.
+ *
+ * Motion between frames comes from corner features tracked with pyramidal
+ * Lucas-Kanade flow and a RANSAC similarity fit. The camera path is then
+ * smoothed in one pass and the difference becomes a per-frame correction.
+ * Images are cv::UMat, so OpenCV runs the tracking through OpenCL when the
+ * machine has a device for it.
+ *
+ * Scene cuts score each frame on its mean luma difference from the previous
+ * frame and the Bhattacharyya distance of the two luma histograms. A cut is a
+ * score above the threshold that also stands out from its neighbours, so
+ * fast motion and flashes do not count.
+ */
+class VideoAnalysis {
+public:
+    struct Options {
+        int threads = 0;                // 0 uses one per core
+        int motion_width = 640;         // Analysis frame widths; height keeps the aspect ratio
+        int cut_width = 160;
+        double smoothing_seconds = 0.5; // Radius of the camera path average
+        double border_zoom = 1.05;      // Hides the edges a correction moves into view
+        double cut_threshold = 0.3;
+        double min_shot_seconds = 0.5;  // Cuts closer together keep the stronger one
+    };
+    
+    // Correction for one frame, as a fraction of the frame size and radians
+    struct Correction {
+        int64_t pts = 0;
+        double dx = 0.0;
+        double dy = 0.0;
+        double angle = 0.0;
+    };
+    
+    struct MotionResult {
+        bool success = false;
+        std::string error_message;
+        std::vector<Correction> corrections; // Sorted by pts
+        bool used_opencl = false;
+    };
+    
+    struct CutResult {
+        bool success = false;
+        std::string error_message;
+        std::vector<double> cuts; // Seconds from the start of the source
+    };
+    
+    // Receives the fraction analysed; returning false cancels. Called on the calling thread.
+    using Progress = std::function<bool(double fraction)>;
+    
+    explicit VideoAnalysis(const Options& options);
+    
+    MotionResult analyzeMotion(const std::string& path, const Progress& progress = nullptr);
+    CutResult detectCuts(const std::string& path, const Progress& progress = nullptr);
+    
+    // A VideoPipeline::process_frame hook that warps each frame by its correction.
+    // Handles 8-bit planar and semi-planar formats; the pipeline must not be trimmed.
+    std::function<void(AVFrame*)> stabilizer(const MotionResult& motion) const;
+
+private:
+    Options options;
+};
+
+} // namespace xeno::video
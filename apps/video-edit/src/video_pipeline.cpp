@@ -0,0 +1,803 @@
+#include "video_pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include "../../shared/utils/include/bounded_queue.h"
+#include "../../shared/utils/include/metrics.h"
+
+namespace xeno::video {
+
+namespace {
+
+struct PacketDeleter {
+    void operator()(AVPacket* packet) const { av_packet_free(&packet); }
+};
+
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+
+struct CodecContextDeleter {
+    void operator()(AVCodecContext* context) const { avcodec_free_context(&context); }
+};
+
+using PacketPtr = std::unique_ptr<AVPacket, PacketDeleter>;
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+using CodecContextPtr = std::unique_ptr<AVCodecContext, CodecContextDeleter>;
+
+// Decoder devices in order of preference for the platform
+constexpr AVHWDeviceType kDecodeDevices[] = {
+#if defined(__APPLE__)
+    AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#elif defined(_WIN32)
+    AV_HWDEVICE_TYPE_CUDA,
+    AV_HWDEVICE_TYPE_D3D11VA,
+#else
+    AV_HWDEVICE_TYPE_CUDA,
+    AV_HWDEVICE_TYPE_VAAPI,
+#endif
+};
+
+struct HardwareEncoder {
+    const char* h264;
+    const char* hevc;
+    AVHWDeviceType device; // Frames decoded on this device are encoded without leaving the GPU
+};
+
+constexpr HardwareEncoder kHardwareEncoders[] = {
+#if defined(__APPLE__)
+    {"h264_videotoolbox", "hevc_videotoolbox", AV_HWDEVICE_TYPE_VIDEOTOOLBOX},
+#else
+    {"h264_nvenc", "hevc_nvenc", AV_HWDEVICE_TYPE_CUDA},
+    {"h264_qsv", "hevc_qsv", AV_HWDEVICE_TYPE_QSV},
+#endif
+};
+
+constexpr size_t kMuxQueueFactor = 4; // Audio and video packets share the mux queue
+
+std::string errorText(int code) {
+    char text[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, text, sizeof(text));
+    return text;
+}
+
+AVPixelFormat hardwareFormat(const AVCodec* codec, AVHWDeviceType type) {
+    for (int i = 0;; i++) {
+        const AVCodecHWConfig* config = avcodec_get_hw_config(codec, i);
+        if (!config) {
+            return AV_PIX_FMT_NONE;
+        }
+        if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) && config->device_type == type) {
+            return config->pix_fmt;
+        }
+    }
+}
+
+AVPixelFormat pickHardwareFormat(AVCodecContext* context, const AVPixelFormat* formats) {
+    auto wanted = static_cast<AVPixelFormat>(reinterpret_cast<intptr_t>(context->opaque));
+    for (const AVPixelFormat* format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+        if (*format == wanted) {
+            return *format;
+        }
+    }
+    // A profile the device cannot decode; FFmpeg falls back to software for this stream
+    return avcodec_default_get_format(context, formats);
+}
+
+// The source format when the encoder takes it, so no conversion is needed
+AVPixelFormat pickSoftwareFormat(const AVCodec* codec, AVPixelFormat source) {
+    if (!codec->pix_fmts) {
+        return source;
+    }
+    AVPixelFormat fallback = AV_PIX_FMT_NONE;
+    for (const AVPixelFormat* format = codec->pix_fmts; *format != AV_PIX_FMT_NONE; ++format) {
+        if (av_pix_fmt_desc_get(*format)->flags & AV_PIX_FMT_FLAG_HWACCEL) {
+            continue;
+        }
+        if (*format == source) {
+            return source;
+        }
+        if (fallback == AV_PIX_FMT_NONE) {
+            fallback = *format;
+        }
+    }
+    return fallback;
+}
+
+/**
+ * @brief State of one transcode; threads share it and stop together on the first error
+ */
+class Session {
+public:
+    explicit Session(const VideoPipeline::Options& options)
+        : options(options),
+          packets(options.queue_depth),
+          frames(options.queue_depth),
+          converted(options.queue_depth),
+          muxed(options.queue_depth * kMuxQueueFactor) {}
+    
+    ~Session() {
+        closeOutput();
+        avformat_free_context(output);
+        avformat_close_input(&input);
+        sws_freeContext(scaler);
+    }
+    
+    VideoPipeline::Result run(const std::string& input_path, const std::string& output_path,
+                              const VideoPipeline::Progress& progress) {
+        VideoPipeline::Result result;
+        bool ready = openInput(input_path) && openDecoder() && openOutput(output_path) && decodeFirstFrame() &&
+                     openEncoder() && writeHeader(output_path);
+        if (ready) {
+            result.decoder = decoder->codec->name;
+            if (first_frame_on_gpu) {
+                result.decoder += std::string(" (") + av_hwdevice_get_type_name(decode_device) + ")";
+            }
+            result.encoder = encoder->codec->name;
+            result.zero_copy = zero_copy;
+            
+            std::thread demuxer(&Session::demuxLoop, this);
+            std::thread decoder_thread(&Session::decodeLoop, this);
+            std::thread processor(&Session::processLoop, this);
+            std::thread encoder_thread(&Session::encodeLoop, this);
+            muxLoop(progress);
+            demuxer.join();
+            decoder_thread.join();
+            processor.join();
+            encoder_thread.join();
+            
+            if (!stopped()) {
+                int code = av_write_trailer(output);
+                if (code < 0) {
+                    fail("Finishing " + output_path + " failed: " + errorText(code));
+                }
+            }
+        }
+        
+        closeOutput();
+        result.frames = frame_count;
+        result.success = !stopped();
+        if (!result.success) {
+            result.error_message = error_message;
+            if (header_written) {
+                std::error_code ignored;
+                std::filesystem::remove(output_path, ignored);
+            }
+        }
+        return result;
+    }
+
+private:
+    bool openInput(const std::string& path) {
+        int code = avformat_open_input(&input, path.c_str(), nullptr, nullptr);
+        if (code < 0) {
+            return fail("Cannot open " + path + ": " + errorText(code));
+        }
+        code = avformat_find_stream_info(input, nullptr);
+        if (code < 0) {
+            return fail("Cannot read streams of " + path + ": " + errorText(code));
+        }
+        
+        const AVCodec* codec = nullptr;
+        video_index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+        if (video_index < 0 || !codec) {
+            return fail("No decodable video stream in " + path);
+        }
+        video_in = input->streams[video_index];
+        decoder.reset(avcodec_alloc_context3(codec));
+        
+        // Trim points count from the container start; trimmed output starts at zero
+        trimmed = options.start_seconds > 0.0 || options.end_seconds > 0.0;
+        int64_t origin = input->start_time != AV_NOPTS_VALUE ? input->start_time : 0;
+        auto toStream = [&](double seconds) {
+            return av_rescale_q(origin + std::llround(seconds * AV_TIME_BASE), AV_TIME_BASE_Q, video_in->time_base);
+        };
+        start_pts = toStream(std::max(options.start_seconds, 0.0));
+        if (options.end_seconds > options.start_seconds) {
+            end_pts = toStream(options.end_seconds);
+        }
+        if (options.start_seconds > 0.0) {
+            code = av_seek_frame(input, video_index, start_pts, AVSEEK_FLAG_BACKWARD);
+            if (code < 0) {
+                return fail("Cannot seek in " + path + ": " + errorText(code));
+            }
+        }
+        return true;
+    }
+    
+    bool openDecoder() {
+        avcodec_parameters_to_context(decoder.get(), video_in->codecpar);
+        decoder->pkt_timebase = video_in->time_base;
+        decoder->thread_count = 0;
+        
+        if (options.hardware_decode) {
+            for (AVHWDeviceType type : kDecodeDevices) {
+                AVPixelFormat format = hardwareFormat(decoder->codec, type);
+                AVBufferRef* device = nullptr;
+                if (format == AV_PIX_FMT_NONE || av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0) < 0) {
+                    continue;
+                }
+                decoder->hw_device_ctx = device;
+                decoder->opaque = reinterpret_cast<void*>(static_cast<intptr_t>(format));
+                decoder->get_format = pickHardwareFormat;
+                // Frames queued in every stage hold a surface from the decoder's pool
+                decoder->extra_hw_frames = static_cast<int>(options.queue_depth * 3 + 4);
+                decode_device = type;
+                break;
+            }
+        }
+        
+        int code = avcodec_open2(decoder.get(), decoder->codec, nullptr);
+        if (code < 0) {
+            return fail(std::string("Cannot open the ") + decoder->codec->name + " decoder: " + errorText(code));
+        }
+        return true;
+    }
+    
+    bool openOutput(const std::string& path) {
+        int code = avformat_alloc_output_context2(&output, nullptr, nullptr, path.c_str());
+        if (code < 0 || !output) {
+            return fail("Unsupported output format for " + path);
+        }
+        video_out = avformat_new_stream(output, nullptr);
+        
+        stream_map.assign(input->nb_streams, -1);
+        for (unsigned i = 0; i < input->nb_streams; i++) {
+            const AVCodecParameters* parameters = input->streams[i]->codecpar;
+            if (parameters->codec_type != AVMEDIA_TYPE_AUDIO ||
+                avformat_query_codec(output->oformat, parameters->codec_id, FF_COMPLIANCE_NORMAL) != 1) {
+                continue;
+            }
+            AVStream* stream = avformat_new_stream(output, nullptr);
+            avcodec_parameters_copy(stream->codecpar, parameters);
+            stream->codecpar->codec_tag = 0;
+            stream->time_base = input->streams[i]->time_base;
+            stream_map[i] = stream->index;
+        }
+        return true;
+    }
+    
+    // Decoding one frame up front tells the encoder the real frame format and device
+    bool decodeFirstFrame() {
+        PacketPtr packet(av_packet_alloc());
+        FramePtr frame(av_frame_alloc());
+        bool draining = false;
+        while (true) {
+            int code = avcodec_receive_frame(decoder.get(), frame.get());
+            if (code == 0) {
+                if (keepFrame(frame.get())) {
+                    break;
+                }
+                av_frame_unref(frame.get());
+                continue;
+            }
+            if (code != AVERROR(EAGAIN)) {
+                return fail(code == AVERROR_EOF ? "The video stream has no frames" : "Decoding failed: " + errorText(code));
+            }
+            
+            code = draining ? AVERROR_EOF : av_read_frame(input, packet.get());
+            if (code == AVERROR_EOF) {
+                avcodec_send_packet(decoder.get(), nullptr);
+                draining = true;
+                continue;
+            }
+            if (code < 0) {
+                return fail("Reading the source failed: " + errorText(code));
+            }
+            if (packet->stream_index == video_index) {
+                code = avcodec_send_packet(decoder.get(), packet.get());
+                av_packet_unref(packet.get());
+                if (code < 0 && code != AVERROR_INVALIDDATA) {
+                    return fail("Decoding failed: " + errorText(code));
+                }
+            } else if (stream_map[packet->stream_index] >= 0) {
+                // Muxed once the header exists
+                pending_audio.emplace_back(av_packet_alloc());
+                av_packet_move_ref(pending_audio.back().get(), packet.get());
+            } else {
+                av_packet_unref(packet.get());
+            }
+        }
+        
+        first_frame_on_gpu = frame->hw_frames_ctx != nullptr;
+        first_frame = std::move(frame);
+        return true;
+    }
+    
+    bool openEncoder() {
+        bool hevc = options.codec == "hevc";
+        std::vector<std::pair<const AVCodec*, AVHWDeviceType>> candidates;
+        auto addCandidate = [&](const AVCodec* codec, AVHWDeviceType device) {
+            bool known = std::any_of(candidates.begin(), candidates.end(),
+                                     [codec](const auto& candidate) { return candidate.first == codec; });
+            if (codec && !known) {
+                candidates.emplace_back(codec, device);
+            }
+        };
+        if (options.hardware_encode) {
+            for (const HardwareEncoder& hardware : kHardwareEncoders) {
+                addCandidate(avcodec_find_encoder_by_name(hevc ? hardware.hevc : hardware.h264), hardware.device);
+            }
+        }
+        addCandidate(avcodec_find_encoder_by_name(hevc ? "libx265" : "libx264"), AV_HWDEVICE_TYPE_NONE);
+        addCandidate(avcodec_find_encoder(hevc ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264), AV_HWDEVICE_TYPE_NONE);
+        
+        AVPixelFormat source_format = static_cast<AVPixelFormat>(first_frame->format);
+        if (first_frame_on_gpu) {
+            source_format = reinterpret_cast<AVHWFramesContext*>(first_frame->hw_frames_ctx->data)->sw_format;
+        }
+        
+        int width = first_frame->width;
+        int height = first_frame->height;
+        if (options.max_height > 0 && height > options.max_height) {
+            // Most encoders need even dimensions for 4:2:0
+            width = static_cast<int>(static_cast<int64_t>(width) * options.max_height / height + 1) & ~1;
+            height = options.max_height & ~1;
+        }
+        bool scaled = width != first_frame->width || height != first_frame->height;
+        
+        // A hardware encoder that is compiled in but has no device fails to open; try the next
+        for (const auto& [codec, device] : candidates) {
+            bool on_gpu = first_frame_on_gpu && device == decode_device && !options.process_frame && !scaled;
+            CodecContextPtr context(avcodec_alloc_context3(codec));
+            context->width = width;
+            context->height = height;
+            context->sample_aspect_ratio = first_frame->sample_aspect_ratio;
+            context->time_base = video_in->time_base;
+            context->framerate = av_guess_frame_rate(input, video_in, nullptr);
+            context->bit_rate = options.bit_rate > 0 ? options.bit_rate : video_in->codecpar->bit_rate;
+            context->color_range = decoder->color_range;
+            context->color_primaries = decoder->color_primaries;
+            context->color_trc = decoder->color_trc;
+            context->colorspace = decoder->colorspace;
+            if (options.keyframe_interval > 0) {
+                context->gop_size = options.keyframe_interval;
+                if (options.keyframe_interval == 1) {
+                    context->max_b_frames = 0;
+                }
+            }
+            if (on_gpu) {
+                context->pix_fmt = static_cast<AVPixelFormat>(first_frame->format);
+                context->hw_frames_ctx = av_buffer_ref(first_frame->hw_frames_ctx);
+            } else {
+                context->pix_fmt = pickSoftwareFormat(codec, source_format);
+            }
+            if (output->oformat->flags & AVFMT_GLOBALHEADER) {
+                context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+            }
+            
+            if (context->pix_fmt != AV_PIX_FMT_NONE && avcodec_open2(context.get(), codec, nullptr) == 0) {
+                encoder = std::move(context);
+                zero_copy = on_gpu;
+                return true;
+            }
+        }
+        return fail(std::string("No usable ") + (hevc ? "HEVC" : "H.264") + " encoder");
+    }
+    
+    bool writeHeader(const std::string& path) {
+        avcodec_parameters_from_context(video_out->codecpar, encoder.get());
+        video_out->time_base = encoder->time_base;
+        video_out->avg_frame_rate = encoder->framerate;
+        
+        int code = 0;
+        if (!(output->oformat->flags & AVFMT_NOFILE)) {
+            code = avio_open(&output->pb, path.c_str(), AVIO_FLAG_WRITE);
+            if (code < 0) {
+                return fail("Cannot write " + path + ": " + errorText(code));
+            }
+        }
+        code = avformat_write_header(output, nullptr);
+        if (code < 0) {
+            return fail("Cannot write " + path + ": " + errorText(code));
+        }
+        header_written = true;
+        
+        // The muxer may have changed the stream time bases, so audio is remapped only now
+        for (PacketPtr& packet : pending_audio) {
+            if (remapAudio(packet.get())) {
+                av_interleaved_write_frame(output, packet.get());
+            }
+        }
+        pending_audio.clear();
+        
+        frames.push(std::move(first_frame));
+        return true;
+    }
+    
+    void demuxLoop() {
+        // Streams still short of end_pts; audio interleaved behind the video can still be in range
+        std::vector<bool> open_streams(input->nb_streams, false);
+        size_t remaining = 0;
+        for (unsigned int i = 0; i < input->nb_streams; i++) {
+            if (static_cast<int>(i) == video_index || stream_map[i] >= 0) {
+                open_streams[i] = true;
+                remaining++;
+            }
+        }
+        
+        while (!stopped()) {
+            PacketPtr packet(av_packet_alloc());
+            int code = av_read_frame(input, packet.get());
+            if (code == AVERROR_EOF) {
+                break;
+            }
+            if (code < 0) {
+                fail("Reading the source failed: " + errorText(code));
+                break;
+            }
+            
+            // Dropped streams, and streams that appeared after the header was read, are never open
+            int index = packet->stream_index;
+            if (static_cast<size_t>(index) >= open_streams.size() || !open_streams[index]) {
+                continue;
+            }
+            if (pastEnd(packet.get())) {
+                // Stop reading once every kept stream is past the trim end
+                open_streams[index] = false;
+                if (--remaining == 0) {
+                    break;
+                }
+                continue;
+            }
+            
+            if (index == video_index) {
+                if (!packets.push(std::move(packet))) {
+                    break;
+                }
+            } else if (remapAudio(packet.get())) {
+                if (!muxed.push(std::move(packet))) {
+                    break;
+                }
+            }
+        }
+        packets.close();
+        producerDone();
+    }
+    
+    void decodeLoop() {
+        if (!receiveFrames()) {
+            return;
+        }
+        while (auto packet = packets.pop()) {
+            if (stopped()) {
+                return;
+            }
+            int code = sendPacket(packet->get());
+            if (code < 0 && code != AVERROR_INVALIDDATA) {
+                fail("Decoding failed: " + errorText(code));
+                return;
+            }
+            if (!receiveFrames()) {
+                return;
+            }
+        }
+        if (!stopped()) {
+            avcodec_send_packet(decoder.get(), nullptr);
+            receiveFrames();
+        }
+        frames.close();
+    }
+    
+    // Stage timings cover the codec work only, not waits on the queues between stages
+    int sendPacket(const AVPacket* packet) {
+        static xeno::utils::Histogram& decode_latency = xeno::utils::Metrics::getInstance().histogram("video.decode");
+        xeno::utils::TraceSpan span(decode_latency);
+        return avcodec_send_packet(decoder.get(), packet);
+    }
+    
+    // Moves every frame the decoder has ready into the frame queue
+    bool receiveFrames() {
+        while (true) {
+            FramePtr frame(av_frame_alloc());
+            int code = avcodec_receive_frame(decoder.get(), frame.get());
+            if (code == AVERROR(EAGAIN) || code == AVERROR_EOF) {
+                return true;
+            }
+            if (code < 0) {
+                fail("Decoding failed: " + errorText(code));
+                return false;
+            }
+            if (!keepFrame(frame.get())) {
+                continue;
+            }
+            if (!frames.push(std::move(frame))) {
+                return false;
+            }
+        }
+    }
+    
+    void processLoop() {
+        static xeno::utils::Histogram& prepare_latency = xeno::utils::Metrics::getInstance().histogram("video.prepare");
+        while (auto frame = frames.pop()) {
+            if (stopped()) {
+                break;
+            }
+            FramePtr ready;
+            {
+                xeno::utils::TraceSpan span(prepare_latency);
+                ready = prepare(std::move(*frame));
+            }
+            if (!ready || !converted.push(std::move(ready))) {
+                break;
+            }
+        }
+        converted.close();
+    }
+    
+    // Brings a decoded frame into the encoder's memory and pixel format
+    FramePtr prepare(FramePtr frame) {
+        if (zero_copy) {
+            return frame;
+        }
+        
+        if (frame->hw_frames_ctx) {
+            FramePtr system(av_frame_alloc());
+            int code = av_hwframe_transfer_data(system.get(), frame.get(), 0);
+            if (code < 0) {
+                fail("Copying a frame from the GPU failed: " + errorText(code));
+                return nullptr;
+            }
+            av_frame_copy_props(system.get(), frame.get());
+            frame = std::move(system);
+        }
+        
+        if (frame->format != encoder->pix_fmt || frame->width != encoder->width || frame->height != encoder->height) {
+            scaler = sws_getCachedContext(scaler, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                          encoder->width, encoder->height, encoder->pix_fmt, SWS_BILINEAR,
+                                          nullptr, nullptr, nullptr);
+            FramePtr scaled(av_frame_alloc());
+            scaled->format = encoder->pix_fmt;
+            scaled->width = encoder->width;
+            scaled->height = encoder->height;
+            int code = scaler ? av_frame_get_buffer(scaled.get(), 0) : AVERROR(EINVAL);
+            if (code >= 0) {
+                code = sws_scale_frame(scaler, scaled.get(), frame.get());
+            }
+            if (code < 0) {
+                fail("Converting a frame failed: " + errorText(code));
+                return nullptr;
+            }
+            av_frame_copy_props(scaled.get(), frame.get());
+            frame = std::move(scaled);
+        }
+        
+        if (options.process_frame) {
+            av_frame_make_writable(frame.get());
+            options.process_frame(frame.get());
+        }
+        return frame;
+    }
+    
+    void encodeLoop() {
+        while (auto frame = converted.pop()) {
+            if (stopped()) {
+                break;
+            }
+            (*frame)->pict_type = AV_PICTURE_TYPE_NONE;
+            if (!encode(frame->get())) {
+                break;
+            }
+            frame_count++;
+        }
+        if (!stopped()) {
+            encode(nullptr);
+        }
+        producerDone();
+    }
+    
+    // Sends one frame, or nullptr to flush, and queues the packets that come out
+    bool encode(AVFrame* frame) {
+        static xeno::utils::Histogram& encode_latency = xeno::utils::Metrics::getInstance().histogram("video.encode");
+        int code;
+        {
+            xeno::utils::TraceSpan span(encode_latency);
+            code = avcodec_send_frame(encoder.get(), frame);
+        }
+        if (code < 0) {
+            fail("Encoding failed: " + errorText(code));
+            return false;
+        }
+        while (true) {
+            PacketPtr packet(av_packet_alloc());
+            code = avcodec_receive_packet(encoder.get(), packet.get());
+            if (code == AVERROR(EAGAIN) || code == AVERROR_EOF) {
+                return true;
+            }
+            if (code < 0) {
+                fail("Encoding failed: " + errorText(code));
+                return false;
+            }
+            packet->stream_index = video_out->index;
+            av_packet_rescale_ts(packet.get(), encoder->time_base, video_out->time_base);
+            if (!muxed.push(std::move(packet))) {
+                return false;
+            }
+        }
+    }
+    
+    void muxLoop(const VideoPipeline::Progress& progress) {
+        double start = input->start_time != AV_NOPTS_VALUE ? static_cast<double>(input->start_time) / AV_TIME_BASE : 0.0;
+        double duration = input->duration > 0 ? static_cast<double>(input->duration) / AV_TIME_BASE : 0.0;
+        if (trimmed) {
+            start = 0.0;
+            duration = end_pts != INT64_MAX ? (end_pts - start_pts) * av_q2d(video_in->time_base)
+                                            : duration - options.start_seconds;
+        }
+        double reported = -1.0;
+        
+        while (auto packet = muxed.pop()) {
+            if (stopped()) {
+                break;
+            }
+            bool video = (*packet)->stream_index == video_out->index;
+            int64_t pts = (*packet)->pts;
+            int code = av_interleaved_write_frame(output, packet->get());
+            if (code < 0) {
+                fail("Writing the output failed: " + errorText(code));
+                break;
+            }
+            
+            if (video && progress && duration > 0.0 && pts != AV_NOPTS_VALUE) {
+                double fraction = std::clamp((pts * av_q2d(video_out->time_base) - start) / duration, 0.0, 1.0);
+                if (fraction - reported >= 0.001) {
+                    reported = fraction;
+                    if (!progress(fraction)) {
+                        fail("Export cancelled");
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Sets the timestamp and applies the trim range; false drops the frame
+    bool keepFrame(AVFrame* frame) const {
+        frame->pts = frame->best_effort_timestamp;
+        if (!trimmed || frame->pts == AV_NOPTS_VALUE) {
+            return true;
+        }
+        if (frame->pts < start_pts || frame->pts >= end_pts) {
+            return false;
+        }
+        frame->pts -= start_pts;
+        return true;
+    }
+    
+    // Moves an audio packet to its output stream; false when it falls outside the trim range
+    // Decode order never goes back below a DTS, so once one reaches end_pts nothing later from that stream is in range
+    bool pastEnd(const AVPacket* packet) const {
+        if (end_pts == INT64_MAX || packet->dts == AV_NOPTS_VALUE) {
+            return false;
+        }
+        AVRational from = input->streams[packet->stream_index]->time_base;
+        return packet->dts >= av_rescale_q(end_pts, video_in->time_base, from);
+    }
+    
+    bool remapAudio(AVPacket* packet) {
+        AVRational from = input->streams[packet->stream_index]->time_base;
+        if (trimmed) {
+            int64_t timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            int64_t start = av_rescale_q(start_pts, video_in->time_base, from);
+            int64_t end = end_pts != INT64_MAX ? av_rescale_q(end_pts, video_in->time_base, from) : INT64_MAX;
+            if (timestamp == AV_NOPTS_VALUE || timestamp < start || timestamp >= end) {
+                return false;
+            }
+            packet->pts = packet->pts != AV_NOPTS_VALUE ? packet->pts - start : packet->pts;
+            packet->dts = packet->dts != AV_NOPTS_VALUE ? packet->dts - start : packet->dts;
+        }
+        packet->stream_index = stream_map[packet->stream_index];
+        av_packet_rescale_ts(packet, from, output->streams[packet->stream_index]->time_base);
+        packet->pos = -1;
+        return true;
+    }
+    
+    // The demuxer and the encoder both feed the mux queue; the last one to finish closes it
+    void producerDone() {
+        if (--producers == 0) {
+            muxed.close();
+        }
+    }
+    
+    void closeOutput() {
+        if (output && output->pb && !(output->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&output->pb);
+        }
+    }
+    
+    bool fail(const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (error_message.empty()) {
+                error_message = message;
+            }
+        }
+        stop = true;
+        // Wakes every stage blocked on a full or empty queue
+        packets.close();
+        frames.close();
+        converted.close();
+        muxed.close();
+        return false;
+    }
+    
+    bool stopped() const { return stop.load(); }
+    
+    const VideoPipeline::Options& options;
+    AVFormatContext* input = nullptr;
+    AVFormatContext* output = nullptr;
+    AVStream* video_in = nullptr;
+    AVStream* video_out = nullptr;
+    int video_index = -1;
+    std::vector<int> stream_map; // Input stream -> output stream, -1 when dropped
+    std::vector<PacketPtr> pending_audio;
+    bool trimmed = false;
+    int64_t start_pts = 0;          // Trim range in the video stream's time base
+    int64_t end_pts = INT64_MAX;
+    
+    CodecContextPtr decoder;
+    CodecContextPtr encoder;
+    AVHWDeviceType decode_device = AV_HWDEVICE_TYPE_NONE;
+    bool first_frame_on_gpu = false;
+    bool zero_copy = false;
+    bool header_written = false;
+    FramePtr first_frame;
+    SwsContext* scaler = nullptr; // Used only by the processing thread
+    
+    utils::BoundedQueue<PacketPtr> packets;  // Demux -> decode
+    utils::BoundedQueue<FramePtr> frames;    // Decode -> process
+    utils::BoundedQueue<FramePtr> converted; // Process -> encode
+    utils::BoundedQueue<PacketPtr> muxed;    // Demux (audio) and encode -> mux
+    std::atomic<int> producers{2};
+    std::atomic<int64_t> frame_count{0};
+    
+    std::atomic<bool> stop{false};
+    std::mutex error_mutex;
+    std::string error_message;
+};
+
+} // namespace
+
+VideoPipeline::VideoPipeline(const Options& options) : options(options) {
+    this->options.queue_depth = std::max<size_t>(this->options.queue_depth, 1);
+}
+
+VideoPipeline::Result VideoPipeline::transcode(const std::string& input, const std::string& output,
+                                               const Progress& progress) {
+    std::error_code ignored;
+    if (std::filesystem::equivalent(input, output, ignored)) {
+        Result result;
+        result.error_message = "Cannot export over the source video";
+        return result;
+    }
+    Session session(options);
+    return session.run(input, output, progress);
+}
+
+std::vector<std::string> VideoPipeline::availableHardware() {
+    std::vector<std::string> names;
+    AVHWDeviceType type = AV_HWDEVICE_TYPE_NONE;
+    while ((type = av_hwdevice_iterate_types(type)) != AV_HWDEVICE_TYPE_NONE) {
+        AVBufferRef* device = nullptr;
+        if (av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0) == 0) {
+            names.push_back(av_hwdevice_get_type_name(type));
+            av_buffer_unref(&device);
+        }
+    }
+    return names;
+}
+
+} // namespace xeno::video
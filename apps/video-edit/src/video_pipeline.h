@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C" {
+struct AVFrame;
+}
+
+namespace xeno::video {
+
+/**
+ * @brief FFmpeg transcode of one video file, split into concurrent stages
+ *
+ * Demux, decode, processing and encode each run on their own thread, joined
+ * by bounded queues so a slow stage holds back the ones before it instead of
+ * letting frames pile up; muxing runs on the calling thread. Decoding uses a
+ * hardware device (CUDA, VAAPI, VideoToolbox or D3D11VA) when one opens, and
+ * encoding prefers NVENC, Quick Sync or VideoToolbox before falling back to
+ * software. When the decoder's device is the one the encoder runs on, frames
+ * stay in GPU memory end to end; otherwise they are downloaded once and
+ * converted to the encoder's pixel format in the processing stage.
+ *
+ * Audio streams are copied without re-encoding when the output container
+ * accepts their codec, and dropped otherwise.
+ */
+class VideoPipeline {
+public:
+    struct Options {
+        std::string codec = "h264";   // "h264" or "hevc"
+        int64_t bit_rate = 0;         // 0 keeps the source bit rate
+        bool hardware_decode = true;
+        bool hardware_encode = true;
+        size_t queue_depth = 8;       // Packets or frames buffered between two stages
+        int max_height = 0;           // Taller sources are scaled down, keeping the aspect ratio
+        int keyframe_interval = 0;    // 1 writes intra-only video; 0 leaves it to the encoder
+        // Source range to transcode; end 0 runs to the end. Trimmed output starts at time zero.
+        double start_seconds = 0.0;
+        double end_seconds = 0.0;
+        // Runs on the processing thread for every frame, in the encoder's pixel format.
+        // Setting it forces frames through system memory.
+        std::function<void(AVFrame* frame)> process_frame;
+    };
+    
+    struct Result {
+        bool success = false;
+        std::string error_message;
+        std::string decoder;          // e.g. "h264 (cuda)"
+        std::string encoder;          // e.g. "h264_nvenc"
+        bool zero_copy = false;       // Frames never left GPU memory
+        int64_t frames = 0;
+    };
+    
+    // Receives the fraction of the source written; returning false cancels
+    using Progress = std::function<bool(double fraction)>;
+    
+    explicit VideoPipeline(const Options& options);
+    
+    // Blocks until output is written or the transcode fails; a failed output is removed
+    Result transcode(const std::string& input, const std::string& output, const Progress& progress = nullptr);
+    
+    // Hardware device types that can be opened on this machine, e.g. {"cuda", "vaapi"}
+    static std::vector<std::string> availableHardware();
+
+private:
+    Options options;
+};
+
+} // namespace xeno::video
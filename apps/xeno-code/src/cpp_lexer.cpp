@@ -0,0 +1,313 @@
+#include "cpp_lexer.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+namespace xeno::code {
+
+namespace {
+
+constexpr const char* kKeywords[] = {
+    "alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch", "char", "char8_t", "char16_t",
+    "char32_t", "class", "co_await", "co_return", "co_yield", "concept", "const", "consteval", "constexpr",
+    "constinit", "const_cast", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+    "else", "enum", "explicit", "export", "extern", "false", "final", "float", "for", "friend", "goto", "if",
+    "import", "inline", "int", "long", "module", "mutable", "namespace", "new", "noexcept", "nullptr",
+    "operator", "override", "private", "protected", "public", "register", "reinterpret_cast", "requires",
+    "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch",
+    "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+    "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while"
+};
+
+constexpr size_t kKeywordCount = std::size(kKeywords);
+constexpr size_t kMaxKeywordLength = 16;
+constexpr size_t kHashSlots = 1024;          // Sparse enough that a collision-free seed turns up quickly
+constexpr uint8_t kEmptySlot = 0xFF;
+constexpr size_t kMaxDelimiterLength = 16;   // The standard's limit for raw string delimiters
+
+static_assert(kKeywordCount < kEmptySlot, "Keyword indices must fit a slot");
+
+template <typename Text>
+uint32_t hashWord(const Text& word, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (auto c : word) {
+        hash ^= static_cast<uint16_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Slot i holds the index of the only keyword that hashes to i under seed
+struct KeywordTable {
+    uint32_t seed = 0;
+    std::array<uint8_t, kHashSlots> slots{};
+    
+    KeywordTable() {
+        for (;; seed++) {
+            slots.fill(kEmptySlot);
+            bool collided = false;
+            for (size_t i = 0; i < kKeywordCount && !collided; i++) {
+                uint8_t& slot = slots[hashWord(std::string_view(kKeywords[i]), seed) % kHashSlots];
+                collided = slot != kEmptySlot;
+                slot = static_cast<uint8_t>(i);
+            }
+            if (!collided) {
+                return;
+            }
+        }
+    }
+};
+
+const KeywordTable& keywordTable() {
+    static const KeywordTable table;
+    return table;
+}
+
+bool isDigit(char16_t c) {
+    return c >= u'0' && c <= u'9';
+}
+
+bool isIdentifierStart(char16_t c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || c == u'_' || c >= 0x80;
+}
+
+bool isIdentifierPart(char16_t c) {
+    return isIdentifierStart(c) || isDigit(c);
+}
+
+bool isSpace(char16_t c) {
+    return c == u' ' || c == u'\t' || c == u'\r' || c == u'\f' || c == u'\v';
+}
+
+// Encoding and raw prefixes that may come straight before a quote
+bool isLiteralPrefix(std::u16string_view word) {
+    if (!word.empty() && word.back() == u'R') {
+        word.remove_suffix(1);
+    }
+    return word.empty() || word == u"u8" || word == u"u" || word == u"U" || word == u"L";
+}
+
+// A backslash as the last visible character joins the next line onto this one
+bool endsWithBackslash(std::u16string_view line) {
+    size_t end = line.size();
+    while (end > 0 && isSpace(line[end - 1])) {
+        end--;
+    }
+    return end > 0 && line[end - 1] == u'\\';
+}
+
+bool isValidDelimiter(std::u16string_view delimiter) {
+    return delimiter.size() <= kMaxDelimiterLength &&
+           std::none_of(delimiter.begin(), delimiter.end(), [](char16_t c) {
+               return isSpace(c) || c == u'\\' || c == u')' || c == u'"';
+           });
+}
+
+} // namespace
+
+int CppLexer::lexLine(std::u16string_view line, int state, std::vector<Token>& tokens) {
+    size_t position = 0;
+    auto add = [&](TokenKind kind, size_t start) {
+        if (position > start) {
+            tokens.push_back({kind, static_cast<uint32_t>(start), static_cast<uint32_t>(position - start)});
+        }
+    };
+    
+    // Finish whatever the previous line left open
+    if (state == kBlockCommentState) {
+        size_t end = line.find(u"*/");
+        position = end == std::u16string_view::npos ? line.size() : end + 2;
+        add(TokenKind::Comment, 0);
+        if (end == std::u16string_view::npos) {
+            return kBlockCommentState;
+        }
+    } else if (state == kLineCommentState) {
+        position = line.size();
+        add(TokenKind::Comment, 0);
+        return endsWithBackslash(line) ? kLineCommentState : kNormalState;
+    } else if (state == kStringState) {
+        bool closed = scanQuoted(line, position, u'"');
+        add(TokenKind::String, 0);
+        if (!closed) {
+            return endsWithBackslash(line) ? kStringState : kNormalState;
+        }
+    } else if (state >= kRawStringState && static_cast<size_t>(state - kRawStringState) < raw_delimiters.size()) {
+        bool closed = scanRawString(line, position, raw_delimiters[state - kRawStringState]);
+        add(TokenKind::String, 0);
+        if (!closed) {
+            return state;
+        }
+    }
+    
+    bool first_token = position == 0;
+    bool include_directive = false;
+    while (position < line.size()) {
+        size_t start = position;
+        char16_t c = line[position];
+        char16_t next = position + 1 < line.size() ? line[position + 1] : u'\0';
+        if (isSpace(c)) {
+            position++;
+            continue;
+        }
+        
+        if (c == u'/' && next == u'/') {
+            position = line.size();
+            add(TokenKind::Comment, start);
+            return endsWithBackslash(line) ? kLineCommentState : kNormalState;
+        }
+        if (c == u'/' && next == u'*') {
+            size_t end = line.find(u"*/", position + 2);
+            position = end == std::u16string_view::npos ? line.size() : end + 2;
+            add(TokenKind::Comment, start);
+            if (end == std::u16string_view::npos) {
+                return kBlockCommentState;
+            }
+            continue;
+        }
+        
+        if (c == u'#' && first_token) {
+            // The directive name, with any spaces after the #
+            position++;
+            while (position < line.size() && isSpace(line[position])) {
+                position++;
+            }
+            size_t name = position;
+            while (position < line.size() && isIdentifierPart(line[position])) {
+                position++;
+            }
+            std::u16string_view directive = line.substr(name, position - name);
+            include_directive = directive == u"include" || directive == u"include_next" || directive == u"import";
+            add(TokenKind::Preprocessor, start);
+            first_token = false;
+            continue;
+        }
+        first_token = false;
+        
+        if (c == u'<' && include_directive) {
+            size_t end = line.find(u'>', position + 1);
+            if (end != std::u16string_view::npos) {
+                position = end + 1;
+                add(TokenKind::String, start);
+                continue;
+            }
+        }
+        
+        if (isIdentifierStart(c)) {
+            while (position < line.size() && isIdentifierPart(line[position])) {
+                position++;
+            }
+            std::u16string_view word = line.substr(start, position - start);
+            char16_t quote = position < line.size() ? line[position] : u'\0';
+            bool raw = word.back() == u'R';
+            if (quote == u'"' && raw && isLiteralPrefix(word)) {
+                size_t open = line.find(u'(', position + 1);
+                std::u16string_view delimiter = open == std::u16string_view::npos
+                    ? std::u16string_view() : line.substr(position + 1, open - position - 1);
+                if (open != std::u16string_view::npos && isValidDelimiter(delimiter)) {
+                    position = open + 1;
+                    bool closed = scanRawString(line, position, delimiter);
+                    add(TokenKind::String, start);
+                    if (!closed) {
+                        return rawStringState(delimiter);
+                    }
+                    continue;
+                }
+            }
+            if ((quote == u'"' || quote == u'\'') && !raw && isLiteralPrefix(word)) {
+                position++;
+                bool closed = scanQuoted(line, position, quote);
+                add(quote == u'"' ? TokenKind::String : TokenKind::Character, start);
+                if (!closed && quote == u'"' && endsWithBackslash(line)) {
+                    return kStringState;
+                }
+                continue;
+            }
+            add(isKeyword(word) ? TokenKind::Keyword : TokenKind::Identifier, start);
+            continue;
+        }
+        
+        if (isDigit(c) || (c == u'.' && isDigit(next))) {
+            // Digits, suffixes, separators and exponents; e is only an exponent outside hex
+            bool hex = c == u'0' && (next == u'x' || next == u'X');
+            position++;
+            while (position < line.size()) {
+                char16_t digit = line[position];
+                char16_t previous = line[position - 1];
+                bool exponent_sign = (digit == u'+' || digit == u'-') &&
+                    (hex ? (previous == u'p' || previous == u'P') : (previous == u'e' || previous == u'E'));
+                if (!exponent_sign && !isIdentifierPart(digit) && digit != u'.' && digit != u'\'') {
+                    break;
+                }
+                position++;
+            }
+            add(TokenKind::Number, start);
+            continue;
+        }
+        
+        if (c == u'"' || c == u'\'') {
+            position++;
+            bool closed = scanQuoted(line, position, c);
+            add(c == u'"' ? TokenKind::String : TokenKind::Character, start);
+            if (!closed && c == u'"' && endsWithBackslash(line)) {
+                return kStringState;
+            }
+            continue;
+        }
+        
+        position++;
+        add(TokenKind::Punctuation, start);
+    }
+    return kNormalState;
+}
+
+bool CppLexer::isKeyword(std::u16string_view word) {
+    if (word.empty() || word.size() > kMaxKeywordLength) {
+        return false;
+    }
+    const KeywordTable& table = keywordTable();
+    uint8_t slot = table.slots[hashWord(word, table.seed) % kHashSlots];
+    if (slot == kEmptySlot) {
+        return false;
+    }
+    std::string_view keyword = kKeywords[slot];
+    return keyword.size() == word.size() && std::equal(word.begin(), word.end(), keyword.begin());
+}
+
+bool CppLexer::scanQuoted(std::u16string_view line, size_t& position, char16_t quote) {
+    while (position < line.size()) {
+        char16_t c = line[position++];
+        if (c == u'\\') {
+            if (position < line.size()) {
+                position++;
+            }
+        } else if (c == quote) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CppLexer::scanRawString(std::u16string_view line, size_t& position, std::u16string_view delimiter) {
+    std::u16string terminator;
+    terminator.reserve(delimiter.size() + 2);
+    terminator += u')';
+    terminator += delimiter;
+    terminator += u'"';
+    size_t end = line.find(terminator, position);
+    if (end == std::u16string_view::npos) {
+        position = line.size();
+        return false;
+    }
+    position = end + terminator.size();
+    return true;
+}
+
+int CppLexer::rawStringState(std::u16string_view delimiter) {
+    auto found = std::find(raw_delimiters.begin(), raw_delimiters.end(), delimiter);
+    if (found == raw_delimiters.end()) {
+        found = raw_delimiters.insert(raw_delimiters.end(), std::u16string(delimiter));
+    }
+    return kRawStringState + static_cast<int>(found - raw_delimiters.begin());
+}
+
+} // namespace xeno::code
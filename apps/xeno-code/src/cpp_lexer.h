@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xeno::code {
+
+enum class TokenKind : uint8_t {
+    Identifier,
+    Keyword,
+    Number,
+    String,
+    Character,
+    Comment,
+    Preprocessor,
+    Punctuation
+};
+
+struct Token {
+    TokenKind kind = TokenKind::Punctuation;
+    uint32_t start = 0;  // UTF-16 offset in the line
+    uint32_t length = 0;
+};
+
+/**
+ * @brief Single-pass C++ tokenizer that works one line at a time
+ *
+ * Every construct that can span lines (block comments, raw strings, and
+ * comments or strings continued with a backslash) is carried to the next
+ * line as an int state, so an editor can re-lex a changed line and stop at
+ * the first following line whose starting state is unchanged. Keywords are
+ * found through a perfect hash of the keyword list, built once, so each
+ * identifier costs one hash and at most one comparison.
+ *
+ * Raw string states include an ID for the delimiter, assigned by this
+ * lexer, so a document should keep using the same CppLexer. Qt is not
+ * needed; lines are UTF-16 so QString data can be passed without copying.
+ */
+class CppLexer {
+public:
+    static constexpr int kNormalState = 0;
+    
+    // Appends the tokens of one line (without its newline) and returns the state at its end.
+    // state is the previous line's result; any negative value means the start of a file.
+    int lexLine(std::u16string_view line, int state, std::vector<Token>& tokens);
+    
+    static bool isKeyword(std::u16string_view word);
+
+private:
+    static constexpr int kBlockCommentState = 1;
+    static constexpr int kLineCommentState = 2;
+    static constexpr int kStringState = 3;
+    static constexpr int kRawStringState = 16; // Plus the delimiter ID
+    
+    // Scans a quoted literal from position, past the opening quote; true if it closed
+    static bool scanQuoted(std::u16string_view line, size_t& position, char16_t quote);
+    // Scans to the end of a raw string; true if it closed on this line
+    static bool scanRawString(std::u16string_view line, size_t& position, std::u16string_view delimiter);
+    int rawStringState(std::u16string_view delimiter);
+    
+    std::vector<std::u16string> raw_delimiters;
+};
+
+} // namespace xeno::code
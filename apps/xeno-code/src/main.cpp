@@ -22,74 +22,747 @@
 #include <QStringListModel>
 #include <QSyntaxHighlighter>
 #include <QTextDocument>
-#include <QRegularExpression>
+#include <QPointer>
+#include <QAction>
+#include <QShortcut>
+#include <QFileSystemWatcher>
+#include <QKeyEvent>
+#include <QAbstractItemView>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAbstractScrollArea>
+#include <QPainter>
+#include <QTextLayout>
+#include <QFontDatabase>
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <climits>
+#include <filesystem>
+#include <fstream>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
+#include "../../shared/ai-integration/include/ai_broker.h"
 #include "../../shared/ai-integration/include/ai_integration.h"
+#include "../../shared/ai-integration/include/completion_scheduler.h"
 #include "../../shared/utils/include/utils.h"
+#include "../../shared/utils/include/mapped_file.h"
+#include "../../shared/utils/include/piece_table.h"
+#include "cpp_lexer.h"
+#include "symbol_index.h"
 
-// Simple C++ syntax highlighter
+/**
+ * @brief C++ highlighting from one CppLexer pass per line
+ *
+ * Each block's lexer state is stored as its block state, so after an edit
+ * QSyntaxHighlighter re-lexes the changed blocks and only carries on while
+ * a block ends in a different state than before. Blocks past a moving limit
+ * are marked pending instead of lexed; idle-time steps push the limit to the
+ * end of the document, and ensureHighlighted() pulls it ahead for the view.
+ */
 class CppSyntaxHighlighter : public QSyntaxHighlighter {
     Q_OBJECT
 
 public:
     explicit CppSyntaxHighlighter(QTextDocument *parent = nullptr)
         : QSyntaxHighlighter(parent) {
-        setupHighlightingRules();
+        setupFormats();
+    }
+    
+    // Highlights every block up to block_number now rather than in idle time
+    void ensureHighlighted(int block_number) {
+        if (block_number <= highlight_limit || !document()) {
+            return;
+        }
+        QTextBlock first_pending = document()->findBlockByNumber(highlight_limit + 1);
+        highlight_limit = block_number;
+        if (first_pending.isValid()) {
+            // Carries on through the following blocks for as long as their states change
+            rehighlightBlock(first_pending);
+        } else {
+            // Nothing left pending; later blocks are new, so they are lexed as they appear
+            highlight_limit = INT_MAX;
+        }
     }
 
 protected:
     void highlightBlock(const QString &text) override {
-        foreach (const HighlightingRule &rule, highlightingRules) {
-            QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-            while (matchIterator.hasNext()) {
-                QRegularExpressionMatch match = matchIterator.next();
-                setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+        if (currentBlock().blockNumber() > highlight_limit) {
+            setCurrentBlockState(kPendingState);
+            scheduleCatchUp();
+            return;
+        }
+        
+        tokens.clear();
+        std::u16string_view line(reinterpret_cast<const char16_t*>(text.utf16()), text.size());
+        int state = lexer.lexLine(line, previousBlockState(), tokens);
+        for (const auto& token : tokens) {
+            if (const QTextCharFormat* format = formatFor(token.kind)) {
+                setFormat(static_cast<int>(token.start), static_cast<int>(token.length), *format);
             }
         }
+        setCurrentBlockState(state);
     }
 
 private:
-    struct HighlightingRule {
-        QRegularExpression pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
+    static constexpr int kPendingState = -2;    // Never a lexer state, so lexing always changes it
+    static constexpr int kInitialBlocks = 300;  // More than a screen, highlighted straight away
+    static constexpr int kIdleBlocks = 2000;    // Highlighted per idle-time step
+    
+    void scheduleCatchUp() {
+        if (!catch_up_scheduled) {
+            catch_up_scheduled = true;
+            QTimer::singleShot(0, this, [this]() {
+                catch_up_scheduled = false;
+                ensureHighlighted(highlight_limit + kIdleBlocks);
+            });
+        }
+    }
+    
+    const QTextCharFormat* formatFor(xeno::code::TokenKind kind) const {
+        switch (kind) {
+        case xeno::code::TokenKind::Keyword:
+            return &keyword_format;
+        case xeno::code::TokenKind::String:
+        case xeno::code::TokenKind::Character:
+            return &string_format;
+        case xeno::code::TokenKind::Comment:
+            return &comment_format;
+        case xeno::code::TokenKind::Number:
+            return &number_format;
+        case xeno::code::TokenKind::Preprocessor:
+            return &preprocessor_format;
+        default:
+            return nullptr;
+        }
+    }
+    
+    void setupFormats() {
+        keyword_format.setForeground(QColor(86, 156, 214));
+        keyword_format.setFontWeight(QFont::Bold);
+        string_format.setForeground(QColor(214, 157, 133));
+        comment_format.setForeground(QColor(106, 153, 85));
+        number_format.setForeground(QColor(181, 206, 168));
+        preprocessor_format.setForeground(QColor(197, 134, 192));
+    }
+    
+    xeno::code::CppLexer lexer;
+    std::vector<xeno::code::Token> tokens; // Reused between blocks
+    int highlight_limit = kInitialBlocks;
+    bool catch_up_scheduled = false;
+    
+    QTextCharFormat keyword_format;
+    QTextCharFormat string_format;
+    QTextCharFormat comment_format;
+    QTextCharFormat number_format;
+    QTextCharFormat preprocessor_format;
+};
 
-    void setupHighlightingRules() {
-        HighlightingRule rule;
+// Leaves the keys that pick from an open completion popup to the completer
+class CodeEditor : public QPlainTextEdit {
+public:
+    using QPlainTextEdit::QPlainTextEdit;
+    
+    void setCompleter(QCompleter* completer) { this->completer = completer; }
 
-        // Keywords
-        QTextCharFormat keywordFormat;
-        keywordFormat.setColor(QColor(86, 156, 214));
-        keywordFormat.setFontWeight(QFont::Bold);
-        QStringList keywordPatterns;
-        keywordPatterns << "\\bclass\\b" << "\\bstruct\\b" << "\\bnamespace\\b"
-                       << "\\bif\\b" << "\\belse\\b" << "\\bfor\\b" << "\\bwhile\\b"
-                       << "\\breturn\\b" << "\\bint\\b" << "\\bfloat\\b" << "\\bdouble\\b"
-                       << "\\bvoid\\b" << "\\bbool\\b" << "\\bchar\\b" << "\\bconst\\b"
-                       << "\\bstatic\\b" << "\\bpublic\\b" << "\\bprivate\\b" << "\\bprotected\\b";
+protected:
+    void keyPressEvent(QKeyEvent* event) override {
+        if (completer && completer->widget() == this && completer->popup()->isVisible()) {
+            switch (event->key()) {
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+            case Qt::Key_Tab:
+            case Qt::Key_Backtab:
+            case Qt::Key_Escape:
+                event->ignore();
+                return;
+            default:
+                break;
+            }
+        }
+        QPlainTextEdit::keyPressEvent(event);
+    }
 
-        foreach (const QString &pattern, keywordPatterns) {
-            rule.pattern = QRegularExpression(pattern);
-            rule.format = keywordFormat;
-            highlightingRules.append(rule);
+private:
+    QPointer<QCompleter> completer;
+};
+
+/**
+ * @brief Editor for files too large to load into a QTextDocument
+ *
+ * The file is memory-mapped and edited through a PieceTable, so opening
+ * costs the same for any size and memory only grows with the edits. Only
+ * the rows in view are read, laid out and painted. Positions are byte
+ * offsets, and so is the scroll bar, since counting lines would mean
+ * reading the whole file. Lines longer than kMaxRowBytes wrap, so no row
+ * reads more than that; rows of such a line are found by byte count, so
+ * they can shift by a few characters when scrolled to from below.
+ */
+class LargeFileView : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    explicit LargeFileView(QWidget* parent = nullptr) : QAbstractScrollArea(parent) {
+        setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        setFocusPolicy(Qt::StrongFocus);
+        viewport()->setCursor(Qt::IBeamCursor);
+        text_option.setWrapMode(QTextOption::NoWrap);
+        text_option.setTabStopDistance(fontMetrics().horizontalAdvance(' ') * 4);
+        
+        connect(verticalScrollBar(), &QScrollBar::actionTriggered, this, &LargeFileView::scrollAction);
+        connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+            if (!syncing_scroll_bar) {
+                top = rowStart(static_cast<size_t>(value) * scroll_scale);
+                viewport()->update();
+            }
+        });
+        connect(horizontalScrollBar(), &QScrollBar::valueChanged, viewport(), qOverload<>(&QWidget::update));
+    }
+    
+    bool open(const QString& path) {
+        if (!file.open(path.toStdString())) {
+            error_message = QString::fromStdString(file.errorMessage());
+            return false;
+        }
+        buffer.reset(file.data());
+        top = cursor = anchor = 0;
+        modified = false;
+        updateScrollRange();
+        viewport()->update();
+        return true;
+    }
+    
+    // Writes the document next to path and moves it into place, then maps the saved file
+    bool save(const QString& path) {
+        std::string target = path.toStdString();
+        std::string temporary = target + ".xeno-save";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            buffer.forEachChunk(0, buffer.size(), [&out](std::string_view chunk) {
+                out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                return static_cast<bool>(out);
+            });
+            out.close();
+            if (!out) {
+                error_message = "Cannot write " + QString::fromStdString(temporary);
+                std::filesystem::remove(temporary);
+                return false;
+            }
+        }
+        
+        // Windows will not replace a mapped file, and the pieces point into the mapping, so the
+        // document is carried over by mapping whichever file ends up holding it
+        file.close();
+        std::error_code error;
+        std::filesystem::rename(temporary, target, error);
+        std::string saved = error ? temporary : target;
+        if (!file.open(saved)) {
+            error_message = QString::fromStdString(file.errorMessage());
+            buffer.reset({});
+            top = cursor = anchor = 0;
+            updateScrollRange();
+            viewport()->update();
+            return false;
+        }
+        buffer.reset(file.data());
+        if (error) {
+            error_message = QString("Cannot replace %1 (%2); the document is kept in %3")
+                .arg(path, QString::fromStdString(error.message()), QString::fromStdString(temporary));
+            return false;
+        }
+        modified = false;
+        return true;
+    }
+    
+    QString filePath() const { return QString::fromStdString(file.path()); }
+    const QString& errorMessage() const { return error_message; }
+    bool isModified() const { return modified; }
+    size_t cursorOffset() const { return cursor; }
+    
+    QString selectedText() const {
+        size_t start = std::min(cursor, anchor);
+        return QString::fromStdString(buffer.text(start, std::max(cursor, anchor) - start));
+    }
+    
+    // About max_bytes of text before offset, for prompts
+    QString textBefore(size_t offset, size_t max_bytes) const {
+        offset = std::min(offset, buffer.size());
+        size_t start = characterStart(offset - std::min(offset, max_bytes));
+        return QString::fromStdString(buffer.text(start, offset - start));
+    }
+    
+    // About max_bytes of text centred on the cursor
+    QString textAroundCursor(size_t max_bytes) const {
+        size_t start = characterStart(cursor - std::min(cursor, max_bytes / 2));
+        size_t end = characterStart(std::min(buffer.size(), start + max_bytes));
+        return QString::fromStdString(buffer.text(start, end - start));
+    }
+    
+    // Replaces the selection, or inserts at the cursor
+    void insertText(const QString& text) {
+        eraseSelection();
+        cursor += insertAt(cursor, text);
+        anchor = cursor;
+        ensureCursorVisible();
+    }
+    
+    // Inserts text at offset without moving the selection off the text it covers; returns the bytes inserted
+    size_t insertAt(size_t offset, const QString& text) {
+        QByteArray bytes = text.toUtf8();
+        size_t length = static_cast<size_t>(bytes.size());
+        offset = std::min(offset, buffer.size());
+        buffer.insert(offset, std::string_view(bytes.constData(), length));
+        if (cursor > offset) {
+            cursor += length;
+        }
+        if (anchor > offset) {
+            anchor += length;
         }
+        if (top > offset) {
+            top += length;
+        }
+        edited();
+        return length;
+    }
+
+signals:
+    void contentsChanged();
 
-        // Strings
-        QTextCharFormat stringFormat;
-        stringFormat.setColor(QColor(214, 157, 133));
-        rule.pattern = QRegularExpression(QStringLiteral("\".*\""));
-        rule.format = stringFormat;
-        highlightingRules.append(rule);
+protected:
+    void paintEvent(QPaintEvent*) override {
+        QPainter painter(viewport());
+        painter.fillRect(viewport()->rect(), palette().base());
+        painter.setPen(palette().text().color());
+        
+        size_t selection_start = std::min(cursor, anchor);
+        size_t selection_end = std::max(cursor, anchor);
+        int line_height = fontMetrics().lineSpacing();
+        qreal widest = 0;
+        size_t start = top;
+        for (int y = 0; y < viewport()->height(); y += line_height) {
+            Row current = row(start);
+            QTextLayout layout(current.text);
+            layoutRow(layout);
+            
+            QList<QTextLayout::FormatRange> selections;
+            if (selection_start < current.end && selection_end > current.start) {
+                QTextLayout::FormatRange range;
+                range.start = indexOf(current, std::max(selection_start, current.start));
+                range.length = indexOf(current, selection_end) - range.start;
+                range.format.setBackground(palette().highlight());
+                range.format.setForeground(palette().highlightedText());
+                selections.append(range);
+            }
+            QPointF origin(kMargin - horizontalScrollBar()->value(), y);
+            layout.draw(&painter, origin, selections);
+            if (hasFocus() && cursor >= current.start && (cursor < current.end || current.last)) {
+                layout.drawCursor(&painter, origin, indexOf(current, cursor), 2);
+            }
+            widest = std::max(widest, layout.maximumWidth());
+            
+            if (current.last) {
+                break;
+            }
+            start = current.end;
+        }
+        
+        // Only rows seen so far are measured, so the range grows as wider ones scroll into view
+        int range = std::max(0, static_cast<int>(widest) + 2 * kMargin - viewport()->width());
+        if (range > horizontalScrollBar()->maximum()) {
+            horizontalScrollBar()->setRange(0, range);
+            horizontalScrollBar()->setPageStep(viewport()->width());
+        }
+    }
+    
+    void resizeEvent(QResizeEvent* event) override {
+        QAbstractScrollArea::resizeEvent(event);
+        updateScrollRange();
+    }
+    
+    void wheelEvent(QWheelEvent* event) override {
+        if (event->angleDelta().y() == 0) {
+            QAbstractScrollArea::wheelEvent(event);
+            return;
+        }
+        // A wheel notch is 120, three rows
+        wheel_delta += event->angleDelta().y();
+        int rows = wheel_delta / 40;
+        wheel_delta -= rows * 40;
+        scrollRows(-rows);
+        event->accept();
+    }
+    
+    void mousePressEvent(QMouseEvent* event) override {
+        if (event->button() != Qt::LeftButton) {
+            QAbstractScrollArea::mousePressEvent(event);
+            return;
+        }
+        setFocus();
+        cursor = offsetAt(event->position().toPoint());
+        if (!(event->modifiers() & Qt::ShiftModifier)) {
+            anchor = cursor;
+        }
+        viewport()->update();
+    }
+    
+    void mouseMoveEvent(QMouseEvent* event) override {
+        if (event->buttons() & Qt::LeftButton) {
+            cursor = offsetAt(event->position().toPoint());
+            viewport()->update();
+        }
+    }
+    
+    void focusInEvent(QFocusEvent* event) override {
+        QAbstractScrollArea::focusInEvent(event);
+        viewport()->update();
+    }
+    
+    void focusOutEvent(QFocusEvent* event) override {
+        QAbstractScrollArea::focusOutEvent(event);
+        viewport()->update();
+    }
+    
+    void keyPressEvent(QKeyEvent* event) override {
+        if (event == QKeySequence::Copy) {
+            QGuiApplication::clipboard()->setText(selectedText());
+            return;
+        }
+        if (event == QKeySequence::Cut) {
+            QGuiApplication::clipboard()->setText(selectedText());
+            eraseSelection();
+            ensureCursorVisible();
+            return;
+        }
+        if (event == QKeySequence::Paste) {
+            insertText(QGuiApplication::clipboard()->text());
+            return;
+        }
+        if (event == QKeySequence::SelectAll) {
+            anchor = 0;
+            cursor = buffer.size();
+            ensureCursorVisible();
+            return;
+        }
+        
+        bool select = event->modifiers() & Qt::ShiftModifier;
+        bool control = event->modifiers() & Qt::ControlModifier;
+        switch (event->key()) {
+        case Qt::Key_Left:
+            moveCursor(previousCharacter(cursor), select);
+            return;
+        case Qt::Key_Right:
+            moveCursor(nextCharacter(cursor), select);
+            return;
+        case Qt::Key_Up:
+            moveCursor(verticalTarget(cursor, -1), select);
+            return;
+        case Qt::Key_Down:
+            moveCursor(verticalTarget(cursor, 1), select);
+            return;
+        case Qt::Key_PageUp:
+            moveCursor(verticalTarget(cursor, -visibleRows()), select);
+            return;
+        case Qt::Key_PageDown:
+            moveCursor(verticalTarget(cursor, visibleRows()), select);
+            return;
+        case Qt::Key_Home:
+            moveCursor(control ? 0 : rowStart(cursor), select);
+            return;
+        case Qt::Key_End:
+            moveCursor(control ? buffer.size() : rowTextEnd(rowStart(cursor)), select);
+            return;
+        case Qt::Key_Backspace:
+            if (cursor == anchor) {
+                anchor = previousCharacter(cursor);
+            }
+            eraseSelection();
+            ensureCursorVisible();
+            return;
+        case Qt::Key_Delete:
+            if (cursor == anchor) {
+                anchor = nextCharacter(cursor);
+            }
+            eraseSelection();
+            ensureCursorVisible();
+            return;
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            insertText("\n");
+            return;
+        case Qt::Key_Tab:
+            insertText("\t");
+            return;
+        default:
+            break;
+        }
+        
+        QString text = event->text();
+        if (!text.isEmpty() && text.at(0).isPrint()) {
+            insertText(text);
+            return;
+        }
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+    
+    bool focusNextPrevChild(bool) override {
+        return false; // Tab is text
+    }
 
-        // Comments
-        QTextCharFormat commentFormat;
-        commentFormat.setColor(QColor(106, 153, 85));
-        rule.pattern = QRegularExpression(QStringLiteral("//[^\n]*"));
-        rule.format = commentFormat;
-        highlightingRules.append(rule);
+private:
+    static constexpr size_t kMaxRowBytes = 4096;
+    static constexpr size_t kMaxScrollSteps = 1u << 30; // Scroll bars count in int
+    static constexpr int kMargin = 4;
+    
+    struct Row {
+        size_t start = 0;
+        size_t end = 0;      // Past the newline
+        bool last = false;   // The document ends in this row
+        std::string bytes;   // Without the line ending
+        QString text;
+    };
+    
+    static bool isContinuation(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+    
+    // The start of the UTF-8 character holding offset
+    size_t characterStart(size_t offset) const {
+        while (offset > 0 && offset < buffer.size() && isContinuation(buffer.at(offset))) {
+            offset--;
+        }
+        return offset;
+    }
+    
+    size_t previousCharacter(size_t offset) const {
+        return offset == 0 ? 0 : characterStart(offset - 1);
+    }
+    
+    size_t nextCharacter(size_t offset) const {
+        if (offset >= buffer.size()) {
+            return buffer.size();
+        }
+        offset++;
+        while (offset < buffer.size() && isContinuation(buffer.at(offset))) {
+            offset++;
+        }
+        return offset;
+    }
+    
+    // Past the newline of the row starting at start, or where a long line wraps
+    size_t rowEnd(size_t start) const {
+        size_t newline = buffer.find('\n', start, kMaxRowBytes);
+        if (newline != xeno::utils::PieceTable::npos) {
+            return newline + 1;
+        }
+        size_t end = std::min(buffer.size(), start + kMaxRowBytes);
+        size_t wrap = characterStart(end);
+        return wrap > start ? wrap : end;
     }
+    
+    // The start of the row holding offset
+    size_t rowStart(size_t offset) const {
+        offset = std::min(offset, buffer.size());
+        size_t newline = buffer.rfind('\n', offset, kMaxRowBytes);
+        if (newline != xeno::utils::PieceTable::npos) {
+            return newline + 1;
+        }
+        return offset <= kMaxRowBytes ? 0 : characterStart(offset - kMaxRowBytes);
+    }
+    
+    // Where the row's text ends, before any line ending
+    size_t rowTextEnd(size_t start) const {
+        Row current = row(start);
+        return current.start + current.bytes.size();
+    }
+    
+    bool isLastRow(size_t start, size_t end) const {
+        return end >= buffer.size() && (end == start || buffer.at(end - 1) != '\n');
+    }
+    
+    Row row(size_t start) const {
+        Row current;
+        current.start = start;
+        current.end = rowEnd(start);
+        current.last = isLastRow(start, current.end);
+        current.bytes = buffer.text(start, current.end - start);
+        if (!current.bytes.empty() && current.bytes.back() == '\n') {
+            current.bytes.pop_back();
+            if (!current.bytes.empty() && current.bytes.back() == '\r') {
+                current.bytes.pop_back();
+            }
+        }
+        current.text = QString::fromStdString(current.bytes);
+        return current;
+    }
+    
+    // The layout index of a byte offset within a row
+    static int indexOf(const Row& current, size_t offset) {
+        size_t length = std::min(offset - std::min(offset, current.start), current.bytes.size());
+        return static_cast<int>(QString::fromUtf8(current.bytes.data(), static_cast<qsizetype>(length)).size());
+    }
+    
+    static size_t offsetOf(const Row& current, int index) {
+        return current.start + static_cast<size_t>(current.text.left(index).toUtf8().size());
+    }
+    
+    void layoutRow(QTextLayout& layout) const {
+        layout.setFont(font());
+        layout.setTextOption(text_option);
+        layout.beginLayout();
+        layout.createLine();
+        layout.endLayout();
+    }
+    
+    int visibleRows() const {
+        return std::max(1, viewport()->height() / fontMetrics().lineSpacing());
+    }
+    
+    // The start of the row rows below (or above, if negative) the one starting at start
+    size_t moveRows(size_t start, int rows) const {
+        for (; rows < 0 && start > 0; rows++) {
+            start = rowStart(start - 1);
+        }
+        for (; rows > 0; rows--) {
+            size_t end = rowEnd(start);
+            if (isLastRow(start, end)) {
+                break;
+            }
+            start = end;
+        }
+        return start;
+    }
+    
+    // The same column rows away from offset, or the end of a shorter row
+    size_t verticalTarget(size_t offset, int rows) const {
+        Row current = row(rowStart(offset));
+        int column = indexOf(current, offset);
+        Row target = row(moveRows(current.start, rows));
+        return offsetOf(target, std::min(column, static_cast<int>(target.text.size())));
+    }
+    
+    size_t offsetAt(const QPoint& point) const {
+        int rows = std::max(0, point.y()) / fontMetrics().lineSpacing();
+        Row current = row(moveRows(top, rows));
+        QTextLayout layout(current.text);
+        layoutRow(layout);
+        int index = layout.lineAt(0).xToCursor(point.x() - kMargin + horizontalScrollBar()->value());
+        return offsetOf(current, index);
+    }
+    
+    void moveCursor(size_t offset, bool select) {
+        cursor = offset;
+        if (!select) {
+            anchor = cursor;
+        }
+        ensureCursorVisible();
+    }
+    
+    void eraseSelection() {
+        size_t start = std::min(cursor, anchor);
+        size_t end = std::max(cursor, anchor);
+        cursor = anchor = start;
+        if (start == end) {
+            return;
+        }
+        buffer.erase(start, end - start);
+        if (top > start) {
+            top = rowStart(top >= end ? top - (end - start) : start);
+        }
+        edited();
+    }
+    
+    void edited() {
+        modified = true;
+        updateScrollRange();
+        viewport()->update();
+        emit contentsChanged();
+    }
+    
+    void ensureCursorVisible() {
+        if (cursor < top) {
+            top = rowStart(cursor);
+        } else {
+            size_t start = top;
+            bool visible = false;
+            for (int i = 0; i < visibleRows() && !visible; i++) {
+                size_t end = rowEnd(start);
+                visible = cursor < end || isLastRow(start, end);
+                start = end;
+            }
+            if (!visible) {
+                // The cursor's row becomes the last one in view
+                top = moveRows(rowStart(cursor), 1 - visibleRows());
+            }
+        }
+        syncScrollBar();
+        viewport()->update();
+    }
+    
+    void scrollRows(int rows) {
+        top = moveRows(top, rows);
+        syncScrollBar();
+        viewport()->update();
+    }
+    
+    void scrollAction(int action) {
+        int rows = 0;
+        switch (action) {
+        case QAbstractSlider::SliderSingleStepAdd:
+            rows = 1;
+            break;
+        case QAbstractSlider::SliderSingleStepSub:
+            rows = -1;
+            break;
+        case QAbstractSlider::SliderPageStepAdd:
+            rows = visibleRows();
+            break;
+        case QAbstractSlider::SliderPageStepSub:
+            rows = -visibleRows();
+            break;
+        default:
+            return; // Dragging maps the slider straight to an offset
+        }
+        // Steps are in rows, not the bytes the slider counts in
+        verticalScrollBar()->setSliderPosition(verticalScrollBar()->value());
+        scrollRows(rows);
+    }
+    
+    void updateScrollRange() {
+        scroll_scale = buffer.size() / kMaxScrollSteps + 1;
+        syncing_scroll_bar = true;
+        verticalScrollBar()->setRange(0, static_cast<int>(buffer.size() / scroll_scale));
+        // Roughly a screen of bytes, which only sets the handle size
+        size_t page = static_cast<size_t>(visibleRows()) * 80 / scroll_scale;
+        verticalScrollBar()->setPageStep(static_cast<int>(std::clamp<size_t>(page, 1, INT_MAX)));
+        syncing_scroll_bar = false;
+        syncScrollBar();
+    }
+    
+    void syncScrollBar() {
+        syncing_scroll_bar = true;
+        verticalScrollBar()->setValue(static_cast<int>(top / scroll_scale));
+        syncing_scroll_bar = false;
+    }
+    
+    xeno::utils::MappedFile file;
+    xeno::utils::PieceTable buffer;
+    QString error_message;
+    QTextOption text_option;
+    size_t top = 0;     // Start of the first row in view
+    size_t cursor = 0;
+    size_t anchor = 0;  // The other end of the selection
+    size_t scroll_scale = 1;
+    int wheel_delta = 0;
+    bool syncing_scroll_bar = false;
+    bool modified = false;
 };
 
 class XenoCodeWindow : public QMainWindow {
@@ -103,23 +776,41 @@ public:
         // Initialize AI integration
         ai_integration = std::make_unique<xeno::ai::AIIntegration>();
         
+        // Typing produces bursts of completion requests; the scheduler debounces and merges them
+        xeno::ai::CompletionScheduler::Options scheduler_options;
+        scheduler_options.debounce = std::chrono::milliseconds(300);
+        completion_scheduler = std::make_unique<xeno::ai::CompletionScheduler>(*ai_integration, scheduler_options);
+        
+        symbol_index = std::make_unique<xeno::code::SymbolIndex>(xeno::code::SymbolIndex::Options{});
+        
         setupUI();
         setupMenus();
         setupToolbars();
         setupConnections();
         
         loadConfiguration();
+        warmUpLocalModel();
         
         statusBar()->showMessage("Ready - AI-assisted coding with Xeno Labs integration");
         
         // Add sample code
         addSampleCode();
     }
+    
+    ~XenoCodeWindow() override {
+        index_cancelled = true;
+        if (index_thread.joinable()) {
+            index_thread.join();
+        }
+        if (!project_root.isEmpty()) {
+            symbol_index->save(xeno::code::SymbolIndex::cachePath(project_root.toStdString()));
+        }
+    }
 
 private slots:
     void newFile() {
-        auto editor = new QPlainTextEdit;
-        auto highlighter = new CppSyntaxHighlighter(editor->document());
+        auto editor = new CodeEditor;
+        attachHighlighter(editor);
         
         int index = editor_tabs->addTab(editor, "untitled.cpp");
         editor_tabs->setCurrentIndex(index);
@@ -130,13 +821,19 @@ private slots:
     
     void openFile() {
         QString filename = QFileDialog::getOpenFileName(this,
-            "Open File", "", "Source Files (*.cpp *.h *.py *.js *.ts *.java *.go *.rs)");
+            "Open File", "", "Source Files (*.cpp *.h *.py *.js *.ts *.java *.go *.rs);;All Files (*)");
+        
+        // Building a QTextDocument of a large file takes seconds and a copy of it in memory
+        if (!filename.isEmpty() && QFileInfo(filename).size() >= kLargeFileBytes) {
+            openLargeFile(filename);
+            return;
+        }
         
         if (!filename.isEmpty()) {
             QFile file(filename);
             if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                auto editor = new QPlainTextEdit;
-                auto highlighter = new CppSyntaxHighlighter(editor->document());
+                auto editor = new CodeEditor;
+                attachHighlighter(editor);
                 
                 QTextStream in(&file);
                 editor->setPlainText(in.readAll());
@@ -146,26 +843,68 @@ private slots:
                 editor_tabs->setCurrentIndex(index);
                 
                 setupAutoCompletion(editor);
+                // Files outside the project are indexed too, and watched like project files
+                symbol_index->updateFile(filename.toStdString());
+                project_watcher->addPath(filename);
                 statusBar()->showMessage("File opened: " + filename);
             }
         }
     }
     
+    void openLargeFile(const QString& filename) {
+        auto view = new LargeFileView;
+        if (!view->open(filename)) {
+            QMessageBox::critical(this, "Error", view->errorMessage());
+            delete view;
+            return;
+        }
+        connect(view, &LargeFileView::contentsChanged, this, [this, view]() {
+            scheduleInlineSuggestion(view);
+        });
+        
+        QFileInfo fileInfo(filename);
+        int index = editor_tabs->addTab(view, fileInfo.fileName());
+        editor_tabs->setCurrentIndex(index);
+        statusBar()->showMessage(QString("Large file opened: %1 (%2 MB, memory-mapped)")
+            .arg(filename).arg(fileInfo.size() / (1024 * 1024)));
+    }
+    
+    void openFolder() {
+        QString folder = QFileDialog::getExistingDirectory(this, "Open Folder");
+        if (!folder.isEmpty()) {
+            indexProject(folder);
+        }
+    }
+    
     void saveFile() {
-        auto current_editor = qobject_cast<QPlainTextEdit*>(editor_tabs->currentWidget());
+        QWidget* current_editor = currentEditor();
         if (!current_editor) {
             QMessageBox::warning(this, "Warning", "No file to save!");
             return;
         }
         
         QString filename = QFileDialog::getSaveFileName(this,
-            "Save File", "", "Source Files (*.cpp *.h *.py *.js *.ts)");
+            "Save File", "", "Source Files (*.cpp *.h *.py *.js *.ts);;All Files (*)");
         
+        if (auto view = qobject_cast<LargeFileView*>(current_editor); view && !filename.isEmpty()) {
+            if (!view->save(filename)) {
+                QMessageBox::critical(this, "Error", view->errorMessage());
+                return;
+            }
+            editor_tabs->setTabText(editor_tabs->currentIndex(), QFileInfo(filename).fileName());
+            statusBar()->showMessage("File saved: " + filename);
+            return;
+        }
+        
+        auto text_editor = qobject_cast<QPlainTextEdit*>(current_editor);
         if (!filename.isEmpty()) {
             QFile file(filename);
             if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
                 QTextStream out(&file);
-                out << current_editor->toPlainText();
+                out << text_editor->toPlainText();
+                
+                file.close();
+                symbol_index->updateFile(filename.toStdString());
                 
                 QFileInfo fileInfo(filename);
                 editor_tabs->setTabText(editor_tabs->currentIndex(), fileInfo.fileName());
@@ -175,51 +914,126 @@ private slots:
     }
     
     void getCodeSuggestion() {
-        auto current_editor = qobject_cast<QPlainTextEdit*>(editor_tabs->currentWidget());
+        QWidget* current_editor = currentEditor();
         if (!current_editor) {
             QMessageBox::warning(this, "Warning", "Please open a file first!");
             return;
         }
         
+        qint64 position = cursorPosition(current_editor);
+        auto provider = completionProvider(current_editor, position, currentProvider());
         int required_credits = 1;
-        if (!ai_integration->validateCredits(required_credits)) {
+        if (provider == xeno::ai::AIIntegration::AIProvider::XenoCloud &&
+            !ai_integration->validateCredits(required_credits)) {
             QMessageBox::warning(this, "Insufficient Credits", 
                 QString("Code suggestions require %1 credit. Please purchase more in Xeno Labs.")
                 .arg(required_credits));
             return;
         }
         
-        QString current_code = current_editor->toPlainText();
-        QTextCursor cursor = current_editor->textCursor();
-        QString context = current_code.left(cursor.position());
+        // Only one suggestion streams at a time; a new request replaces the previous one
+        active_suggestion.cancel();
+        quint64 generation = ++suggestion_generation;
+        suggestion_editor = qobject_cast<QPlainTextEdit*>(current_editor);
+        suggestion_view = qobject_cast<LargeFileView*>(current_editor);
+        if (suggestion_editor) {
+            suggestion_cursor = QTextCursor(suggestion_editor->document());
+            suggestion_cursor.setPosition(suggestion_editor->textCursor().position());
+        } else {
+            suggestion_offset = suggestion_view->cursorOffset();
+        }
+        suggestion_started = false;
+        suggestion_provider = provider;
+        suggestion_timer.start();
+        
+        auto progress = new QProgressDialog("Getting AI code suggestion...", "Cancel", 0, 0, this);
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setAttribute(Qt::WA_DeleteOnClose);
+        progress->show();
+        suggestion_progress = progress;
+        
+        auto request = completionRequest(current_editor, position, provider);
+        dropStalePrefetch(request, provider);
+        
+        // Tokens are inserted into the editor as they arrive rather than after the whole generation
+        active_suggestion = ai_integration->completeCodeStreamAsync(request,
+            [this, generation](const std::string& chunk) {
+                QString text = QString::fromStdString(chunk);
+                QMetaObject::invokeMethod(this, [this, generation, text]() {
+                    appendSuggestionChunk(generation, text);
+                }, Qt::QueuedConnection);
+                return true;
+            },
+            provider,
+            [this, generation](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, generation, response]() {
+                    finishCodeSuggestion(generation, response);
+                }, Qt::QueuedConnection);
+            });
+        
+        connect(progress, &QProgressDialog::canceled, this, [this]() { active_suggestion.cancel(); });
+    }
+    
+    void appendSuggestionChunk(quint64 generation, const QString& text) {
+        if (generation != suggestion_generation || (!suggestion_editor && !suggestion_view)) {
+            return;
+        }
         
-        QProgressDialog progress("Getting AI code suggestion...", "Cancel", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
+        // First token arrived; keep streaming in the editor without blocking it
+        if (suggestion_progress) {
+            suggestion_progress->close();
+            statusBar()->showMessage("Streaming code suggestion... (Esc to stop)");
+        }
         
-        for (int i = 0; i <= 100; i += 20) {
-            progress.setValue(i);
-            QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                return;
-            }
-            QThread::msleep(50);
+        if (suggestion_view) {
+            suggestion_offset += suggestion_view->insertAt(suggestion_offset, text);
+            return;
         }
         
-        xeno::ai::AIIntegration::AIRequest request;
-        request.prompt = "Complete this code: " + context.right(200).toStdString();
-        request.operation_type = "code_completion";
+        // Group the whole suggestion into one undo step
+        if (suggestion_started) {
+            suggestion_cursor.joinPreviousEditBlock();
+        } else {
+            suggestion_cursor.beginEditBlock();
+            suggestion_started = true;
+        }
+        suggestion_cursor.insertText(text);
+        suggestion_cursor.endEditBlock();
+    }
+    
+    void finishCodeSuggestion(quint64 generation, const xeno::ai::AIIntegration::AIResponse& response) {
+        if (generation != suggestion_generation) {
+            return;
+        }
+        if (suggestion_progress) {
+            suggestion_progress->close();
+        }
+        active_suggestion = {};
         
-        auto response = ai_integration->completeCode(request);
+        if (response.metadata.value("cancelled", false)) {
+            statusBar()->showMessage("Code suggestion stopped");
+            return;
+        }
         
         if (response.success) {
-            // Insert suggestion at cursor
-            QString suggestion = QString::fromStdString(response.content);
-            cursor.insertText(suggestion);
-            
-            statusBar()->showMessage(QString("Code suggestion applied - %1 credit used")
-                .arg(response.credits_used));
+            if (response.credits_used > 0) {
+                statusBar()->showMessage(QString("Code suggestion applied - %1 credit used")
+                    .arg(response.credits_used));
+            } else {
+                statusBar()->showMessage(QString("Code suggestion applied in %1 ms").arg(suggestion_timer.elapsed()));
+            }
             updateCreditDisplay();
+            
+            // Runs ahead to what follows the suggestion while it is being read
+            bool served_locally = suggestion_provider == xeno::ai::AIIntegration::AIProvider::Ollama ||
+                                  response.metadata.value("routed_provider", "") == "Ollama";
+            if (served_locally) {
+                if (suggestion_editor) {
+                    prefetchCompletion(suggestion_editor, suggestion_cursor.position());
+                } else if (suggestion_view) {
+                    prefetchCompletion(suggestion_view, static_cast<qint64>(suggestion_offset));
+                }
+            }
         } else {
             QMessageBox::critical(this, "AI Error", 
                 QString("Failed to get code suggestion: %1").arg(QString::fromStdString(response.error_message)));
@@ -227,13 +1041,14 @@ private slots:
     }
     
     void refactorCode() {
-        auto current_editor = qobject_cast<QPlainTextEdit*>(editor_tabs->currentWidget());
+        QWidget* current_editor = currentEditor();
         if (!current_editor) {
             QMessageBox::warning(this, "Warning", "Please open a file first!");
             return;
         }
         
-        if (!current_editor->textCursor().hasSelection()) {
+        QString selected_code = selectedText(current_editor);
+        if (selected_code.isEmpty()) {
             QMessageBox::warning(this, "Warning", "Please select code to refactor!");
             return;
         }
@@ -245,8 +1060,6 @@ private slots:
             return;
         }
         
-        QString selected_code = current_editor->textCursor().selectedText();
-        
         QProgressDialog progress("Refactoring code...", "Cancel", 0, 100, this);
         progress.setWindowModality(Qt::WindowModal);
         progress.show();
@@ -264,44 +1077,124 @@ private slots:
         
         // Simulate refactoring
         QString refactored = "// Refactored code:\n" + selected_code + "\n// End refactored";
-        current_editor->textCursor().insertText(refactored);
+        replaceSelection(current_editor, refactored);
         
         statusBar()->showMessage(QString("Code refactored - %1 credits used").arg(required_credits));
         updateCreditDisplay();
     }
     
     void explainCode() {
-        auto current_editor = qobject_cast<QPlainTextEdit*>(editor_tabs->currentWidget());
+        QWidget* current_editor = currentEditor();
         if (!current_editor) {
             QMessageBox::warning(this, "Warning", "Please open a file first!");
             return;
         }
         
-        QString selected_code = current_editor->textCursor().selectedText();
+        QString selected_code = selectedText(current_editor);
         if (selected_code.isEmpty()) {
-            selected_code = current_editor->toPlainText().left(500); // First 500 chars
+            selected_code = textAroundCursor(current_editor, kExplainContextChars);
         }
         
+        auto provider = currentProvider();
         int required_credits = 1;
-        if (!ai_integration->validateCredits(required_credits)) {
+        if (provider == xeno::ai::AIIntegration::AIProvider::XenoCloud &&
+            !ai_integration->validateCredits(required_credits)) {
             QMessageBox::warning(this, "Insufficient Credits", 
                 QString("Code explanation requires %1 credit.").arg(required_credits));
             return;
         }
         
-        ai_integration->deductCredits(required_credits);
+        active_explanation.cancel();
+        quint64 generation = ++explanation_generation;
+        ai_output->clear();
+        statusBar()->showMessage("Explaining code... (Esc to stop)");
         
-        QString explanation = QString("AI Explanation for selected code:\n\n"
-                                    "%1\n\n"
-                                    "This code appears to define a function or class structure. "
-                                    "The AI would provide detailed explanation here about the code's "
-                                    "purpose, functionality, and any potential improvements.")
-                             .arg(selected_code.left(200));
+        xeno::ai::AIIntegration::AIRequest request;
+        request.prompt = "Explain the purpose, behaviour and possible improvements of this code:\n\n" +
+                         selected_code.toStdString();
+        request.operation_type = "code_explanation";
+        
+        active_explanation = ai_integration->chatCompletionStreamAsync(request,
+            [this, generation](const std::string& chunk) {
+                QString text = QString::fromStdString(chunk);
+                QMetaObject::invokeMethod(this, [this, generation, text]() {
+                    if (generation != explanation_generation) {
+                        return;
+                    }
+                    ai_output->moveCursor(QTextCursor::End);
+                    ai_output->insertPlainText(text);
+                }, Qt::QueuedConnection);
+                return true;
+            },
+            provider,
+            [this, generation](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, generation, response]() {
+                    finishExplanation(generation, response);
+                }, Qt::QueuedConnection);
+            });
+    }
+    
+    void finishExplanation(quint64 generation, const xeno::ai::AIIntegration::AIResponse& response) {
+        if (generation != explanation_generation) {
+            return;
+        }
+        active_explanation = {};
         
-        ai_output->setPlainText(explanation);
+        if (response.metadata.value("cancelled", false)) {
+            statusBar()->showMessage("Code explanation stopped");
+        } else if (response.success) {
+            statusBar()->showMessage(QString("Code explained - %1 credit used").arg(response.credits_used));
+            updateCreditDisplay();
+        } else {
+            ai_output->setPlainText(QString("Failed to explain code: %1")
+                .arg(QString::fromStdString(response.error_message)));
+        }
+    }
+    
+    void scheduleInlineSuggestion(QWidget* editor) {
+        // Text inserted by a streaming suggestion is not typing
+        if (!suggest_while_typing->isChecked() || active_suggestion.token) {
+            return;
+        }
         
-        statusBar()->showMessage(QString("Code explained - %1 credit used").arg(required_credits));
-        updateCreditDisplay();
+        qint64 position = cursorPosition(editor);
+        auto provider = completionProvider(editor, position, currentProvider());
+        auto request = completionRequest(editor, position, provider);
+        dropStalePrefetch(request, provider);
+        
+        // One slot per editor, so each keystroke supersedes the request made by the previous one
+        std::string slot = "editor:" + std::to_string(reinterpret_cast<quintptr>(editor));
+        QPointer<QWidget> target(editor);
+        completion_scheduler->request(slot, request, provider,
+            [this, target, position](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, target, position, response]() {
+                    showInlineSuggestion(target, position, response);
+                }, Qt::QueuedConnection);
+            });
+    }
+    
+    void showInlineSuggestion(QWidget* editor, qint64 position,
+                              const xeno::ai::AIIntegration::AIResponse& response) {
+        if (!editor || response.metadata.value("cancelled", false)) {
+            return;
+        }
+        // The cursor moved on since the request was made
+        if (cursorPosition(editor) != position) {
+            return;
+        }
+        
+        if (response.success) {
+            ai_output->setPlainText("Suggestion at cursor:\n\n" + QString::fromStdString(response.content));
+            updateCreditDisplay();
+        } else {
+            statusBar()->showMessage(QString("Inline suggestion failed: %1")
+                .arg(QString::fromStdString(response.error_message)), 3000);
+        }
+    }
+    
+    void stopStreaming() {
+        active_suggestion.cancel();
+        active_explanation.cancel();
     }
     
     void switchAIProvider() {
@@ -312,6 +1205,8 @@ private slots:
         if (provider == "Ollama (Local)") {
             credit_status->setText("Local Mode - No credits required");
             credit_status->setStyleSheet("font-weight: bold; font-size: 14px; color: #27ae60;");
+            // The model may have been unloaded while another provider was in use
+            warmUpLocalModel();
         } else {
             updateCreditDisplay();
         }
@@ -357,6 +1252,8 @@ private:
         // Provider selection
         auto provider_label = new QLabel("AI Provider:");
         ai_provider_combo = new QComboBox;
+        // Routes each request to the fastest healthy provider and fails over when one is down
+        ai_provider_combo->addItem("Automatic");
         ai_provider_combo->addItem("Xeno AI Cloud");
         ai_provider_combo->addItem("Open Router");
         ai_provider_combo->addItem("Ollama (Local)");
@@ -436,6 +1333,7 @@ private:
         auto file_menu = menuBar()->addMenu("&File");
         file_menu->addAction("&New", this, &XenoCodeWindow::newFile, QKeySequence::New);
         file_menu->addAction("&Open", this, &XenoCodeWindow::openFile, QKeySequence::Open);
+        file_menu->addAction("Open &Folder...", this, &XenoCodeWindow::openFolder, QKeySequence("Ctrl+Shift+O"));
         file_menu->addAction("&Save", this, &XenoCodeWindow::saveFile, QKeySequence::Save);
         file_menu->addSeparator();
         file_menu->addAction("&Quit", this, &QWidget::close, QKeySequence::Quit);
@@ -449,6 +1347,10 @@ private:
         ai_menu->addAction("Code Suggestion", this, &XenoCodeWindow::getCodeSuggestion, QKeySequence("Ctrl+Space"));
         ai_menu->addAction("Refactor Code", this, &XenoCodeWindow::refactorCode, QKeySequence("Ctrl+R"));
         ai_menu->addAction("Explain Code", this, &XenoCodeWindow::explainCode, QKeySequence("Ctrl+E"));
+        ai_menu->addSeparator();
+        // Off by default: every pause in typing may spend a credit
+        suggest_while_typing = ai_menu->addAction("Suggest While Typing");
+        suggest_while_typing->setCheckable(true);
     }
     
     void setupToolbars() {
@@ -462,25 +1364,322 @@ private:
     }
     
     void setupConnections() {
-        // Additional connections
+        // Esc stops whichever AI response is currently streaming
+        auto stop_shortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+        connect(stop_shortcut, &QShortcut::activated, this, &XenoCodeWindow::stopStreaming);
+        
+        // Saves made outside the editor; directories report added, removed and atomically replaced files
+        project_watcher = new QFileSystemWatcher(this);
+        connect(project_watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& directory) {
+            symbol_index->updateDirectory(directory.toStdString());
+        });
+        connect(project_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString& path) {
+            symbol_index->updateFile(path.toStdString());
+            // Replacing a file drops its watch
+            if (QFileInfo::exists(path) && !project_watcher->files().contains(path)) {
+                project_watcher->addPath(path);
+            }
+        });
+        
+        completion_model = new QStringListModel(this);
+        symbol_completer = new QCompleter(completion_model, this);
+        symbol_completer->setCompletionMode(QCompleter::PopupCompletion);
+        symbol_completer->setCaseSensitivity(Qt::CaseSensitive);
+        symbol_completer->setMaxVisibleItems(12);
+        connect(symbol_completer, qOverload<const QString&>(&QCompleter::activated), this,
+                &XenoCodeWindow::insertCompletion);
     }
     
-    void setupAutoCompletion(QPlainTextEdit* editor) {
-        // Basic C++ keywords for autocompletion
-        QStringList wordList;
-        wordList << "class" << "struct" << "namespace" << "if" << "else" 
-                 << "for" << "while" << "return" << "int" << "float" << "double"
-                 << "void" << "bool" << "char" << "const" << "static"
-                 << "public" << "private" << "protected" << "virtual";
+    void attachHighlighter(QPlainTextEdit* editor) {
+        auto highlighter = new CppSyntaxHighlighter(editor->document());
+        // The scroll bar counts lines, so its value is the first visible block
+        auto scroll_bar = editor->verticalScrollBar();
+        connect(scroll_bar, &QScrollBar::valueChanged, highlighter, [highlighter, scroll_bar](int value) {
+            highlighter->ensureHighlighted(value + scroll_bar->pageStep());
+        });
+    }
+    
+    void setupAutoCompletion(CodeEditor* editor) {
+        editor->setCompleter(symbol_completer);
+        connect(editor, &QPlainTextEdit::textChanged, this, [this, editor]() {
+            updateCompletion(editor);
+            scheduleInlineSuggestion(editor);
+        });
+    }
+    
+    // Offers project identifiers and keywords that extend the word before the cursor
+    void updateCompletion(QPlainTextEdit* editor) {
+        if (inserting_completion || active_suggestion.token) {
+            return;
+        }
+        QTextCursor cursor = editor->textCursor();
+        QString line = cursor.block().text().left(cursor.positionInBlock());
+        int start = line.size();
+        while (start > 0 && (line[start - 1].isLetterOrNumber() || line[start - 1] == '_')) {
+            start--;
+        }
+        QString prefix = line.mid(start);
+        if (prefix.size() < kMinCompletionPrefix || prefix[0].isDigit()) {
+            symbol_completer->popup()->hide();
+            return;
+        }
         
-        auto completer = new QCompleter(wordList, this);
-        completer->setCaseSensitivity(Qt::CaseInsensitive);
+        QStringList words;
+        for (const auto& word : symbol_index->complete(prefix.toStdString(), kMaxCompletions)) {
+            words << QString::fromStdString(word);
+        }
+        for (const auto& keyword : completion_keywords) {
+            if (keyword.startsWith(prefix) && keyword != prefix && !words.contains(keyword)) {
+                words << keyword;
+            }
+        }
+        if (words.isEmpty()) {
+            symbol_completer->popup()->hide();
+            return;
+        }
         
-        // Note: QPlainTextEdit doesn't have setCompleter, 
-        // but we can implement custom completion logic here
+        completion_model->setStringList(words);
+        symbol_completer->setWidget(editor);
+        symbol_completer->setCompletionPrefix(prefix);
+        symbol_completer->popup()->setCurrentIndex(symbol_completer->completionModel()->index(0, 0));
+        QRect rect = editor->cursorRect();
+        rect.setWidth(symbol_completer->popup()->sizeHintForColumn(0) +
+                      symbol_completer->popup()->verticalScrollBar()->sizeHint().width());
+        symbol_completer->complete(rect);
+    }
+    
+    void insertCompletion(const QString& completion) {
+        auto editor = qobject_cast<QPlainTextEdit*>(symbol_completer->widget());
+        if (!editor) {
+            return;
+        }
+        inserting_completion = true;
+        QTextCursor cursor = editor->textCursor();
+        cursor.insertText(completion.mid(symbol_completer->completionPrefix().size()));
+        editor->setTextCursor(cursor);
+        inserting_completion = false;
+    }
+    
+    // Editors are either kind; AI requests read only the ranges they need from them, never the whole document
+    QWidget* currentEditor() const {
+        QWidget* widget = editor_tabs->currentWidget();
+        return qobject_cast<QPlainTextEdit*>(widget) || qobject_cast<LargeFileView*>(widget) ? widget : nullptr;
+    }
+    
+    // In characters for text editors and bytes for large files; only compared with itself
+    static qint64 cursorPosition(QWidget* editor) {
+        if (auto view = qobject_cast<LargeFileView*>(editor)) {
+            return static_cast<qint64>(view->cursorOffset());
+        }
+        return qobject_cast<QPlainTextEdit*>(editor)->textCursor().position();
+    }
+    
+    static QString textRange(QPlainTextEdit* editor, int from, int to) {
+        QTextCursor range(editor->document());
+        range.setPosition(std::max(0, from));
+        range.setPosition(std::min(to, editor->document()->characterCount() - 1), QTextCursor::KeepAnchor);
+        // selectedText() separates lines with U+2029
+        return range.selectedText().replace(QChar::ParagraphSeparator, '\n');
+    }
+    
+    static QString textBefore(QWidget* editor, qint64 position, qint64 length) {
+        if (auto view = qobject_cast<LargeFileView*>(editor)) {
+            return view->textBefore(static_cast<size_t>(position), static_cast<size_t>(length));
+        }
+        int end = static_cast<int>(position);
+        return textRange(qobject_cast<QPlainTextEdit*>(editor), end - static_cast<int>(length), end);
+    }
+    
+    static QString textAroundCursor(QWidget* editor, int max_chars) {
+        if (auto view = qobject_cast<LargeFileView*>(editor)) {
+            return view->textAroundCursor(static_cast<size_t>(max_chars));
+        }
+        auto text_editor = qobject_cast<QPlainTextEdit*>(editor);
+        int start = std::max(0, text_editor->textCursor().position() - max_chars / 2);
+        return textRange(text_editor, start, start + max_chars);
+    }
+    
+    static QString selectedText(QWidget* editor) {
+        if (auto view = qobject_cast<LargeFileView*>(editor)) {
+            return view->selectedText();
+        }
+        QString text = qobject_cast<QPlainTextEdit*>(editor)->textCursor().selectedText();
+        return text.replace(QChar::ParagraphSeparator, '\n');
+    }
+    
+    static void replaceSelection(QWidget* editor, const QString& text) {
+        if (auto view = qobject_cast<LargeFileView*>(editor)) {
+            view->insertText(text);
+        } else {
+            qobject_cast<QPlainTextEdit*>(editor)->textCursor().insertText(text);
+        }
+    }
+    
+    xeno::ai::AIIntegration::AIProvider currentProvider() const {
+        QString provider = ai_provider_combo->currentText();
+        if (provider == "Automatic") {
+            return xeno::ai::AIIntegration::AIProvider::Auto;
+        }
+        if (provider == "Ollama (Local)") {
+            return xeno::ai::AIIntegration::AIProvider::Ollama;
+        }
+        if (provider == "Open Router") {
+            return xeno::ai::AIIntegration::AIProvider::OpenRouter;
+        }
+        return xeno::ai::AIIntegration::AIProvider::XenoCloud;
+    }
+    
+    // The code before position that completions see. Its start snaps to a kPromptStepChars boundary,
+    // so it only moves every few hundred characters typed and consecutive prompts share a prefix,
+    // whose evaluation a local model keeps between requests.
+    static QString promptContext(QWidget* editor, qint64 position) {
+        qint64 start = std::max<qint64>(0, (position - kPromptContextChars) / kPromptStepChars * kPromptStepChars);
+        return textBefore(editor, position, position - start);
+    }
+    
+    // Prefetches build their requests here too, so they match the request they stand in for
+    xeno::ai::AIIntegration::AIRequest completionRequest(QWidget* editor, qint64 position,
+                                                         xeno::ai::AIIntegration::AIProvider provider) {
+        xeno::ai::AIIntegration::AIRequest request;
+        request.prompt = completionPrompt(promptContext(editor, position));
+        request.operation_type = "code_completion";
+        if (provider == xeno::ai::AIIntegration::AIProvider::Ollama) {
+            // Short local completions keep within the latency budget
+            request.parameters["num_predict"] = kLocalCompletionTokens;
+        }
+        return request;
+    }
+    
+    // With a local model, completing from where a suggestion ended costs nothing, and the response
+    // cache answers the request for that spot at once if it comes
+    void prefetchCompletion(QWidget* editor, qint64 position) {
+        auto request = completionRequest(editor, position, xeno::ai::AIIntegration::AIProvider::Ollama);
+        prefetch_task.cancel();
+        prefetch_key = prefetchKey(request, xeno::ai::AIIntegration::AIProvider::Ollama);
+        prefetch_task = ai_integration->completeCodeAsync(request, xeno::ai::AIIntegration::AIProvider::Ollama);
+    }
+    
+    // The fields the response cache keys a request on
+    static std::string prefetchKey(const xeno::ai::AIIntegration::AIRequest& request,
+                                   xeno::ai::AIIntegration::AIProvider provider) {
+        return std::to_string(static_cast<int>(provider)) + '\n' + request.model + '\n' + request.operation_type +
+               '\n' + nlohmann::json(request.parameters).dump() + '\n' + request.prompt;
+    }
+    
+    // Where a completion at position goes. Under Automatic, the spot a prefetch ran ahead to goes to
+    // Ollama, which served the prefetch, and is built the same way, so the cache entry answers it.
+    xeno::ai::AIIntegration::AIProvider completionProvider(QWidget* editor, qint64 position,
+                                                           xeno::ai::AIIntegration::AIProvider selected) {
+        using Provider = xeno::ai::AIIntegration::AIProvider;
+        if (selected == Provider::Auto && !prefetch_key.empty() &&
+            prefetchKey(completionRequest(editor, position, Provider::Ollama), Provider::Ollama) == prefetch_key) {
+            return Provider::Ollama;
+        }
+        return selected;
+    }
+    
+    // Ollama runs one generation at a time, so a prefetch the cache cannot answer this request
+    // from would hold it up
+    void dropStalePrefetch(const xeno::ai::AIIntegration::AIRequest& request,
+                           xeno::ai::AIIntegration::AIProvider provider) {
+        if (prefetchKey(request, provider) != prefetch_key) {
+            prefetch_task.cancel();
+            prefetch_key.clear();
+        }
+    }
+    
+    // Loads the local model in the background, so the first completion does not wait for it
+    void warmUpLocalModel() {
+        if (!ai_integration->isProviderAvailable(xeno::ai::AIIntegration::AIProvider::Ollama)) {
+            return;
+        }
+        ai_integration->warmUpAsync(xeno::ai::AIIntegration::AIProvider::Ollama, "",
+            [this](const xeno::ai::AIIntegration::AIResponse& response) {
+                QMetaObject::invokeMethod(this, [this, response]() {
+                    if (response.success) {
+                        statusBar()->showMessage(QString("Local model %1 loaded in %2 ms")
+                            .arg(QString::fromStdString(response.metadata.value("model", "")))
+                            .arg(response.metadata.value("elapsed_ms", 0.0), 0, 'f', 0), 5000);
+                    } else if (!response.metadata.value("cancelled", false)) {
+                        statusBar()->showMessage(QString("Local model unavailable: %1")
+                            .arg(QString::fromStdString(response.error_message)), 5000);
+                    }
+                }, Qt::QueuedConnection);
+            });
+    }
+    
+    // The code before the cursor, led by the project definitions it refers to most. Those are
+    // taken from whole steps of the context, so they change no more often than its start does.
+    std::string completionPrompt(const QString& context) {
+        QString settled = context.left(context.size() / kPromptStepChars * kPromptStepChars);
+        std::string prompt;
+        auto related = symbol_index->relatedSymbols((settled.isEmpty() ? context : settled).toStdString(),
+                                                    kPromptSymbols);
+        if (!related.empty()) {
+            prompt += "Relevant definitions from the project:\n";
+            for (const auto& symbol : related) {
+                std::string file = QFileInfo(QString::fromStdString(symbol.path)).fileName().toStdString();
+                prompt += file + ":" + std::to_string(symbol.line) + ": " + symbol.signature + "\n";
+            }
+            prompt += "\n";
+        }
+        return prompt + "Complete this code:\n" + context.toStdString();
+    }
+    
+    // Indexes a project on the index thread, starting from the copy saved last session
+    void indexProject(const QString& root) {
+        index_cancelled = true;
+        if (index_thread.joinable()) {
+            index_thread.join();
+        }
+        if (!project_root.isEmpty()) {
+            symbol_index->save(xeno::code::SymbolIndex::cachePath(project_root.toStdString()));
+        }
+        project_root = root;
+        index_cancelled = false;
+        statusBar()->showMessage("Indexing " + root + "...");
+        
+        index_thread = std::thread([this, root = root.toStdString()]() {
+            std::string cache = xeno::code::SymbolIndex::cachePath(root);
+            symbol_index->load(cache);
+            int last_percent = -1;
+            size_t parsed = symbol_index->indexDirectory(root, [&](double fraction) {
+                int percent = static_cast<int>(fraction * 100);
+                if (percent != last_percent) {
+                    last_percent = percent;
+                    QMetaObject::invokeMethod(this, [this, percent]() {
+                        statusBar()->showMessage(QString("Indexing project... %1%").arg(percent));
+                    }, Qt::QueuedConnection);
+                }
+                return !index_cancelled.load();
+            });
+            if (index_cancelled) {
+                return;
+            }
+            symbol_index->save(cache);
+            
+            std::vector<std::string> directories = symbol_index->directories();
+            QMetaObject::invokeMethod(this, [this, parsed, directories]() {
+                if (!project_watcher->directories().isEmpty()) {
+                    project_watcher->removePaths(project_watcher->directories());
+                }
+                QStringList paths;
+                for (const auto& directory : directories) {
+                    paths << QString::fromStdString(directory);
+                }
+                if (!paths.isEmpty()) {
+                    project_watcher->addPaths(paths);
+                }
+                statusBar()->showMessage(QString("Project indexed - %1 files, %2 symbols (%3 files read)")
+                    .arg(symbol_index->fileCount()).arg(symbol_index->symbolCount()).arg(parsed));
+            }, Qt::QueuedConnection);
+        });
     }
     
     void loadConfiguration() {
+        // With the launcher running, AI requests and credits go through its shared service and the
+        // config here only takes over if the launcher quits
+        ai_integration->connectToBroker(xeno::ai::AIBroker::defaultAddress());
         std::string config_path = xeno::utils::Platform::getAppDataPath() + "/config.json";
         ai_integration->loadConfigFromFile(config_path);
     }
@@ -503,8 +1702,8 @@ private:
     }
     
     void addSampleCode() {
-        auto editor = new QPlainTextEdit;
-        auto highlighter = new CppSyntaxHighlighter(editor->document());
+        auto editor = new CodeEditor;
+        attachHighlighter(editor);
         
         QString sample_code = 
             "#include <iostream>\n"
@@ -544,12 +1743,55 @@ private:
 
 private:
     std::unique_ptr<xeno::ai::AIIntegration> ai_integration;
+    std::unique_ptr<xeno::ai::CompletionScheduler> completion_scheduler;
+    
+    // Project symbols for completion and prompts; indexing runs on index_thread
+    static constexpr int kMinCompletionPrefix = 2;
+    static constexpr size_t kMaxCompletions = 50;
+    static constexpr int kPromptContextChars = 1500;
+    static constexpr int kPromptStepChars = 500;
+    static constexpr int kLocalCompletionTokens = 64;
+    static constexpr int kExplainContextChars = 500;
+    static constexpr size_t kPromptSymbols = 12;
+    std::unique_ptr<xeno::code::SymbolIndex> symbol_index;
+    std::thread index_thread;
+    std::atomic<bool> index_cancelled{false};
+    QString project_root;
+    QFileSystemWatcher* project_watcher;
+    QCompleter* symbol_completer;
+    QStringListModel* completion_model;
+    bool inserting_completion = false;
+    const QStringList completion_keywords = {
+        "class", "struct", "namespace", "if", "else", "for", "while", "return", "int", "float", "double",
+        "void", "bool", "char", "const", "static", "public", "private", "protected", "virtual"
+    };
+    
+    // Files this large open in a LargeFileView
+    static constexpr qint64 kLargeFileBytes = 16 * 1024 * 1024;
+    
+    // Streaming AI responses; generation counters drop chunks from superseded requests
+    xeno::ai::AIIntegration::AITask active_suggestion;
+    xeno::ai::AIIntegration::AITask active_explanation;
+    quint64 suggestion_generation = 0;
+    quint64 explanation_generation = 0;
+    QPointer<QPlainTextEdit> suggestion_editor;
+    QPointer<LargeFileView> suggestion_view;
+    size_t suggestion_offset = 0;
+    QPointer<QProgressDialog> suggestion_progress;
+    QTextCursor suggestion_cursor;
+    bool suggestion_started = false;
+    xeno::ai::AIIntegration::AIProvider suggestion_provider = xeno::ai::AIIntegration::AIProvider::XenoCloud;
+    QElapsedTimer suggestion_timer;
+    // Completion requested ahead from the local model, and the cache key of its request
+    xeno::ai::AIIntegration::AITask prefetch_task;
+    std::string prefetch_key;
     
     // UI elements
     QTabWidget* editor_tabs;
     QComboBox* ai_provider_combo;
     QPlainTextEdit* ai_output;
     QLabel* credit_status;
+    QAction* suggest_while_typing;
 };
 
 int main(int argc, char *argv[]) {
@@ -559,6 +1801,12 @@ int main(int argc, char *argv[]) {
     QApplication::setApplicationVersion("1.0.0");
     QApplication::setOrganizationName("Xeno AI");
     
+    // Log to <app data>/logs/xeno-code.log as well as the console
+    xeno::utils::Logger::Options log_options;
+    log_options.file_name = "xeno-code";
+    xeno::utils::Logger::getInstance().configure(log_options);
+    // Edits to config.json apply without a restart
+    xeno::utils::ConfigManager::getInstance().watch();
     xeno::utils::Logger::getInstance().info("Starting Xeno Code AI-Assisted IDE");
     
     XenoCodeWindow window;
@@ -0,0 +1,765 @@
+#include "symbol_index.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+#include "../../shared/utils/include/utils.h"
+#include "cpp_lexer.h"
+
+namespace xeno::code {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* kIndexHeader = "xeno-symbol-index 1";
+constexpr size_t kMinWordLength = 3;    // Shorter words are quicker to type than to pick
+constexpr size_t kMaxWordLength = 64;
+constexpr size_t kMaxSignatureLength = 160;
+constexpr size_t kMaxCompletionCandidates = 4096; // Bounds the ranking work for one-letter prefixes
+constexpr size_t kMaxStatementTokens = 256;       // How far a declaration is followed before giving up
+
+struct Lexeme {
+    TokenKind kind = TokenKind::Punctuation;
+    uint32_t line = 0;
+    uint32_t column = 0;
+    std::string_view text;
+};
+
+std::string normalPath(const std::string& path) {
+    return fs::path(path).lexically_normal().make_preferred().string();
+}
+
+int64_t modifiedTime(const fs::path& path, std::error_code& error) {
+    return static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+}
+
+std::string_view trim(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
+
+// Directories that hold build output, dependencies or tool state rather than project sources
+bool skippedDirectory(const std::string& name) {
+    return name.empty() || name[0] == '.' || name == "node_modules" || name == "CMakeFiles" || name == "_deps" ||
+           name.rfind("build", 0) == 0 || name.rfind("cmake-build", 0) == 0;
+}
+
+// Lexes UTF-8 text line by line. Bytes are widened one to one, so token offsets are byte
+// offsets and the bytes of non-ASCII characters read as identifier characters.
+void lexText(std::string_view text, std::vector<Lexeme>& lexemes, std::vector<std::string_view>* lines) {
+    CppLexer lexer;
+    int state = -1;
+    std::u16string buffer;
+    std::vector<Token> tokens;
+    uint32_t line_number = 0;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = std::min(text.find('\n', start), text.size());
+        std::string_view line = text.substr(start, end - start);
+        line_number++;
+        if (lines) {
+            lines->push_back(line);
+        }
+        buffer.resize(line.size());
+        for (size_t i = 0; i < line.size(); i++) {
+            buffer[i] = static_cast<unsigned char>(line[i]);
+        }
+        tokens.clear();
+        state = lexer.lexLine(buffer, state, tokens);
+        for (const auto& token : tokens) {
+            lexemes.push_back({token.kind, line_number, token.start + 1, line.substr(token.start, token.length)});
+        }
+        start = end + 1;
+    }
+}
+
+bool isTypeKeyword(std::string_view word) {
+    static const std::unordered_set<std::string_view> types = {
+        "auto", "bool", "char", "char8_t", "char16_t", "char32_t", "double", "float", "int", "long",
+        "short", "signed", "unsigned", "void", "wchar_t"
+    };
+    return types.count(word) > 0;
+}
+
+bool isQualifierKeyword(std::string_view word) {
+    return word == "const" || word == "volatile" || word == "noexcept" || word == "override" || word == "final" ||
+           word == "mutable";
+}
+
+/**
+ * Finds definitions in the tokens of one file. Braces are tracked as a stack
+ * of namespace, type and body scopes; bodies are skipped, and in the other
+ * scopes a name is recorded when the tokens around it have the shape of a
+ * namespace, type, alias or function declaration. This is a heuristic, not
+ * a parser, so macros that look like declarations may be recorded too.
+ */
+class DefinitionScanner {
+public:
+    DefinitionScanner(const std::vector<Lexeme>& lexemes, const std::vector<std::string_view>& lines,
+                      const std::string& path, std::vector<Symbol>& symbols)
+        : lines(lines), path(path), symbols(symbols) {
+        // Preprocessor lines only contribute macro names
+        uint32_t directive_line = 0;
+        for (size_t i = 0; i < lexemes.size(); i++) {
+            const Lexeme& lexeme = lexemes[i];
+            if (lexeme.kind == TokenKind::Preprocessor) {
+                directive_line = lexeme.line;
+                bool define = lexeme.text.size() >= 6 && lexeme.text.substr(lexeme.text.size() - 6) == "define";
+                if (define && i + 1 < lexemes.size() && lexemes[i + 1].line == lexeme.line &&
+                    lexemes[i + 1].kind == TokenKind::Identifier) {
+                    add(lexemes[i + 1], SymbolKind::Macro);
+                }
+            } else if (lexeme.kind != TokenKind::Comment && lexeme.line != directive_line) {
+                code.push_back(lexeme);
+            }
+        }
+    }
+    
+    void scan() {
+        for (size_t i = 0; i < code.size(); i++) {
+            const Lexeme& token = code[i];
+            if (token.kind == TokenKind::Punctuation) {
+                if (token.text == "{") {
+                    scopes.push_back(pending);
+                    pending = Scope::Body;
+                } else if (token.text == "}") {
+                    if (!scopes.empty()) {
+                        scopes.pop_back();
+                    }
+                    pending = Scope::Body;
+                } else if (token.text == ";") {
+                    pending = Scope::Body;
+                }
+                continue;
+            }
+            Scope scope = scopes.empty() ? Scope::Outer : scopes.back();
+            if (scope == Scope::Body) {
+                continue;
+            }
+            if (token.kind == TokenKind::Keyword) {
+                i = keyword(i);
+            } else if (token.kind == TokenKind::Identifier && punctuation(i + 1, "(")) {
+                i = function(i, scope);
+            }
+        }
+    }
+
+private:
+    enum class Scope : uint8_t { Outer, Type, Body };
+    
+    bool punctuation(size_t i, std::string_view text) const {
+        return i < code.size() && code[i].kind == TokenKind::Punctuation && code[i].text == text;
+    }
+    
+    bool identifier(size_t i) const {
+        return i < code.size() && code[i].kind == TokenKind::Identifier;
+    }
+    
+    bool keywordAt(size_t i, std::string_view text) const {
+        return i < code.size() && code[i].kind == TokenKind::Keyword && code[i].text == text;
+    }
+    
+    void add(const Lexeme& name, SymbolKind kind) {
+        Symbol symbol;
+        symbol.name = std::string(name.text);
+        symbol.kind = kind;
+        symbol.path = path;
+        symbol.line = name.line;
+        symbol.column = name.column;
+        symbol.signature = std::string(trim(lines[name.line - 1]).substr(0, kMaxSignatureLength));
+        symbols.push_back(std::move(symbol));
+    }
+    
+    // Index of the bracket closing the one at open, or code.size()
+    size_t closing(size_t open) const {
+        std::string_view opener = code[open].text;
+        std::string_view closer = opener == "(" ? ")" : opener == "{" ? "}" : "]";
+        int depth = 0;
+        for (size_t i = open; i < code.size(); i++) {
+            if (punctuation(i, opener)) {
+                depth++;
+            } else if (punctuation(i, closer) && --depth == 0) {
+                return i;
+            }
+        }
+        return code.size();
+    }
+    
+    // Handles a keyword at i and returns the index the scan continues after
+    size_t keyword(size_t i) {
+        std::string_view word = code[i].text;
+        if (word == "namespace") {
+            size_t j = i + 1;
+            size_t name = 0;
+            while (identifier(j)) {
+                name = j++;
+                if (!punctuation(j, ":") || !punctuation(j + 1, ":")) {
+                    break;
+                }
+                j += 2;
+            }
+            if (punctuation(j, "{")) {
+                if (name != 0) {
+                    add(code[name], SymbolKind::Namespace);
+                }
+                pending = Scope::Outer;
+                return j - 1;
+            }
+            return i;
+        }
+        if (word == "extern" && i + 2 < code.size() && code[i + 1].kind == TokenKind::String &&
+            punctuation(i + 2, "{")) {
+            pending = Scope::Outer;
+            return i + 1;
+        }
+        if (word == "class" || word == "struct" || word == "union" || word == "enum") {
+            size_t j = i + 1;
+            if (word == "enum" && (keywordAt(j, "class") || keywordAt(j, "struct"))) {
+                j++;
+            }
+            size_t name = code.size();
+            while (identifier(j)) {
+                name = j++;
+                if (!punctuation(j, ":") || !punctuation(j + 1, ":") || !identifier(j + 2)) {
+                    break;
+                }
+                j += 2;
+            }
+            // A definition continues with its body, a base list, final or template arguments
+            bool defines = punctuation(j, "{") ||
+                (name != code.size() && (punctuation(j, ":") || punctuation(j, "<") || keywordAt(j, "final")));
+            if (!defines) {
+                return i;
+            }
+            if (name != code.size()) {
+                add(code[name], word == "enum" ? SymbolKind::Enum : SymbolKind::Class);
+            }
+            pending = Scope::Type;
+            return j - 1;
+        }
+        if (word == "using" && identifier(i + 1) && punctuation(i + 2, "=")) {
+            add(code[i + 1], SymbolKind::Alias);
+            return i + 2;
+        }
+        if (word == "typedef") {
+            // The alias is the last name before the semicolon, or the one in (*name) for function pointers
+            size_t name = code.size();
+            for (size_t j = i + 1; j < code.size() && j < i + kMaxStatementTokens; j++) {
+                if (punctuation(j, "{")) {
+                    return i;
+                }
+                if (punctuation(j, ";")) {
+                    break;
+                }
+                if (identifier(j) && (punctuation(j - 1, "*") && punctuation(j - 2, "("))) {
+                    name = j;
+                    break;
+                }
+                if (identifier(j)) {
+                    name = j;
+                }
+            }
+            if (name != code.size()) {
+                add(code[name], SymbolKind::Alias);
+            }
+            return i;
+        }
+        return i;
+    }
+    
+    // Handles a name followed by ( and returns the index the scan continues after
+    size_t function(size_t i, Scope scope) {
+        // What comes before must be a return type, a qualifier, or a statement start inside a class
+        bool after_type = i > 0 && (code[i - 1].kind == TokenKind::Identifier ||
+            (code[i - 1].kind == TokenKind::Keyword && isTypeKeyword(code[i - 1].text)) ||
+            punctuation(i - 1, ">") || punctuation(i - 1, "*") || punctuation(i - 1, "&") ||
+            punctuation(i - 1, "~") || (punctuation(i - 1, ":") && punctuation(i - 2, ":")));
+        bool member_start = scope == Scope::Type && (i == 0 || punctuation(i - 1, ";") || punctuation(i - 1, "{") ||
+            punctuation(i - 1, "}") || punctuation(i - 1, ":"));
+        if (!after_type && !member_start) {
+            return i;
+        }
+        
+        size_t k = closing(i + 1) + 1;
+        // Qualifiers, noexcept(...), reference qualifiers and a trailing return type
+        while (k < code.size()) {
+            if (code[k].kind == TokenKind::Keyword && isQualifierKeyword(code[k].text)) {
+                k = punctuation(k + 1, "(") ? closing(k + 1) + 1 : k + 1;
+            } else if (punctuation(k, "&")) {
+                k++;
+            } else if (punctuation(k, "-") && punctuation(k + 1, ">")) {
+                size_t limit = k + kMaxStatementTokens;
+                while (k < code.size() && k < limit && !punctuation(k, "{") && !punctuation(k, ";") &&
+                       !punctuation(k, "=")) {
+                    k++;
+                }
+            } else {
+                break;
+            }
+        }
+        
+        if (punctuation(k, "{") || punctuation(k, ";") || punctuation(k, "=")) {
+            add(code[i], SymbolKind::Function);
+            return k - 1;
+        }
+        if (punctuation(k, ":") && !punctuation(k + 1, ":")) {
+            // Constructor initializers: name(...) or name{...} groups up to the body
+            for (size_t j = k + 1; j < code.size() && j < k + kMaxStatementTokens; j++) {
+                bool group = punctuation(j, "(") || punctuation(j, "{");
+                if (group && (punctuation(j - 1, ")") || punctuation(j - 1, "}")) && punctuation(j, "{")) {
+                    add(code[i], SymbolKind::Function);
+                    return j - 1;
+                }
+                if (group) {
+                    j = closing(j);
+                } else if (punctuation(j, ";")) {
+                    break;
+                }
+            }
+        }
+        return i;
+    }
+    
+    const std::vector<std::string_view>& lines;
+    const std::string& path;
+    std::vector<Symbol>& symbols;
+    std::vector<Lexeme> code;
+    std::vector<Scope> scopes;
+    Scope pending = Scope::Body; // What the next { opens
+};
+
+std::string kindName(SymbolKind kind) {
+    return std::to_string(static_cast<int>(kind));
+}
+
+} // namespace
+
+SymbolIndex::SymbolIndex(const Options& options) : options(options) {}
+
+size_t SymbolIndex::indexDirectory(const std::string& root, const Progress& progress) {
+    std::string base = normalPath(root);
+    std::vector<std::string> listed;
+    std::error_code error;
+    std::error_code ignored;
+    for (fs::recursive_directory_iterator it(base, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        if (it->is_directory(ignored)) {
+            if (skippedDirectory(it->path().filename().string())) {
+                it.disable_recursion_pending();
+            }
+        } else if (it->is_regular_file(ignored) && wanted(it->path().string())) {
+            listed.push_back(normalPath(it->path().string()));
+        }
+    }
+    
+    // Only files whose size or modification time differ from the index are read again
+    std::vector<std::string> changed;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& path : listed) {
+            auto found = files.find(path);
+            if (found == files.end() || found->second.size != fs::file_size(path, ignored) ||
+                found->second.modified != modifiedTime(path, ignored)) {
+                changed.push_back(path);
+            }
+        }
+    }
+    
+    std::vector<FileEntry> entries(changed.size());
+    std::vector<char> parsed(changed.size(), 0);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::atomic<bool> cancelled{false};
+    auto work = [&]() {
+        for (size_t k = next++; k < changed.size() && !cancelled; k = next++) {
+            parsed[k] = parseFile(changed[k], entries[k]);
+            done++;
+        }
+    };
+    size_t thread_count = options.threads > 0 ? static_cast<size_t>(options.threads)
+                                              : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < std::min(thread_count, changed.size()); t++) {
+        workers.emplace_back(work);
+    }
+    // The calling thread parses too and is the one that reports progress
+    for (size_t k = next++; k < changed.size() && !cancelled; k = next++) {
+        parsed[k] = parseFile(changed[k], entries[k]);
+        done++;
+        if (progress && !progress(static_cast<double>(done) / changed.size())) {
+            cancelled = true;
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    size_t count = 0;
+    for (size_t k = 0; k < changed.size(); k++) {
+        if (parsed[k]) {
+            replaceLocked(changed[k], &entries[k]);
+            count++;
+        }
+    }
+    if (!cancelled) {
+        // Drop files under root that were deleted or no longer match
+        std::unordered_set<std::string> present(listed.begin(), listed.end());
+        std::string prefix = (fs::path(base) / "").string();
+        std::vector<std::string> gone;
+        for (auto it = files.lower_bound(prefix); it != files.end() && it->first.rfind(prefix, 0) == 0; ++it) {
+            if (!present.count(it->first)) {
+                gone.push_back(it->first);
+            }
+        }
+        for (const auto& path : gone) {
+            replaceLocked(path, nullptr);
+        }
+    }
+    return count;
+}
+
+size_t SymbolIndex::updateDirectory(const std::string& directory) {
+    std::string base = normalPath(directory);
+    std::vector<std::string> listed;
+    std::error_code error;
+    std::error_code ignored;
+    for (fs::directory_iterator it(base, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(ignored) && wanted(it->path().string())) {
+            listed.push_back(normalPath(it->path().string()));
+        }
+    }
+    
+    std::vector<std::string> changed;
+    std::vector<std::string> gone;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& path : listed) {
+            auto found = files.find(path);
+            if (found == files.end() || found->second.size != fs::file_size(path, ignored) ||
+                found->second.modified != modifiedTime(path, ignored)) {
+                changed.push_back(path);
+            }
+        }
+        std::string prefix = (fs::path(base) / "").string();
+        for (auto it = files.lower_bound(prefix); it != files.end() && it->first.rfind(prefix, 0) == 0; ++it) {
+            if (fs::path(it->first).parent_path() == fs::path(base) &&
+                std::find(listed.begin(), listed.end(), it->first) == listed.end()) {
+                gone.push_back(it->first);
+            }
+        }
+    }
+    
+    std::vector<FileEntry> entries(changed.size());
+    std::vector<char> parsed(changed.size(), 0);
+    for (size_t k = 0; k < changed.size(); k++) {
+        parsed[k] = parseFile(changed[k], entries[k]);
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    size_t count = 0;
+    for (size_t k = 0; k < changed.size(); k++) {
+        if (parsed[k]) {
+            replaceLocked(changed[k], &entries[k]);
+            count++;
+        }
+    }
+    for (const auto& path : gone) {
+        replaceLocked(path, nullptr);
+    }
+    return count;
+}
+
+void SymbolIndex::updateFile(const std::string& file) {
+    std::string path = normalPath(file);
+    if (!wanted(path)) {
+        return;
+    }
+    FileEntry entry;
+    std::error_code ignored;
+    bool parsed = fs::is_regular_file(path, ignored) && parseFile(path, entry);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    replaceLocked(path, parsed ? &entry : nullptr);
+}
+
+std::vector<std::string> SymbolIndex::complete(std::string_view prefix, size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::pair<uint32_t, const std::string*>> found;
+    for (auto it = words.lower_bound(prefix); it != words.end() && found.size() < kMaxCompletionCandidates; ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        if (it->first.size() > prefix.size()) {
+            found.emplace_back(it->second, &it->first);
+        }
+    }
+    
+    size_t count = std::min(limit, found.size());
+    std::partial_sort(found.begin(), found.begin() + count, found.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : *a.second < *b.second;
+    });
+    std::vector<std::string> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        result.push_back(*found[i].second);
+    }
+    return result;
+}
+
+std::vector<Symbol> SymbolIndex::definitions(std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto found = symbols.find(std::string(name));
+    return found != symbols.end() ? found->second : std::vector<Symbol>();
+}
+
+std::vector<Symbol> SymbolIndex::relatedSymbols(std::string_view text, size_t limit) const {
+    std::vector<Lexeme> lexemes;
+    lexText(text, lexemes, nullptr);
+    
+    // Later mentions are closer to the cursor and count up to three times as much
+    std::unordered_map<std::string_view, double> weights;
+    for (size_t i = 0; i < lexemes.size(); i++) {
+        if (lexemes[i].kind == TokenKind::Identifier) {
+            weights[lexemes[i].text] += 1.0 + 2.0 * static_cast<double>(i) / lexemes.size();
+        }
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::pair<double, const Symbol*>> ranked;
+    for (const auto& [name, weight] : weights) {
+        auto found = symbols.find(std::string(name));
+        if (found == symbols.end()) {
+            continue;
+        }
+        // A type's definition says more than its constructors, so the lowest kind wins
+        const Symbol* best = nullptr;
+        for (const auto& symbol : found->second) {
+            if (symbol.kind != SymbolKind::Namespace && (!best || symbol.kind < best->kind)) {
+                best = &symbol;
+            }
+        }
+        if (best) {
+            ranked.emplace_back(weight, best);
+        }
+    }
+    size_t count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second->name < b.second->name;
+    });
+    std::vector<Symbol> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        result.push_back(*ranked[i].second);
+    }
+    return result;
+}
+
+std::vector<std::string> SymbolIndex::directories() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> result;
+    for (const auto& [path, entry] : files) {
+        std::string directory = fs::path(path).parent_path().string();
+        if (result.empty() || result.back() != directory) {
+            result.push_back(directory);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+size_t SymbolIndex::fileCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return files.size();
+}
+
+size_t SymbolIndex::symbolCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return symbol_total;
+}
+
+bool SymbolIndex::save(const std::string& path) const {
+    std::error_code ignored;
+    fs::create_directories(fs::path(path).parent_path(), ignored);
+    std::string partial = path + ".part";
+    {
+        std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        out << kIndexHeader << '\n';
+        for (const auto& [file, entry] : files) {
+            out << "file\t" << entry.modified << '\t' << entry.size << '\t' << file << '\n';
+            out << "words\t";
+            for (size_t i = 0; i < entry.words.size(); i++) {
+                out << (i > 0 ? " " : "") << entry.words[i];
+            }
+            out << '\n';
+            for (const auto& symbol : entry.symbols) {
+                std::string signature = symbol.signature;
+                std::replace(signature.begin(), signature.end(), '\t', ' ');
+                out << "symbol\t" << kindName(symbol.kind) << '\t' << symbol.line << '\t' << symbol.column << '\t'
+                    << symbol.name << '\t' << signature << '\n';
+            }
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(partial, path, error);
+    return !error;
+}
+
+bool SymbolIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kIndexHeader) {
+        return false;
+    }
+    
+    std::vector<std::pair<std::string, FileEntry>> loaded;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string type;
+        std::getline(fields, type, '\t');
+        if (type == "file") {
+            FileEntry entry;
+            std::string file;
+            fields >> entry.modified >> entry.size;
+            fields.ignore(1);
+            std::getline(fields, file);
+            loaded.emplace_back(file, std::move(entry));
+        } else if (type == "words" && !loaded.empty()) {
+            std::string word;
+            while (fields >> word) {
+                loaded.back().second.words.push_back(word);
+            }
+        } else if (type == "symbol" && !loaded.empty()) {
+            Symbol symbol;
+            int kind = 0;
+            fields >> kind >> symbol.line >> symbol.column;
+            fields.ignore(1);
+            std::getline(fields, symbol.name, '\t');
+            std::getline(fields, symbol.signature);
+            if (kind < 0 || kind > static_cast<int>(SymbolKind::Macro) || symbol.name.empty()) {
+                return false;
+            }
+            symbol.kind = static_cast<SymbolKind>(kind);
+            symbol.path = loaded.back().first;
+            loaded.back().second.symbols.push_back(std::move(symbol));
+        } else if (!line.empty()) {
+            return false;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    files.clear();
+    words.clear();
+    symbols.clear();
+    symbol_total = 0;
+    for (auto& [file, entry] : loaded) {
+        replaceLocked(file, &entry);
+    }
+    return true;
+}
+
+std::string SymbolIndex::cachePath(const std::string& root) {
+    std::error_code ignored;
+    std::string absolute = normalPath(fs::absolute(root, ignored).string());
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(absolute) << ".idx";
+    return (fs::path(utils::Platform::getAppDataPath()) / "code-index" / name.str()).string();
+}
+
+bool SymbolIndex::wanted(const std::string& path) const {
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(options.extensions.begin(), options.extensions.end(), extension) != options.extensions.end();
+}
+
+bool SymbolIndex::parseFile(const std::string& path, FileEntry& entry) const {
+    std::error_code error;
+    entry.size = fs::file_size(path, error);
+    if (error || entry.size > options.max_file_bytes) {
+        return false;
+    }
+    entry.modified = modifiedTime(path, error);
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string text(static_cast<size_t>(entry.size), '\0');
+    in.read(text.data(), static_cast<std::streamsize>(text.size()));
+    text.resize(static_cast<size_t>(in.gcount()));
+    
+    std::vector<Lexeme> lexemes;
+    std::vector<std::string_view> lines;
+    lexText(text, lexemes, &lines);
+    
+    std::unordered_set<std::string_view> unique;
+    for (const auto& lexeme : lexemes) {
+        if (lexeme.kind == TokenKind::Identifier && lexeme.text.size() >= kMinWordLength &&
+            lexeme.text.size() <= kMaxWordLength && unique.insert(lexeme.text).second) {
+            entry.words.emplace_back(lexeme.text);
+        }
+    }
+    std::sort(entry.words.begin(), entry.words.end());
+    
+    entry.symbols.clear();
+    DefinitionScanner scanner(lexemes, lines, path, entry.symbols);
+    scanner.scan();
+    return true;
+}
+
+void SymbolIndex::replaceLocked(const std::string& path, FileEntry* entry) {
+    auto old = files.find(path);
+    if (old != files.end()) {
+        for (const auto& word : old->second.words) {
+            auto found = words.find(word);
+            if (found != words.end() && --found->second == 0) {
+                words.erase(found);
+            }
+        }
+        for (const auto& symbol : old->second.symbols) {
+            auto found = symbols.find(symbol.name);
+            if (found == symbols.end()) {
+                continue;
+            }
+            auto& list = found->second;
+            list.erase(std::remove_if(list.begin(), list.end(), [&](const Symbol& s) { return s.path == path; }),
+                       list.end());
+            if (list.empty()) {
+                symbols.erase(found);
+            }
+        }
+        symbol_total -= old->second.symbols.size();
+        files.erase(old);
+    }
+    if (!entry) {
+        return;
+    }
+    
+    for (const auto& word : entry->words) {
+        words[word]++;
+    }
+    for (const auto& symbol : entry->symbols) {
+        symbols[symbol.name].push_back(symbol);
+    }
+    symbol_total += entry->symbols.size();
+    files.emplace(path, std::move(*entry));
+}
+
+} // namespace xeno::code
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xeno::code {
+
+enum class SymbolKind : uint8_t {
+    Namespace,
+    Class,
+    Enum,
+    Alias,
+    Function,
+    Macro
+};
+
+struct Symbol {
+    std::string name;
+    SymbolKind kind = SymbolKind::Function;
+    std::string path;
+    uint32_t line = 0;          // 1-based
+    uint32_t column = 0;        // 1-based, in bytes
+    std::string signature;      // The trimmed source line, for prompts
+};
+
+/**
+ * @brief Identifiers and definitions of every C and C++ file under a project
+ *
+ * Files are lexed with CppLexer on parallel threads. Each file contributes
+ * its identifiers to an ordered word table, counted by the number of files
+ * that use them, so completion is a lower_bound on the prefix. A light
+ * scope-aware pass over the tokens records where namespaces, types,
+ * aliases, functions and macros are defined.
+ *
+ * Files are replaced whole, so updating one after a save costs one lex of
+ * that file. The index saves to disk with each file's size and modification
+ * time, and indexing a project after load only reads files that changed.
+ * All methods are thread-safe; readers share a lock that writers only take
+ * to swap in finished results.
+ */
+class SymbolIndex {
+public:
+    struct Options {
+        std::vector<std::string> extensions = {".h", ".hh", ".hpp", ".hxx", ".inl", ".ipp",
+                                               ".c", ".cc", ".cpp", ".cxx"};
+        uintmax_t max_file_bytes = 2 * 1024 * 1024; // Larger files are usually generated data
+        int threads = 0;                             // 0 uses one per core
+    };
+    
+    // Receives the fraction of files read; returning false cancels
+    using Progress = std::function<bool(double fraction)>;
+    
+    explicit SymbolIndex(const Options& options);
+    
+    // Brings every matching file under root up to date and drops indexed files that are
+    // gone from it. Returns the number of files read; unchanged files are skipped.
+    size_t indexDirectory(const std::string& root, const Progress& progress = nullptr);
+    // Re-reads the matching files directly in directory and drops the ones deleted from it
+    size_t updateDirectory(const std::string& directory);
+    // Re-reads one file, or drops it if it no longer exists
+    void updateFile(const std::string& path);
+    
+    // Identifiers starting with prefix, those used in the most files first
+    std::vector<std::string> complete(std::string_view prefix, size_t limit) const;
+    std::vector<Symbol> definitions(std::string_view name) const;
+    // Definitions of the identifiers used in text, weighting those near its end, for AI prompts
+    std::vector<Symbol> relatedSymbols(std::string_view text, size_t limit) const;
+    // Directories holding indexed files, to watch for changes
+    std::vector<std::string> directories() const;
+    
+    size_t fileCount() const;
+    size_t symbolCount() const;
+    
+    bool save(const std::string& path) const;
+    // Replaces the index with a saved one; false if the file is missing or not an index
+    bool load(const std::string& path);
+    // Where the index of a project root is kept between sessions
+    static std::string cachePath(const std::string& root);
+
+private:
+    struct FileEntry {
+        int64_t modified = 0;
+        uintmax_t size = 0;
+        std::vector<std::string> words;  // Unique identifiers in the file
+        std::vector<Symbol> symbols;
+    };
+    
+    bool wanted(const std::string& path) const;
+    // Lexes one file; false if it cannot be read or is too large
+    bool parseFile(const std::string& path, FileEntry& entry) const;
+    // Replaces or, with entry null, removes a file; the caller holds the write lock
+    void replaceLocked(const std::string& path, FileEntry* entry);
+    
+    Options options;
+    mutable std::shared_mutex mutex;
+    std::map<std::string, FileEntry> files;
+    std::map<std::string, uint32_t, std::less<>> words;            // Identifier to number of files using it
+    std::unordered_map<std::string, std::vector<Symbol>> symbols;  // Name to definitions
+    size_t symbol_total = 0;
+};
+
+} // namespace xeno::code
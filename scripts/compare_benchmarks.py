@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Compare two Google Benchmark JSON files and fail when a benchmark got slower.
+
+Usage: compare_benchmarks.py BASELINE CURRENT [--threshold 0.10] [--metric real_time]
+
+Both files come from xeno-benchmarks --benchmark_out_format=json (the
+run-benchmarks target). With repetitions, the median of each benchmark is
+compared; otherwise the mean of its runs. A benchmark fails when it takes more
+than threshold longer than in the baseline. Benchmarks that were skipped, or
+that exist in only one file, are listed but do not fail the check, so adding a
+benchmark or building without an optional pipeline does not break CI.
+"""
+
+import argparse
+import json
+import sys
+
+NANOSECONDS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    """Returns ({benchmark: nanoseconds}, {benchmark: error}, context) for one results file."""
+    with open(path, encoding="utf-8") as results_file:
+        results = json.load(results_file)
+
+    medians = {}
+    runs = {}
+    errors = {}
+    for entry in results.get("benchmarks", []):
+        name = entry.get("run_name", entry["name"])
+        if entry.get("error_occurred"):
+            errors[name] = entry.get("error_message", "skipped")
+            continue
+        value = entry[metric] * NANOSECONDS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            runs.setdefault(name, []).append(value)
+
+    times = {name: sum(values) / len(values) for name, values in runs.items()}
+    times.update(medians)
+    return times, errors, results.get("context", {})
+
+
+def describe(nanoseconds):
+    for unit in ("s", "ms", "us"):
+        if nanoseconds >= NANOSECONDS[unit]:
+            return f"{nanoseconds / NANOSECONDS[unit]:.3g} {unit}"
+    return f"{nanoseconds:.3g} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="results from a known-good build")
+    parser.add_argument("current", help="results to check")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="slowdown that counts as a regression (default 0.10 = 10%%)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time")
+    args = parser.parse_args()
+
+    baseline, _, baseline_context = load(args.baseline, args.metric)
+    current, errors, current_context = load(args.current, args.metric)
+
+    # Timings only compare between like builds on like machines
+    for key in ("library_build_type", "num_cpus"):
+        if key in baseline_context and baseline_context.get(key) != current_context.get(key):
+            print(f"warning: {key} differs: baseline {baseline_context.get(key)}, "
+                  f"current {current_context.get(key)}")
+    if current_context.get("library_build_type") == "debug":
+        print("warning: Google Benchmark was built in debug mode; timings may be unreliable")
+
+    regressions = []
+    width = max((len(name) for name in baseline), default=0)
+    for name in sorted(baseline):
+        if name in errors:
+            print(f"{name:<{width}}  skipped: {errors[name]}")
+            continue
+        if name not in current:
+            print(f"{name:<{width}}  missing from current results")
+            continue
+        change = current[name] / baseline[name] - 1.0
+        verdict = "REGRESSION" if change > args.threshold else "ok"
+        print(f"{name:<{width}}  {describe(baseline[name]):>10} -> {describe(current[name]):>10}"
+              f"  {change:+7.1%}  {verdict}")
+        if change > args.threshold:
+            regressions.append(name)
+    for name in sorted(set(current) - set(baseline)):
+        print(f"{name}  new, not in baseline")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) more than {args.threshold:.0%} slower than the baseline")
+        return 1
+    print(f"\nNo benchmark more than {args.threshold:.0%} slower than the baseline")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
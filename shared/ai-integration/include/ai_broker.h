@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ai_integration.h"
+#include <memory>
+#include <string>
+
+namespace xeno::ai {
+
+/**
+ * @brief Serves one AIIntegration to the other suite apps on this machine
+ *
+ * The launcher hosts the broker; apps that reach it with
+ * AIIntegration::connectToBroker() run their requests through the launcher's
+ * connection pools, response cache, router and credit wallet instead of
+ * keeping their own. Control messages travel over a Unix-domain socket and
+ * large payloads through shared memory. Requests run on the served
+ * integration's worker pool, and a client that disconnects has its requests
+ * cancelled. The served AIIntegration must outlive the broker.
+ */
+class AIBroker {
+public:
+    // Set by the launcher for the apps it starts, so they find the broker without looking
+    static constexpr const char* kAddressVariable = "XENO_AI_BROKER";
+    
+    explicit AIBroker(AIIntegration& ai);
+    ~AIBroker();
+    
+    AIBroker(const AIBroker&) = delete;
+    AIBroker& operator=(const AIBroker&) = delete;
+    
+    // Starts serving at address, a socket path; false with errorMessage() set if it cannot listen,
+    // or if another broker already serves it
+    bool start(const std::string& address = defaultAddress());
+    // Closes every connection and waits for the broker's threads; requests in flight are cancelled
+    void stop();
+    
+    bool isRunning() const;
+    const std::string& address() const;
+    size_t clientCount() const;
+    const std::string& errorMessage() const;
+    
+    // $XENO_AI_BROKER when set, else ai-broker.sock in the app data folder
+    static std::string defaultAddress();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace xeno::ai
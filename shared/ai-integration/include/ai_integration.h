@@ -4,10 +4,39 @@
 #include <map>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace xeno::ai {
 
+/**
+ * @brief Cooperative cancellation flag shared between a caller and an in-flight AI request
+ *
+ * Cancelling never interrupts a request mid-write; the worker checks the token
+ * at safe points and completes the request with a "cancelled" response.
+ */
+class CancellationToken {
+public:
+    void cancel();
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    
+    // Registers a hook that aborts blocking I/O (e.g. a pending HTTP read) on cancel;
+    // runs immediately if the token is already cancelled
+    void setCancelHandler(std::function<void()> handler);
+    // Once this returns the handler is guaranteed not to be running
+    void clearCancelHandler();
+
+private:
+    std::atomic<bool> cancelled{false};
+    std::mutex handler_mutex;
+    std::function<void()> cancel_handler;
+};
+
 /**
  * @brief AI Integration class for managing API calls to various AI services
  * 
@@ -22,74 +51,332 @@ public:
         std::string endpoint;
         std::string api_key;
         std::map<std::string, std::string> headers;
+        std::string default_model;      // Used when AIRequest::model is empty
+        size_t max_connections = 4;     // Persistent keep-alive connections per provider
+        int idle_timeout_seconds = 60;  // Idle connections are closed after this long
+        int timeout_seconds = 30;       // Read/write timeout per request
+        // Ollama only: how long the model stays loaded after a request, as a duration ("30m")
+        // or seconds ("-1" keeps it loaded). Empty leaves Ollama's default of five minutes.
+        std::string keep_alive;
     };
-
+    
     struct AIRequest {
         std::string prompt;
         std::string model;
         std::map<std::string, nlohmann::json> parameters;
         std::string operation_type; // e.g., "generative_fill", "code_completion"
+        bool cacheable = true;      // Set false for non-deterministic calls to bypass the response cache
     };
-
+    
     struct AIResponse {
-        bool success;
+        bool success = false;
         std::string content;
-        int credits_used;
+        int credits_used = 0;
         std::string error_message;
-        nlohmann::json metadata;
+        nlohmann::json metadata = nlohmann::json::object();
     };
-
+    
+    /**
+     * @brief Response cache settings
+     *
+     * Repeating a request with the same provider, model, prompt, parameters
+     * and operation type is answered from the cache, with no network call and
+     * no credit charge. Hits report metadata["cache"] = "memory" or "disk".
+     */
+    struct CacheConfig {
+        bool enabled = true;
+        size_t memory_entries = 256;
+        std::string directory;                   // On-disk tier; defaults to <app data>/cache/ai
+        uint64_t disk_bytes = 256 * 1024 * 1024; // Past this the least recently used files go
+        std::map<std::string, int> ttl_seconds;  // Per operation, e.g. {"image_generation", 86400}
+    };
+    
+    /**
+     * @brief Source and result files for an audio or video job on Xeno Cloud
+     *
+     * The source is uploaded in chunks read straight from disk, several at a
+     * time, and the result is streamed to result_path, so memory use does not
+     * grow with file size. Responses report metadata["transfer_id"]; passing it
+     * back after a failed upload resends only the chunks the server is missing.
+     */
+    struct MediaFiles {
+        std::string source_path;
+        std::string result_path;               // Empty keeps the result in AIResponse::content
+        std::string transfer_id;               // Resumes an earlier upload of the same source
+        size_t chunk_size = 8 * 1024 * 1024;
+        size_t parallel_chunks = 4;            // Also bounded by APIConfig::max_connections
+    };
+    
     enum class AIProvider {
         XenoCloud,
         OpenRouter,
-        Ollama
+        Ollama,
+        Auto        // Chosen per request by the RoutingPolicy
     };
-
+    
+    /**
+     * @brief How requests sent to AIProvider::Auto pick their provider
+     *
+     * Candidates are the configured providers that serve the operation, in
+     * preference order; by_operation overrides the order for an operation
+     * type. Xeno Cloud is left out when spending credits is off or would take
+     * the balance below min_credit_balance. Providers failing their health
+     * probe or more than max_error_rate of recent requests go last, and the
+     * rest trade places by p50 latency plus ms_per_credit for each credit.
+     *
+     * A failed request moves on to the next candidate, unless a stream had
+     * already delivered text. With hedge on, a request that is not streamed
+     * also goes to the runner-up once the first provider passes its p95; the
+     * first answer wins and the other request is cancelled, and so not
+     * charged, unless it had already finished.
+     */
+    struct RoutingPolicy {
+        std::vector<AIProvider> preference = {AIProvider::XenoCloud, AIProvider::OpenRouter, AIProvider::Ollama};
+        std::map<std::string, std::vector<AIProvider>> by_operation; // Keyed by AIRequest::operation_type
+        bool spend_credits = true;
+        int min_credit_balance = 0;
+        double ms_per_credit = 0;           // Latency one credit is worth; 0 ranks on latency alone
+        double max_error_rate = 0.5;
+        size_t min_samples = 5;             // Requests seen before latency or errors move a provider
+        bool hedge = false;
+        size_t min_hedge_samples = 20;      // Successes needed for a p95 worth hedging on
+        int health_interval_seconds = 30;   // Between background probes; 0 turns them off
+    };
+    
+    /**
+     * @brief Recent behaviour of one provider on one operation
+     *
+     * Latencies cover the latest successful requests, the error rate the
+     * requests of the last few minutes.
+     */
+    struct ProviderStats {
+        double p50_ms = 0;
+        double p95_ms = 0;
+        double p99_ms = 0;
+        double error_rate = 0;
+        size_t samples = 0;     // Successes the percentiles are taken over
+        size_t requests = 0;    // Requests the error rate is taken over
+        bool healthy = true;    // Last health probe succeeded, or none has run yet
+    };
+    
+    /**
+     * @brief Invoked once an asynchronous request finishes, on a worker thread
+     */
+    using CompletionCallback = std::function<void(const AIResponse&)>;
+    
+    /**
+     * @brief Receives generated text incrementally from a streaming request
+     *
+     * Called on the thread running the request, once per token batch as the
+     * provider sends it. Return false to stop the generation early.
+     */
+    using StreamCallback = std::function<bool(const std::string& chunk)>;
+    
+    /**
+     * @brief Reports bytes moved for the upload and then for the result download
+     *
+     * Called on the thread running the request; total is 0 when the server did
+     * not announce a size. Return false to cancel the transfer.
+     */
+    using TransferProgress = std::function<bool(uint64_t done, uint64_t total)>;
+    
+    /**
+     * @brief Invoked once an asynchronous batch finishes, with one response per request in order
+     */
+    using BatchCallback = std::function<void(const std::vector<AIResponse>&)>;
+    
+    /**
+     * @brief Handle to an asynchronous AI request
+     *
+     * Copies share the same request; cancelling any copy cancels it. A
+     * cancelled request still completes, with success = false and
+     * metadata["cancelled"] = true, and is never charged.
+     */
+    struct AITask {
+        std::shared_future<AIResponse> result;
+        std::shared_ptr<CancellationToken> token;
+        
+        void cancel() const;
+        bool isReady() const;
+        AIResponse get() const;
+    };
+    
     AIIntegration();
     ~AIIntegration();
-
+    
     // Configuration
     bool configure(AIProvider provider, const APIConfig& config);
+    void setRoutingPolicy(const RoutingPolicy& policy);
     bool loadConfigFromFile(const std::string& config_path);
-
+    void configureCache(const CacheConfig& config);
+    void clearCache();
+    
+    // Hands requests, credits and provider status to the AIBroker at address, so this instance shares
+    // the broker's connections, cache, router and wallet. Call it before loadConfigFromFile(): a config
+    // loaded while connected is only set up here if the broker goes away, and requests then run in this
+    // process. False when no broker answers; the instance then works on its own.
+    bool connectToBroker(const std::string& address);
+    bool isUsingBroker();
+    
     // Credit management (Xeno Labs integration)
     int getCreditBalance();
     bool deductCredits(int amount);
     bool validateCredits(int required_credits);
-
+    
     // AI operations
-    AIResponse generateImage(const AIRequest& request, AIProvider provider = AIProvider::XenoCloud);
-    AIResponse processVideo(const AIRequest& request, AIProvider provider = AIProvider::XenoCloud);
-    AIResponse processAudio(const AIRequest& request, AIProvider provider = AIProvider::XenoCloud);
-    AIResponse completeCode(const AIRequest& request, AIProvider provider = AIProvider::XenoCloud);
-    AIResponse chatCompletion(const AIRequest& request, AIProvider provider = AIProvider::XenoCloud);
-
+    AIResponse generateImage(const AIRequest& request, AIProvider provider = AIProvider::Auto);
+    AIResponse processVideo(const AIRequest& request, AIProvider provider = AIProvider::Auto);
+    AIResponse processAudio(const AIRequest& request, AIProvider provider = AIProvider::Auto);
+    AIResponse completeCode(const AIRequest& request, AIProvider provider = AIProvider::Auto);
+    AIResponse chatCompletion(const AIRequest& request, AIProvider provider = AIProvider::Auto);
+    
+    // Asynchronous AI operations, run on the shared worker pool. The task completes even if the work
+    // or on_complete throws; an exception from the work becomes a failed response.
+    AITask generateImageAsync(const AIRequest& request, AIProvider provider = AIProvider::Auto,
+                              CompletionCallback on_complete = nullptr);
+    AITask processVideoAsync(const AIRequest& request, AIProvider provider = AIProvider::Auto,
+                             CompletionCallback on_complete = nullptr);
+    AITask processAudioAsync(const AIRequest& request, AIProvider provider = AIProvider::Auto,
+                             CompletionCallback on_complete = nullptr);
+    AITask completeCodeAsync(const AIRequest& request, AIProvider provider = AIProvider::Auto,
+                             CompletionCallback on_complete = nullptr);
+    AITask chatCompletionAsync(const AIRequest& request, AIProvider provider = AIProvider::Auto,
+                               CompletionCallback on_complete = nullptr);
+    
+    // Media jobs on files; only Xeno Cloud accepts uploads, so Auto sends them there. Responses are never cached.
+    AIResponse processAudioFile(const AIRequest& request, const MediaFiles& files,
+                                TransferProgress progress = nullptr, AIProvider provider = AIProvider::Auto);
+    AIResponse processVideoFile(const AIRequest& request, const MediaFiles& files,
+                                TransferProgress progress = nullptr, AIProvider provider = AIProvider::Auto);
+    AITask processAudioFileAsync(const AIRequest& request, const MediaFiles& files, TransferProgress progress = nullptr,
+                                 AIProvider provider = AIProvider::Auto, CompletionCallback on_complete = nullptr);
+    AITask processVideoFileAsync(const AIRequest& request, const MediaFiles& files, TransferProgress progress = nullptr,
+                                 AIProvider provider = AIProvider::Auto, CompletionCallback on_complete = nullptr);
+    
+    // Streaming text operations; the returned AIResponse::content holds the full text
+    AIResponse completeCodeStream(const AIRequest& request, StreamCallback on_chunk,
+                                  AIProvider provider = AIProvider::Auto);
+    AIResponse chatCompletionStream(const AIRequest& request, StreamCallback on_chunk,
+                                    AIProvider provider = AIProvider::Auto);
+    AITask completeCodeStreamAsync(const AIRequest& request, StreamCallback on_chunk,
+                                   AIProvider provider = AIProvider::Auto,
+                                   CompletionCallback on_complete = nullptr);
+    AITask chatCompletionStreamAsync(const AIRequest& request, StreamCallback on_chunk,
+                                     AIProvider provider = AIProvider::Auto,
+                                     CompletionCallback on_complete = nullptr);
+    
+    // Independent code completions sent together; Xeno Cloud serves them in one round trip,
+    // other providers fall back to one request each. An async batch's task resolves to a summary
+    // (success when every item succeeded) and cancels the whole batch; on_complete gets the responses.
+    std::vector<AIResponse> completeCodeBatch(const std::vector<AIRequest>& requests,
+                                              AIProvider provider = AIProvider::Auto);
+    AITask completeCodeBatchAsync(const std::vector<AIRequest>& requests, AIProvider provider,
+                                  BatchCallback on_complete);
+    // Image generations sent together, e.g. one per file in a batch job
+    std::vector<AIResponse> generateImageBatch(const std::vector<AIRequest>& requests,
+                                               AIProvider provider = AIProvider::Auto);
+    AITask generateImageBatchAsync(const std::vector<AIRequest>& requests, AIProvider provider,
+                                   BatchCallback on_complete);
+    
     // Generic API call
     AIResponse makeAPICall(AIProvider provider, const std::string& endpoint, 
                           const nlohmann::json& payload);
-
-    // Health checks
+    AITask makeAPICallAsync(AIProvider provider, const std::string& endpoint,
+                            const nlohmann::json& payload, CompletionCallback on_complete = nullptr);
+    
+    // Loads the model into memory ahead of the first request, so it does not pay the load time;
+    // metadata["warmed"] says whether anything was loaded. Only Ollama has a model to load; other
+    // providers and demo mode succeed at once.
+    AIResponse warmUp(AIProvider provider, const std::string& model = "");
+    AITask warmUpAsync(AIProvider provider, const std::string& model = "", CompletionCallback on_complete = nullptr);
+    
+    // Health checks. A configured provider is available until a background probe fails to reach it,
+    // and Auto is available while any provider is.
     bool isProviderAvailable(AIProvider provider);
     std::string getProviderStatus(AIProvider provider);
+    // operation is an OperationSpec name such as "code_completion"
+    ProviderStats getProviderStats(AIProvider provider, const std::string& operation);
 
 private:
+    // Applies a config document; initial is false for reloads, which skip unchanged sections
+    // and the account
+    bool applyConfig(const nlohmann::json& document, const std::string& config_path, bool initial);
+    // Applies the document ConfigManager loaded from config_path and follows its reloads
+    bool applyLoadedConfig(const std::string& config_path);
+    
     class Impl;
     std::unique_ptr<Impl> pImpl;
 };
 
 /**
  * @brief Credit Wallet manager for Xeno Labs integration
+ *
+ * Thread-safe: the balance is a single atomic, so concurrent AI calls never
+ * serialize on the wallet. Operations reserve credits before they run and
+ * commit or refund afterwards. Committed deductions are pushed to Xeno Labs
+ * in batches by a background thread once server sync is started.
  */
 class CreditWallet {
 public:
+    struct SyncOptions {
+        std::string endpoint = "https://api.xenolabs.ai";
+        std::chrono::milliseconds interval{2000};         // Longest a deduction waits before it is sent
+        size_t max_batch_size = 64;                       // A full batch is sent without waiting for the interval
+        size_t max_queued = 4096;                         // Held in memory; the rest wait in the journal
+        std::chrono::milliseconds max_backoff{60000};     // Longest wait between retries while sends fail
+        std::chrono::milliseconds shutdown_timeout{1000}; // Longest stopSync() waits on a send before aborting it
+    };
+    
+    /**
+     * @brief Credits set aside for one operation
+     *
+     * Move-only. Credits not committed by the time the reservation is
+     * destroyed are refunded.
+     */
+    class Reservation {
+    public:
+        Reservation() = default;
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+        ~Reservation();
+        
+        // False when the balance could not cover the request
+        explicit operator bool() const { return wallet != nullptr; }
+        int amount() const { return credits; }
+        
+        void commit(const std::string& operation);
+        // Charges part of the reservation and refunds the rest
+        void commit(const std::string& operation, int charged);
+        void refund();
+    
+    private:
+        friend class CreditWallet;
+        Reservation(CreditWallet* wallet, int credits) : wallet(wallet), credits(credits) {}
+        
+        CreditWallet* wallet = nullptr;
+        int credits = 0;
+    };
+    
     CreditWallet();
     ~CreditWallet();
-
+    
+    // An empty token runs the wallet in anonymous demo mode (local balance, no sync)
     bool authenticate(const std::string& user_token);
+    // Local view including pending reservations; never waits on the network
     int getBalance();
     bool deductCredits(int amount, const std::string& operation);
     bool addCredits(int amount); // For testing/admin
     
+    Reservation reserveCredits(int amount);
+    
+    // Starts the background batcher; requires a non-empty user token
+    bool startSync(const SyncOptions& options);
+    // Sends what is queued first, but aborts a send still out after shutdown_timeout
+    void stopSync();
+    // Committed deductions not yet acknowledged by Xeno Labs, including any an earlier session left in
+    // the journal; startSync() sends those first
+    size_t pendingSyncCount();
+    
     struct Transaction {
         std::string id;
         std::string operation;
@@ -98,9 +385,24 @@ public:
         bool success;
     };
     
+    // Transactions kept in memory until a journal file is opened
+    static constexpr size_t kHistoryCapacity = 1024;
+    // Transactions kept by a journal file (24 bytes each)
+    static constexpr size_t kJournalCapacity = 256 * 1024;
+    
+    // Records transactions in a memory-mapped journal that survives restarts. Fails if
+    // the file is unusable or another process holds it; history then stays in memory.
+    bool openJournal(const std::string& path);
+    
+    // Queries return the newest matches, oldest first
     std::vector<Transaction> getTransactionHistory(int limit = 50);
+    std::vector<Transaction> getTransactionsBetween(std::chrono::system_clock::time_point from,
+                                                    std::chrono::system_clock::time_point to, int limit = 50);
+    std::vector<Transaction> getTransactionsForOperation(const std::string& operation, int limit = 50);
 
 private:
+    void settle(int reserved, int charged, const std::string& operation);
+    
     class Impl;
     std::unique_ptr<Impl> pImpl;
 };
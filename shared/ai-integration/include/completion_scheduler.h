@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ai_integration.h"
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace xeno::ai {
+
+/**
+ * @brief Rate-shapes interactive code completion requests in front of AIIntegration
+ *
+ * - Debounce: a request is only sent once its slot has been quiet for the debounce delay
+ * - Supersede: a newer request for the same slot (e.g. editor + cursor) replaces the older one,
+ *   cancelling it if it is already in flight
+ * - Single-flight: identical requests in flight at the same time share one network call
+ * - Batching: Xeno Cloud or Auto requests that become due together go out as one batch,
+ *   which Auto routes as a whole
+ *
+ * Superseded requests complete with success = false and metadata["superseded"] = true,
+ * on the thread that made the newer request. Other callbacks run on a worker thread.
+ * Destroying the scheduler drops outstanding requests without invoking their callbacks.
+ */
+class CompletionScheduler {
+public:
+    struct Options {
+        std::chrono::milliseconds debounce{150};
+        std::chrono::milliseconds batch_window{25}; // Requests due this close together share a batch
+        size_t max_batch_size = 8;
+    };
+    
+    struct Stats {
+        size_t requested = 0;
+        size_t superseded = 0;
+        size_t coalesced = 0;  // Answered by another identical request's call
+        size_t batched = 0;    // Sent as part of a multi-request batch
+        size_t provider_calls = 0;
+    };
+    
+    explicit CompletionScheduler(AIIntegration& ai_integration);
+    CompletionScheduler(AIIntegration& ai_integration, const Options& options);
+    ~CompletionScheduler();
+    
+    CompletionScheduler(const CompletionScheduler&) = delete;
+    CompletionScheduler& operator=(const CompletionScheduler&) = delete;
+    
+    void request(const std::string& slot, const AIIntegration::AIRequest& request,
+                 AIIntegration::AIProvider provider, AIIntegration::CompletionCallback on_complete);
+    
+    // Drops the slot's pending or in-flight request; its callback is not invoked
+    void cancel(const std::string& slot);
+    
+    Stats stats() const;
+
+private:
+    class Impl;
+    std::shared_ptr<Impl> pImpl; // Shared with completion callbacks that outlive a request
+};
+
+} // namespace xeno::ai
@@ -0,0 +1,341 @@
+#include "ai_broker.h"
+#include "broker_channel.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace xeno::ai {
+
+namespace {
+
+using Provider = AIIntegration::AIProvider;
+
+Provider providerOf(const nlohmann::json& message) {
+    int value = message.value("provider", static_cast<int>(Provider::Auto));
+    if (value < static_cast<int>(Provider::XenoCloud) || value > static_cast<int>(Provider::Auto)) {
+        return Provider::Auto;
+    }
+    return static_cast<Provider>(value);
+}
+
+nlohmann::json failure(const std::string& message) {
+    AIIntegration::AIResponse response;
+    response.error_message = message;
+    return detail::encodeResponse(response);
+}
+
+/**
+ * @brief One app's connection and the requests it has running
+ */
+struct Session {
+    struct Running {
+        AIIntegration::AITask task;
+        std::shared_ptr<std::atomic<bool>> stopped;  // Set when the app stops reading a stream
+    };
+    
+    std::unique_ptr<detail::BrokerChannel> channel;
+    std::thread reader;
+    std::atomic<bool> finished{false};
+    std::mutex running_mutex;
+    std::map<int64_t, Running> running;
+    
+    void reply(int64_t id, nlohmann::json value) {
+        channel->send({{"id", id}, {"reply", std::move(value)}});
+    }
+    
+    void track(int64_t id, AIIntegration::AITask task, std::shared_ptr<std::atomic<bool>> stopped = nullptr) {
+        std::lock_guard<std::mutex> lock(running_mutex);
+        // A request can finish before it is tracked, so finished ones are dropped here rather than on completion
+        std::erase_if(running, [](const auto& entry) { return entry.second.task.isReady(); });
+        running[id] = Running{std::move(task), std::move(stopped)};
+    }
+    
+    void cancel(int64_t id) {
+        std::lock_guard<std::mutex> lock(running_mutex);
+        if (auto it = running.find(id); it != running.end()) {
+            it->second.task.cancel();
+        }
+    }
+    
+    void stopStream(int64_t id) {
+        std::lock_guard<std::mutex> lock(running_mutex);
+        if (auto it = running.find(id); it != running.end() && it->second.stopped) {
+            it->second.stopped->store(true);
+        }
+    }
+    
+    void cancelAll() {
+        std::lock_guard<std::mutex> lock(running_mutex);
+        for (auto& [id, entry] : running) {
+            entry.task.cancel();
+        }
+        running.clear();
+    }
+};
+
+} // namespace
+
+class AIBroker::Impl {
+public:
+    explicit Impl(AIIntegration& ai) : ai(ai) {}
+    
+    AIIntegration& ai;
+    std::string address;
+    std::string error_message;
+    std::unique_ptr<detail::BrokerListener> listener;
+    std::thread acceptor;
+    std::atomic<bool> running{false};
+    
+    mutable std::mutex sessions_mutex;
+    std::vector<std::shared_ptr<Session>> sessions;
+    
+    void acceptLoop() {
+        while (auto channel = listener->accept()) {
+            auto session = std::make_shared<Session>();
+            session->channel = std::move(channel);
+            
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            reapFinished();
+            sessions.push_back(session);
+            session->reader = std::thread([this, session]() { serve(session); });
+        }
+    }
+    
+    // Joins the readers of apps that have disconnected; the caller holds sessions_mutex
+    void reapFinished() {
+        std::erase_if(sessions, [](const std::shared_ptr<Session>& session) {
+            if (!session->finished.load()) {
+                return false;
+            }
+            session->reader.join();
+            return true;
+        });
+    }
+    
+    void serve(const std::shared_ptr<Session>& session) {
+        while (auto message = session->channel->receive()) {
+            try {
+                dispatch(session, *message);
+            } catch (const std::exception& e) {
+                utils::Logger::getInstance().warning("AI broker: malformed request: ", e.what());
+            }
+        }
+        // Nobody is left to read the answers, so the requests stop costing credits
+        session->cancelAll();
+        session->finished.store(true);
+    }
+    
+    void dispatch(const std::shared_ptr<Session>& session, const nlohmann::json& message) {
+        std::string type = message.value("type", std::string());
+        int64_t id = message.value("id", int64_t{0});
+        Provider provider = providerOf(message);
+        
+        if (type == "hello") {
+            session->reply(id, {{"protocol", detail::kBrokerProtocol}});
+        } else if (type == "cancel") {
+            session->cancel(id);
+        } else if (type == "stop") {
+            session->stopStream(id);
+        } else if (type == "run") {
+            runOperation(session, id, message, provider);
+        } else if (type == "batch") {
+            runBatch(session, id, message, provider);
+        } else if (type == "media") {
+            runMedia(session, id, message, provider);
+        } else if (type == "call") {
+            auto done = completion(session, id);
+            session->track(id, ai.makeAPICallAsync(provider, message.value("endpoint", std::string()),
+                                                   message.value("payload", nlohmann::json::object()), done));
+        } else if (type == "warm_up") {
+            auto done = completion(session, id);
+            session->track(id, ai.warmUpAsync(provider, message.value("model", std::string()), done));
+        } else if (type == "balance") {
+            session->reply(id, ai.getCreditBalance());
+        } else if (type == "deduct") {
+            session->reply(id, ai.deductCredits(message.value("amount", 0)));
+        } else if (type == "available") {
+            session->reply(id, ai.isProviderAvailable(provider));
+        } else if (type == "status") {
+            session->reply(id, ai.getProviderStatus(provider));
+        } else if (type == "stats") {
+            auto stats = ai.getProviderStats(provider, message.value("operation", std::string()));
+            session->reply(id, {{"p50_ms", stats.p50_ms},
+                                {"p95_ms", stats.p95_ms},
+                                {"p99_ms", stats.p99_ms},
+                                {"error_rate", stats.error_rate},
+                                {"samples", stats.samples},
+                                {"requests", stats.requests},
+                                {"healthy", stats.healthy}});
+        } else if (type == "clear_cache") {
+            ai.clearCache();
+            session->reply(id, true);
+        } else {
+            session->reply(id, failure("The AI broker does not handle \"" + type + "\" requests"));
+        }
+    }
+    
+    static AIIntegration::CompletionCallback completion(const std::shared_ptr<Session>& session, int64_t id) {
+        return [session, id](const AIIntegration::AIResponse& response) {
+            session->reply(id, detail::encodeResponse(response));
+        };
+    }
+    
+    void runOperation(const std::shared_ptr<Session>& session, int64_t id, const nlohmann::json& message,
+                      Provider provider) {
+        auto request = detail::decodeRequest(message.value("request", nlohmann::json::object()));
+        std::string operation = message.value("operation", std::string());
+        bool stream = message.value("stream", false);
+        auto done = completion(session, id);
+        
+        auto stopped = std::make_shared<std::atomic<bool>>(false);
+        AIIntegration::StreamCallback on_chunk = [session, id, stopped](const std::string& chunk) {
+            return !stopped->load() && session->channel->send({{"id", id}, {"chunk", chunk}});
+        };
+        
+        AIIntegration::AITask task;
+        if (operation == "image_generation") {
+            task = ai.generateImageAsync(request, provider, done);
+        } else if (operation == "video_processing") {
+            task = ai.processVideoAsync(request, provider, done);
+        } else if (operation == "audio_processing") {
+            task = ai.processAudioAsync(request, provider, done);
+        } else if (operation == "code_completion") {
+            task = stream ? ai.completeCodeStreamAsync(request, on_chunk, provider, done)
+                          : ai.completeCodeAsync(request, provider, done);
+        } else if (operation == "chat_completion") {
+            task = stream ? ai.chatCompletionStreamAsync(request, on_chunk, provider, done)
+                          : ai.chatCompletionAsync(request, provider, done);
+        } else {
+            session->reply(id, failure("Unknown operation: " + operation));
+            return;
+        }
+        session->track(id, std::move(task), std::move(stopped));
+    }
+    
+    void runBatch(const std::shared_ptr<Session>& session, int64_t id, const nlohmann::json& message,
+                  Provider provider) {
+        std::vector<AIIntegration::AIRequest> requests;
+        for (const auto& request : message.value("requests", nlohmann::json::array())) {
+            requests.push_back(detail::decodeRequest(request));
+        }
+        AIIntegration::BatchCallback done = [session, id](const std::vector<AIIntegration::AIResponse>& responses) {
+            nlohmann::json encoded = nlohmann::json::array();
+            for (const auto& response : responses) {
+                encoded.push_back(detail::encodeResponse(response));
+            }
+            session->reply(id, std::move(encoded));
+        };
+        
+        std::string operation = message.value("operation", std::string());
+        if (operation == "code_completion") {
+            session->track(id, ai.completeCodeBatchAsync(requests, provider, std::move(done)));
+        } else if (operation == "image_generation") {
+            session->track(id, ai.generateImageBatchAsync(requests, provider, std::move(done)));
+        } else {
+            session->reply(id, failure("Unknown batch operation: " + operation));
+        }
+    }
+    
+    // Media files are on this machine, so the broker reads and writes them itself
+    void runMedia(const std::shared_ptr<Session>& session, int64_t id, const nlohmann::json& message,
+                  Provider provider) {
+        auto request = detail::decodeRequest(message.value("request", nlohmann::json::object()));
+        auto files = detail::decodeFiles(message.value("files", nlohmann::json::object()));
+        AIIntegration::TransferProgress progress = [session, id](uint64_t done, uint64_t total) {
+            return session->channel->send({{"id", id}, {"progress", {done, total}}});
+        };
+        
+        std::string operation = message.value("operation", std::string());
+        if (operation == "audio_processing") {
+            session->track(id, ai.processAudioFileAsync(request, files, progress, provider, completion(session, id)));
+        } else if (operation == "video_processing") {
+            session->track(id, ai.processVideoFileAsync(request, files, progress, provider, completion(session, id)));
+        } else {
+            session->reply(id, failure("Unknown media operation: " + operation));
+        }
+    }
+};
+
+AIBroker::AIBroker(AIIntegration& ai) : pImpl(std::make_unique<Impl>(ai)) {}
+
+AIBroker::~AIBroker() {
+    stop();
+}
+
+bool AIBroker::start(const std::string& address) {
+    if (pImpl->running.load()) {
+        pImpl->error_message = "The AI broker is already serving " + pImpl->address;
+        return false;
+    }
+    pImpl->error_message.clear();
+    
+    std::string directory = std::filesystem::path(address).parent_path().string();
+    if (!directory.empty()) {
+        utils::Platform::createDirectory(directory);
+    }
+    auto listener = std::make_unique<detail::BrokerListener>();
+    if (!listener->listen(address, pImpl->error_message)) {
+        return false;
+    }
+    pImpl->listener = std::move(listener);
+    pImpl->address = address;
+    pImpl->running.store(true);
+    pImpl->acceptor = std::thread([this]() { pImpl->acceptLoop(); });
+    return true;
+}
+
+void AIBroker::stop() {
+    if (!pImpl->running.exchange(false)) {
+        return;
+    }
+    pImpl->listener->close();
+    pImpl->acceptor.join();
+    
+    std::vector<std::shared_ptr<Session>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->sessions_mutex);
+        sessions.swap(pImpl->sessions);
+    }
+    for (const auto& session : sessions) {
+        session->channel->close();
+    }
+    for (const auto& session : sessions) {
+        session->reader.join();
+    }
+    // Removes the socket file, so apps started later run on their own
+    pImpl->listener.reset();
+}
+
+bool AIBroker::isRunning() const {
+    return pImpl->running.load();
+}
+
+const std::string& AIBroker::address() const {
+    return pImpl->address;
+}
+
+size_t AIBroker::clientCount() const {
+    std::lock_guard<std::mutex> lock(pImpl->sessions_mutex);
+    return static_cast<size_t>(std::count_if(pImpl->sessions.begin(), pImpl->sessions.end(),
+                                             [](const auto& session) { return !session->finished.load(); }));
+}
+
+const std::string& AIBroker::errorMessage() const {
+    return pImpl->error_message;
+}
+
+std::string AIBroker::defaultAddress() {
+    if (const char* configured = std::getenv(kAddressVariable); configured && *configured) {
+        return configured;
+    }
+    return utils::Platform::getAppDataPath() + "/ai-broker.sock";
+}
+
+} // namespace xeno::ai
@@ -1,83 +1,1794 @@
 #include "ai_integration.h"
+#include "broker_client.h"
+#include "connection_pool.h"
+#include "media_transfer.h"
+#include "metrics.h"
+#include "provider_router.h"
+#include "response_cache.h"
+#include "stream_parser.h"
+#include "utils.h"
 #include <httplib.h>
-#include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
 
 namespace xeno::ai {
 
+namespace {
+
+/**
+ * @brief Fixed-size pool of threads that runs queued AI requests
+ *
+ * AI calls are dominated by network wait, so the pool is sized for
+ * concurrency rather than for the number of cores.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t thread_count) {
+        for (size_t i = 0; i < thread_count; i++) {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+    
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                // Queued jobs are still drained on shutdown so every promise is fulfilled
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+    
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+struct OperationSpec {
+    const char* name;
+    int base_credits; // Charged on Xeno Cloud only
+    const char* placeholder;
+    const char* xeno_path;
+    bool text_generation; // Served by the LLM providers (Open Router, Ollama) as well
+    int cache_ttl_seconds; // Default lifetime of a cached response
+};
+
+constexpr int kHour = 60 * 60;
+constexpr int kDay = 24 * kHour;
+
+constexpr OperationSpec kImageGeneration{"image_generation", 3, "Generated image data (placeholder)",
+                                         "/v1/images/generate", false, 7 * kDay};
+constexpr OperationSpec kVideoProcessing{"video_processing", 5, "Processed video data (placeholder)",
+                                         "/v1/video/process", false, kDay};
+constexpr OperationSpec kAudioProcessing{"audio_processing", 2, "Processed audio data (placeholder)",
+                                         "/v1/audio/process", false, kDay};
+// Completions depend on surrounding code that keeps changing, so they go stale quickly
+constexpr OperationSpec kCodeCompletion{"code_completion", 1, "Code completion suggestion (placeholder)",
+                                        "/v1/code/complete", true, kHour};
+constexpr OperationSpec kChatCompletion{"chat_completion", 1, "Chat response (placeholder)",
+                                        "/v1/chat/completions", true, kDay};
+
+// "ai.<operation>" times each call to a provider, cache hits included; failures other than
+// cancellation count in "ai.<operation>.errors"
+struct OperationMetrics {
+    utils::Histogram& latency;
+    utils::Counter& errors;
+};
+
+const OperationMetrics& metricsFor(const OperationSpec& spec) {
+    static const auto table = [] {
+        std::map<std::string_view, OperationMetrics> metrics;
+        auto& registry = utils::Metrics::getInstance();
+        for (const OperationSpec* op : {&kImageGeneration, &kVideoProcessing, &kAudioProcessing, &kCodeCompletion,
+                                        &kChatCompletion}) {
+            std::string name = std::string("ai.") + op->name;
+            metrics.emplace(op->name, OperationMetrics{registry.histogram(name), registry.counter(name + ".errors")});
+        }
+        return metrics;
+    }();
+    return table.at(spec.name);
+}
+
+const char* providerName(AIIntegration::AIProvider provider) {
+    switch (provider) {
+        case AIIntegration::AIProvider::XenoCloud: return "Xeno AI Cloud";
+        case AIIntegration::AIProvider::OpenRouter: return "Open Router";
+        case AIIntegration::AIProvider::Ollama: return "Ollama";
+        case AIIntegration::AIProvider::Auto: return "Auto";
+    }
+    return "Unknown";
+}
+
+// Provider by its section name in the config file
+std::optional<AIIntegration::AIProvider> providerFromConfigName(const std::string& name) {
+    if (name == "xeno_ai") {
+        return AIIntegration::AIProvider::XenoCloud;
+    }
+    if (name == "open_router") {
+        return AIIntegration::AIProvider::OpenRouter;
+    }
+    if (name == "ollama") {
+        return AIIntegration::AIProvider::Ollama;
+    }
+    return std::nullopt;
+}
+
+// A cheap GET that answers without running a model
+const char* healthPath(AIIntegration::AIProvider provider) {
+    switch (provider) {
+        case AIIntegration::AIProvider::XenoCloud: return "/v1/health";
+        case AIIntegration::AIProvider::OpenRouter: return "/key";
+        case AIIntegration::AIProvider::Ollama: return "/api/version";
+        case AIIntegration::AIProvider::Auto: break;
+    }
+    return "/";
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string ollamaModel(const std::string& model, const AIIntegration::APIConfig& config) {
+    std::string chosen = model.empty() ? config.default_model : model;
+    return chosen.empty() ? "llama3" : chosen;
+}
+
+// Ollama takes keep_alive as a duration string or as a number of seconds
+nlohmann::json keepAliveValue(const std::string& keep_alive) {
+    size_t sign = !keep_alive.empty() && keep_alive[0] == '-' ? 1 : 0;
+    bool seconds = keep_alive.size() > sign && std::all_of(keep_alive.begin() + sign, keep_alive.end(), [](char c) {
+        return c >= '0' && c <= '9';
+    });
+    if (seconds) {
+        return std::stoll(keep_alive);
+    }
+    return keep_alive;
+}
+
+// Copies the timings Ollama reports with a finished generation, converted from ns to ms.
+// A low prompt_eval_count means the model reused its cached evaluation of the prompt prefix.
+void recordOllamaTimings(const nlohmann::json& body, nlohmann::json& metadata) {
+    for (const char* count : {"prompt_eval_count", "eval_count"}) {
+        if (body.contains(count) && body[count].is_number()) {
+            metadata[count] = body[count];
+        }
+    }
+    const std::pair<const char*, const char*> durations[] = {
+        {"total_duration", "total_ms"}, {"load_duration", "load_ms"},
+        {"prompt_eval_duration", "prompt_eval_ms"}, {"eval_duration", "eval_ms"}
+    };
+    for (const auto& [duration, name] : durations) {
+        if (body.contains(duration) && body[duration].is_number()) {
+            metadata[name] = body[duration].get<double>() / 1e6;
+        }
+    }
+}
+
+struct ProviderCall {
+    std::string path;
+    nlohmann::json payload;
+    detail::StreamParser::Format stream_format = detail::StreamParser::Format::ServerSentEvents;
+};
+
+// Translates an operation into the request shape each provider expects
+std::optional<ProviderCall> buildProviderCall(AIIntegration::AIProvider provider, const OperationSpec& spec,
+                                              const AIIntegration::AIRequest& request,
+                                              const AIIntegration::APIConfig& config, bool stream) {
+    std::string model = request.model.empty() ? config.default_model : request.model;
+    
+    switch (provider) {
+        case AIIntegration::AIProvider::XenoCloud: {
+            nlohmann::json payload = {
+                {"prompt", request.prompt},
+                {"operation_type", request.operation_type},
+                {"parameters", request.parameters}
+            };
+            if (!model.empty()) {
+                payload["model"] = model;
+            }
+            if (stream) {
+                payload["stream"] = true;
+            }
+            return ProviderCall{spec.xeno_path, payload};
+        }
+        case AIIntegration::AIProvider::OpenRouter: {
+            if (!spec.text_generation) {
+                return std::nullopt;
+            }
+            // OpenAI-compatible chat API; extra parameters (temperature, max_tokens...) go top-level
+            nlohmann::json payload = request.parameters;
+            payload["model"] = model.empty() ? "openrouter/auto" : model;
+            payload["messages"] = nlohmann::json::array({{{"role", "user"}, {"content", request.prompt}}});
+            if (stream) {
+                payload["stream"] = true;
+            }
+            return ProviderCall{"/chat/completions", payload};
+        }
+        case AIIntegration::AIProvider::Ollama: {
+            if (!spec.text_generation) {
+                return std::nullopt;
+            }
+            // The runner keeps the evaluated prompt, so a request sharing its prefix with the previous
+            // one only evaluates the rest; changing options such as num_ctx reloads the model instead
+            nlohmann::json payload = {
+                {"model", ollamaModel(request.model, config)},
+                {"prompt", request.prompt},
+                {"stream", stream}
+            };
+            if (!request.parameters.empty()) {
+                payload["options"] = request.parameters;
+            }
+            if (!config.keep_alive.empty()) {
+                payload["keep_alive"] = keepAliveValue(config.keep_alive);
+            }
+            return ProviderCall{"/api/generate", payload, detail::StreamParser::Format::JsonLines};
+        }
+        case AIIntegration::AIProvider::Auto:
+            break;
+    }
+    return std::nullopt;
+}
+
+std::string extractContent(AIIntegration::AIProvider provider, const nlohmann::json& body) {
+    const nlohmann::json* content = nullptr;
+    switch (provider) {
+        case AIIntegration::AIProvider::XenoCloud:
+            if (body.contains("content")) {
+                content = &body["content"];
+            }
+            break;
+        case AIIntegration::AIProvider::OpenRouter:
+            if (body.contains("choices") && !body["choices"].empty()) {
+                const auto& choice = body["choices"][0];
+                if (choice.contains("message") && choice["message"].contains("content")) {
+                    content = &choice["message"]["content"];
+                }
+            }
+            break;
+        case AIIntegration::AIProvider::Ollama:
+            if (body.contains("response")) {
+                content = &body["response"];
+            }
+            break;
+        case AIIntegration::AIProvider::Auto:
+            break;
+    }
+    if (!content) {
+        return body.dump();
+    }
+    return content->is_string() ? content->get<std::string>() : content->dump();
+}
+
+// Pulls the text delta out of one streamed event
+std::string extractStreamToken(AIIntegration::AIProvider provider, const nlohmann::json& event) {
+    const nlohmann::json* token = nullptr;
+    switch (provider) {
+        case AIIntegration::AIProvider::XenoCloud:
+            if (event.contains("delta")) {
+                token = &event["delta"];
+            }
+            break;
+        case AIIntegration::AIProvider::OpenRouter:
+            if (event.contains("choices") && !event["choices"].empty()) {
+                const auto& choice = event["choices"][0];
+                if (choice.contains("delta") && choice["delta"].contains("content")) {
+                    token = &choice["delta"]["content"];
+                }
+            }
+            break;
+        case AIIntegration::AIProvider::Ollama:
+            if (event.contains("response")) {
+                token = &event["response"];
+            }
+            break;
+        case AIIntegration::AIProvider::Auto:
+            break;
+    }
+    return token && token->is_string() ? token->get<std::string>() : std::string();
+}
+
+using BodySink = std::function<bool(const char* data, size_t length)>;
+
+AIIntegration::AIResponse cancelledResponse() {
+    AIIntegration::AIResponse response;
+    response.success = false;
+    response.error_message = "Request cancelled";
+    response.metadata["cancelled"] = true;
+    return response;
+}
+
+AIIntegration::AIResponse failedResponse(const std::string& error) {
+    AIIntegration::AIResponse response;
+    response.success = false;
+    response.error_message = error;
+    return response;
+}
+
+// Writes through a temporary file so a failed write never leaves a truncated result
+bool writeResultFile(const std::string& path, const std::string& content, std::string& error) {
+    std::string partial = path + ".part";
+    {
+        std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+        output.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!output) {
+            error = "Cannot write " + partial;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(partial, path, ec);
+    if (ec) {
+        std::filesystem::remove(partial, ec);
+        error = "Cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
 // Private implementation
 class AIIntegration::Impl {
 public:
+    std::mutex configs_mutex;
     std::map<AIProvider, APIConfig> configs;
+    // Shared so a request in flight keeps its pool alive across reconfiguration
+    std::map<AIProvider, std::shared_ptr<detail::ConnectionPool>> pools;
     std::unique_ptr<CreditWallet> wallet;
     
+    std::mutex cache_mutex;
+    CacheConfig cache_config;
+    std::shared_ptr<detail::ResponseCache> cache; // Created on first use
+    
+    std::once_flag pool_once;
+    std::unique_ptr<WorkerPool> pool;
+    std::mutex tokens_mutex;
+    std::vector<std::weak_ptr<CancellationToken>> live_tokens;
+    
+    detail::ProviderRouter router;
+    std::mutex routing_mutex;
+    RoutingPolicy routing_policy;
+    
+    // Health probes run on their own thread from the first configure() until shutdown
+    std::mutex health_mutex;
+    std::condition_variable health_cv;
+    std::thread health_thread;
+    bool health_stopping = false;
+    httplib::Client* probing_client = nullptr; // Stopped on shutdown so a probe in flight returns
+    
+    // Sections of the config file as last applied, so a reload only touches what changed
+    std::mutex applied_mutex;
+    nlohmann::json applied_config;
+    std::string config_source;
+    std::once_flag listener_once;
+    int config_listener = 0;
+    
+    // While connected to a broker requests go there, and the config loaded meanwhile waits in
+    // deferred_config until the broker goes away
+    std::mutex broker_mutex;
+    std::shared_ptr<detail::BrokerClient> broker;
+    std::function<void()> deferred_config;
+    
     Impl() : wallet(std::make_unique<CreditWallet>()) {}
+    
+    // The broker while it is connected; the first call after it drops sets up this instance instead
+    std::shared_ptr<detail::BrokerClient> brokerClient() {
+        std::lock_guard<std::mutex> lock(broker_mutex);
+        if (!broker) {
+            return nullptr;
+        }
+        if (broker->isConnected()) {
+            return broker;
+        }
+        utils::Logger::getInstance().warning("Lost the AI broker; running AI requests in this process");
+        broker.reset();
+        if (deferred_config) {
+            std::exchange(deferred_config, nullptr)();
+        }
+        return nullptr;
+    }
+    
+    // The broker's reply to message; nullopt without a broker, or when it went away before answering
+    std::optional<nlohmann::json> viaBroker(nlohmann::json message, CancellationToken* token = nullptr,
+                                            const StreamCallback* on_chunk = nullptr,
+                                            const TransferProgress* progress = nullptr) {
+        auto client = brokerClient();
+        if (!client) {
+            return std::nullopt;
+        }
+        return client->call(std::move(message), token, on_chunk, progress);
+    }
+    
+    WorkerPool& workers() {
+        std::call_once(pool_once, [this]() {
+            size_t threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 4, 16);
+            pool = std::make_unique<WorkerPool>(threads);
+        });
+        return *pool;
+    }
+    
+    std::shared_ptr<CancellationToken> trackToken() {
+        auto token = std::make_shared<CancellationToken>();
+        std::lock_guard<std::mutex> lock(tokens_mutex);
+        live_tokens.erase(std::remove_if(live_tokens.begin(), live_tokens.end(),
+                                         [](const auto& weak) { return weak.expired(); }),
+                          live_tokens.end());
+        live_tokens.push_back(token);
+        return token;
+    }
+    
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(health_mutex);
+            health_stopping = true;
+            if (probing_client) {
+                probing_client->stop();
+            }
+        }
+        health_cv.notify_all();
+        if (health_thread.joinable()) {
+            health_thread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(tokens_mutex);
+            for (auto& weak : live_tokens) {
+                if (auto token = weak.lock()) {
+                    token->cancel();
+                }
+            }
+        }
+        pool.reset();
+    }
+    
+    void setConfig(AIProvider provider, const APIConfig& config) {
+        detail::ConnectionPool::Options options;
+        options.max_connections = config.max_connections;
+        options.idle_timeout = std::chrono::seconds(config.idle_timeout_seconds);
+        options.read_timeout = std::chrono::seconds(config.timeout_seconds);
+        auto pool = std::make_shared<detail::ConnectionPool>(config.endpoint, options);
+        
+        {
+            std::lock_guard<std::mutex> lock(configs_mutex);
+            configs[provider] = config;
+            pools[provider] = std::move(pool);
+        }
+        startHealthChecks();
+    }
+    
+    // Requests already holding the pool finish on it
+    void clearConfig(AIProvider provider) {
+        std::lock_guard<std::mutex> lock(configs_mutex);
+        configs.erase(provider);
+        pools.erase(provider);
+    }
+    
+    RoutingPolicy routingPolicy() {
+        std::lock_guard<std::mutex> lock(routing_mutex);
+        return routing_policy;
+    }
+    
+    void setRoutingPolicy(const RoutingPolicy& policy) {
+        {
+            std::lock_guard<std::mutex> lock(routing_mutex);
+            routing_policy = policy;
+        }
+        // Wakes the probes so a new interval applies at once
+        health_cv.notify_all();
+    }
+    
+    void startHealthChecks() {
+        {
+            std::lock_guard<std::mutex> lock(health_mutex);
+            if (!health_thread.joinable() && !health_stopping) {
+                health_thread = std::thread([this]() { healthLoop(); });
+                return;
+            }
+        }
+        health_cv.notify_all();
+    }
+    
+    // Probes every configured provider, then sleeps for the policy's interval or until woken
+    void healthLoop() {
+        std::unique_lock<std::mutex> lock(health_mutex);
+        while (!health_stopping) {
+            auto interval = std::chrono::seconds(routingPolicy().health_interval_seconds);
+            if (interval.count() <= 0) {
+                health_cv.wait(lock);
+                continue;
+            }
+            lock.unlock();
+            for (AIProvider provider : {AIProvider::XenoCloud, AIProvider::OpenRouter, AIProvider::Ollama}) {
+                probe(provider);
+            }
+            lock.lock();
+            if (!health_stopping) {
+                health_cv.wait_for(lock, interval);
+            }
+        }
+    }
+    
+    // Any answer short of a server error shows the provider up, even a 401 or 404
+    void probe(AIProvider provider) {
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        if (!config || !pool) {
+            return;
+        }
+        // With every connection busy, the outcomes of those requests say more than a probe would
+        auto lease = pool->tryAcquire();
+        if (!lease) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(health_mutex);
+            if (health_stopping) {
+                return;
+            }
+            probing_client = &lease->client();
+        }
+        httplib::Headers headers(config->headers.begin(), config->headers.end());
+        auto result = lease->client().Get(pool->basePath() + healthPath(provider), headers);
+        {
+            std::lock_guard<std::mutex> lock(health_mutex);
+            probing_client = nullptr;
+            if (health_stopping) {
+                lease->discard();
+                return;
+            }
+        }
+        bool up = result && result->status < 500;
+        if (!up) {
+            lease->discard();
+        }
+        router.setHealthy(provider, up);
+    }
+    
+    bool anyConfigured() {
+        std::lock_guard<std::mutex> lock(configs_mutex);
+        return !configs.empty();
+    }
+    
+    std::optional<APIConfig> configFor(AIProvider provider) {
+        std::lock_guard<std::mutex> lock(configs_mutex);
+        auto it = configs.find(provider);
+        if (it == configs.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+    
+    std::shared_ptr<detail::ConnectionPool> poolFor(AIProvider provider) {
+        std::lock_guard<std::mutex> lock(configs_mutex);
+        auto it = pools.find(provider);
+        return it == pools.end() ? nullptr : it->second;
+    }
+    
+    // Returns nullptr when caching is disabled
+    std::shared_ptr<detail::ResponseCache> responseCache() {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (!cache_config.enabled) {
+            return nullptr;
+        }
+        if (!cache) {
+            detail::ResponseCache::Options options;
+            options.memory_entries = cache_config.memory_entries;
+            options.disk_directory = cache_config.directory;
+            options.disk_bytes = cache_config.disk_bytes;
+            if (options.disk_directory.empty()) {
+                std::string app_data = utils::Platform::getAppDataPath();
+                if (!app_data.empty()) {
+                    options.disk_directory = app_data + "/cache/ai";
+                }
+            }
+            cache = std::make_shared<detail::ResponseCache>(options);
+        }
+        return cache;
+    }
+    
+    std::chrono::seconds cacheTTL(const OperationSpec& spec) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache_config.ttl_seconds.find(spec.name);
+        return std::chrono::seconds(it == cache_config.ttl_seconds.end() ? spec.cache_ttl_seconds : it->second);
+    }
+    
+    struct CacheSlot {
+        std::shared_ptr<detail::ResponseCache> cache; // Null when the request is not cached
+        std::string key;
+    };
+    
+    CacheSlot cacheSlotFor(const AIRequest& request, AIProvider provider, const APIConfig& config) {
+        CacheSlot slot;
+        if (!request.cacheable) {
+            return slot;
+        }
+        slot.cache = responseCache();
+        if (slot.cache) {
+            std::string model = request.model.empty() ? config.default_model : request.model;
+            slot.key = detail::ResponseCache::makeKey(providerName(provider), model, request.prompt,
+                                                      request.parameters, request.operation_type);
+        }
+        return slot;
+    }
+    
+    std::optional<AIResponse> cachedResponse(const CacheSlot& slot) {
+        static utils::Counter& hits = utils::Metrics::getInstance().counter("ai.cache.hits");
+        static utils::Counter& misses = utils::Metrics::getInstance().counter("ai.cache.misses");
+        if (!slot.cache) {
+            return std::nullopt;
+        }
+        auto hit = slot.cache->get(slot.key);
+        if (!hit) {
+            misses.add();
+            return std::nullopt;
+        }
+        hits.add();
+        AIResponse response;
+        response.success = true;
+        response.content = std::move(hit->entry.content);
+        response.metadata = std::move(hit->entry.metadata);
+        response.metadata["cache"] = hit->tier == detail::ResponseCache::Tier::Memory ? "memory" : "disk";
+        response.credits_used = 0;
+        return response;
+    }
+    
+    void storeResponse(const CacheSlot& slot, const OperationSpec& spec, AIResponse& response) {
+        if (!slot.cache) {
+            return;
+        }
+        detail::ResponseCache::Entry entry;
+        entry.content = response.content;
+        entry.metadata = response.metadata;
+        entry.expires = std::chrono::system_clock::now() + cacheTTL(spec);
+        slot.cache->put(slot.key, std::move(entry));
+        response.metadata["cache"] = "miss";
+    }
+    
+    AITask submit(std::function<AIResponse(CancellationToken*)> work, CompletionCallback on_complete) {
+        auto token = trackToken();
+        auto promise = std::make_shared<std::promise<AIResponse>>();
+        
+        AITask task;
+        task.result = promise->get_future().share();
+        task.token = token;
+        
+        workers().submit([work = std::move(work), on_complete = std::move(on_complete), promise, token]() {
+            AIResponse response;
+            try {
+                response = token->isCancelled() ? cancelledResponse() : work(token.get());
+            } catch (const std::exception& e) {
+                response = failedResponse(e.what());
+            } catch (...) {
+                response = failedResponse("Unknown error");
+            }
+            
+            // A throwing callback must not leave the task's waiters hanging or take the worker down
+            if (on_complete) {
+                try {
+                    on_complete(response);
+                } catch (const std::exception& e) {
+                    utils::Logger::getInstance().error("AI completion callback threw: ", e.what());
+                } catch (...) {
+                    utils::Logger::getInstance().error("AI completion callback threw");
+                }
+            }
+            promise->set_value(std::move(response));
+        });
+        return task;
+    }
+    
+    // POSTs a JSON payload over a pooled keep-alive connection. The body is returned raw in
+    // content, or handed to body_sink chunk by chunk as it arrives when a sink is given.
+    AIResponse postJSON(AIProvider provider, detail::ConnectionPool& pool, const APIConfig& config,
+                        const std::string& path, const nlohmann::json& payload, CancellationToken* token,
+                        const BodySink* body_sink = nullptr) {
+        AIResponse response;
+        
+        httplib::Request http_request;
+        http_request.method = "POST";
+        http_request.path = pool.basePath() + path;
+        for (const auto& [key, value] : config.headers) {
+            http_request.headers.emplace(key, value);
+        }
+        http_request.headers.emplace("Content-Type", "application/json");
+        http_request.body = payload.dump();
+        http_request.progress = [token](uint64_t, uint64_t) {
+            return !(token && token->isCancelled());
+        };
+        
+        // Error bodies are kept for the message instead of being streamed to the sink
+        int stream_status = 0;
+        std::string error_body;
+        bool sink_stopped = false;
+        if (body_sink) {
+            http_request.headers.emplace("Accept", "text/event-stream");
+            http_request.response_handler = [&stream_status](const httplib::Response& http_response) {
+                stream_status = http_response.status;
+                return true;
+            };
+            http_request.content_receiver = [&](const char* data, size_t length, uint64_t, uint64_t) {
+                if (token && token->isCancelled()) {
+                    return false;
+                }
+                if (stream_status < 200 || stream_status >= 300) {
+                    if (error_body.size() < 512) {
+                        error_body.append(data, std::min<size_t>(length, 512 - error_body.size()));
+                    }
+                    return true;
+                }
+                if (!(*body_sink)(data, length)) {
+                    sink_stopped = true;
+                    return false;
+                }
+                return true;
+            };
+        }
+        
+        auto lease = pool.acquire();
+        auto& client = lease.client();
+        if (token) {
+            // Unblocks a request that is still waiting on the server
+            token->setCancelHandler([&client]() { client.stop(); });
+        }
+        auto result = client.send(http_request);
+        if (token) {
+            token->clearCancelHandler();
+        }
+        
+        if (token && token->isCancelled()) {
+            lease.discard();
+            return cancelledResponse();
+        }
+        
+        // The caller stopped reading mid-stream; what was received is the result
+        if (sink_stopped) {
+            lease.discard();
+            response.success = true;
+            response.metadata["provider"] = providerName(provider);
+            response.metadata["stopped_early"] = true;
+            return response;
+        }
+        
+        if (!result) {
+            lease.discard();
+            response.success = false;
+            response.error_message = std::string("Could not reach ") + providerName(provider) + ": " +
+                                     httplib::to_string(result.error());
+            return response;
+        }
+        
+        response.metadata["provider"] = providerName(provider);
+        response.metadata["http_status"] = result->status;
+        if (result->status < 200 || result->status >= 300) {
+            response.success = false;
+            response.error_message = std::string(providerName(provider)) + " returned HTTP " +
+                                     std::to_string(result->status) + ": " +
+                                     (body_sink ? error_body : result->body.substr(0, 512));
+            return response;
+        }
+        
+        response.success = true;
+        response.content = std::move(result->body);
+        return response;
+    }
+    
+    AIResponse callProvider(AIProvider provider, const std::string& endpoint,
+                            const nlohmann::json& payload, CancellationToken* token) {
+        AIResponse response;
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        if (auto reply = viaBroker({{"type", "call"}, {"provider", static_cast<int>(provider)}, {"endpoint", endpoint},
+                                    {"payload", payload}}, token)) {
+            return detail::decodeResponse(*reply);
+        }
+        // Endpoint paths and payloads differ between providers, so there is nothing to route
+        if (provider == AIProvider::Auto) {
+            response.error_message = "API calls to " + endpoint + " need an explicit provider";
+            return response;
+        }
+        
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        if (config && pool) {
+            response = postJSON(provider, *pool, *config, endpoint, payload, token);
+            response.credits_used = response.success && provider == AIProvider::XenoCloud ? 1 : 0;
+            return response;
+        }
+        
+        // Unconfigured providers run in offline demo mode
+        response.success = true;
+        response.content = "API response (placeholder)";
+        response.credits_used = provider == AIProvider::XenoCloud ? 1 : 0;
+        response.metadata["endpoint"] = endpoint;
+        response.metadata["payload_size"] = payload.size();
+        
+        return response;
+    }
+    
+    // Streams one operation through the provider's incremental API, forwarding each token
+    AIResponse streamContent(AIProvider provider, detail::ConnectionPool& pool, const APIConfig& config,
+                             const ProviderCall& call, CancellationToken* token, const StreamCallback& on_chunk) {
+        std::string text;
+        std::string stream_error;
+        nlohmann::json timings = nlohmann::json::object();
+        detail::StreamParser parser(call.stream_format, [&](std::string_view data) {
+            auto event = nlohmann::json::parse(data, nullptr, false);
+            if (event.is_discarded()) {
+                return true; // Tolerate non-JSON keep-alive payloads
+            }
+            if (event.contains("error")) {
+                stream_error = event["error"].is_string() ? event["error"].get<std::string>() : event["error"].dump();
+                return false;
+            }
+            if (provider == AIProvider::Ollama && event.value("done", false)) {
+                recordOllamaTimings(event, timings);
+            }
+            std::string chunk = extractStreamToken(provider, event);
+            if (chunk.empty()) {
+                return true;
+            }
+            text += chunk;
+            return on_chunk(chunk);
+        });
+        
+        BodySink sink = [&parser](const char* data, size_t length) { return parser.feed(data, length); };
+        AIResponse response = postJSON(provider, pool, config, call.path, call.payload, token, &sink);
+        if (response.success) {
+            parser.finish();
+        }
+        if (!stream_error.empty()) {
+            response.success = false;
+            response.error_message = std::string(providerName(provider)) + " stream error: " + stream_error;
+        }
+        response.metadata.update(timings);
+        response.content = std::move(text);
+        return response;
+    }
+    
+    AIResponse runOperation(const OperationSpec& spec, const AIRequest& request, AIProvider provider,
+                            CancellationToken* token, const StreamCallback* on_chunk = nullptr) {
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        if (auto reply = viaBroker({{"type", "run"}, {"operation", spec.name}, {"provider", static_cast<int>(provider)},
+                                    {"request", detail::encodeRequest(request)}, {"stream", on_chunk != nullptr}},
+                                   token, on_chunk)) {
+            return detail::decodeResponse(*reply);
+        }
+        if (provider == AIProvider::Auto) {
+            return runRouted(spec, request, token, on_chunk);
+        }
+        
+        const OperationMetrics& metrics = metricsFor(spec);
+        utils::TraceSpan span(metrics.latency);
+        AIResponse response = runOnProvider(spec, request, provider, token, on_chunk);
+        if (!response.success && !(token && token->isCancelled())) {
+            metrics.errors.add();
+        }
+        return response;
+    }
+    
+    AIResponse runOnProvider(const OperationSpec& spec, const AIRequest& request, AIProvider provider,
+                             CancellationToken* token, const StreamCallback* on_chunk) {
+        AIResponse response;
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        
+        // Repeats are served locally before any credit check: a hit costs nothing.
+        // Demo-mode placeholders are never cached.
+        CacheSlot cache_slot;
+        if (config && pool) {
+            cache_slot = cacheSlotFor(request, provider, *config);
+            if (auto hit = cachedResponse(cache_slot)) {
+                if (on_chunk) {
+                    (*on_chunk)(hit->content);
+                }
+                return *hit;
+            }
+        }
+        
+        // Xeno Cloud credits are held for the duration of the call; any early return refunds them
+        CreditWallet::Reservation reservation;
+        if (provider == AIProvider::XenoCloud) {
+            reservation = wallet->reserveCredits(spec.base_credits);
+            if (!reservation) {
+                response.success = false;
+                response.error_message = "Insufficient credits";
+                return response;
+            }
+        }
+        
+        if (config && pool) {
+            auto call = buildProviderCall(provider, spec, request, *config, on_chunk != nullptr);
+            if (!call) {
+                response.success = false;
+                response.error_message = std::string(spec.name) + " is not supported by " + providerName(provider);
+                return response;
+            }
+            
+            auto started = std::chrono::steady_clock::now();
+            if (on_chunk) {
+                response = streamContent(provider, *pool, *config, *call, token, *on_chunk);
+            } else {
+                response = postJSON(provider, *pool, *config, call->path, call->payload, token);
+                if (response.success) {
+                    try {
+                        auto body = nlohmann::json::parse(response.content);
+                        response.content = extractContent(provider, body);
+                        if (provider == AIProvider::Ollama) {
+                            recordOllamaTimings(body, response.metadata);
+                        }
+                    } catch (const nlohmann::json::exception& e) {
+                        response.success = false;
+                        response.error_message = std::string("Malformed response from ") + providerName(provider) +
+                                                 ": " + e.what();
+                    }
+                }
+            }
+            // Cancelled and cut-short requests say nothing about how the provider is doing
+            if (!(token && token->isCancelled()) && !response.metadata.value("stopped_early", false)) {
+                router.record(provider, spec.name, millisecondsSince(started), response.success);
+            }
+            if (!response.success) {
+                return response;
+            }
+        } else {
+            // Unconfigured providers run in offline demo mode
+            response.success = true;
+            response.content = spec.placeholder;
+            if (on_chunk) {
+                // Replay the placeholder word by word so streaming callers see incremental output
+                size_t start = 0;
+                while (start < response.content.size()) {
+                    size_t end = response.content.find(' ', start);
+                    end = end == std::string::npos ? response.content.size() : end + 1;
+                    if ((token && token->isCancelled()) || !(*on_chunk)(response.content.substr(start, end - start))) {
+                        response.content.resize(end);
+                        break;
+                    }
+                    start = end;
+                }
+            }
+        }
+        response.credits_used = provider == AIProvider::XenoCloud ? spec.base_credits : 0;
+        response.metadata["operation"] = spec.name;
+        if (!request.operation_type.empty()) {
+            response.metadata["operation_type"] = request.operation_type;
+        }
+        
+        // A request cancelled while in flight is never charged
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        
+        // A stream the caller stopped early holds a truncated answer
+        if (!response.metadata.value("stopped_early", false)) {
+            storeResponse(cache_slot, spec, response);
+        }
+        
+        if (reservation) {
+            reservation.commit(spec.name, response.credits_used);
+        }
+        
+        return response;
+    }
+    
+    // The configured providers that can run request under policy, best first. withheld_credits
+    // reports Xeno Cloud left out by the credit policy.
+    std::vector<AIProvider> routeFor(const OperationSpec& spec, const AIRequest& request, const RoutingPolicy& policy,
+                                     bool* withheld_credits = nullptr) {
+        const std::vector<AIProvider>* order = &policy.preference;
+        auto custom = policy.by_operation.find(request.operation_type.empty() ? spec.name : request.operation_type);
+        if (custom != policy.by_operation.end()) {
+            order = &custom->second;
+        }
+        
+        std::vector<detail::ProviderRouter::Candidate> candidates;
+        for (AIProvider provider : *order) {
+            bool listed = std::any_of(candidates.begin(), candidates.end(), [provider](const auto& candidate) {
+                return candidate.provider == provider;
+            });
+            if (provider == AIProvider::Auto || listed || !configFor(provider)) {
+                continue;
+            }
+            if (!spec.text_generation && provider != AIProvider::XenoCloud) {
+                continue;
+            }
+            int credits = provider == AIProvider::XenoCloud ? spec.base_credits : 0;
+            if (credits > 0 && (!policy.spend_credits || wallet->getBalance() - credits < policy.min_credit_balance)) {
+                if (withheld_credits) {
+                    *withheld_credits = true;
+                }
+                continue;
+            }
+            candidates.push_back({provider, credits});
+        }
+        
+        detail::ProviderRouter::Weights weights;
+        weights.ms_per_credit = policy.ms_per_credit;
+        weights.max_error_rate = policy.max_error_rate;
+        weights.min_samples = policy.min_samples;
+        return router.rank(candidates, spec.name, weights);
+    }
+    
+    // Runs a request on the best provider for it, failing over down the ranking
+    AIResponse runRouted(const OperationSpec& spec, const AIRequest& request, CancellationToken* token,
+                         const StreamCallback* on_chunk) {
+        RoutingPolicy policy = routingPolicy();
+        bool withheld_credits = false;
+        auto order = routeFor(spec, request, policy, &withheld_credits);
+        
+        AIResponse response;
+        if (order.empty()) {
+            if (anyConfigured()) {
+                response.error_message = withheld_credits ? std::string("Insufficient credits")
+                                                          : std::string("No configured provider runs ") + spec.name;
+                return response;
+            }
+            // Nothing configured: demo mode, as the first preference would run it
+            AIProvider demo = AIProvider::XenoCloud;
+            if (!policy.preference.empty() && policy.preference.front() != AIProvider::Auto) {
+                demo = policy.preference.front();
+            }
+            response = runOperation(spec, request, demo, token, on_chunk);
+            response.metadata["routed_provider"] = providerName(demo);
+            return response;
+        }
+        
+        AIProvider served = order.front();
+        size_t attempts = 0;
+        bool hedged = false;
+        std::string failures;
+        for (size_t next = 0; next < order.size();) {
+            // Text already shown cannot be taken back, so a stream that has started is not retried
+            bool delivered = false;
+            StreamCallback tracked;
+            if (on_chunk) {
+                tracked = [&delivered, on_chunk](const std::string& chunk) {
+                    delivered = true;
+                    return (*on_chunk)(chunk);
+                };
+            }
+            
+            if (policy.hedge && !on_chunk && next + 1 < order.size()) {
+                bool raced = false;
+                response = runHedged(spec, request, order[next], order[next + 1], policy, token, served, raced);
+                hedged = hedged || raced;
+                attempts += raced ? 2 : 1;
+                next += raced ? 2 : 1;
+            } else {
+                served = order[next++];
+                response = runOperation(spec, request, served, token, on_chunk ? &tracked : nullptr);
+                attempts++;
+            }
+            if (response.success || delivered || (token && token->isCancelled())) {
+                break;
+            }
+            failures += std::string(failures.empty() ? "" : "; ") + response.error_message;
+        }
+        
+        if (!response.success && attempts > 1 && !(token && token->isCancelled())) {
+            response.error_message = "Every provider failed: " + failures;
+        }
+        response.metadata["routed_provider"] = providerName(served);
+        response.metadata["attempts"] = attempts;
+        if (hedged) {
+            response.metadata["hedged"] = true;
+        }
+        return response;
+    }
+    
+    // Sends request to primary and, if it has not answered by its p95, to backup as well; the first
+    // success is returned and the other request cancelled. served names the provider that answered
+    // and raced whether backup was asked. A primary without enough history runs alone.
+    AIResponse runHedged(const OperationSpec& spec, const AIRequest& request, AIProvider primary, AIProvider backup,
+                         const RoutingPolicy& policy, CancellationToken* token, AIProvider& served, bool& raced) {
+        served = primary;
+        raced = false;
+        auto delay = router.hedgeDelay(primary, spec.name, policy.min_hedge_samples);
+        if (!delay) {
+            return runOperation(spec, request, primary, token);
+        }
+        
+        CancellationToken primary_token;
+        CancellationToken backup_token;
+        if (token) {
+            token->setCancelHandler([&primary_token, &backup_token]() {
+                primary_token.cancel();
+                backup_token.cancel();
+            });
+        }
+        
+        // A thread per hedged request is small next to the network wait, and keeps the worker
+        // pool from filling with requests that wait on each other
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool primary_done = false;
+        AIResponse primary_response;
+        std::thread primary_thread([&]() {
+            AIResponse result = runOperation(spec, request, primary, &primary_token);
+            if (result.success) {
+                backup_token.cancel();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                primary_response = std::move(result);
+                primary_done = true;
+            }
+            finished.notify_one();
+        });
+        
+        bool in_time = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            in_time = finished.wait_for(lock, *delay, [&primary_done]() { return primary_done; });
+        }
+        
+        AIResponse response;
+        if (!in_time && !(token && token->isCancelled())) {
+            raced = true;
+            response = runOperation(spec, request, backup, &backup_token);
+            if (response.success) {
+                primary_token.cancel();
+                served = backup;
+            }
+        }
+        primary_thread.join();
+        if (token) {
+            token->clearCancelHandler();
+        }
+        if (served == primary) {
+            response = std::move(primary_response);
+        }
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        return response;
+    }
+    
+    // Runs independent requests together. Xeno Cloud accepts them as one batch payload;
+    // the other providers have no batch API and get one request each.
+    std::vector<AIResponse> runBatch(const OperationSpec& spec, const std::vector<AIRequest>& requests,
+                                     AIProvider provider, CancellationToken* token = nullptr) {
+        std::vector<AIResponse> responses(requests.size());
+        nlohmann::json encoded = nlohmann::json::array();
+        for (const auto& request : requests) {
+            encoded.push_back(detail::encodeRequest(request));
+        }
+        if (auto reply = viaBroker({{"type", "batch"}, {"operation", spec.name},
+                                    {"provider", static_cast<int>(provider)}, {"requests", std::move(encoded)}},
+                                   token)) {
+            size_t answered = reply->is_array() ? reply->size() : 0;
+            for (size_t i = 0; i < responses.size(); i++) {
+                responses[i] = detail::decodeResponse(i < answered ? (*reply)[i] : nlohmann::json());
+            }
+            return responses;
+        }
+        if (provider == AIProvider::Auto && !requests.empty()) {
+            // The whole batch goes to one provider, so Xeno Cloud can still serve it in one round trip;
+            // with no provider to pick, each request is routed (or refused) on its own
+            auto order = routeFor(spec, requests.front(), routingPolicy());
+            if (!order.empty()) {
+                provider = order.front();
+            }
+        }
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        if (provider != AIProvider::XenoCloud || !config || !pool) {
+            for (size_t i = 0; i < requests.size(); i++) {
+                responses[i] = runOperation(spec, requests[i], provider, token);
+            }
+            return responses;
+        }
+        
+        std::vector<CacheSlot> slots(requests.size());
+        std::vector<size_t> misses;
+        for (size_t i = 0; i < requests.size(); i++) {
+            slots[i] = cacheSlotFor(requests[i], provider, *config);
+            if (auto hit = cachedResponse(slots[i])) {
+                responses[i] = std::move(*hit);
+            } else {
+                misses.push_back(i);
+            }
+        }
+        if (misses.size() <= 1) {
+            for (size_t i : misses) {
+                responses[i] = runOperation(spec, requests[i], provider, token);
+            }
+            return responses;
+        }
+        
+        auto failAll = [&](const std::string& message) {
+            for (size_t i : misses) {
+                responses[i].success = false;
+                responses[i].error_message = message;
+            }
+            return responses;
+        };
+        auto cancelAll = [&]() {
+            for (size_t i : misses) {
+                responses[i] = cancelledResponse();
+            }
+            return responses;
+        };
+        if (token && token->isCancelled()) {
+            return cancelAll();
+        }
+        
+        auto reservation = wallet->reserveCredits(spec.base_credits * static_cast<int>(misses.size()));
+        if (!reservation) {
+            return failAll("Insufficient credits");
+        }
+        
+        nlohmann::json items = nlohmann::json::array();
+        for (size_t i : misses) {
+            items.push_back(buildProviderCall(provider, spec, requests[i], *config, false)->payload);
+        }
+        AIResponse batch = postJSON(provider, *pool, *config, std::string(spec.xeno_path) + "/batch",
+                                    {{"requests", items}}, token);
+        if (!batch.success) {
+            // The reservation is refunded either way
+            return token && token->isCancelled() ? cancelAll() : failAll(batch.error_message);
+        }
+        
+        auto body = nlohmann::json::parse(batch.content, nullptr, false);
+        if (body.is_discarded() || !body.contains("results") || !body["results"].is_array() ||
+            body["results"].size() != misses.size()) {
+            return failAll(std::string("Malformed batch response from ") + providerName(provider));
+        }
+        
+        int charged = 0;
+        for (size_t k = 0; k < misses.size(); k++) {
+            const auto& result = body["results"][k];
+            AIResponse& response = responses[misses[k]];
+            if (result.contains("error")) {
+                response.success = false;
+                response.error_message = result["error"].is_string() ? result["error"].get<std::string>()
+                                                                     : result["error"].dump();
+                continue;
+            }
+            response.success = true;
+            response.content = extractContent(provider, result);
+            response.credits_used = spec.base_credits;
+            response.metadata = batch.metadata;
+            response.metadata["operation"] = spec.name;
+            response.metadata["batch_size"] = misses.size();
+            if (!requests[misses[k]].operation_type.empty()) {
+                response.metadata["operation_type"] = requests[misses[k]].operation_type;
+            }
+            storeResponse(slots[misses[k]], spec, response);
+            charged += response.credits_used;
+        }
+        
+        // One ledger entry for the whole batch; failed items are refunded
+        reservation.commit(spec.name, charged);
+        return responses;
+    }
+    
+    // Uploads the source file, runs the job on it and delivers the result to disk
+    AIResponse runMediaOperation(const OperationSpec& spec, const AIRequest& request, const MediaFiles& files,
+                                 AIProvider provider, CancellationToken* token, const TransferProgress& progress) {
+        AIResponse response;
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        if (auto reply = viaBroker({{"type", "media"}, {"operation", spec.name},
+                                    {"provider", static_cast<int>(provider)}, {"request", detail::encodeRequest(request)},
+                                    {"files", detail::encodeFiles(files)}},
+                                   token, nullptr, progress ? &progress : nullptr)) {
+            return detail::decodeResponse(*reply);
+        }
+        
+        std::error_code ec;
+        uint64_t source_bytes = std::filesystem::file_size(files.source_path, ec);
+        if (ec) {
+            response.error_message = "Cannot read " + files.source_path + ": " + ec.message();
+            return response;
+        }
+        // Only Xeno Cloud accepts uploads, so that is where routing sends them
+        if (provider == AIProvider::Auto) {
+            provider = AIProvider::XenoCloud;
+        }
+        if (provider != AIProvider::XenoCloud) {
+            response.error_message = std::string(spec.name) + " is not supported by " + providerName(provider);
+            return response;
+        }
+        
+        auto reservation = wallet->reserveCredits(spec.base_credits);
+        if (!reservation) {
+            response.error_message = "Insufficient credits";
+            return response;
+        }
+        
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        std::string error;
+        if (config && pool) {
+            detail::MediaTransfer::Options options;
+            options.chunk_size = files.chunk_size;
+            options.parallel_chunks = std::min(files.parallel_chunks, config->max_connections);
+            detail::MediaTransfer transfer(*pool, config->headers, options, token);
+            
+            std::string transfer_id = files.transfer_id;
+            bool uploaded = transfer.upload(files.source_path, transfer_id, progress, error);
+            if (!uploaded) {
+                if (token && token->isCancelled()) {
+                    response = cancelledResponse();
+                } else {
+                    response.error_message = error;
+                }
+                if (!transfer_id.empty()) {
+                    response.metadata["transfer_id"] = transfer_id;
+                }
+                return response;
+            }
+            
+            // The job refers to the upload instead of carrying the media
+            auto call = buildProviderCall(provider, spec, request, *config, false);
+            call->payload["transfer_id"] = transfer_id;
+            if (!files.result_path.empty()) {
+                call->payload["result_delivery"] = "download";
+            }
+            AIResponse job = postJSON(provider, *pool, *config, call->path, call->payload, token);
+            job.metadata["transfer_id"] = transfer_id;
+            if (!job.success) {
+                return job;
+            }
+            
+            auto body = nlohmann::json::parse(job.content, nullptr, false);
+            if (body.is_discarded()) {
+                job.success = false;
+                job.content.clear();
+                job.error_message = std::string("Malformed response from ") + providerName(provider);
+                return job;
+            }
+            response.metadata = std::move(job.metadata);
+            
+            if (!files.result_path.empty() && body.contains("result_url") && body["result_url"].is_string()) {
+                if (!transfer.download(body["result_url"].get<std::string>(), files.result_path, progress, error)) {
+                    response.error_message = error;
+                    return token && token->isCancelled() ? cancelledResponse() : response;
+                }
+            } else {
+                response.content = extractContent(provider, body);
+                if (!files.result_path.empty() && !writeResultFile(files.result_path, response.content, error)) {
+                    response.error_message = error;
+                    return response;
+                }
+            }
+        } else {
+            // Unconfigured providers run in offline demo mode
+            response.content = spec.placeholder;
+            if (progress) {
+                progress(source_bytes, source_bytes);
+            }
+            if (!files.result_path.empty() && !writeResultFile(files.result_path, response.content, error)) {
+                response.error_message = error;
+                return response;
+            }
+        }
+        
+        response.success = true;
+        response.credits_used = spec.base_credits;
+        response.metadata["operation"] = spec.name;
+        response.metadata["source_bytes"] = source_bytes;
+        if (!files.result_path.empty()) {
+            response.metadata["result_path"] = files.result_path;
+        }
+        if (!request.operation_type.empty()) {
+            response.metadata["operation_type"] = request.operation_type;
+        }
+        
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        reservation.commit(spec.name, response.credits_used);
+        return response;
+    }
+    
+    AIResponse warmUp(AIProvider provider, const std::string& model, CancellationToken* token) {
+        AIResponse response;
+        if (token && token->isCancelled()) {
+            return cancelledResponse();
+        }
+        // The broker's model is the one later requests will use
+        if (auto reply = viaBroker({{"type", "warm_up"}, {"provider", static_cast<int>(provider)}, {"model", model}},
+                                   token)) {
+            return detail::decodeResponse(*reply);
+        }
+        // Whichever provider routing picks later, only a local one has a model to load
+        if (provider == AIProvider::Auto) {
+            provider = AIProvider::Ollama;
+        }
+        auto config = configFor(provider);
+        auto pool = poolFor(provider);
+        if (provider != AIProvider::Ollama || !config || !pool) {
+            response.success = true;
+            response.metadata["warmed"] = false;
+            return response;
+        }
+        
+        // A generate request without a prompt only loads the model, and returns once it is resident
+        nlohmann::json payload = {{"model", ollamaModel(model, *config)}, {"stream", false}};
+        if (!config->keep_alive.empty()) {
+            payload["keep_alive"] = keepAliveValue(config->keep_alive);
+        }
+        auto start = std::chrono::steady_clock::now();
+        response = postJSON(provider, *pool, *config, "/api/generate", payload, token);
+        response.content.clear();
+        response.metadata["warmed"] = response.success;
+        response.metadata["model"] = payload["model"];
+        response.metadata["elapsed_ms"] = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return response;
+    }
+    
+    AITask runOperationAsync(const OperationSpec& spec, const AIRequest& request, AIProvider provider,
+                             CompletionCallback on_complete, StreamCallback on_chunk = nullptr) {
+        return submit([this, &spec, request, provider, on_chunk = std::move(on_chunk)](CancellationToken* token) {
+            return runOperation(spec, request, provider, token, on_chunk ? &on_chunk : nullptr);
+        }, std::move(on_complete));
+    }
+    
+    // The task resolves to a summary: success when every item succeeded, with the credits they used.
+    // on_complete gets the responses themselves, even when the batch is cancelled before it starts.
+    AITask runBatchAsync(const OperationSpec& spec, const std::vector<AIRequest>& requests, AIProvider provider,
+                         BatchCallback on_complete) {
+        auto responses = std::make_shared<std::vector<AIResponse>>();
+        return submit([this, &spec, requests, provider, responses](CancellationToken* token) {
+            *responses = runBatch(spec, requests, provider, token);
+            AIResponse summary;
+            summary.success = true;
+            for (const auto& response : *responses) {
+                summary.success = summary.success && response.success;
+                summary.credits_used += response.credits_used;
+                if (!response.success && summary.error_message.empty()) {
+                    summary.error_message = response.error_message;
+                }
+            }
+            summary.metadata["batch_size"] = responses->size();
+            if (token->isCancelled()) {
+                summary.metadata["cancelled"] = true;
+            }
+            return summary;
+        }, [responses, count = requests.size(), on_complete = std::move(on_complete)](const AIResponse& summary) {
+            if (responses->empty()) {
+                responses->assign(count, summary);
+            }
+            if (on_complete) {
+                on_complete(*responses);
+            }
+        });
+    }
 };
 
-class CreditWallet::Impl {
-public:
-    std::string user_token;
-    std::string xeno_labs_endpoint = "https://api.xenolabs.ai";
-    int cached_balance = 0;
-    std::vector<Transaction> transactions;
-};
+// CancellationToken implementation
+void CancellationToken::cancel() {
+    cancelled.store(true, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    if (cancel_handler) {
+        cancel_handler();
+    }
+}
+
+void CancellationToken::setCancelHandler(std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    cancel_handler = std::move(handler);
+    if (isCancelled() && cancel_handler) {
+        cancel_handler();
+    }
+}
+
+void CancellationToken::clearCancelHandler() {
+    std::lock_guard<std::mutex> lock(handler_mutex);
+    cancel_handler = nullptr;
+}
+
+// AITask implementation
+void AIIntegration::AITask::cancel() const {
+    if (token) {
+        token->cancel();
+    }
+}
+
+bool AIIntegration::AITask::isReady() const {
+    return result.valid() &&
+           result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+AIIntegration::AIResponse AIIntegration::AITask::get() const {
+    return result.get();
+}
 
 // AIIntegration implementation
 AIIntegration::AIIntegration() : pImpl(std::make_unique<Impl>()) {}
-AIIntegration::~AIIntegration() = default;
+
+AIIntegration::~AIIntegration() {
+    if (pImpl->config_listener != 0) {
+        utils::ConfigManager::getInstance().unsubscribe(pImpl->config_listener);
+    }
+    // Cancel and drain in-flight requests while the state they use is still alive
+    pImpl->shutdown();
+}
 
 bool AIIntegration::configure(AIProvider provider, const APIConfig& config) {
-    pImpl->configs[provider] = config;
+    pImpl->setConfig(provider, config);
     return true;
 }
 
+void AIIntegration::setRoutingPolicy(const RoutingPolicy& policy) {
+    pImpl->setRoutingPolicy(policy);
+}
+
+bool AIIntegration::connectToBroker(const std::string& address) {
+    std::string error;
+    std::shared_ptr<detail::BrokerClient> client = detail::BrokerClient::connect(address, error);
+    if (!client) {
+        return false;
+    }
+    auto hello = client->call({{"type", "hello"}});
+    if (!hello || !hello->is_object() || hello->value("protocol", 0) != detail::kBrokerProtocol) {
+        utils::Logger::getInstance().warning("AI broker at ", address,
+                                             " speaks another protocol version; running on our own");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(pImpl->broker_mutex);
+    pImpl->broker = std::move(client);
+    return true;
+}
+
+bool AIIntegration::isUsingBroker() {
+    return pImpl->brokerClient() != nullptr;
+}
+
 bool AIIntegration::loadConfigFromFile(const std::string& config_path) {
+    auto& store = utils::ConfigManager::getInstance();
+    if (!store.loadConfig(config_path)) {
+        return false;
+    }
+    {
+        // Behind a broker the providers, cache and wallet are the broker's, so an app starts
+        // without opening connections, probing providers or reading the journal
+        std::lock_guard<std::mutex> lock(pImpl->broker_mutex);
+        if (pImpl->broker && pImpl->broker->isConnected()) {
+            pImpl->deferred_config = [this, config_path]() { applyLoadedConfig(config_path); };
+            return true;
+        }
+    }
+    return applyLoadedConfig(config_path);
+}
+
+bool AIIntegration::applyLoadedConfig(const std::string& config_path) {
+    auto& store = utils::ConfigManager::getInstance();
+    if (!applyConfig(store.snapshot()->document(), config_path, true)) {
+        return false;
+    }
+    
+    // With ConfigManager::watch() on, edits to the file retune providers, routing and the cache
+    // in place. The account is only read at startup.
+    std::call_once(pImpl->listener_once, [&]() {
+        pImpl->config_listener = store.subscribe([this](const utils::ConfigManager::Snapshot& snapshot) {
+            applyConfig(snapshot.document(), snapshot.sourcePath(), false);
+        });
+    });
+    return true;
+}
+
+bool AIIntegration::applyConfig(const nlohmann::json& document, const std::string& config_path, bool initial) {
+    std::lock_guard<std::mutex> lock(pImpl->applied_mutex);
+    // Reloads follow the file this instance loaded last
+    if (!initial && config_path != pImpl->config_source) {
+        return false;
+    }
     try {
-        std::ifstream file(config_path);
-        if (!file.is_open()) {
-            return false;
+        // A copy, since a missing key reads as null here where the document would assert
+        nlohmann::json config = document;
+        auto changed = [&](const char* section) {
+            return config.contains(section) &&
+                   (initial || !pImpl->applied_config.contains(section) ||
+                    pImpl->applied_config[section] != config[section]);
+        };
+        // A section deleted from the file takes its settings back to the defaults
+        auto removed = [&](const char* section) {
+            return !initial && !config.contains(section) && pImpl->applied_config.contains(section);
+        };
+        for (auto [section, provider] : {std::pair{"xeno_ai", AIProvider::XenoCloud},
+                                         std::pair{"open_router", AIProvider::OpenRouter},
+                                         std::pair{"ollama", AIProvider::Ollama}}) {
+            if (removed(section)) {
+                pImpl->clearConfig(provider);
+            }
+        }
+        if (removed("routing")) {
+            setRoutingPolicy(RoutingPolicy());
+        }
+        if (removed("cache")) {
+            configureCache(CacheConfig());
         }
         
-        nlohmann::json config;
-        file >> config;
+        // Optional connection tuning shared by every provider section
+        auto applyConnectionSettings = [](const nlohmann::json& section, APIConfig& api_config) {
+            api_config.default_model = section.value("model", api_config.default_model);
+            api_config.max_connections = section.value("max_connections", api_config.max_connections);
+            api_config.idle_timeout_seconds = section.value("idle_timeout_seconds", api_config.idle_timeout_seconds);
+            api_config.timeout_seconds = section.value("timeout_seconds", api_config.timeout_seconds);
+        };
         
         // Configure Xeno AI
-        if (config.contains("xeno_ai")) {
+        if (changed("xeno_ai")) {
             APIConfig xeno_config;
             xeno_config.endpoint = config["xeno_ai"]["endpoint"];
             xeno_config.api_key = config["xeno_ai"]["api_key"];
             xeno_config.headers["Authorization"] = "Bearer " + xeno_config.api_key;
+            applyConnectionSettings(config["xeno_ai"], xeno_config);
             configure(AIProvider::XenoCloud, xeno_config);
         }
         
         // Configure Open Router
-        if (config.contains("open_router")) {
+        if (changed("open_router")) {
             APIConfig router_config;
             router_config.endpoint = config["open_router"]["endpoint"];
             router_config.api_key = config["open_router"]["api_key"];
             router_config.headers["Authorization"] = "Bearer " + router_config.api_key;
+            applyConnectionSettings(config["open_router"], router_config);
             configure(AIProvider::OpenRouter, router_config);
         }
         
         // Configure Ollama
-        if (config.contains("ollama")) {
+        if (changed("ollama")) {
             APIConfig ollama_config;
             ollama_config.endpoint = config["ollama"]["endpoint"];
+            // Accepts "30m" or a number of seconds, kept as text either way
+            if (config["ollama"].contains("keep_alive")) {
+                const auto& keep_alive = config["ollama"]["keep_alive"];
+                ollama_config.keep_alive = keep_alive.is_string() ? keep_alive.get<std::string>() : keep_alive.dump();
+            }
+            applyConnectionSettings(config["ollama"], ollama_config);
             configure(AIProvider::Ollama, ollama_config);
         }
         
+        // Xeno Labs account: deductions are synced to the server in the background
+        if (initial && config.contains("xeno_labs")) {
+            const auto& section = config["xeno_labs"];
+            std::string user_token = section.value("user_token", std::string());
+            pImpl->wallet->authenticate(user_token);
+            
+            // Transaction history is kept next to the config unless a path is given
+            std::string default_journal =
+                (std::filesystem::path(config_path).parent_path() / "transactions.journal").string();
+            std::string journal_path = section.value("journal", default_journal);
+            if (!pImpl->wallet->openJournal(journal_path)) {
+                utils::Logger::getInstance().warning("Transaction journal unavailable, keeping history in memory: ",
+                                                     journal_path);
+            }
+            if (!user_token.empty()) {
+                CreditWallet::SyncOptions sync_options;
+                sync_options.endpoint = section.value("endpoint", sync_options.endpoint);
+                sync_options.interval = std::chrono::milliseconds(
+                    section.value("sync_interval_ms", static_cast<int>(sync_options.interval.count())));
+                pImpl->wallet->startSync(sync_options);
+            }
+        }
+        
+        // Optional routing policy for requests sent to AIProvider::Auto
+        if (changed("routing")) {
+            const auto& section = config["routing"];
+            RoutingPolicy policy;
+            auto providerList = [](const nlohmann::json& names) {
+                std::vector<AIProvider> providers;
+                for (const auto& name : names) {
+                    if (auto provider = providerFromConfigName(name.get<std::string>())) {
+                        providers.push_back(*provider);
+                    }
+                }
+                return providers;
+            };
+            if (section.contains("preference")) {
+                policy.preference = providerList(section["preference"]);
+            }
+            if (section.contains("by_operation")) {
+                for (const auto& [operation, names] : section["by_operation"].items()) {
+                    policy.by_operation[operation] = providerList(names);
+                }
+            }
+            policy.spend_credits = section.value("spend_credits", policy.spend_credits);
+            policy.min_credit_balance = section.value("min_credit_balance", policy.min_credit_balance);
+            policy.ms_per_credit = section.value("ms_per_credit", policy.ms_per_credit);
+            policy.max_error_rate = section.value("max_error_rate", policy.max_error_rate);
+            policy.min_samples = section.value("min_samples", policy.min_samples);
+            policy.hedge = section.value("hedge", policy.hedge);
+            policy.min_hedge_samples = section.value("min_hedge_samples", policy.min_hedge_samples);
+            policy.health_interval_seconds = section.value("health_interval_seconds", policy.health_interval_seconds);
+            setRoutingPolicy(policy);
+        }
+        
+        // Optional response cache tuning
+        if (changed("cache")) {
+            const auto& section = config["cache"];
+            CacheConfig cache_config;
+            cache_config.enabled = section.value("enabled", cache_config.enabled);
+            cache_config.memory_entries = section.value("memory_entries", cache_config.memory_entries);
+            cache_config.directory = section.value("directory", cache_config.directory);
+            cache_config.disk_bytes = section.value("disk_bytes", cache_config.disk_bytes);
+            if (section.contains("ttl_seconds")) {
+                cache_config.ttl_seconds = section["ttl_seconds"].get<std::map<std::string, int>>();
+            }
+            configureCache(cache_config);
+        }
+        
+        pImpl->applied_config = std::move(config);
+        pImpl->config_source = config_path;
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error loading config: " << e.what() << std::endl;
+        utils::Logger::getInstance().error("Error loading config: ", e.what());
         return false;
     }
 }
 
+void AIIntegration::configureCache(const CacheConfig& config) {
+    std::lock_guard<std::mutex> lock(pImpl->cache_mutex);
+    pImpl->cache_config = config;
+    pImpl->cache.reset(); // Rebuilt with the new settings on next use
+}
+
+void AIIntegration::clearCache() {
+    if (pImpl->viaBroker({{"type", "clear_cache"}})) {
+        return;
+    }
+    if (auto cache = pImpl->responseCache()) {
+        cache->clear();
+    }
+}
+
 int AIIntegration::getCreditBalance() {
+    if (auto reply = pImpl->viaBroker({{"type", "balance"}}); reply && reply->is_number_integer()) {
+        return reply->get<int>();
+    }
     return pImpl->wallet->getBalance();
 }
 
 bool AIIntegration::deductCredits(int amount) {
+    if (auto reply = pImpl->viaBroker({{"type", "deduct"}, {"amount", amount}}); reply && reply->is_boolean()) {
+        return reply->get<bool>();
+    }
     return pImpl->wallet->deductCredits(amount, "api_call");
 }
 
@@ -86,205 +1797,195 @@ bool AIIntegration::validateCredits(int required_credits) {
 }
 
 AIIntegration::AIResponse AIIntegration::generateImage(const AIRequest& request, AIProvider provider) {
-    AIResponse response;
-    
-    // Check credits for Xeno Cloud
-    if (provider == AIProvider::XenoCloud) {
-        int required_credits = 3; // Base cost for image generation
-        if (!validateCredits(required_credits)) {
-            response.success = false;
-            response.error_message = "Insufficient credits";
-            return response;
-        }
-    }
-    
-    // Simulate API call for now
-    response.success = true;
-    response.content = "Generated image data (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 3 : 0;
-    
-    if (provider == AIProvider::XenoCloud) {
-        deductCredits(response.credits_used);
-    }
-    
-    return response;
+    return pImpl->runOperation(kImageGeneration, request, provider, nullptr);
 }
 
 AIIntegration::AIResponse AIIntegration::processVideo(const AIRequest& request, AIProvider provider) {
-    AIResponse response;
-    
-    if (provider == AIProvider::XenoCloud) {
-        int required_credits = 5; // Base cost for video processing
-        if (!validateCredits(required_credits)) {
-            response.success = false;
-            response.error_message = "Insufficient credits";
-            return response;
-        }
-    }
-    
-    response.success = true;
-    response.content = "Processed video data (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 5 : 0;
-    
-    if (provider == AIProvider::XenoCloud) {
-        deductCredits(response.credits_used);
-    }
-    
-    return response;
+    return pImpl->runOperation(kVideoProcessing, request, provider, nullptr);
 }
 
 AIIntegration::AIResponse AIIntegration::processAudio(const AIRequest& request, AIProvider provider) {
-    AIResponse response;
-    
-    if (provider == AIProvider::XenoCloud) {
-        int required_credits = 2; // Base cost for audio processing
-        if (!validateCredits(required_credits)) {
-            response.success = false;
-            response.error_message = "Insufficient credits";
-            return response;
-        }
-    }
-    
-    response.success = true;
-    response.content = "Processed audio data (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 2 : 0;
-    
-    if (provider == AIProvider::XenoCloud) {
-        deductCredits(response.credits_used);
-    }
-    
-    return response;
+    return pImpl->runOperation(kAudioProcessing, request, provider, nullptr);
+}
+
+AIIntegration::AIResponse AIIntegration::processAudioFile(const AIRequest& request, const MediaFiles& files,
+                                                         TransferProgress progress, AIProvider provider) {
+    return pImpl->runMediaOperation(kAudioProcessing, request, files, provider, nullptr, progress);
+}
+
+AIIntegration::AIResponse AIIntegration::processVideoFile(const AIRequest& request, const MediaFiles& files,
+                                                         TransferProgress progress, AIProvider provider) {
+    return pImpl->runMediaOperation(kVideoProcessing, request, files, provider, nullptr, progress);
+}
+
+AIIntegration::AITask AIIntegration::processAudioFileAsync(const AIRequest& request, const MediaFiles& files,
+                                                           TransferProgress progress, AIProvider provider,
+                                                           CompletionCallback on_complete) {
+    return pImpl->submit([this, request, files, progress = std::move(progress), provider](CancellationToken* token) {
+        return pImpl->runMediaOperation(kAudioProcessing, request, files, provider, token, progress);
+    }, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::processVideoFileAsync(const AIRequest& request, const MediaFiles& files,
+                                                           TransferProgress progress, AIProvider provider,
+                                                           CompletionCallback on_complete) {
+    return pImpl->submit([this, request, files, progress = std::move(progress), provider](CancellationToken* token) {
+        return pImpl->runMediaOperation(kVideoProcessing, request, files, provider, token, progress);
+    }, std::move(on_complete));
 }
 
 AIIntegration::AIResponse AIIntegration::completeCode(const AIRequest& request, AIProvider provider) {
-    AIResponse response;
-    
-    if (provider == AIProvider::XenoCloud) {
-        int required_credits = 1; // Base cost for code completion
-        if (!validateCredits(required_credits)) {
-            response.success = false;
-            response.error_message = "Insufficient credits";
-            return response;
-        }
-    }
-    
-    response.success = true;
-    response.content = "Code completion suggestion (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 1 : 0;
-    
-    if (provider == AIProvider::XenoCloud) {
-        deductCredits(response.credits_used);
-    }
-    
-    return response;
+    return pImpl->runOperation(kCodeCompletion, request, provider, nullptr);
 }
 
 AIIntegration::AIResponse AIIntegration::chatCompletion(const AIRequest& request, AIProvider provider) {
-    AIResponse response;
-    
-    if (provider == AIProvider::XenoCloud) {
-        int required_credits = 1;
-        if (!validateCredits(required_credits)) {
-            response.success = false;
-            response.error_message = "Insufficient credits";
-            return response;
-        }
-    }
-    
-    response.success = true;
-    response.content = "Chat response (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 1 : 0;
-    
-    if (provider == AIProvider::XenoCloud) {
-        deductCredits(response.credits_used);
-    }
-    
-    return response;
+    return pImpl->runOperation(kChatCompletion, request, provider, nullptr);
 }
 
-AIIntegration::AIResponse AIIntegration::makeAPICall(AIProvider provider, const std::string& endpoint, 
-                                                   const nlohmann::json& payload) {
-    AIResponse response;
-    
-    // For now, return a placeholder response
-    // In production, this would make actual HTTP calls using httplib
-    response.success = true;
-    response.content = "API response (placeholder)";
-    response.credits_used = provider == AIProvider::XenoCloud ? 1 : 0;
-    
-    return response;
+AIIntegration::AIResponse AIIntegration::completeCodeStream(const AIRequest& request, StreamCallback on_chunk,
+                                                           AIProvider provider) {
+    return pImpl->runOperation(kCodeCompletion, request, provider, nullptr, on_chunk ? &on_chunk : nullptr);
 }
 
-bool AIIntegration::isProviderAvailable(AIProvider provider) {
-    return pImpl->configs.find(provider) != pImpl->configs.end();
+AIIntegration::AIResponse AIIntegration::chatCompletionStream(const AIRequest& request, StreamCallback on_chunk,
+                                                             AIProvider provider) {
+    return pImpl->runOperation(kChatCompletion, request, provider, nullptr, on_chunk ? &on_chunk : nullptr);
 }
 
-std::string AIIntegration::getProviderStatus(AIProvider provider) {
-    if (!isProviderAvailable(provider)) {
-        return "Not configured";
-    }
-    return "Available";
+AIIntegration::AITask AIIntegration::completeCodeStreamAsync(const AIRequest& request, StreamCallback on_chunk,
+                                                             AIProvider provider, CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kCodeCompletion, request, provider, std::move(on_complete), std::move(on_chunk));
 }
 
-// CreditWallet implementation
-CreditWallet::CreditWallet() : pImpl(std::make_unique<Impl>()) {
-    // Initialize with some demo credits
-    pImpl->cached_balance = 100;
+AIIntegration::AITask AIIntegration::chatCompletionStreamAsync(const AIRequest& request, StreamCallback on_chunk,
+                                                               AIProvider provider, CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kChatCompletion, request, provider, std::move(on_complete), std::move(on_chunk));
 }
 
-CreditWallet::~CreditWallet() = default;
+std::vector<AIIntegration::AIResponse> AIIntegration::completeCodeBatch(const std::vector<AIRequest>& requests,
+                                                                       AIProvider provider) {
+    return pImpl->runBatch(kCodeCompletion, requests, provider);
+}
 
-bool CreditWallet::authenticate(const std::string& user_token) {
-    pImpl->user_token = user_token;
-    return !user_token.empty();
+AIIntegration::AITask AIIntegration::completeCodeBatchAsync(const std::vector<AIRequest>& requests,
+                                                            AIProvider provider, BatchCallback on_complete) {
+    return pImpl->runBatchAsync(kCodeCompletion, requests, provider, std::move(on_complete));
 }
 
-int CreditWallet::getBalance() {
-    // In production, this would make an API call to Xeno Labs
-    return pImpl->cached_balance;
+std::vector<AIIntegration::AIResponse> AIIntegration::generateImageBatch(const std::vector<AIRequest>& requests,
+                                                                        AIProvider provider) {
+    return pImpl->runBatch(kImageGeneration, requests, provider);
 }
 
-bool CreditWallet::deductCredits(int amount, const std::string& operation) {
-    if (pImpl->cached_balance >= amount) {
-        pImpl->cached_balance -= amount;
-        
-        // Log transaction
-        Transaction transaction;
-        transaction.id = "tx_" + std::to_string(pImpl->transactions.size() + 1);
-        transaction.operation = operation;
-        transaction.credits = -amount;
-        transaction.timestamp = "2024-01-01T00:00:00Z"; // Placeholder
-        transaction.success = true;
-        pImpl->transactions.push_back(transaction);
-        
-        return true;
+AIIntegration::AITask AIIntegration::generateImageBatchAsync(const std::vector<AIRequest>& requests,
+                                                             AIProvider provider, BatchCallback on_complete) {
+    return pImpl->runBatchAsync(kImageGeneration, requests, provider, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::generateImageAsync(const AIRequest& request, AIProvider provider,
+                                                        CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kImageGeneration, request, provider, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::processVideoAsync(const AIRequest& request, AIProvider provider,
+                                                       CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kVideoProcessing, request, provider, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::processAudioAsync(const AIRequest& request, AIProvider provider,
+                                                       CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kAudioProcessing, request, provider, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::completeCodeAsync(const AIRequest& request, AIProvider provider,
+                                                       CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kCodeCompletion, request, provider, std::move(on_complete));
+}
+
+AIIntegration::AITask AIIntegration::chatCompletionAsync(const AIRequest& request, AIProvider provider,
+                                                         CompletionCallback on_complete) {
+    return pImpl->runOperationAsync(kChatCompletion, request, provider, std::move(on_complete));
+}
+
+AIIntegration::AIResponse AIIntegration::makeAPICall(AIProvider provider, const std::string& endpoint,
+                                                   const nlohmann::json& payload) {
+    return pImpl->callProvider(provider, endpoint, payload, nullptr);
+}
+
+AIIntegration::AITask AIIntegration::makeAPICallAsync(AIProvider provider, const std::string& endpoint,
+                                                      const nlohmann::json& payload, CompletionCallback on_complete) {
+    return pImpl->submit([this, provider, endpoint, payload](CancellationToken* token) {
+        return pImpl->callProvider(provider, endpoint, payload, token);
+    }, std::move(on_complete));
+}
+
+AIIntegration::AIResponse AIIntegration::warmUp(AIProvider provider, const std::string& model) {
+    return pImpl->warmUp(provider, model, nullptr);
+}
+
+AIIntegration::AITask AIIntegration::warmUpAsync(AIProvider provider, const std::string& model,
+                                                 CompletionCallback on_complete) {
+    return pImpl->submit([this, provider, model](CancellationToken* token) {
+        return pImpl->warmUp(provider, model, token);
+    }, std::move(on_complete));
+}
+
+bool AIIntegration::isProviderAvailable(AIProvider provider) {
+    if (auto reply = pImpl->viaBroker({{"type", "available"}, {"provider", static_cast<int>(provider)}});
+        reply && reply->is_boolean()) {
+        return reply->get<bool>();
+    }
+    if (provider == AIProvider::Auto) {
+        return isProviderAvailable(AIProvider::XenoCloud) || isProviderAvailable(AIProvider::OpenRouter) ||
+               isProviderAvailable(AIProvider::Ollama);
     }
-    return false;
+    return pImpl->configFor(provider).has_value() && pImpl->router.isHealthy(provider);
 }
 
-bool CreditWallet::addCredits(int amount) {
-    pImpl->cached_balance += amount;
-    
-    Transaction transaction;
-    transaction.id = "tx_" + std::to_string(pImpl->transactions.size() + 1);
-    transaction.operation = "credit_purchase";
-    transaction.credits = amount;
-    transaction.timestamp = "2024-01-01T00:00:00Z"; // Placeholder
-    transaction.success = true;
-    pImpl->transactions.push_back(transaction);
+std::string AIIntegration::getProviderStatus(AIProvider provider) {
+    if (auto reply = pImpl->viaBroker({{"type", "status"}, {"provider", static_cast<int>(provider)}});
+        reply && reply->is_string()) {
+        return reply->get<std::string>();
+    }
+    if (provider == AIProvider::Auto) {
+        return isProviderAvailable(provider) ? "Routing between configured providers" : "No provider available";
+    }
+    if (!pImpl->configFor(provider)) {
+        return "Not configured";
+    }
+    if (!pImpl->router.isHealthy(provider)) {
+        return "Unreachable";
+    }
     
-    return true;
+    // e.g. "Available; code_completion p50 180 ms, p99 900 ms, 2% errors"
+    std::string status = "Available";
+    for (const auto& operation : pImpl->router.operations(provider)) {
+        auto stats = pImpl->router.stats(provider, operation);
+        if (stats.requests == 0) {
+            continue;
+        }
+        status += "; " + operation + " p50 " + std::to_string(std::lround(stats.p50_ms)) + " ms, p99 " +
+                  std::to_string(std::lround(stats.p99_ms)) + " ms, " +
+                  std::to_string(std::lround(stats.error_rate * 100)) + "% errors";
+    }
+    return status;
 }
 
-std::vector<CreditWallet::Transaction> CreditWallet::getTransactionHistory(int limit) {
-    std::vector<Transaction> result;
-    int count = std::min(limit, static_cast<int>(pImpl->transactions.size()));
-    
-    for (int i = pImpl->transactions.size() - count; i < static_cast<int>(pImpl->transactions.size()); i++) {
-        result.push_back(pImpl->transactions[i]);
+AIIntegration::ProviderStats AIIntegration::getProviderStats(AIProvider provider, const std::string& operation) {
+    if (auto reply = pImpl->viaBroker({{"type", "stats"}, {"provider", static_cast<int>(provider)},
+                                       {"operation", operation}});
+        reply && reply->is_object()) {
+        ProviderStats stats;
+        stats.p50_ms = reply->value("p50_ms", 0.0);
+        stats.p95_ms = reply->value("p95_ms", 0.0);
+        stats.p99_ms = reply->value("p99_ms", 0.0);
+        stats.error_rate = reply->value("error_rate", 0.0);
+        stats.samples = reply->value("samples", size_t{0});
+        stats.requests = reply->value("requests", size_t{0});
+        stats.healthy = reply->value("healthy", true);
+        return stats;
     }
-    
-    return result;
+    return pImpl->router.stats(provider, operation);
 }
 
-} // namespace xeno::ai
\ No newline at end of file
+} // namespace xeno::ai
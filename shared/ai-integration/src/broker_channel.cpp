@@ -0,0 +1,503 @@
+#include "broker_channel.h"
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <afunix.h>
+    #include <windows.h>
+    #include <system_error>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace xeno::ai::detail {
+
+namespace {
+
+#ifdef _WIN32
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+constexpr int kSendFlags = 0;
+constexpr const char* kSegmentPrefix = "Local\\xeno-ai-";
+
+std::string lastSocketError() {
+    return std::system_category().message(WSAGetLastError());
+}
+
+void closeSocket(SocketHandle socket) {
+    closesocket(socket);
+}
+
+std::wstring wideName(const std::string& name) {
+    return std::wstring(name.begin(), name.end());
+}
+#else
+constexpr SocketHandle kInvalidSocket = -1;
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;  // SO_NOSIGPIPE is set on the socket instead
+#endif
+// macOS keeps shared-memory names under 32 characters
+constexpr const char* kSegmentPrefix = "/xeno-ai-";
+
+std::string lastSocketError() {
+    return std::strerror(errno);
+}
+
+void closeSocket(SocketHandle socket) {
+    ::close(socket);
+}
+#endif
+
+uint32_t processId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+#ifndef _WIN32
+// Children started with QProcess must not inherit the socket, and a peer that goes away
+// must not raise SIGPIPE
+void configureSocket(SocketHandle handle) {
+    fcntl(handle, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+#endif
+
+// Opens a stream socket of the Unix-domain family, ready for use by this process only
+SocketHandle openSocket() {
+#ifdef _WIN32
+    // Windows 10 1803 and later speak AF_UNIX once Winsock is started
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    if (!started) {
+        return kInvalidSocket;
+    }
+    return ::socket(AF_UNIX, SOCK_STREAM, 0);
+#else
+    SocketHandle handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (handle != kInvalidSocket) {
+        configureSocket(handle);
+    }
+    return handle;
+#endif
+}
+
+bool addressFor(const std::string& path, sockaddr_un& address, std::string& error) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Broker socket path must be 1 to " + std::to_string(sizeof(address.sun_path) - 1) +
+                " bytes long: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+struct BrokerChannel::Segment {
+    std::string name;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+    
+    ~Segment() {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+    }
+#else
+    ~Segment() {
+        if (!name.empty()) {
+            shm_unlink(name.c_str());
+        }
+    }
+#endif
+};
+
+BrokerChannel::BrokerChannel(SocketHandle socket) : socket(socket) {}
+
+BrokerChannel::~BrokerChannel() {
+    close();
+    closeSocket(socket);
+}
+
+std::unique_ptr<BrokerChannel> BrokerChannel::connect(const std::string& address, std::string& error) {
+    sockaddr_un socket_address;
+    if (!addressFor(address, socket_address, error)) {
+        return nullptr;
+    }
+    SocketHandle handle = openSocket();
+    if (handle == kInvalidSocket) {
+        error = "Cannot create a socket: " + lastSocketError();
+        return nullptr;
+    }
+    if (::connect(handle, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) != 0) {
+        error = "Cannot connect to " + address + ": " + lastSocketError();
+        closeSocket(handle);
+        return nullptr;
+    }
+    return std::make_unique<BrokerChannel>(handle);
+}
+
+bool BrokerChannel::send(const nlohmann::json& message) {
+    if (closed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::vector<uint8_t> bytes = nlohmann::json::to_msgpack(message);
+    if (bytes.size() <= kInlineLimit) {
+        return writeFrame(bytes);
+    }
+    
+    // Too large for the socket: the peer maps it from a segment this side owns until released
+    static std::atomic<uint64_t> next_segment{1};
+    auto segment = std::make_unique<Segment>();
+    segment->name = kSegmentPrefix + std::to_string(processId()) + "-" +
+                    std::to_string(next_segment.fetch_add(1, std::memory_order_relaxed));
+#ifdef _WIN32
+    uint64_t size = bytes.size();
+    segment->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                          static_cast<DWORD>(size >> 32), static_cast<DWORD>(size),
+                                          wideName(segment->name).c_str());
+    void* view = segment->mapping ? MapViewOfFile(segment->mapping, FILE_MAP_WRITE, 0, 0, bytes.size()) : nullptr;
+    if (!view) {
+        close();
+        return false;
+    }
+    std::memcpy(view, bytes.data(), bytes.size());
+    UnmapViewOfFile(view);
+#else
+    int descriptor = shm_open(segment->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0) {
+        segment->name.clear();
+        close();
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(bytes.size())) == 0) {
+        view = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    ::close(descriptor);
+    if (view == MAP_FAILED) {
+        close();
+        return false;
+    }
+    std::memcpy(view, bytes.data(), bytes.size());
+    munmap(view, bytes.size());
+#endif
+
+    nlohmann::json reference = {{"$segment", segment->name}, {"size", bytes.size()}};
+    {
+        std::lock_guard<std::mutex> lock(segments_mutex);
+        std::string name = segment->name;
+        segments.emplace(std::move(name), std::move(segment));
+    }
+    return writeFrame(nlohmann::json::to_msgpack(reference));
+}
+
+std::optional<nlohmann::json> BrokerChannel::receive() {
+    while (true) {
+        uint32_t length = 0;
+        if (!readExactly(&length, sizeof(length))) {
+            return std::nullopt;
+        }
+        // Anything larger comes through a segment, so a longer frame means a confused peer
+        if (length > kInlineLimit) {
+            close();
+            return std::nullopt;
+        }
+        std::vector<uint8_t> bytes(length);
+        if (!readExactly(bytes.data(), bytes.size())) {
+            return std::nullopt;
+        }
+        auto message = nlohmann::json::from_msgpack(bytes, true, false);
+        if (message.is_discarded()) {
+            close();
+            return std::nullopt;
+        }
+        if (message.is_object() && message.contains("$release")) {
+            if (message["$release"].is_string()) {
+                releaseSegment(message["$release"].get<std::string>());
+            }
+            continue;
+        }
+        if (message.is_object() && message.contains("$segment")) {
+            auto payload = readSegment(message);
+            if (!payload) {
+                close();
+            }
+            return payload;
+        }
+        return message;
+    }
+}
+
+void BrokerChannel::close() {
+    if (closed.exchange(true)) {
+        return;
+    }
+#ifdef _WIN32
+    ::shutdown(socket, SD_BOTH);
+#else
+    ::shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+size_t BrokerChannel::outstandingSegments() const {
+    std::lock_guard<std::mutex> lock(segments_mutex);
+    return segments.size();
+}
+
+bool BrokerChannel::writeFrame(const std::vector<uint8_t>& bytes) {
+    uint32_t length = static_cast<uint32_t>(bytes.size());
+    std::lock_guard<std::mutex> lock(write_mutex);
+    for (auto [data, remaining] : {std::pair{reinterpret_cast<const char*>(&length), sizeof(length)},
+                                   std::pair{reinterpret_cast<const char*>(bytes.data()), bytes.size()}}) {
+        while (remaining > 0) {
+            auto written = ::send(socket, data, static_cast<int>(remaining), kSendFlags);
+            if (written <= 0) {
+#ifndef _WIN32
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+#endif
+                close();
+                return false;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+    }
+    return true;
+}
+
+bool BrokerChannel::readExactly(void* data, size_t length) {
+    char* out = static_cast<char*>(data);
+    while (length > 0) {
+        auto received = ::recv(socket, out, static_cast<int>(length), 0);
+        if (received <= 0) {
+#ifndef _WIN32
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            close();
+            return false;
+        }
+        out += received;
+        length -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+std::optional<nlohmann::json> BrokerChannel::readSegment(const nlohmann::json& reference) {
+    if (!reference["$segment"].is_string() || !reference.contains("size") || !reference["size"].is_number_unsigned()) {
+        return std::nullopt;
+    }
+    std::string name = reference["$segment"].get<std::string>();
+    size_t size = reference["size"].get<size_t>();
+    // Only segments made by a broker channel are opened
+    if (name.rfind(kSegmentPrefix, 0) != 0) {
+        return std::nullopt;
+    }
+    
+    nlohmann::json message = nlohmann::json::value_t::discarded;
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, wideName(name).c_str());
+    if (!mapping) {
+        return std::nullopt;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (view) {
+        const auto* begin = static_cast<const uint8_t*>(view);
+        message = nlohmann::json::from_msgpack(begin, begin + size, true, false);
+        UnmapViewOfFile(view);
+    }
+    CloseHandle(mapping);
+#else
+    int descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if (descriptor < 0) {
+        return std::nullopt;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && static_cast<uint64_t>(status.st_size) >= size && size > 0) {
+        void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (view != MAP_FAILED) {
+            // Decoded in place, so the payload is copied once, into the message
+            const auto* begin = static_cast<const uint8_t*>(view);
+            message = nlohmann::json::from_msgpack(begin, begin + size, true, false);
+            munmap(view, size);
+        }
+    }
+    ::close(descriptor);
+#endif
+
+    send({{"$release", name}});
+    if (message.is_discarded()) {
+        return std::nullopt;
+    }
+    return message;
+}
+
+void BrokerChannel::releaseSegment(const std::string& name) {
+    std::lock_guard<std::mutex> lock(segments_mutex);
+    segments.erase(name);
+}
+
+BrokerListener::~BrokerListener() {
+    close();
+    if (listening) {
+        closeSocket(socket);
+        std::error_code ec;
+        std::filesystem::remove(socket_path, ec);
+    }
+}
+
+bool BrokerListener::listen(const std::string& address, std::string& error) {
+    sockaddr_un socket_address;
+    if (!addressFor(address, socket_address, error)) {
+        return false;
+    }
+    // A socket file that still answers belongs to a running broker; one that does not was left by a crash
+    std::string probe_error;
+    if (BrokerChannel::connect(address, probe_error)) {
+        error = "Another AI broker is already serving " + address;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(address, ec);
+    
+    socket = openSocket();
+    if (socket == kInvalidSocket) {
+        error = "Cannot create a socket: " + lastSocketError();
+        return false;
+    }
+    if (::bind(socket, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) != 0 ||
+        ::listen(socket, 16) != 0) {
+        error = "Cannot listen on " + address + ": " + lastSocketError();
+        closeSocket(socket);
+        return false;
+    }
+#ifndef _WIN32
+    // Only this user's apps may talk to the broker and spend its credits
+    chmod(address.c_str(), S_IRUSR | S_IWUSR);
+#endif
+    socket_path = address;
+    listening = true;
+    return true;
+}
+
+std::unique_ptr<BrokerChannel> BrokerListener::accept() {
+    while (listening && !closing.load()) {
+        SocketHandle client = ::accept(socket, nullptr, nullptr);
+        if (client == kInvalidSocket) {
+#ifndef _WIN32
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+#endif
+            return nullptr;
+        }
+        if (closing.load()) {
+            closeSocket(client);
+            return nullptr;
+        }
+#ifndef _WIN32
+        configureSocket(client);
+#endif
+        return std::make_unique<BrokerChannel>(client);
+    }
+    return nullptr;
+}
+
+void BrokerListener::close() {
+    if (!listening || closing.exchange(true)) {
+        return;
+    }
+    // accept() does not return on every platform when the socket is shut down, but a connection wakes it
+    std::string error;
+    BrokerChannel::connect(socket_path, error);
+}
+
+nlohmann::json encodeRequest(const AIIntegration::AIRequest& request) {
+    nlohmann::json parameters = nlohmann::json::object();
+    for (const auto& [name, value] : request.parameters) {
+        parameters[name] = value;
+    }
+    return {{"prompt", request.prompt},
+            {"model", request.model},
+            {"parameters", std::move(parameters)},
+            {"operation_type", request.operation_type},
+            {"cacheable", request.cacheable}};
+}
+
+AIIntegration::AIRequest decodeRequest(const nlohmann::json& message) {
+    AIIntegration::AIRequest request;
+    request.prompt = message.value("prompt", std::string());
+    request.model = message.value("model", std::string());
+    request.operation_type = message.value("operation_type", std::string());
+    request.cacheable = message.value("cacheable", true);
+    if (message.contains("parameters") && message["parameters"].is_object()) {
+        for (const auto& [name, value] : message["parameters"].items()) {
+            request.parameters[name] = value;
+        }
+    }
+    return request;
+}
+
+nlohmann::json encodeResponse(const AIIntegration::AIResponse& response) {
+    return {{"success", response.success},
+            {"content", response.content},
+            {"credits_used", response.credits_used},
+            {"error_message", response.error_message},
+            {"metadata", response.metadata}};
+}
+
+AIIntegration::AIResponse decodeResponse(const nlohmann::json& message) {
+    AIIntegration::AIResponse response;
+    if (!message.is_object()) {
+        response.error_message = "Malformed reply from the AI broker";
+        return response;
+    }
+    response.success = message.value("success", false);
+    response.content = message.value("content", std::string());
+    response.credits_used = message.value("credits_used", 0);
+    response.error_message = message.value("error_message", std::string());
+    response.metadata = message.value("metadata", nlohmann::json::object());
+    return response;
+}
+
+nlohmann::json encodeFiles(const AIIntegration::MediaFiles& files) {
+    return {{"source_path", files.source_path},
+            {"result_path", files.result_path},
+            {"transfer_id", files.transfer_id},
+            {"chunk_size", files.chunk_size},
+            {"parallel_chunks", files.parallel_chunks}};
+}
+
+AIIntegration::MediaFiles decodeFiles(const nlohmann::json& message) {
+    AIIntegration::MediaFiles files;
+    files.source_path = message.value("source_path", std::string());
+    files.result_path = message.value("result_path", std::string());
+    files.transfer_id = message.value("transfer_id", std::string());
+    files.chunk_size = message.value("chunk_size", files.chunk_size);
+    files.parallel_chunks = message.value("parallel_chunks", files.parallel_chunks);
+    return files;
+}
+
+} // namespace xeno::ai::detail
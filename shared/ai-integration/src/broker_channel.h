@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ai_integration.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace xeno::ai::detail {
+
+// Bumped whenever a message changes shape; an app and a broker must agree on it
+constexpr int kBrokerProtocol = 1;
+
+#ifdef _WIN32
+using SocketHandle = uintptr_t;
+#else
+using SocketHandle = int;
+#endif
+
+/**
+ * @brief One end of a local connection between a suite app and the AI broker
+ *
+ * Messages are JSON, sent as MessagePack behind a 32-bit length. Control
+ * messages go through the socket itself; one larger than kInlineLimit (an
+ * image, a long file) is written to a shared-memory segment instead, and the
+ * socket carries only the segment's name. The receiver maps the segment,
+ * decodes straight from it and tells the sender to release it. send() may be
+ * called from any thread; receive() belongs to a single reader thread.
+ */
+class BrokerChannel {
+public:
+    static constexpr size_t kInlineLimit = 64 * 1024;
+    
+    explicit BrokerChannel(SocketHandle socket);
+    ~BrokerChannel();
+    
+    BrokerChannel(const BrokerChannel&) = delete;
+    BrokerChannel& operator=(const BrokerChannel&) = delete;
+    
+    // address is the path of a Unix-domain socket; nullptr with error set on failure
+    static std::unique_ptr<BrokerChannel> connect(const std::string& address, std::string& error);
+    
+    // False once the connection is closed
+    bool send(const nlohmann::json& message);
+    // Next message from the peer; nullopt once the connection is closed or the peer misbehaves
+    std::optional<nlohmann::json> receive();
+    // Wakes a blocked receive() and fails later sends; safe from any thread
+    void close();
+    
+    // Large messages sent whose segments the peer has not released yet
+    size_t outstandingSegments() const;
+
+private:
+    struct Segment;
+    
+    bool writeFrame(const std::vector<uint8_t>& bytes);
+    bool readExactly(void* data, size_t length);
+    std::optional<nlohmann::json> readSegment(const nlohmann::json& reference);
+    void releaseSegment(const std::string& name);
+    
+    SocketHandle socket;
+    std::atomic<bool> closed{false};
+    std::mutex write_mutex;
+    mutable std::mutex segments_mutex;
+    std::map<std::string, std::unique_ptr<Segment>> segments;  // Sent, keyed by name
+};
+
+/**
+ * @brief Listening end of the broker socket
+ */
+class BrokerListener {
+public:
+    BrokerListener() = default;
+    ~BrokerListener();
+    
+    BrokerListener(const BrokerListener&) = delete;
+    BrokerListener& operator=(const BrokerListener&) = delete;
+    
+    // Fails if another process is already accepting on address; a stale socket file is replaced
+    bool listen(const std::string& address, std::string& error);
+    // Blocks for the next connection; nullptr once close() is called
+    std::unique_ptr<BrokerChannel> accept();
+    void close();
+
+private:
+    std::string socket_path;
+    SocketHandle socket{};
+    std::atomic<bool> closing{false};
+    bool listening = false;
+};
+
+// Wire forms of the AIIntegration request types
+nlohmann::json encodeRequest(const AIIntegration::AIRequest& request);
+AIIntegration::AIRequest decodeRequest(const nlohmann::json& message);
+nlohmann::json encodeResponse(const AIIntegration::AIResponse& response);
+AIIntegration::AIResponse decodeResponse(const nlohmann::json& message);
+nlohmann::json encodeFiles(const AIIntegration::MediaFiles& files);
+AIIntegration::MediaFiles decodeFiles(const nlohmann::json& message);
+
+} // namespace xeno::ai::detail
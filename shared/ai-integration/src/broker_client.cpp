@@ -0,0 +1,126 @@
+#include "broker_client.h"
+
+namespace xeno::ai::detail {
+
+BrokerClient::BrokerClient(std::unique_ptr<BrokerChannel> channel) : channel(std::move(channel)) {
+    reader = std::thread([this]() { readLoop(); });
+}
+
+BrokerClient::~BrokerClient() {
+    channel->close();
+    reader.join();
+}
+
+std::unique_ptr<BrokerClient> BrokerClient::connect(const std::string& address, std::string& error) {
+    auto channel = BrokerChannel::connect(address, error);
+    if (!channel) {
+        return nullptr;
+    }
+    return std::unique_ptr<BrokerClient>(new BrokerClient(std::move(channel)));
+}
+
+std::optional<nlohmann::json> BrokerClient::call(nlohmann::json message, CancellationToken* token,
+                                                 const AIIntegration::StreamCallback* on_chunk,
+                                                 const AIIntegration::TransferProgress* progress) {
+    int64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    message["id"] = id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!connected.load()) {
+            return std::nullopt;
+        }
+        pending[id];
+    }
+    if (!channel->send(message)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(id);
+        return std::nullopt;
+    }
+    if (token) {
+        token->setCancelHandler([this, id]() { cancel(id); });
+    }
+    
+    // Chunks and progress are handed to the callbacks here, so they run on the caller's thread
+    bool delivered = false;
+    bool stopped = false;
+    std::optional<nlohmann::json> reply;
+    while (true) {
+        std::deque<nlohmann::json> events;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Pending& entry = pending[id];
+            cv.wait(lock, [&]() { return !entry.events.empty() || entry.reply || entry.disconnected; });
+            events.swap(entry.events);
+            if (events.empty()) {
+                reply = std::move(entry.reply);
+                pending.erase(id);
+                break;
+            }
+        }
+        for (const auto& event : events) {
+            if (stopped) {
+                continue;
+            }
+            if (on_chunk && event.contains("chunk") && event["chunk"].is_string()) {
+                delivered = true;
+                if (!(*on_chunk)(event["chunk"].get<std::string>())) {
+                    // The broker ends the generation as a provider would when its stream is dropped
+                    stopped = true;
+                    channel->send({{"type", "stop"}, {"id", id}});
+                }
+            } else if (progress && event.contains("progress") && event["progress"].size() == 2) {
+                delivered = true;
+                if (!(*progress)(event["progress"][0].get<uint64_t>(), event["progress"][1].get<uint64_t>())) {
+                    stopped = true;
+                    cancel(id);
+                }
+            }
+        }
+    }
+    if (token) {
+        token->clearCancelHandler();
+    }
+    
+    if (!reply && delivered) {
+        // Part of the answer already reached the caller, so running the request again would repeat it
+        AIIntegration::AIResponse lost;
+        lost.error_message = "Lost the connection to the AI broker";
+        reply = encodeResponse(lost);
+    }
+    return reply;
+}
+
+void BrokerClient::cancel(int64_t id) {
+    channel->send({{"type", "cancel"}, {"id", id}});
+}
+
+void BrokerClient::readLoop() {
+    while (auto message = channel->receive()) {
+        if (!message->is_object() || !message->contains("id") || !(*message)["id"].is_number_integer()) {
+            continue;
+        }
+        int64_t id = (*message)["id"].get<int64_t>();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(id);
+        if (it == pending.end()) {
+            continue;
+        }
+        if (message->contains("reply")) {
+            it->second.reply = std::move((*message)["reply"]);
+        } else {
+            it->second.events.push_back(std::move(*message));
+        }
+        cv.notify_all();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected.store(false);
+        for (auto& [id, entry] : pending) {
+            entry.disconnected = true;
+        }
+    }
+    cv.notify_all();
+}
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ai_integration.h"
+#include "broker_channel.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief An app's connection to the AI broker hosted by the launcher
+ *
+ * Requests are numbered and may be in flight from any number of threads at
+ * once; a reader thread hands each reply, stream chunk and progress report
+ * to the caller waiting on it, and callbacks run on that caller's thread as
+ * they would without the broker. Once the connection drops, every call
+ * returns nullopt, so the caller can run the request itself.
+ */
+class BrokerClient {
+public:
+    ~BrokerClient();
+    
+    // nullptr with error set when no broker answers at address
+    static std::unique_ptr<BrokerClient> connect(const std::string& address, std::string& error);
+    
+    bool isConnected() const { return connected.load(); }
+    
+    // Sends message under a new request number and waits for the broker's reply. Cancelling the
+    // token or returning false from progress cancels the request at the broker; on_chunk returning
+    // false ends the stream there. nullopt if the connection dropped before anything was delivered.
+    std::optional<nlohmann::json> call(nlohmann::json message, CancellationToken* token = nullptr,
+                                       const AIIntegration::StreamCallback* on_chunk = nullptr,
+                                       const AIIntegration::TransferProgress* progress = nullptr);
+
+private:
+    // What the reader has received for one request, not yet seen by its caller
+    struct Pending {
+        std::deque<nlohmann::json> events;
+        std::optional<nlohmann::json> reply;
+        bool disconnected = false;
+    };
+    
+    explicit BrokerClient(std::unique_ptr<BrokerChannel> channel);
+    void readLoop();
+    void cancel(int64_t id);
+    
+    std::unique_ptr<BrokerChannel> channel;
+    std::atomic<bool> connected{true};
+    std::atomic<int64_t> next_id{1};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<int64_t, Pending> pending;
+    std::thread reader;
+};
+
+} // namespace xeno::ai::detail
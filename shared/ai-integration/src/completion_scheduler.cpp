@@ -0,0 +1,292 @@
+#include "completion_scheduler.h"
+#include "response_cache.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace xeno::ai {
+
+namespace {
+
+AIIntegration::AIResponse supersededResponse() {
+    AIIntegration::AIResponse response;
+    response.success = false;
+    response.error_message = "Superseded by a newer request";
+    response.metadata["cancelled"] = true;
+    response.metadata["superseded"] = true;
+    return response;
+}
+
+} // namespace
+
+class CompletionScheduler::Impl : public std::enable_shared_from_this<CompletionScheduler::Impl> {
+public:
+    struct Pending {
+        AIIntegration::AIRequest request;
+        AIIntegration::AIProvider provider;
+        AIIntegration::CompletionCallback on_complete;
+        std::chrono::steady_clock::time_point due;
+    };
+    
+    struct Waiter {
+        std::string slot;
+        AIIntegration::CompletionCallback on_complete;
+    };
+    
+    struct Flight {
+        uint64_t id = 0;
+        std::vector<Waiter> waiters;
+        AIIntegration::AITask task; // Empty for batched flights, which cannot be cancelled individually
+    };
+    
+    struct Send {
+        std::string key;
+        uint64_t id;
+        AIIntegration::AIRequest request;
+        AIIntegration::AIProvider provider;
+    };
+    
+    AIIntegration& ai_integration;
+    Options options;
+    
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::thread thread;
+    
+    std::map<std::string, Pending> pending;     // By slot, waiting out the debounce delay
+    std::map<std::string, Flight> flights;      // By request key, sent to the provider
+    std::map<std::string, std::string> slot_flights; // Slot -> key of the flight it waits on
+    uint64_t next_flight_id = 0;
+    Stats stats;
+    
+    Impl(AIIntegration& ai_integration, const Options& options)
+        : ai_integration(ai_integration), options(options) {}
+    
+    static std::string flightKey(const AIIntegration::AIRequest& request, AIIntegration::AIProvider provider) {
+        return detail::ResponseCache::makeKey(std::to_string(static_cast<int>(provider)), request.model,
+                                              request.prompt, request.parameters, request.operation_type);
+    }
+    
+    // Removes the slot's current request, returning its callback if there was one
+    std::optional<AIIntegration::CompletionCallback> detachSlotLocked(const std::string& slot) {
+        std::optional<AIIntegration::CompletionCallback> callback;
+        
+        auto pending_it = pending.find(slot);
+        if (pending_it != pending.end()) {
+            callback = std::move(pending_it->second.on_complete);
+            pending.erase(pending_it);
+            return callback;
+        }
+        
+        auto slot_it = slot_flights.find(slot);
+        if (slot_it == slot_flights.end()) {
+            return callback;
+        }
+        auto flight_it = flights.find(slot_it->second);
+        slot_flights.erase(slot_it);
+        if (flight_it == flights.end()) {
+            return callback;
+        }
+        
+        auto& waiters = flight_it->second.waiters;
+        for (auto it = waiters.begin(); it != waiters.end(); ++it) {
+            if (it->slot == slot) {
+                callback = std::move(it->on_complete);
+                waiters.erase(it);
+                break;
+            }
+        }
+        // Nobody wants the answer any more; stop paying for it
+        if (waiters.empty()) {
+            flight_it->second.task.cancel();
+            flights.erase(flight_it);
+        }
+        return callback;
+    }
+    
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (pending.empty()) {
+                cv.wait(lock, [this]() { return stopping || !pending.empty(); });
+                continue;
+            }
+            
+            auto now = std::chrono::steady_clock::now();
+            auto earliest = pending.begin()->second.due;
+            for (const auto& [slot, request] : pending) {
+                earliest = std::min(earliest, request.due);
+            }
+            if (earliest > now) {
+                cv.wait_until(lock, earliest);
+                continue;
+            }
+            
+            dispatchDueLocked(now + options.batch_window);
+        }
+    }
+    
+    void dispatchDueLocked(std::chrono::steady_clock::time_point horizon) {
+        std::vector<Send> singles;
+        std::map<AIIntegration::AIProvider, std::vector<Send>> batchable;
+        
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second.due > horizon) {
+                ++it;
+                continue;
+            }
+            
+            std::string key = flightKey(it->second.request, it->second.provider);
+            slot_flights[it->first] = key;
+            
+            auto flight_it = flights.find(key);
+            if (flight_it != flights.end()) {
+                // Single-flight: an identical request is already on its way
+                flight_it->second.waiters.push_back({it->first, std::move(it->second.on_complete)});
+                stats.coalesced++;
+            } else {
+                Flight& flight = flights[key];
+                flight.id = ++next_flight_id;
+                flight.waiters.push_back({it->first, std::move(it->second.on_complete)});
+                
+                Send send{key, flight.id, std::move(it->second.request), it->second.provider};
+                // Auto batches too: the batch is routed as a whole, so it reaches Xeno Cloud's
+                // batch endpoint whenever that is the provider chosen
+                if (send.provider == AIIntegration::AIProvider::XenoCloud ||
+                    send.provider == AIIntegration::AIProvider::Auto) {
+                    batchable[send.provider].push_back(std::move(send));
+                } else {
+                    singles.push_back(std::move(send));
+                }
+            }
+            it = pending.erase(it);
+        }
+        
+        // A batch of one gains nothing
+        for (auto it = batchable.begin(); it != batchable.end();) {
+            if (it->second.size() == 1) {
+                singles.push_back(std::move(it->second.front()));
+                it = batchable.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        
+        for (auto& send : singles) {
+            auto self = shared_from_this();
+            flights[send.key].task = ai_integration.completeCodeAsync(send.request, send.provider,
+                [self, key = send.key, id = send.id](const AIIntegration::AIResponse& response) {
+                    self->complete(key, id, response);
+                });
+            stats.provider_calls++;
+        }
+        
+        size_t batch_size = std::max<size_t>(options.max_batch_size, 1);
+        for (auto& [provider, sends] : batchable) {
+            for (size_t start = 0; start < sends.size(); start += batch_size) {
+                size_t end = std::min(start + batch_size, sends.size());
+                std::vector<AIIntegration::AIRequest> requests;
+                std::vector<std::pair<std::string, uint64_t>> targets;
+                for (size_t i = start; i < end; i++) {
+                    requests.push_back(std::move(sends[i].request));
+                    targets.emplace_back(sends[i].key, sends[i].id);
+                }
+                
+                auto self = shared_from_this();
+                ai_integration.completeCodeBatchAsync(requests, provider,
+                    [self, targets](const std::vector<AIIntegration::AIResponse>& responses) {
+                        for (size_t i = 0; i < targets.size() && i < responses.size(); i++) {
+                            self->complete(targets[i].first, targets[i].second, responses[i]);
+                        }
+                    });
+                stats.batched += requests.size();
+                stats.provider_calls++;
+            }
+        }
+    }
+    
+    void complete(const std::string& key, uint64_t id, const AIIntegration::AIResponse& response) {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = flights.find(key);
+            // A cancelled flight may have been replaced by a newer identical one
+            if (stopping || it == flights.end() || it->second.id != id) {
+                return;
+            }
+            waiters = std::move(it->second.waiters);
+            flights.erase(it);
+            for (const auto& waiter : waiters) {
+                slot_flights.erase(waiter.slot);
+            }
+        }
+        
+        for (const auto& waiter : waiters) {
+            if (waiter.on_complete) {
+                waiter.on_complete(response);
+            }
+        }
+    }
+};
+
+CompletionScheduler::CompletionScheduler(AIIntegration& ai_integration)
+    : CompletionScheduler(ai_integration, Options()) {}
+
+CompletionScheduler::CompletionScheduler(AIIntegration& ai_integration, const Options& options)
+    : pImpl(std::make_shared<Impl>(ai_integration, options)) {
+    pImpl->thread = std::thread([impl = pImpl.get()]() { impl->run(); });
+}
+
+CompletionScheduler::~CompletionScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->stopping = true;
+        for (auto& [key, flight] : pImpl->flights) {
+            flight.task.cancel();
+        }
+        pImpl->flights.clear();
+        pImpl->pending.clear();
+        pImpl->slot_flights.clear();
+    }
+    pImpl->cv.notify_all();
+    pImpl->thread.join();
+}
+
+void CompletionScheduler::request(const std::string& slot, const AIIntegration::AIRequest& request,
+                                  AIIntegration::AIProvider provider, AIIntegration::CompletionCallback on_complete) {
+    std::optional<AIIntegration::CompletionCallback> superseded;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->mutex);
+        pImpl->stats.requested++;
+        superseded = pImpl->detachSlotLocked(slot);
+        if (superseded) {
+            pImpl->stats.superseded++;
+        }
+        
+        Impl::Pending& entry = pImpl->pending[slot];
+        entry.request = request;
+        entry.provider = provider;
+        entry.on_complete = std::move(on_complete);
+        entry.due = std::chrono::steady_clock::now() + pImpl->options.debounce;
+    }
+    pImpl->cv.notify_one();
+    
+    if (superseded && *superseded) {
+        (*superseded)(supersededResponse());
+    }
+}
+
+void CompletionScheduler::cancel(const std::string& slot) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    pImpl->detachSlotLocked(slot);
+}
+
+CompletionScheduler::Stats CompletionScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    return pImpl->stats;
+}
+
+} // namespace xeno::ai
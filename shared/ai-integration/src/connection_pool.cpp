@@ -0,0 +1,120 @@
+#include "connection_pool.h"
+#include <httplib.h>
+#include <algorithm>
+
+namespace xeno::ai::detail {
+
+// Lease implementation
+ConnectionPool::Lease::Lease(ConnectionPool* pool, std::unique_ptr<httplib::Client> connection)
+    : pool(pool), connection(std::move(connection)) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), connection(std::move(other.connection)), reusable(other.reusable) {
+    other.pool = nullptr;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (pool && connection) {
+        pool->release(std::move(connection), reusable);
+    }
+}
+
+// ConnectionPool implementation
+ConnectionPool::ConnectionPool(const std::string& base_url, const Options& options)
+    : options(options) {
+    // Split "https://host:port/api/v1" into the origin httplib connects to and the path prefix
+    size_t scheme_end = base_url.find("://");
+    size_t host_start = scheme_end == std::string::npos ? 0 : scheme_end + 3;
+    size_t path_start = base_url.find('/', host_start);
+    
+    origin = path_start == std::string::npos ? base_url : base_url.substr(0, path_start);
+    if (path_start != std::string::npos) {
+        base_path = base_url.substr(path_start);
+        while (!base_path.empty() && base_path.back() == '/') {
+            base_path.pop_back();
+        }
+    }
+    
+    if (this->options.max_connections == 0) {
+        this->options.max_connections = 1;
+    }
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    evictIdleLocked(std::chrono::steady_clock::now());
+    
+    available.wait(lock, [this]() {
+        return !idle.empty() || leased + idle.size() < options.max_connections;
+    });
+    return Lease(this, takeLocked());
+}
+
+std::optional<ConnectionPool::Lease> ConnectionPool::tryAcquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    evictIdleLocked(std::chrono::steady_clock::now());
+    if (idle.empty() && leased + idle.size() >= options.max_connections) {
+        return std::nullopt;
+    }
+    return std::optional<Lease>(std::in_place, this, takeLocked());
+}
+
+size_t ConnectionPool::idleConnections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+size_t ConnectionPool::leasedConnections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return leased;
+}
+
+void ConnectionPool::evictIdle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    evictIdleLocked(std::chrono::steady_clock::now());
+}
+
+std::unique_ptr<httplib::Client> ConnectionPool::connect() const {
+    // httplib opens the socket lazily on the first request and keeps it open afterwards
+    auto client = std::make_unique<httplib::Client>(origin);
+    client->set_keep_alive(true);
+    client->set_follow_location(true);
+    client->set_connection_timeout(options.connect_timeout.count(), 0);
+    client->set_read_timeout(options.read_timeout.count(), 0);
+    client->set_write_timeout(options.read_timeout.count(), 0);
+    return client;
+}
+
+std::unique_ptr<httplib::Client> ConnectionPool::takeLocked() {
+    std::unique_ptr<httplib::Client> connection;
+    if (!idle.empty()) {
+        connection = std::move(idle.back().client);
+        idle.pop_back();
+    } else {
+        connection = connect();
+    }
+    leased++;
+    return connection;
+}
+
+void ConnectionPool::release(std::unique_ptr<httplib::Client> connection, bool reusable) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        leased--;
+        if (reusable) {
+            idle.push_back({std::move(connection), std::chrono::steady_clock::now()});
+        }
+    }
+    available.notify_one();
+}
+
+void ConnectionPool::evictIdleLocked(std::chrono::steady_clock::time_point now) {
+    idle.erase(std::remove_if(idle.begin(), idle.end(), [this, now](const IdleConnection& connection) {
+                   return now - connection.last_used > options.idle_timeout;
+               }),
+               idle.end());
+}
+
+} // namespace xeno::ai::detail
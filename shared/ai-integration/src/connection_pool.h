@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace httplib {
+class Client;
+}
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief Pool of persistent keep-alive HTTP connections to one provider
+ *
+ * Each pooled httplib::Client owns one socket (and TLS session), so reusing a
+ * client skips the TCP and TLS handshakes. A client serves one request at a
+ * time; concurrency comes from holding several clients per provider.
+ */
+class ConnectionPool {
+public:
+    struct Options {
+        size_t max_connections = 4;
+        std::chrono::seconds idle_timeout{60};
+        std::chrono::seconds connect_timeout{10};
+        std::chrono::seconds read_timeout{30};
+    };
+    
+    /**
+     * @brief Exclusive use of one pooled connection, returned to the pool on destruction
+     */
+    class Lease {
+    public:
+        Lease(ConnectionPool* pool, std::unique_ptr<httplib::Client> connection);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+        
+        httplib::Client& client() { return *connection; }
+        
+        // Closes the connection instead of returning it, e.g. after an aborted request
+        void discard() { reusable = false; }
+    
+    private:
+        ConnectionPool* pool;
+        std::unique_ptr<httplib::Client> connection;
+        bool reusable = true;
+    };
+    
+    ConnectionPool(const std::string& base_url, const Options& options);
+    ~ConnectionPool();
+    
+    // Blocks while max_connections are leased
+    Lease acquire();
+    // Empty instead of blocking when max_connections are leased
+    std::optional<Lease> tryAcquire();
+    
+    // Path prefix of the base URL (e.g. "/api/v1"), to be prepended to request paths
+    const std::string& basePath() const { return base_path; }
+    
+    size_t idleConnections() const;
+    size_t leasedConnections() const;
+    
+    // Closes idle connections unused for longer than the idle timeout
+    void evictIdle();
+
+private:
+    struct IdleConnection {
+        std::unique_ptr<httplib::Client> client;
+        std::chrono::steady_clock::time_point last_used;
+    };
+    
+    std::unique_ptr<httplib::Client> connect() const;
+    // Takes the warmest idle connection or opens one; the caller holds the lock and has checked the limit
+    std::unique_ptr<httplib::Client> takeLocked();
+    void release(std::unique_ptr<httplib::Client> connection, bool reusable);
+    void evictIdleLocked(std::chrono::steady_clock::time_point now);
+    
+    std::string origin;
+    std::string base_path;
+    Options options;
+    
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<IdleConnection> idle; // Most recently used last, so the warmest socket is reused first
+    size_t leased = 0;
+};
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,504 @@
+#include "ai_integration.h"
+#include "connection_pool.h"
+#include "metrics.h"
+#include "mpsc_queue.h"
+#include "transaction_journal.h"
+#include <httplib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <thread>
+
+namespace xeno::ai {
+
+namespace {
+
+std::string formatTimestamp(std::chrono::system_clock::time_point time) {
+    std::time_t now = std::chrono::system_clock::to_time_t(time);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buffer;
+}
+
+} // namespace
+
+class CreditWallet::Impl {
+public:
+    using Entry = detail::TransactionJournal::Entry;
+    
+    // Reservations are already subtracted from available, so a balance check never needs a lock
+    std::atomic<int> available{0};
+    std::atomic<int> reserved{0};
+    
+    // Guards swapping the journal and the producer side of sync; the journal itself serializes appends
+    std::mutex journal_mutex;
+    std::unique_ptr<detail::TransactionJournal> journal =
+        std::make_unique<detail::TransactionJournal>(kHistoryCapacity);
+    std::string id_prefix = idPrefix(*journal);
+    bool queueing = false; // Sync is running, so new deductions go to pending
+    bool backlog = false;  // The journal owes deductions newer than the queued ones
+    size_t queued = 0;     // Deductions in pending or unsynced
+    size_t queue_limit = 1;
+    size_t batch_size = 1;
+    // Deductions on their way to syncLoop, pushed under journal_mutex so they arrive in journal order
+    utils::MpscQueue<Entry> pending;
+    std::atomic<bool> batch_ready{false};
+    std::atomic<bool> authenticated{false};
+    
+    std::mutex sync_mutex;
+    std::condition_variable sync_cv;
+    std::condition_variable stopped_cv;
+    std::string user_token;
+    SyncOptions sync_options;
+    std::unique_ptr<detail::ConnectionPool> sync_pool;
+    // Deductions owed to the server, oldest first. The journal is the record of what is owed; the
+    // queue holds at most max_queued of them, and once it fills the rest wait in the journal alone.
+    std::deque<Entry> unsynced;
+    bool behind = false;             // The last refill left deductions in the journal
+    int failures = 0;                // Consecutive failed sends
+    uint64_t journal_generation = 0; // Bumped when openJournal() swaps the journal
+    std::thread sync_thread;
+    bool syncing = false;
+    bool stopping = false;
+    bool finished = false; // syncLoop has returned
+    
+    // The send in flight, so stopSync() can cut it short
+    std::mutex request_mutex;
+    httplib::Client* request = nullptr;
+    bool cancelled = false;
+    
+    // Sequences restart in every journal, so ids carry the journal's own id
+    static std::string idPrefix(const detail::TransactionJournal& journal) {
+        char buffer[24];
+        std::snprintf(buffer, sizeof(buffer), "tx_%016llx_", static_cast<unsigned long long>(journal.id()));
+        return buffer;
+    }
+    
+    static Transaction toTransaction(const Entry& entry, const std::string& prefix) {
+        Transaction transaction;
+        transaction.id = prefix + std::to_string(entry.sequence);
+        transaction.operation = entry.operation;
+        transaction.credits = entry.credits;
+        transaction.timestamp = formatTimestamp(entry.timestamp);
+        transaction.success = entry.success;
+        return transaction;
+    }
+    
+    static std::vector<Transaction> toTransactions(const std::vector<Entry>& entries, const std::string& prefix) {
+        std::vector<Transaction> transactions;
+        transactions.reserve(entries.size());
+        for (const auto& entry : entries) {
+            transactions.push_back(toTransaction(entry, prefix));
+        }
+        return transactions;
+    }
+    
+    Transaction record(const std::string& operation, int credits) {
+        std::lock_guard<std::mutex> lock(journal_mutex);
+        return toTransaction(journal->append(operation, credits, true), id_prefix);
+    }
+    
+    // Takes only the journal lock; syncLoop is woken when a batch fills or the queue overflows.
+    // Without a token the deduction is local only.
+    void recordDeduction(const std::string& operation, int credits) {
+        bool for_sync = authenticated.load();
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(journal_mutex);
+            Entry entry = journal->append(operation, credits, true, for_sync);
+            // Until sync starts it is picked up from the journal
+            if (!for_sync || !queueing) {
+                return;
+            }
+            if (backlog || queued >= queue_limit) {
+                wake = !backlog;
+                backlog = true;
+            } else {
+                pending.push(std::move(entry));
+                wake = ++queued == batch_size;
+            }
+        }
+        if (wake) {
+            batch_ready = true;
+            // Passing through the lock orders the flag with syncLoop's wait, so the wakeup is not lost
+            { std::lock_guard<std::mutex> lock(sync_mutex); }
+            sync_cv.notify_one();
+        }
+    }
+    
+    // Empties the queue; the caller holds both locks and sets backlog so the journal refills it
+    void resetQueueLocked() {
+        pending.drain();
+        unsynced.clear();
+        queued = 0;
+        backlog = true;
+        behind = true;
+    }
+    
+    // Moves pushed deductions into unsynced and tops it up with ones waiting in the journal
+    void collectLocked() {
+        batch_ready = false;
+        std::lock_guard<std::mutex> journal_lock(journal_mutex);
+        for (auto& entry : pending.drain()) {
+            unsynced.push_back(std::move(entry));
+        }
+        behind = backlog;
+        if (!backlog || queued >= queue_limit) {
+            return;
+        }
+        size_t room = queue_limit - queued;
+        auto loaded = journal->unsynced(unsynced.empty() ? 0 : unsynced.back().sequence, room);
+        unsynced.insert(unsynced.end(), loaded.begin(), loaded.end());
+        queued += loaded.size();
+        backlog = behind = loaded.size() == room;
+    }
+    
+    // Doubles with each failure in a row, up to max_backoff
+    std::chrono::milliseconds backoffLocked() const {
+        auto backoff = sync_options.interval * (int64_t{1} << std::min(failures, 20));
+        return std::min<std::chrono::milliseconds>(backoff, std::max(sync_options.max_backoff, sync_options.interval));
+    }
+    
+    // Sends one batch; fills in balance when the server reports it
+    bool sendBatch(const std::vector<Entry>& batch, const std::string& prefix, const std::string& token,
+                   std::optional<int>& balance) {
+        static utils::Histogram& sync_latency = utils::Metrics::getInstance().histogram("wallet.sync");
+        static utils::Counter& sync_failures = utils::Metrics::getInstance().counter("wallet.sync.failures");
+        utils::TraceSpan span(sync_latency);
+        
+        nlohmann::json deductions = nlohmann::json::array();
+        for (const auto& entry : batch) {
+            Transaction transaction = toTransaction(entry, prefix);
+            deductions.push_back({
+                {"id", transaction.id},
+                {"operation", transaction.operation},
+                {"credits", -transaction.credits},
+                {"timestamp", transaction.timestamp}
+            });
+        }
+        
+        httplib::Headers headers = {{"Authorization", "Bearer " + token}};
+        auto lease = sync_pool->acquire();
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            if (cancelled) {
+                return false;
+            }
+            request = &lease.client();
+        }
+        auto result = lease.client().Post(sync_pool->basePath() + "/v1/credits/deductions", headers,
+                                          nlohmann::json{{"deductions", deductions}}.dump(), "application/json");
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            request = nullptr;
+        }
+        if (!result || result->status < 200 || result->status >= 300) {
+            lease.discard();
+            sync_failures.add();
+            return false;
+        }
+        
+        auto body = nlohmann::json::parse(result->body, nullptr, false);
+        if (!body.is_discarded() && body.contains("balance") && body["balance"].is_number_integer()) {
+            balance = body["balance"].get<int>();
+        }
+        return true;
+    }
+    
+    // Aborts the send in flight and any later one
+    void cancelRequests() {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        cancelled = true;
+        if (request) {
+            request->stop();
+        }
+    }
+    
+    // Adopts the server's balance without losing reservations or deductions still in flight
+    void reconcileLocked(int server_balance) {
+        int unsynced_charges = 0;
+        for (const auto& entry : unsynced) {
+            unsynced_charges -= entry.credits;
+        }
+        int local_view = available.load() + reserved.load() + unsynced_charges;
+        available.fetch_add(server_balance - local_view);
+    }
+    
+    void syncLoop() {
+        std::unique_lock<std::mutex> lock(sync_mutex);
+        runLocked(lock);
+        finished = true;
+        stopped_cv.notify_all();
+    }
+    
+    void runLocked(std::unique_lock<std::mutex>& lock) {
+        while (true) {
+            if (failures > 0) {
+                // Back off while the server is failing; a full batch does not cut the wait short
+                sync_cv.wait_for(lock, backoffLocked(), [this]() { return stopping; });
+                if (stopping) {
+                    // Shutdown does not wait on a failing server; the journal still owes the rest
+                    return;
+                }
+            } else {
+                sync_cv.wait_for(lock, sync_options.interval, [this]() {
+                    return stopping || behind || batch_ready.load() || unsynced.size() >= sync_options.max_batch_size;
+                });
+            }
+            collectLocked();
+            if (unsynced.empty()) {
+                if (stopping) {
+                    return;
+                }
+                continue;
+            }
+            
+            size_t count = std::min(unsynced.size(), std::max<size_t>(sync_options.max_batch_size, 1));
+            std::vector<Entry> batch(unsynced.begin(), unsynced.begin() + count);
+            std::string prefix = id_prefix;
+            std::string token = user_token;
+            uint64_t generation = journal_generation;
+            
+            // The network round trip happens without the lock so deductions keep flowing
+            lock.unlock();
+            std::optional<int> server_balance;
+            bool sent = sendBatch(batch, prefix, token, server_balance);
+            lock.lock();
+            
+            if (generation != journal_generation) {
+                // The queue was reloaded from another journal while the batch was out
+                continue;
+            }
+            if (sent) {
+                failures = 0;
+                std::lock_guard<std::mutex> journal_lock(journal_mutex);
+                journal->markSynced(batch.back().sequence);
+                unsynced.erase(unsynced.begin(), unsynced.begin() + count);
+                queued -= count;
+                // Deductions pushed during the round trip belong in the local view
+                for (auto& entry : pending.drain()) {
+                    unsynced.push_back(std::move(entry));
+                }
+                // Deductions still waiting in the journal would be missing from it
+                if (server_balance && !backlog) {
+                    reconcileLocked(*server_balance);
+                }
+            } else {
+                failures++;
+                if (stopping) {
+                    // Unreachable on shutdown; the journal keeps what is left for the next session
+                    return;
+                }
+            }
+        }
+    }
+};
+
+// Reservation implementation
+CreditWallet::Reservation::Reservation(Reservation&& other) noexcept
+    : wallet(other.wallet), credits(other.credits) {
+    other.wallet = nullptr;
+    other.credits = 0;
+}
+
+CreditWallet::Reservation& CreditWallet::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        refund();
+        wallet = other.wallet;
+        credits = other.credits;
+        other.wallet = nullptr;
+        other.credits = 0;
+    }
+    return *this;
+}
+
+CreditWallet::Reservation::~Reservation() {
+    refund();
+}
+
+void CreditWallet::Reservation::commit(const std::string& operation) {
+    commit(operation, credits);
+}
+
+void CreditWallet::Reservation::commit(const std::string& operation, int charged) {
+    if (wallet) {
+        wallet->settle(credits, std::clamp(charged, 0, credits), operation);
+        wallet = nullptr;
+    }
+}
+
+void CreditWallet::Reservation::refund() {
+    if (wallet) {
+        wallet->settle(credits, 0, std::string());
+        wallet = nullptr;
+    }
+}
+
+// CreditWallet implementation
+CreditWallet::CreditWallet() : pImpl(std::make_unique<Impl>()) {
+    // Initialize with some demo credits
+    pImpl->available = 100;
+}
+
+CreditWallet::~CreditWallet() {
+    stopSync();
+}
+
+bool CreditWallet::authenticate(const std::string& user_token) {
+    std::lock_guard<std::mutex> lock(pImpl->sync_mutex);
+    pImpl->user_token = user_token;
+    pImpl->authenticated = !user_token.empty();
+    return true;
+}
+
+int CreditWallet::getBalance() {
+    return pImpl->available.load();
+}
+
+bool CreditWallet::deductCredits(int amount, const std::string& operation) {
+    auto reservation = reserveCredits(amount);
+    if (!reservation) {
+        return false;
+    }
+    reservation.commit(operation);
+    return true;
+}
+
+bool CreditWallet::addCredits(int amount) {
+    pImpl->available.fetch_add(amount);
+    pImpl->record("credit_purchase", amount);
+    return true;
+}
+
+CreditWallet::Reservation CreditWallet::reserveCredits(int amount) {
+    amount = std::max(amount, 0);
+    int current = pImpl->available.load();
+    do {
+        if (current < amount) {
+            return Reservation();
+        }
+    } while (!pImpl->available.compare_exchange_weak(current, current - amount));
+    
+    pImpl->reserved.fetch_add(amount);
+    return Reservation(this, amount);
+}
+
+void CreditWallet::settle(int reserved, int charged, const std::string& operation) {
+    pImpl->available.fetch_add(reserved - charged);
+    pImpl->reserved.fetch_sub(reserved);
+    if (charged > 0) {
+        pImpl->recordDeduction(operation, -charged);
+    }
+}
+
+bool CreditWallet::startSync(const SyncOptions& options) {
+    std::lock_guard<std::mutex> lock(pImpl->sync_mutex);
+    if (pImpl->user_token.empty()) {
+        return false;
+    }
+    if (pImpl->syncing) {
+        return true;
+    }
+    
+    detail::ConnectionPool::Options pool_options;
+    pool_options.max_connections = 1; // Batches are sent one at a time
+    pImpl->sync_pool = std::make_unique<detail::ConnectionPool>(options.endpoint, pool_options);
+    pImpl->sync_options = options;
+    pImpl->syncing = true;
+    pImpl->stopping = false;
+    pImpl->finished = false;
+    pImpl->failures = 0;
+    {
+        std::lock_guard<std::mutex> request_lock(pImpl->request_mutex);
+        pImpl->cancelled = false;
+    }
+    {
+        std::lock_guard<std::mutex> journal_lock(pImpl->journal_mutex);
+        pImpl->queueing = true;
+        pImpl->queue_limit = std::max<size_t>(options.max_queued, 1);
+        pImpl->batch_size = std::max<size_t>(options.max_batch_size, 1);
+        // Whatever an earlier session left unsent is still in the journal
+        pImpl->resetQueueLocked();
+    }
+    pImpl->sync_thread = std::thread([this]() { pImpl->syncLoop(); });
+    return true;
+}
+
+void CreditWallet::stopSync() {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->sync_mutex);
+        if (!pImpl->syncing) {
+            return;
+        }
+        pImpl->stopping = true;
+    }
+    pImpl->sync_cv.notify_all();
+    {
+        // The loop sends what is queued on the way out, but a slow server does not hold up shutdown
+        std::unique_lock<std::mutex> lock(pImpl->sync_mutex);
+        if (!pImpl->stopped_cv.wait_for(lock, pImpl->sync_options.shutdown_timeout,
+                                        [this]() { return pImpl->finished; })) {
+            lock.unlock();
+            pImpl->cancelRequests();
+        }
+    }
+    pImpl->sync_thread.join();
+    
+    std::lock_guard<std::mutex> lock(pImpl->sync_mutex);
+    std::lock_guard<std::mutex> journal_lock(pImpl->journal_mutex);
+    pImpl->queueing = false;
+    pImpl->syncing = false;
+    pImpl->stopping = false;
+}
+
+size_t CreditWallet::pendingSyncCount() {
+    std::lock_guard<std::mutex> lock(pImpl->journal_mutex);
+    return pImpl->journal->unsynced(0, std::numeric_limits<size_t>::max()).size();
+}
+
+bool CreditWallet::openJournal(const std::string& path) {
+    auto journal = detail::TransactionJournal::open(path, kJournalCapacity);
+    if (!journal) {
+        return false;
+    }
+    std::lock_guard<std::mutex> sync_lock(pImpl->sync_mutex);
+    std::lock_guard<std::mutex> lock(pImpl->journal_mutex);
+    pImpl->journal = std::move(journal);
+    pImpl->id_prefix = Impl::idPrefix(*pImpl->journal);
+    // What is owed now comes from the new journal, which records what it has already sent
+    pImpl->resetQueueLocked();
+    pImpl->journal_generation++;
+    return true;
+}
+
+std::vector<CreditWallet::Transaction> CreditWallet::getTransactionHistory(int limit) {
+    std::lock_guard<std::mutex> lock(pImpl->journal_mutex);
+    return Impl::toTransactions(pImpl->journal->tail(static_cast<size_t>(std::max(limit, 0))), pImpl->id_prefix);
+}
+
+std::vector<CreditWallet::Transaction> CreditWallet::getTransactionsBetween(std::chrono::system_clock::time_point from,
+                                                                          std::chrono::system_clock::time_point to,
+                                                                          int limit) {
+    std::lock_guard<std::mutex> lock(pImpl->journal_mutex);
+    return Impl::toTransactions(pImpl->journal->range(from, to, static_cast<size_t>(std::max(limit, 0))),
+                                 pImpl->id_prefix);
+}
+
+std::vector<CreditWallet::Transaction> CreditWallet::getTransactionsForOperation(const std::string& operation,
+                                                                               int limit) {
+    std::lock_guard<std::mutex> lock(pImpl->journal_mutex);
+    return Impl::toTransactions(pImpl->journal->byOperation(operation, static_cast<size_t>(std::max(limit, 0))),
+                                 pImpl->id_prefix);
+}
+
+} // namespace xeno::ai
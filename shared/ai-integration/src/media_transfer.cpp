@@ -0,0 +1,460 @@
+#include "media_transfer.h"
+#include "ai_integration.h"
+#include "connection_pool.h"
+#include <httplib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace xeno::ai::detail {
+
+namespace {
+
+constexpr size_t kReadBlockSize = 256 * 1024; // Bytes handed to the socket per write
+constexpr size_t kMinimumChunkSize = 256 * 1024;
+constexpr auto kProgressInterval = std::chrono::milliseconds(100);
+
+bool isSuccess(int status) {
+    return status >= 200 && status < 300;
+}
+
+// Connection failures, timeouts, throttling and server errors are worth another attempt
+bool isRetryable(const httplib::Result& result) {
+    if (!result) {
+        return true;
+    }
+    int status = result->status;
+    return status == 408 || status == 429 || status >= 500;
+}
+
+std::string describe(const httplib::Result& result) {
+    if (!result) {
+        return "Could not reach Xeno AI Cloud: " + httplib::to_string(result.error());
+    }
+    return "Xeno AI Cloud returned HTTP " + std::to_string(result->status) + ": " + result->body.substr(0, 512);
+}
+
+bool isAbsoluteURL(const std::string& url) {
+    return url.rfind("http://", 0) == 0 || url.rfind("https://", 0) == 0;
+}
+
+httplib::Headers toHeaders(const std::map<std::string, std::string>& headers) {
+    httplib::Headers result;
+    for (const auto& [key, value] : headers) {
+        result.emplace(key, value);
+    }
+    return result;
+}
+
+// Total size from "Content-Range: bytes 100-199/1000", or 0 when the server did not say
+uint64_t rangeTotal(const std::string& content_range) {
+    size_t slash = content_range.rfind('/');
+    if (slash == std::string::npos || slash + 1 >= content_range.size() || content_range[slash + 1] == '*') {
+        return 0;
+    }
+    return std::strtoull(content_range.c_str() + slash + 1, nullptr, 10);
+}
+
+} // namespace
+
+MediaTransfer::MediaTransfer(ConnectionPool& pool, std::map<std::string, std::string> headers,
+                             const Options& options, CancellationToken* token)
+    : pool(pool), headers(std::move(headers)), options(options), token(token) {
+    this->options.chunk_size = std::max(this->options.chunk_size, kMinimumChunkSize);
+    this->options.parallel_chunks = std::max<size_t>(this->options.parallel_chunks, 1);
+    this->options.max_attempts = std::max(this->options.max_attempts, 1);
+}
+
+std::vector<MediaTransfer::Chunk> MediaTransfer::planChunks(uint64_t size, size_t chunk_size) {
+    std::vector<Chunk> chunks;
+    if (chunk_size == 0) {
+        return chunks;
+    }
+    for (uint64_t offset = 0; offset < size; offset += chunk_size) {
+        chunks.push_back({chunks.size(), offset, std::min<uint64_t>(chunk_size, size - offset)});
+    }
+    return chunks;
+}
+
+bool MediaTransfer::upload(const std::string& path, std::string& transfer_id, const Progress& progress,
+                           std::string& error) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        error = "Cannot read " + path + ": " + ec.message();
+        return false;
+    }
+    
+    Session session;
+    bool ready = transfer_id.empty() ? openSession(path, size, transfer_id, session, error)
+                                     : resumeSession(transfer_id, size, session, error);
+    if (!ready) {
+        return false;
+    }
+    
+    std::set<size_t> received(session.received.begin(), session.received.end());
+    std::vector<Chunk> missing;
+    uint64_t done = 0;
+    for (const Chunk& chunk : planChunks(size, session.chunk_size)) {
+        if (received.count(chunk.index)) {
+            done += chunk.length;
+        } else {
+            missing.push_back(chunk);
+        }
+    }
+    
+    if (!sendChunks(std::move(missing), path, transfer_id, done, size, progress, error)) {
+        return false;
+    }
+    
+    nlohmann::json reply;
+    return requestJSON("POST", "/v1/uploads/" + transfer_id + "/complete", nullptr, reply, error);
+}
+
+bool MediaTransfer::openSession(const std::string& path, uint64_t size, std::string& transfer_id,
+                                Session& session, std::string& error) {
+    nlohmann::json body = {
+        {"filename", std::filesystem::path(path).filename().string()},
+        {"size", size},
+        {"chunk_size", options.chunk_size}
+    };
+    nlohmann::json reply;
+    if (!requestJSON("POST", "/v1/uploads", &body, reply, error)) {
+        return false;
+    }
+    if (!reply.contains("transfer_id") || !reply["transfer_id"].is_string()) {
+        error = "Malformed upload response from Xeno AI Cloud";
+        return false;
+    }
+    
+    transfer_id = reply["transfer_id"].get<std::string>();
+    session.size = size;
+    // The server may round the chunk size to suit its storage
+    session.chunk_size = reply.value("chunk_size", options.chunk_size);
+    return true;
+}
+
+bool MediaTransfer::resumeSession(const std::string& transfer_id, uint64_t size, Session& session,
+                                  std::string& error) {
+    nlohmann::json reply;
+    if (!requestJSON("GET", "/v1/uploads/" + transfer_id, nullptr, reply, error)) {
+        return false;
+    }
+    
+    session.size = reply.value("size", uint64_t(0));
+    session.chunk_size = reply.value("chunk_size", size_t(0));
+    if (session.size != size || session.chunk_size == 0) {
+        error = "Transfer " + transfer_id + " does not match the source file";
+        return false;
+    }
+    if (reply.contains("received") && reply["received"].is_array()) {
+        session.received = reply["received"].get<std::vector<size_t>>();
+    }
+    return true;
+}
+
+bool MediaTransfer::sendChunks(std::vector<Chunk> chunks, const std::string& path,
+                               const std::string& transfer_id, uint64_t done, uint64_t total,
+                               const Progress& progress, std::string& error) {
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t finished = 0;
+    std::string first_error;
+    
+    size_t worker_count = std::min(options.parallel_chunks, chunks.size());
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < worker_count; w++) {
+        workers.emplace_back([&]() {
+            // Each worker reads through its own handle, one buffer at a time
+            std::ifstream file(path, std::ios::binary);
+            std::vector<char> buffer(std::min<size_t>(kReadBlockSize, options.chunk_size));
+            std::string chunk_error;
+            
+            while (!stop) {
+                size_t i = next.fetch_add(1);
+                if (i >= chunks.size()) {
+                    break;
+                }
+                if (!file.is_open()) {
+                    chunk_error = "Cannot read " + path;
+                }
+                if (!file.is_open() || !sendChunk(file, buffer, transfer_id, chunks[i], total, stop, chunk_error)) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (first_error.empty() && !stop) {
+                        first_error = chunk_error;
+                    }
+                    stop = true;
+                    break;
+                }
+                sent += chunks[i].length;
+                changed.notify_one();
+            }
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            finished++;
+            changed.notify_one();
+        });
+    }
+    
+    // Progress and cancellation are handled here so callbacks never run on a worker
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (finished < worker_count) {
+            changed.wait_for(lock, kProgressInterval);
+            lock.unlock();
+            if (cancelled() || (progress && !progress(done + sent, total))) {
+                stop = true;
+            }
+            lock.lock();
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    if (!first_error.empty()) {
+        error = first_error;
+        return false;
+    }
+    if (stop) {
+        error = "Transfer cancelled";
+        return false;
+    }
+    if (progress) {
+        progress(total, total);
+    }
+    return true;
+}
+
+bool MediaTransfer::sendChunk(std::istream& file, std::vector<char>& buffer, const std::string& transfer_id,
+                              const Chunk& chunk, uint64_t total, const std::atomic<bool>& stop,
+                              std::string& error) {
+    std::string path = pool.basePath() + "/v1/uploads/" + transfer_id + "/chunks/" + std::to_string(chunk.index);
+    httplib::Headers request_headers = toHeaders(headers);
+    request_headers.emplace("Content-Range", "bytes " + std::to_string(chunk.offset) + "-" +
+                                             std::to_string(chunk.offset + chunk.length - 1) + "/" +
+                                             std::to_string(total));
+    
+    for (int attempt = 1;; attempt++) {
+        bool read_failed = false;
+        auto lease = pool.acquire();
+        auto result = lease.client().Put(path, request_headers, static_cast<size_t>(chunk.length),
+            [&](size_t offset, size_t length, httplib::DataSink& sink) {
+                if (stop) {
+                    return false;
+                }
+                // The body is re-read from disk on every attempt instead of being kept around
+                size_t count = std::min(length, buffer.size());
+                file.clear();
+                file.seekg(static_cast<std::streamoff>(chunk.offset + offset));
+                file.read(buffer.data(), static_cast<std::streamsize>(count));
+                if (static_cast<size_t>(file.gcount()) != count) {
+                    read_failed = true;
+                    return false;
+                }
+                return sink.write(buffer.data(), count);
+            },
+            "application/octet-stream");
+        
+        if (read_failed || stop) {
+            lease.discard();
+            error = read_failed ? "Source file changed during upload" : "Transfer cancelled";
+            return false;
+        }
+        if (result && isSuccess(result->status)) {
+            return true;
+        }
+        if (!result) {
+            lease.discard();
+        }
+        
+        error = describe(result);
+        if (!isRetryable(result) || attempt >= options.max_attempts || !waitBeforeRetry(attempt, stop)) {
+            return false;
+        }
+    }
+}
+
+bool MediaTransfer::download(const std::string& url, const std::string& destination, const Progress& progress,
+                             std::string& error) {
+    // Presigned links go to their own host and must not carry the provider's credentials
+    std::unique_ptr<ConnectionPool> foreign;
+    ConnectionPool* source = &pool;
+    std::string path;
+    httplib::Headers base_headers;
+    if (isAbsoluteURL(url)) {
+        ConnectionPool::Options foreign_options;
+        foreign_options.max_connections = 1;
+        foreign = std::make_unique<ConnectionPool>(url, foreign_options);
+        source = foreign.get();
+        path = foreign->basePath().empty() ? "/" : foreign->basePath();
+    } else {
+        path = pool.basePath() + url;
+        base_headers = toHeaders(headers);
+    }
+    
+    std::string partial = destination + ".part";
+    std::ofstream output(partial, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        error = "Cannot write " + partial;
+        return false;
+    }
+    
+    uint64_t written = 0;
+    uint64_t total = 0;
+    std::atomic<bool> stop{false};
+    bool complete = false;
+    for (int attempt = 1;; attempt++) {
+        httplib::Headers request_headers = base_headers;
+        if (written > 0) {
+            request_headers.emplace("Range", "bytes=" + std::to_string(written) + "-");
+        }
+        
+        int status = 0;
+        bool write_failed = false;
+        auto lease = source->acquire();
+        auto& client = lease.client();
+        if (token) {
+            token->setCancelHandler([&client]() { client.stop(); });
+        }
+        auto result = client.Get(path, request_headers,
+            [&](const httplib::Response& response) {
+                status = response.status;
+                if (status == 200 && written > 0) {
+                    // The server ignored the range, so the body starts over
+                    output.close();
+                    output.open(partial, std::ios::binary | std::ios::trunc);
+                    written = 0;
+                }
+                if (status == 206) {
+                    total = rangeTotal(response.get_header_value("Content-Range"));
+                } else if (status == 200) {
+                    total = std::strtoull(response.get_header_value("Content-Length").c_str(), nullptr, 10);
+                }
+                return status == 200 || status == 206;
+            },
+            [&](const char* data, size_t length) {
+                if (cancelled()) {
+                    return false;
+                }
+                output.write(data, static_cast<std::streamsize>(length));
+                if (!output) {
+                    write_failed = true;
+                    return false;
+                }
+                written += length;
+                if (progress && !progress(written, total)) {
+                    stop = true;
+                    return false;
+                }
+                return true;
+            });
+        if (token) {
+            token->clearCancelHandler();
+        }
+        
+        if (result && (status == 200 || status == 206) && (total == 0 || written == total)) {
+            complete = true;
+            break;
+        }
+        lease.discard();
+        
+        if (write_failed || cancelled() || stop) {
+            error = write_failed ? "Cannot write " + partial : "Transfer cancelled";
+            break;
+        }
+        // A refused status stops the request from the handler, so it is judged by status alone;
+        // a short body without an error is a dropped connection like any other
+        bool retryable = true;
+        if (status != 0 && status != 200 && status != 206) {
+            error = "Download failed with HTTP " + std::to_string(status);
+            retryable = status == 408 || status == 429 || status >= 500;
+        } else if (!result) {
+            error = "Download failed: " + httplib::to_string(result.error());
+        } else {
+            error = "Download of " + destination + " was cut short";
+        }
+        if (!retryable || attempt >= options.max_attempts || !waitBeforeRetry(attempt, stop)) {
+            break;
+        }
+    }
+    output.close();
+    
+    std::error_code ec;
+    if (!complete) {
+        std::filesystem::remove(partial, ec);
+        return false;
+    }
+    std::filesystem::rename(partial, destination, ec);
+    if (ec) {
+        error = "Cannot replace " + destination + ": " + ec.message();
+        std::filesystem::remove(partial, ec);
+        return false;
+    }
+    return true;
+}
+
+bool MediaTransfer::requestJSON(const std::string& method, const std::string& path, const nlohmann::json* body,
+                                nlohmann::json& reply, std::string& error) {
+    if (cancelled()) {
+        error = "Transfer cancelled";
+        return false;
+    }
+    
+    httplib::Headers request_headers = toHeaders(headers);
+    auto lease = pool.acquire();
+    auto& client = lease.client();
+    if (token) {
+        token->setCancelHandler([&client]() { client.stop(); });
+    }
+    auto result = method == "GET"
+        ? client.Get(pool.basePath() + path, request_headers)
+        : client.Post(pool.basePath() + path, request_headers, body ? body->dump() : std::string("{}"),
+                      "application/json");
+    if (token) {
+        token->clearCancelHandler();
+    }
+    
+    if (cancelled()) {
+        lease.discard();
+        error = "Transfer cancelled";
+        return false;
+    }
+    if (!result || !isSuccess(result->status)) {
+        if (!result) {
+            lease.discard();
+        }
+        error = describe(result);
+        return false;
+    }
+    
+    reply = nlohmann::json::parse(result->body, nullptr, false);
+    if (reply.is_discarded()) {
+        reply = nlohmann::json::object();
+    }
+    return true;
+}
+
+bool MediaTransfer::waitBeforeRetry(int attempt, const std::atomic<bool>& stop) const {
+    auto until = std::chrono::steady_clock::now() + options.retry_delay * attempt;
+    while (std::chrono::steady_clock::now() < until) {
+        if (stop || cancelled()) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return !stop && !cancelled();
+}
+
+bool MediaTransfer::cancelled() const {
+    return token && token->isCancelled();
+}
+
+} // namespace xeno::ai::detail
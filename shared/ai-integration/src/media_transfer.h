@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace xeno::ai {
+class CancellationToken;
+}
+
+namespace xeno::ai::detail {
+
+class ConnectionPool;
+
+/**
+ * @brief Moves media files to and from Xeno Cloud without holding them in memory
+ *
+ * Uploads open a transfer, send the file as fixed-size chunks read straight
+ * from disk (several in flight over pooled connections), then complete it.
+ * The server remembers which chunks arrived, so a transfer that failed part
+ * way resumes from its ID and only sends what is missing. Downloads stream the
+ * body to "<destination>.part" and retry with a Range request after a dropped
+ * connection; the file is renamed into place once complete.
+ *
+ * Memory use is one read buffer per chunk in flight, whatever the file size.
+ */
+class MediaTransfer {
+public:
+    struct Options {
+        size_t chunk_size = 8 * 1024 * 1024;
+        size_t parallel_chunks = 4;
+        int max_attempts = 3; // Per chunk, and per download
+        std::chrono::milliseconds retry_delay{500}; // Grows linearly with each attempt
+    };
+    
+    struct Chunk {
+        size_t index;
+        uint64_t offset;
+        uint64_t length;
+    };
+    
+    // Receives bytes done and the total (0 when unknown); returning false aborts
+    using Progress = std::function<bool(uint64_t done, uint64_t total)>;
+    
+    MediaTransfer(ConnectionPool& pool, std::map<std::string, std::string> headers, const Options& options,
+                  CancellationToken* token);
+    
+    // Uploads path; a non-empty transfer_id resumes that transfer. On return transfer_id
+    // names the transfer, even after a failure, so the caller can resume it later.
+    bool upload(const std::string& path, std::string& transfer_id, const Progress& progress, std::string& error);
+    
+    // url is a path on the provider, or an absolute URL (e.g. a presigned link) fetched
+    // without the provider's credentials
+    bool download(const std::string& url, const std::string& destination, const Progress& progress,
+                  std::string& error);
+    
+    static std::vector<Chunk> planChunks(uint64_t size, size_t chunk_size);
+
+private:
+    struct Session {
+        uint64_t size = 0;
+        size_t chunk_size = 0;
+        std::vector<size_t> received;
+    };
+    
+    bool openSession(const std::string& path, uint64_t size, std::string& transfer_id, Session& session,
+                     std::string& error);
+    bool resumeSession(const std::string& transfer_id, uint64_t size, Session& session, std::string& error);
+    bool sendChunks(std::vector<Chunk> chunks, const std::string& path, const std::string& transfer_id,
+                    uint64_t done, uint64_t total, const Progress& progress, std::string& error);
+    bool sendChunk(std::istream& file, std::vector<char>& buffer, const std::string& transfer_id,
+                   const Chunk& chunk, uint64_t total, const std::atomic<bool>& stop, std::string& error);
+    // One JSON call on the calling thread; body may be null
+    bool requestJSON(const std::string& method, const std::string& path, const nlohmann::json* body,
+                     nlohmann::json& reply, std::string& error);
+    // Sleeps before the next attempt; false if stop was raised meanwhile
+    bool waitBeforeRetry(int attempt, const std::atomic<bool>& stop) const;
+    bool cancelled() const;
+    
+    ConnectionPool& pool;
+    std::map<std::string, std::string> headers;
+    Options options;
+    CancellationToken* token;
+};
+
+} // namespace xeno::ai::detail
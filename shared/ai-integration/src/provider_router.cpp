@@ -0,0 +1,153 @@
+#include "provider_router.h"
+#include <algorithm>
+#include <cmath>
+
+namespace xeno::ai::detail {
+
+namespace {
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace
+
+void ProviderRouter::record(Provider provider, const std::string& operation, double latency_ms, bool success) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    Window& window = windows[{provider, operation}];
+    if (success) {
+        window.latencies.push_back(latency_ms);
+        if (window.latencies.size() > kLatencyWindow) {
+            window.latencies.pop_front();
+        }
+        // An answer proves the provider reachable whatever the last probe said
+        healthy[provider] = true;
+    }
+    window.outcomes.emplace_back(now, success);
+    if (window.outcomes.size() > kOutcomeWindow) {
+        window.outcomes.pop_front();
+    }
+}
+
+void ProviderRouter::setHealthy(Provider provider, bool is_healthy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    healthy[provider] = is_healthy;
+}
+
+bool ProviderRouter::isHealthy(Provider provider) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = healthy.find(provider);
+    return it == healthy.end() || it->second;
+}
+
+AIIntegration::ProviderStats ProviderRouter::stats(Provider provider, const std::string& operation) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return statsLocked(provider, operation);
+}
+
+std::vector<std::string> ProviderRouter::operations(Provider provider) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> result;
+    for (const auto& [key, window] : windows) {
+        if (key.first == provider) {
+            result.push_back(key.second);
+        }
+    }
+    return result;
+}
+
+std::vector<ProviderRouter::Provider> ProviderRouter::rank(const std::vector<Candidate>& candidates,
+                                                           const std::string& operation,
+                                                           const Weights& weights) const {
+    struct Ranked {
+        Provider provider;
+        bool degraded = false;
+        double score = 0;
+    };
+    std::vector<Ranked> ranked;
+    std::vector<size_t> scored_slots;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Candidate& candidate : candidates) {
+            auto stats = statsLocked(candidate.provider, operation);
+            Ranked entry{candidate.provider};
+            entry.degraded = !stats.healthy ||
+                             (stats.requests >= weights.min_samples && stats.error_rate > weights.max_error_rate);
+            if (stats.samples >= weights.min_samples) {
+                entry.score = stats.p50_ms + candidate.credits * weights.ms_per_credit;
+                scored_slots.push_back(ranked.size());
+            }
+            ranked.push_back(entry);
+        }
+    }
+    
+    // Providers with enough history trade places by score, within the slots they hold
+    std::vector<Ranked> scored;
+    for (size_t slot : scored_slots) {
+        scored.push_back(ranked[slot]);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const Ranked& a, const Ranked& b) {
+        return a.score < b.score;
+    });
+    for (size_t i = 0; i < scored_slots.size(); i++) {
+        ranked[scored_slots[i]] = scored[i];
+    }
+    
+    // Degraded providers are kept as a last resort rather than dropped
+    std::stable_partition(ranked.begin(), ranked.end(), [](const Ranked& entry) { return !entry.degraded; });
+    
+    std::vector<Provider> order;
+    order.reserve(ranked.size());
+    for (const Ranked& entry : ranked) {
+        order.push_back(entry.provider);
+    }
+    return order;
+}
+
+std::optional<std::chrono::milliseconds> ProviderRouter::hedgeDelay(Provider provider, const std::string& operation,
+                                                                    size_t min_samples) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto stats = statsLocked(provider, operation);
+    if (stats.samples < std::max<size_t>(min_samples, 1)) {
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(static_cast<int64_t>(std::ceil(stats.p95_ms)));
+}
+
+AIIntegration::ProviderStats ProviderRouter::statsLocked(Provider provider, const std::string& operation) const {
+    AIIntegration::ProviderStats stats;
+    auto health = healthy.find(provider);
+    stats.healthy = health == healthy.end() || health->second;
+    
+    auto it = windows.find({provider, operation});
+    if (it == windows.end()) {
+        return stats;
+    }
+    const Window& window = it->second;
+    
+    std::vector<double> sorted(window.latencies.begin(), window.latencies.end());
+    std::sort(sorted.begin(), sorted.end());
+    stats.samples = sorted.size();
+    stats.p50_ms = percentile(sorted, 0.50);
+    stats.p95_ms = percentile(sorted, 0.95);
+    stats.p99_ms = percentile(sorted, 0.99);
+    
+    auto horizon = std::chrono::steady_clock::now() - kOutcomeHorizon;
+    size_t failures = 0;
+    for (const auto& [when, success] : window.outcomes) {
+        if (when >= horizon) {
+            stats.requests++;
+            failures += success ? 0 : 1;
+        }
+    }
+    stats.error_rate = stats.requests > 0 ? static_cast<double>(failures) / static_cast<double>(stats.requests) : 0;
+    return stats;
+}
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ai_integration.h"
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief Recent latency and outcomes of each provider, and the order to try them in
+ *
+ * Every request that reaches a provider reports how long it took and whether
+ * it succeeded. History is kept per provider and operation, since an image on
+ * Xeno Cloud and a completion on it differ by orders of magnitude. Latency
+ * percentiles cover the latest kLatencyWindow successes; the error rate
+ * covers the latest kOutcomeWindow outcomes no older than kOutcomeHorizon,
+ * so a provider that was failing is tried again once its failures age out.
+ * Health is per provider and comes from probes: a failed probe marks the
+ * provider down until a probe or a request to it succeeds.
+ */
+class ProviderRouter {
+public:
+    using Provider = AIIntegration::AIProvider;
+    
+    static constexpr size_t kLatencyWindow = 128;
+    static constexpr size_t kOutcomeWindow = 64;
+    static constexpr std::chrono::minutes kOutcomeHorizon{5};
+    
+    struct Candidate {
+        Provider provider;
+        int credits = 0;  // What the provider charges for the operation
+    };
+    
+    struct Weights {
+        double ms_per_credit = 0;
+        double max_error_rate = 0.5;
+        size_t min_samples = 5;  // History needed before latency or errors move a provider
+    };
+    
+    void record(Provider provider, const std::string& operation, double latency_ms, bool success);
+    void setHealthy(Provider provider, bool healthy);
+    bool isHealthy(Provider provider) const;
+    
+    AIIntegration::ProviderStats stats(Provider provider, const std::string& operation) const;
+    // Operations provider has history for
+    std::vector<std::string> operations(Provider provider) const;
+    
+    // Orders candidates, given in preference order, for trying in turn. Providers that are down
+    // or failing more than max_error_rate go last. Among the rest, those with min_samples of
+    // history trade places by p50 plus ms_per_credit per credit; the others keep their place.
+    std::vector<Provider> rank(const std::vector<Candidate>& candidates, const std::string& operation,
+                               const Weights& weights) const;
+    // How long to give provider before hedging: its p95, once it has min_samples successes
+    std::optional<std::chrono::milliseconds> hedgeDelay(Provider provider, const std::string& operation,
+                                                        size_t min_samples) const;
+
+private:
+    struct Window {
+        std::deque<double> latencies;  // Milliseconds, oldest first
+        std::deque<std::pair<std::chrono::steady_clock::time_point, bool>> outcomes;
+    };
+    
+    // The caller holds the lock
+    AIIntegration::ProviderStats statsLocked(Provider provider, const std::string& operation) const;
+    
+    mutable std::mutex mutex;
+    std::map<std::pair<Provider, std::string>, Window> windows;
+    std::map<Provider, bool> healthy;  // Providers not yet probed count as healthy
+};
+
+} // namespace xeno::ai::detail
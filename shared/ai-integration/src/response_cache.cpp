@@ -0,0 +1,359 @@
+#include "response_cache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace xeno::ai::detail {
+
+namespace {
+
+// Two independently mixed 64-bit lanes give a 128-bit key, so collisions between
+// distinct prompts are not a practical concern
+class KeyHasher {
+public:
+    void add(const std::string& field) {
+        // Length prefix keeps ("ab", "c") and ("a", "bc") distinct
+        uint64_t length = field.size();
+        for (int i = 0; i < 8; i++) {
+            addByte(static_cast<unsigned char>(length >> (i * 8)));
+        }
+        for (unsigned char byte : field) {
+            addByte(byte);
+        }
+    }
+    
+    std::string hex() const {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", static_cast<unsigned long long>(fnv),
+                      static_cast<unsigned long long>(finalize(mix)));
+        return buffer;
+    }
+
+private:
+    void addByte(unsigned char byte) {
+        fnv = (fnv ^ byte) * 0x100000001b3ULL;
+        mix = (mix ^ byte) * 0x9e3779b97f4a7c15ULL;
+        mix = (mix << 31) | (mix >> 33);
+    }
+    
+    static uint64_t finalize(uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+    
+    uint64_t fnv = 0xcbf29ce484222325ULL;
+    uint64_t mix = 0x6a09e667f3bcc909ULL;
+};
+
+int64_t toEpochSeconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+// Files the disk tier writes: <key>.json entries, and the .json.tmp<n> files writeDisk renames into place.
+// The directory may be shared with other files, so an entry is only recognised by its contents.
+bool isCacheFile(const std::filesystem::directory_entry& file) {
+    std::error_code error;
+    if (!file.is_regular_file(error)) {
+        return false;
+    }
+    std::string name = file.path().filename().string();
+    if (name.find(".json.tmp") != std::string::npos) {
+        return true;
+    }
+    if (file.path().extension() != ".json") {
+        return false;
+    }
+    std::ifstream input(file.path(), std::ios::binary);
+    auto stored = nlohmann::json::parse(input, nullptr, false);
+    return stored.is_object() && stored.size() == 3 && stored.contains("expires") && stored.contains("content") &&
+           stored.contains("metadata");
+}
+
+// Keys from makeKey() are 32 hex digits, which no other file in a shared directory is going to be named
+bool isKeyFile(const std::filesystem::path& path) {
+    std::string stem = path.stem().string();
+    return path.extension() == ".json" && stem.size() == 32 &&
+           std::all_of(stem.begin(), stem.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+} // namespace
+
+ResponseCache::ResponseCache(const Options& options) : options(options) {
+    scanDisk();
+}
+
+std::string ResponseCache::makeKey(const std::string& provider, const std::string& model, const std::string& prompt,
+                                   const nlohmann::json& parameters, const std::string& operation_type) {
+    KeyHasher hasher;
+    hasher.add(provider);
+    hasher.add(model);
+    hasher.add(prompt);
+    // nlohmann objects are key-ordered, so equal parameter maps dump identically
+    hasher.add(parameters.dump());
+    hasher.add(operation_type);
+    return hasher.hex();
+}
+
+std::optional<ResponseCache::Hit> ResponseCache::get(const std::string& key) {
+    auto now = std::chrono::system_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            if (it->second->second.expires > now) {
+                lru.splice(lru.begin(), lru, it->second);
+                return Hit{it->second->second, Tier::Memory};
+            }
+            memory_bytes -= it->second->second.content.size();
+            lru.erase(it->second);
+            index.erase(it);
+        }
+    }
+    
+    // Disk reads happen outside the lock so a slow disk never blocks memory hits
+    auto entry = readDisk(key);
+    if (!entry) {
+        return std::nullopt;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    insertMemoryLocked(key, *entry);
+    return Hit{std::move(*entry), Tier::Disk};
+}
+
+void ResponseCache::put(const std::string& key, Entry entry) {
+    writeDisk(key, entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    insertMemoryLocked(key, std::move(entry));
+}
+
+void ResponseCache::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lru.clear();
+        index.clear();
+        memory_bytes = 0;
+    }
+    std::lock_guard<std::mutex> lock(disk_mutex);
+    disk_files.clear();
+    disk_bytes = 0;
+    if (!options.disk_directory.empty()) {
+        // Only the cache's own files go; the directory and anything else in it stay
+        std::error_code error;
+        for (const auto& file : std::filesystem::directory_iterator(options.disk_directory, error)) {
+            if (isCacheFile(file)) {
+                std::filesystem::remove(file.path(), error);
+            }
+        }
+    }
+}
+
+size_t ResponseCache::memoryEntries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lru.size();
+}
+
+size_t ResponseCache::diskEntries() const {
+    std::lock_guard<std::mutex> lock(disk_mutex);
+    return disk_files.size();
+}
+
+std::string ResponseCache::diskPath(const std::string& key) const {
+    return (std::filesystem::path(options.disk_directory) / (key + ".json")).string();
+}
+
+std::optional<ResponseCache::Entry> ResponseCache::readDisk(const std::string& key) {
+    if (options.disk_directory.empty()) {
+        return std::nullopt;
+    }
+    
+    std::string path = diskPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    
+    auto stored = nlohmann::json::parse(file, nullptr, false);
+    file.close();
+    
+    // A truncated or hand-edited file is a miss, and is removed so it is not read again
+    auto discard = [&]() -> std::optional<Entry> {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        std::lock_guard<std::mutex> lock(disk_mutex);
+        forgetDiskLocked(key);
+        return std::nullopt;
+    };
+    Entry entry;
+    try {
+        if (stored.is_discarded() || !stored.contains("content") || !stored.contains("expires")) {
+            return discard();
+        }
+        entry.expires = std::chrono::system_clock::time_point(std::chrono::seconds(stored["expires"].get<int64_t>()));
+        if (entry.expires <= std::chrono::system_clock::now()) {
+            return discard();
+        }
+        entry.content = stored["content"].get<std::string>();
+        entry.metadata = stored.value("metadata", nlohmann::json::object());
+    } catch (const nlohmann::json::exception&) {
+        return discard();
+    }
+    
+    // A hit counts as a use, so the file is among the last to be evicted
+    std::error_code error;
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(path, now, error);
+    uint64_t bytes = std::filesystem::file_size(path, error);
+    if (!error) {
+        std::lock_guard<std::mutex> lock(disk_mutex);
+        trackDiskLocked(key, bytes, now);
+    }
+    return entry;
+}
+
+void ResponseCache::writeDisk(const std::string& key, const Entry& entry) {
+    if (options.disk_directory.empty()) {
+        return;
+    }
+    
+    std::error_code error;
+    std::filesystem::create_directories(options.disk_directory, error);
+    
+    nlohmann::json stored = {
+        {"expires", toEpochSeconds(entry.expires)},
+        {"content", entry.content},
+        {"metadata", entry.metadata}
+    };
+    
+    // Write then rename so a concurrent reader (another app of the suite) never sees a partial file
+    std::string path = diskPath(key);
+    std::string temp_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    std::string text = stored.dump();
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file << text;
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::filesystem::remove(temp_path, error);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(disk_mutex);
+    trackDiskLocked(key, text.size(), std::filesystem::file_time_type::clock::now());
+    evictDiskLocked();
+}
+
+void ResponseCache::scanDisk() {
+    if (options.disk_directory.empty()) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(disk_mutex);
+    std::error_code error;
+    auto now = std::filesystem::file_time_type::clock::now();
+    for (const auto& file : std::filesystem::directory_iterator(options.disk_directory, error)) {
+        std::error_code file_error;
+        if (!file.is_regular_file(file_error)) {
+            continue;
+        }
+        auto used = file.last_write_time(file_error);
+        if (file_error) {
+            continue;
+        }
+        std::string name = file.path().filename().string();
+        if (name.find(".json.tmp") != std::string::npos) {
+            // Left by a writer that died mid-write; a live one renames its file within moments
+            if (now - used > std::chrono::hours(1)) {
+                std::filesystem::remove(file.path(), file_error);
+            }
+        } else if (isKeyFile(file.path())) {
+            uint64_t bytes = file.file_size(file_error);
+            if (!file_error) {
+                trackDiskLocked(file.path().stem().string(), bytes, used);
+            }
+        }
+    }
+    evictDiskLocked();
+}
+
+void ResponseCache::trackDiskLocked(const std::string& key, uint64_t bytes, std::filesystem::file_time_type used) {
+    auto& file = disk_files[key];
+    disk_bytes = disk_bytes - file.bytes + bytes;
+    file.bytes = bytes;
+    file.used = used;
+}
+
+void ResponseCache::forgetDiskLocked(const std::string& key) {
+    auto it = disk_files.find(key);
+    if (it != disk_files.end()) {
+        disk_bytes -= it->second.bytes;
+        disk_files.erase(it);
+    }
+}
+
+void ResponseCache::evictDiskLocked() {
+    if (disk_files.size() <= options.disk_entries && disk_bytes <= options.disk_bytes) {
+        return;
+    }
+    std::vector<std::pair<std::filesystem::file_time_type, std::string>> by_use;
+    by_use.reserve(disk_files.size());
+    for (const auto& [key, file] : disk_files) {
+        by_use.emplace_back(file.used, key);
+    }
+    std::sort(by_use.begin(), by_use.end());
+    
+    // Sweeps down to 90% of the budget, so the writes that follow do not each trigger one.
+    // As in memory, the newest entry always stays.
+    size_t entry_target = options.disk_entries - options.disk_entries / 10;
+    uint64_t byte_target = options.disk_bytes - options.disk_bytes / 10;
+    for (size_t i = 0; i + 1 < by_use.size(); i++) {
+        if (disk_files.size() <= entry_target && disk_bytes <= byte_target) {
+            break;
+        }
+        std::error_code error;
+        std::filesystem::remove(diskPath(by_use[i].second), error);
+        forgetDiskLocked(by_use[i].second);
+    }
+}
+
+void ResponseCache::insertMemoryLocked(const std::string& key, Entry entry) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        memory_bytes -= it->second->second.content.size();
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    
+    memory_bytes += entry.content.size();
+    lru.emplace_front(key, std::move(entry));
+    index[key] = lru.begin();
+    evictMemoryLocked();
+}
+
+void ResponseCache::evictMemoryLocked() {
+    // The newest entry always stays, even if it alone exceeds the byte budget
+    while (lru.size() > 1 && (lru.size() > options.memory_entries || memory_bytes > options.memory_bytes)) {
+        memory_bytes -= lru.back().second.content.size();
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief Two-tier cache of provider responses keyed by request content
+ *
+ * Recently used entries live in an in-memory LRU; every entry is also written
+ * to one JSON file per key under the disk directory so repeats survive a
+ * restart. Expired entries are dropped when they are next looked up.
+ *
+ * The disk tier has its own entry and byte budget. Files not used for the
+ * longest (by modification time, which a disk hit refreshes) are removed when
+ * the cache opens and whenever a write takes it over budget.
+ */
+class ResponseCache {
+public:
+    struct Options {
+        size_t memory_entries = 256;
+        size_t memory_bytes = 64 * 1024 * 1024;
+        std::string disk_directory; // Empty keeps the cache in memory only
+        size_t disk_entries = 4096;
+        uint64_t disk_bytes = 256 * 1024 * 1024;
+    };
+    
+    struct Entry {
+        std::string content;
+        nlohmann::json metadata;
+        std::chrono::system_clock::time_point expires;
+    };
+    
+    enum class Tier {
+        Memory,
+        Disk
+    };
+    
+    struct Hit {
+        Entry entry;
+        Tier tier;
+    };
+    
+    explicit ResponseCache(const Options& options);
+    
+    // Hex digest over everything that determines a provider's answer
+    static std::string makeKey(const std::string& provider, const std::string& model, const std::string& prompt,
+                               const nlohmann::json& parameters, const std::string& operation_type);
+    
+    std::optional<Hit> get(const std::string& key);
+    void put(const std::string& key, Entry entry);
+    
+    // Drops every entry from both tiers
+    void clear();
+    
+    size_t memoryEntries() const;
+    size_t diskEntries() const;
+
+private:
+    using LruList = std::list<std::pair<std::string, Entry>>;
+    
+    struct DiskFile {
+        uint64_t bytes = 0;
+        std::filesystem::file_time_type used;
+    };
+    
+    std::string diskPath(const std::string& key) const;
+    std::optional<Entry> readDisk(const std::string& key);
+    void writeDisk(const std::string& key, const Entry& entry);
+    void insertMemoryLocked(const std::string& key, Entry entry);
+    void evictMemoryLocked();
+    void scanDisk();
+    void trackDiskLocked(const std::string& key, uint64_t bytes, std::filesystem::file_time_type used);
+    void forgetDiskLocked(const std::string& key);
+    void evictDiskLocked();
+    
+    Options options;
+    
+    mutable std::mutex mutex;
+    LruList lru; // Most recently used first
+    std::unordered_map<std::string, LruList::iterator> index;
+    size_t memory_bytes = 0;
+    
+    // Files of the disk tier this instance knows of; other apps of the suite share the directory,
+    // so files they write are only counted at the next open
+    mutable std::mutex disk_mutex;
+    std::unordered_map<std::string, DiskFile> disk_files;
+    uint64_t disk_bytes = 0;
+};
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,113 @@
+#include "stream_parser.h"
+#include <cstring>
+
+namespace xeno::ai::detail {
+
+StreamParser::StreamParser(Format format, EventHandler on_event)
+    : format(format), on_event(std::move(on_event)) {}
+
+bool StreamParser::feed(const char* data, size_t length) {
+    if (stopped) {
+        return false;
+    }
+    
+    const char* end = data + length;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        if (!newline) {
+            partial_line.append(data, end - data);
+            break;
+        }
+        
+        // Complete lines are parsed in place unless a previous chunk left a partial line
+        std::string_view line;
+        if (partial_line.empty()) {
+            line = std::string_view(data, newline - data);
+        } else {
+            partial_line.append(data, newline - data);
+            line = partial_line;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        
+        bool keep_going = processLine(line);
+        partial_line.clear();
+        data = newline + 1;
+        if (!keep_going) {
+            stopped = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StreamParser::finish() {
+    if (stopped) {
+        return false;
+    }
+    if (!partial_line.empty()) {
+        std::string line = std::move(partial_line);
+        partial_line.clear();
+        if (!processLine(line)) {
+            stopped = true;
+            return false;
+        }
+    }
+    return format == Format::ServerSentEvents ? dispatch() : true;
+}
+
+bool StreamParser::processLine(std::string_view line) {
+    if (format == Format::JsonLines) {
+        return line.empty() ? true : on_event(line);
+    }
+    
+    // A blank line terminates an SSE event
+    if (line.empty()) {
+        return dispatch();
+    }
+    // Comment lines are keep-alives (e.g. ": OPENROUTER PROCESSING")
+    if (line.front() == ':') {
+        return true;
+    }
+    
+    std::string_view field = line;
+    std::string_view value;
+    size_t colon = line.find(':');
+    if (colon != std::string_view::npos) {
+        field = line.substr(0, colon);
+        value = line.substr(colon + 1);
+        if (!value.empty() && value.front() == ' ') {
+            value.remove_prefix(1);
+        }
+    }
+    
+    // Only data fields carry tokens; event/id/retry are not used by the providers
+    if (field == "data") {
+        if (has_event_data) {
+            event_data.push_back('\n');
+        }
+        event_data.append(value);
+        has_event_data = true;
+    }
+    return true;
+}
+
+bool StreamParser::dispatch() {
+    if (!has_event_data) {
+        return true;
+    }
+    has_event_data = false;
+    
+    if (event_data == "[DONE]") {
+        done = true;
+        event_data.clear();
+        return true;
+    }
+    
+    bool keep_going = on_event(event_data);
+    event_data.clear();
+    return keep_going;
+}
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief Incremental parser for streamed provider responses
+ *
+ * Handles Server-Sent Events (Xeno Cloud, Open Router) and newline-delimited
+ * JSON (Ollama). Bytes are consumed as they arrive; only the unterminated
+ * tail of the current line is buffered, never the whole body.
+ */
+class StreamParser {
+public:
+    enum class Format {
+        ServerSentEvents,
+        JsonLines
+    };
+    
+    // Receives the payload of one event (SSE data field or one JSON line); return false to stop
+    using EventHandler = std::function<bool(std::string_view data)>;
+    
+    StreamParser(Format format, EventHandler on_event);
+    
+    // Returns false once the handler has asked to stop
+    bool feed(const char* data, size_t length);
+    // Flushes an event left unterminated at end of stream
+    bool finish();
+    
+    // True after an SSE "[DONE]" sentinel
+    bool isDone() const { return done; }
+
+private:
+    bool processLine(std::string_view line);
+    bool dispatch();
+    
+    Format format;
+    EventHandler on_event;
+    std::string partial_line;
+    std::string event_data;
+    bool has_event_data = false;
+    bool stopped = false;
+    bool done = false;
+};
+
+} // namespace xeno::ai::detail
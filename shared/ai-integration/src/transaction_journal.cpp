@@ -0,0 +1,463 @@
+#include "transaction_journal.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xeno::ai::detail {
+
+namespace {
+
+constexpr char kMagic[8] = {'X', 'E', 'N', 'O', 'T', 'X', 'J', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 4096;
+constexpr uint8_t kForSync = 1; // Record flag: a deduction the sync server must receive
+
+int64_t toMilliseconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+uint64_t randomId() {
+    std::random_device device;
+    uint64_t id = (uint64_t{device()} << 32) | device();
+    return id ? id : 1;
+}
+
+} // namespace
+
+struct TransactionJournal::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t next_sequence; // Sequence the next append receives; the first is 1
+    uint64_t record_count;
+    uint32_t operation_count;
+    uint32_t reserved;
+    char operations[kMaxOperations][kMaxOperationLength + 1];
+    uint64_t synced_sequence; // Zero in journals written before sync was tracked
+    uint64_t journal_id;      // Zero in journals written before ids were kept
+};
+
+struct TransactionJournal::Record {
+    uint64_t sequence;
+    int64_t timestamp_ms;
+    int32_t credits;
+    uint16_t operation;
+    uint8_t success;
+    uint8_t flags;
+};
+
+/**
+ * @brief Byte range backing a journal: a heap buffer or a locked, memory-mapped file
+ */
+class TransactionJournal::Storage {
+public:
+    static std::unique_ptr<Storage> inMemory(size_t size) {
+        auto storage = std::unique_ptr<Storage>(new Storage());
+        storage->memory.assign(size, 0);
+        storage->data = storage->memory.data();
+        storage->size = size;
+        storage->created = true;
+        return storage;
+    }
+    
+    static std::unique_ptr<Storage> mapFile(const std::string& path, size_t size_if_new) {
+        auto storage = std::unique_ptr<Storage>(new Storage());
+#ifdef _WIN32
+        // No sharing: a second process opening the journal fails instead of corrupting it
+        storage->file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (storage->file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(storage->file, &file_size)) {
+            return nullptr;
+        }
+        if (file_size.QuadPart == 0) {
+            LARGE_INTEGER new_size;
+            new_size.QuadPart = static_cast<LONGLONG>(size_if_new);
+            if (!SetFilePointerEx(storage->file, new_size, nullptr, FILE_BEGIN) || !SetEndOfFile(storage->file)) {
+                return nullptr;
+            }
+            file_size = new_size;
+            storage->created = true;
+        }
+        storage->size = static_cast<size_t>(file_size.QuadPart);
+        storage->mapping = CreateFileMappingA(storage->file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (!storage->mapping) {
+            return nullptr;
+        }
+        storage->data = static_cast<char*>(MapViewOfFile(storage->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+#else
+        storage->fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (storage->fd < 0) {
+            return nullptr;
+        }
+        // Advisory lock: a second process opening the journal fails instead of corrupting it
+        if (flock(storage->fd, LOCK_EX | LOCK_NB) != 0) {
+            return nullptr;
+        }
+        struct stat info;
+        if (fstat(storage->fd, &info) != 0) {
+            return nullptr;
+        }
+        if (info.st_size == 0) {
+            if (ftruncate(storage->fd, static_cast<off_t>(size_if_new)) != 0) {
+                return nullptr;
+            }
+            info.st_size = static_cast<off_t>(size_if_new);
+            storage->created = true;
+        }
+        storage->size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, storage->size, PROT_READ | PROT_WRITE, MAP_SHARED, storage->fd, 0);
+        storage->data = mapped == MAP_FAILED ? nullptr : static_cast<char*>(mapped);
+#endif
+        return storage->data ? std::move(storage) : nullptr;
+    }
+    
+    ~Storage() {
+        if (memory.empty() && data) {
+            flush();
+        }
+#ifdef _WIN32
+        if (memory.empty() && data) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        if (memory.empty() && data) {
+            munmap(data, size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+    
+    void flush() {
+        if (!memory.empty() || !data) {
+            return;
+        }
+#ifdef _WIN32
+        FlushViewOfFile(data, size);
+#else
+        msync(data, size, MS_ASYNC);
+#endif
+    }
+    
+    char* data = nullptr;
+    size_t size = 0;
+    bool created = false; // True when the bytes are fresh and need a header
+
+private:
+    Storage() = default;
+    
+    std::vector<char> memory;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+TransactionJournal::TransactionJournal(size_t capacity)
+    : TransactionJournal(Storage::inMemory(kHeaderSize + std::max<size_t>(capacity, 1) * sizeof(Record))) {
+    initialize(std::max<size_t>(capacity, 1));
+    buildIndex();
+}
+
+TransactionJournal::TransactionJournal(std::unique_ptr<Storage> storage) : storage(std::move(storage)) {}
+
+TransactionJournal::~TransactionJournal() = default;
+
+std::unique_ptr<TransactionJournal> TransactionJournal::open(const std::string& path, size_t capacity) {
+    capacity = std::max<size_t>(capacity, 1);
+    auto storage = Storage::mapFile(path, kHeaderSize + capacity * sizeof(Record));
+    if (!storage) {
+        return nullptr;
+    }
+    
+    bool created = storage->created;
+    std::unique_ptr<TransactionJournal> journal(new TransactionJournal(std::move(storage)));
+    if (created) {
+        journal->initialize(capacity);
+    } else if (!journal->validate()) {
+        return nullptr;
+    } else if (journal->header().journal_id == 0) {
+        journal->header().journal_id = randomId();
+    }
+    journal->buildIndex();
+    return journal;
+}
+
+void TransactionJournal::initialize(size_t capacity) {
+    static_assert(sizeof(Header) <= kHeaderSize, "journal header must fit its page");
+    static_assert(sizeof(Record) == 24, "journal records are fixed at 24 bytes");
+    
+    Header& h = header();
+    std::memset(&h, 0, sizeof(Header));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.record_size = sizeof(Record);
+    h.capacity = capacity;
+    h.next_sequence = 1;
+    h.record_count = 0;
+    h.journal_id = randomId();
+}
+
+bool TransactionJournal::validate() const {
+    if (storage->size < kHeaderSize) {
+        return false;
+    }
+    const Header& h = header();
+    return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+           h.record_size == sizeof(Record) && h.capacity > 0 &&
+           storage->size >= kHeaderSize + h.capacity * sizeof(Record) && h.record_count <= h.capacity &&
+           h.next_sequence > h.record_count && h.operation_count <= kMaxOperations &&
+           h.synced_sequence < h.next_sequence;
+}
+
+void TransactionJournal::buildIndex() {
+    const Header& h = header();
+    operation_ids.clear();
+    operation_index.assign(kMaxOperations, {});
+    for (uint32_t id = 0; id < h.operation_count; id++) {
+        operation_ids.emplace(std::string(h.operations[id]), static_cast<uint16_t>(id));
+    }
+    for (uint64_t sequence = firstSequence(); sequence < h.next_sequence; sequence++) {
+        const Record& record = slot(sequence);
+        if (record.operation < kMaxOperations) {
+            operation_index[record.operation].push_back(sequence);
+        }
+    }
+}
+
+TransactionJournal::Header& TransactionJournal::header() const {
+    return *reinterpret_cast<Header*>(storage->data);
+}
+
+TransactionJournal::Record& TransactionJournal::slot(uint64_t sequence) const {
+    auto* records = reinterpret_cast<Record*>(storage->data + kHeaderSize);
+    return records[(sequence - 1) % header().capacity];
+}
+
+uint64_t TransactionJournal::firstSequence() const {
+    return header().next_sequence - header().record_count;
+}
+
+uint16_t TransactionJournal::internLocked(const std::string& operation) {
+    std::string name = operation.substr(0, kMaxOperationLength);
+    auto it = operation_ids.find(name);
+    if (it != operation_ids.end()) {
+        return it->second;
+    }
+    
+    Header& h = header();
+    if (h.operation_count >= kMaxOperations - 1) {
+        // The table is full; everything new is filed under the last slot
+        name = "other";
+        it = operation_ids.find(name);
+        if (it != operation_ids.end()) {
+            return it->second;
+        }
+        if (h.operation_count >= kMaxOperations) {
+            return static_cast<uint16_t>(kMaxOperations - 1);
+        }
+    }
+    
+    uint16_t id = static_cast<uint16_t>(h.operation_count);
+    std::memset(h.operations[id], 0, sizeof(h.operations[id]));
+    std::memcpy(h.operations[id], name.data(), name.size());
+    h.operation_count++;
+    operation_ids.emplace(name, id);
+    return id;
+}
+
+TransactionJournal::Entry TransactionJournal::toEntry(const Record& record) const {
+    Entry entry;
+    entry.sequence = record.sequence;
+    entry.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(record.timestamp_ms));
+    entry.credits = record.credits;
+    if (record.operation < header().operation_count) {
+        entry.operation = header().operations[record.operation];
+    }
+    entry.success = record.success != 0;
+    return entry;
+}
+
+TransactionJournal::Entry TransactionJournal::append(const std::string& operation, int credits, bool success,
+                                                    bool for_sync) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Header& h = header();
+    uint16_t operation_id = internLocked(operation);
+    
+    // Timestamps never go backwards, which keeps the ring sorted for range queries
+    int64_t timestamp_ms = toMilliseconds(std::chrono::system_clock::now());
+    if (h.record_count > 0) {
+        timestamp_ms = std::max(timestamp_ms, slot(h.next_sequence - 1).timestamp_ms);
+    }
+    
+    uint64_t sequence = h.next_sequence;
+    if (h.record_count == h.capacity) {
+        // The oldest record is about to be overwritten, and it is the oldest of its operation too
+        const Record& oldest = slot(firstSequence());
+        if (oldest.operation < kMaxOperations && !operation_index[oldest.operation].empty()) {
+            operation_index[oldest.operation].pop_front();
+        }
+    }
+    
+    Record& record = slot(sequence);
+    record.sequence = sequence;
+    record.timestamp_ms = timestamp_ms;
+    record.credits = credits;
+    record.operation = operation_id;
+    record.success = success ? 1 : 0;
+    record.flags = for_sync ? kForSync : 0;
+    
+    // Counters move only after the record is complete
+    if (h.record_count < h.capacity) {
+        h.record_count++;
+    }
+    h.next_sequence = sequence + 1;
+    operation_index[operation_id].push_back(sequence);
+    
+    return toEntry(record);
+}
+
+size_t TransactionJournal::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return header().record_count;
+}
+
+size_t TransactionJournal::capacity() const {
+    return header().capacity;
+}
+
+std::vector<TransactionJournal::Entry> TransactionJournal::tail(size_t count) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Header& h = header();
+    count = std::min<size_t>(count, h.record_count);
+    
+    std::vector<Entry> entries;
+    entries.reserve(count);
+    for (uint64_t sequence = h.next_sequence - count; sequence < h.next_sequence; sequence++) {
+        entries.push_back(toEntry(slot(sequence)));
+    }
+    return entries;
+}
+
+std::vector<TransactionJournal::Entry> TransactionJournal::range(std::chrono::system_clock::time_point from,
+                                                                 std::chrono::system_clock::time_point to,
+                                                                 size_t limit) const {
+    std::vector<Entry> entries;
+    if (to <= from || limit == 0) {
+        return entries;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t first = firstSequence();
+    uint64_t end = header().next_sequence;
+    
+    // First sequence in [first, end) whose timestamp is >= the given time
+    auto lowerBound = [&](int64_t timestamp_ms) {
+        uint64_t low = first;
+        uint64_t high = end;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            if (slot(middle).timestamp_ms < timestamp_ms) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+    
+    // Records older than the ring keeps are gone, so the range starts no earlier than the oldest kept
+    uint64_t range_begin = std::max(lowerBound(toMilliseconds(from)), first);
+    uint64_t range_end = lowerBound(toMilliseconds(to));
+    if (range_end <= range_begin) {
+        return entries;
+    }
+    if (range_end - range_begin > limit) {
+        range_begin = range_end - limit;
+    }
+    
+    for (uint64_t sequence = range_begin; sequence < range_end; sequence++) {
+        entries.push_back(toEntry(slot(sequence)));
+    }
+    return entries;
+}
+
+std::vector<TransactionJournal::Entry> TransactionJournal::byOperation(const std::string& operation,
+                                                                       size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Entry> entries;
+    auto it = operation_ids.find(operation.substr(0, kMaxOperationLength));
+    if (it == operation_ids.end()) {
+        return entries;
+    }
+    
+    const auto& sequences = operation_index[it->second];
+    size_t count = std::min(limit, sequences.size());
+    for (size_t i = sequences.size() - count; i < sequences.size(); i++) {
+        entries.push_back(toEntry(slot(sequences[i])));
+    }
+    return entries;
+}
+
+std::vector<TransactionJournal::Entry> TransactionJournal::unsynced(uint64_t after, size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Entry> entries;
+    uint64_t sequence = std::max(after + 1, std::max(firstSequence(), header().synced_sequence + 1));
+    for (; sequence < header().next_sequence && entries.size() < limit; sequence++) {
+        const Record& record = slot(sequence);
+        if (record.flags & kForSync) {
+            entries.push_back(toEntry(record));
+        }
+    }
+    return entries;
+}
+
+uint64_t TransactionJournal::id() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return header().journal_id;
+}
+
+uint64_t TransactionJournal::syncedThrough() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return header().synced_sequence;
+}
+
+void TransactionJournal::markSynced(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Header& h = header();
+    h.synced_sequence = std::max(h.synced_sequence, std::min(sequence, h.next_sequence - 1));
+}
+
+void TransactionJournal::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    storage->flush();
+}
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xeno::ai::detail {
+
+/**
+ * @brief Append-only log of credit transactions in fixed-size records
+ *
+ * Records are 24 bytes (sequence, millisecond timestamp, credits, interned
+ * operation id) laid out in a ring of fixed capacity, so the newest
+ * `capacity` transactions are kept and memory never grows. A file-backed
+ * journal is memory-mapped and survives restarts; the file is locked so
+ * only one process writes it at a time.
+ *
+ * Records are stored in timestamp order, which makes time range queries a
+ * binary search. A per-operation index answers operation queries without a
+ * scan.
+ *
+ * Records appended for sync are flagged, and a synced-through sequence kept
+ * in the header marks how far the server has acknowledged them, so a restart
+ * can pick up exactly the ones still owed.
+ *
+ * Each journal gets a random id when it is created, which keeps sequences
+ * from different journals (or processes) apart.
+ */
+class TransactionJournal {
+public:
+    struct Entry {
+        uint64_t sequence = 0;
+        std::chrono::system_clock::time_point timestamp;
+        int credits = 0;
+        std::string operation;
+        bool success = false;
+    };
+    
+    // Distinct operation names; later names share the last slot ("other")
+    static constexpr size_t kMaxOperations = 64;
+    static constexpr size_t kMaxOperationLength = 47;
+    
+    // Journal held in process memory only
+    explicit TransactionJournal(size_t capacity);
+    ~TransactionJournal();
+    
+    TransactionJournal(const TransactionJournal&) = delete;
+    TransactionJournal& operator=(const TransactionJournal&) = delete;
+    
+    // Maps the journal at path, creating it with room for capacity records. An existing
+    // journal keeps its own capacity. Returns nullptr if the file is unusable or locked.
+    static std::unique_ptr<TransactionJournal> open(const std::string& path, size_t capacity);
+    
+    // for_sync entries are returned by unsynced() until markSynced() passes them
+    Entry append(const std::string& operation, int credits, bool success, bool for_sync = false);
+    
+    size_t size() const;
+    size_t capacity() const;
+    // Random and nonzero; a file-backed journal keeps its id across restarts
+    uint64_t id() const;
+    
+    // Newest `count` entries, oldest first
+    std::vector<Entry> tail(size_t count) const;
+    // Entries with from <= timestamp < to, oldest first, at most limit of the newest
+    std::vector<Entry> range(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                             size_t limit) const;
+    // Newest `limit` entries for one operation, oldest first
+    std::vector<Entry> byOperation(const std::string& operation, size_t limit) const;
+    
+    // Entries appended for sync with a sequence above after, oldest first, at most limit
+    std::vector<Entry> unsynced(uint64_t after, size_t limit) const;
+    // Highest sequence the server has acknowledged; 0 before the first
+    uint64_t syncedThrough() const;
+    void markSynced(uint64_t sequence);
+    
+    // Asks the OS to write dirty pages back to the file
+    void flush();
+
+private:
+    struct Header;
+    struct Record;
+    class Storage;
+    
+    explicit TransactionJournal(std::unique_ptr<Storage> storage);
+    
+    void initialize(size_t capacity);
+    bool validate() const;
+    void buildIndex();
+    
+    Header& header() const;
+    Record& slot(uint64_t sequence) const;
+    uint16_t internLocked(const std::string& operation);
+    Entry toEntry(const Record& record) const;
+    uint64_t firstSequence() const;
+    
+    std::unique_ptr<Storage> storage;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, uint16_t> operation_ids;
+    std::vector<std::deque<uint64_t>> operation_index; // Sequences per operation id, oldest first
+};
+
+} // namespace xeno::ai::detail
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace xeno::dsp {
+
+constexpr int kMaxChannels = 8;
+
+/**
+ * @brief Non-owning view of planar float samples
+ */
+struct AudioBlock {
+    std::array<float*, kMaxChannels> data{};
+    int channels = 0;
+    size_t frames = 0;
+    
+    float* channel(int index) const { return data[index]; }
+};
+
+/**
+ * @brief Owning planar float buffer, one contiguous run of samples per channel
+ *
+ * Storage is sized once by allocate(); setFrames() and the interleave
+ * helpers then only move samples, so a prepared buffer is safe to use on a
+ * real-time thread.
+ */
+class AudioBuffer {
+public:
+    AudioBuffer() = default;
+    AudioBuffer(int channels, size_t capacity) { allocate(channels, capacity); }
+    
+    void allocate(int channels, size_t capacity);
+    
+    int channels() const { return channel_count; }
+    size_t frames() const { return frame_count; }
+    size_t capacity() const { return frame_capacity; }
+    // frames is clamped to the capacity
+    void setFrames(size_t frames);
+    
+    float* channel(int index) { return samples.data() + index * frame_capacity; }
+    const float* channel(int index) const { return samples.data() + index * frame_capacity; }
+    AudioBlock block(size_t offset, size_t frames);
+    
+    void clear();
+    // Copies frames interleaved samples in, setting frames()
+    void deinterleave(const float* interleaved, size_t frames);
+    void interleave(float* interleaved) const;
+
+private:
+    std::vector<float> samples;
+    int channel_count = 0;
+    size_t frame_count = 0;
+    size_t frame_capacity = 0;
+};
+
+/**
+ * @brief One stage of an EffectChain
+ *
+ * prepare() may allocate and runs before processing starts; process() must
+ * not allocate, lock or block. Parameter setters are atomic, so a UI thread
+ * can change them while the audio thread processes.
+ */
+class Processor {
+public:
+    virtual ~Processor() = default;
+    
+    virtual void prepare(double sample_rate, int channels, size_t max_frames) = 0;
+    // block.frames never exceeds the max_frames given to prepare()
+    virtual void process(const AudioBlock& block) = 0;
+    // Clears internal state, e.g. after a seek
+    virtual void reset() {}
+    // Frames by which output lags input
+    virtual size_t latency() const { return 0; }
+};
+
+/**
+ * @brief Gain stage that ramps to a new gain over one block, so changes never click
+ */
+class GainProcessor : public Processor {
+public:
+    void setGain(float linear) { target_gain.store(linear, std::memory_order_relaxed); }
+    float gain() const { return target_gain.load(std::memory_order_relaxed); }
+    
+    void prepare(double sample_rate, int channels, size_t max_frames) override;
+    void process(const AudioBlock& block) override;
+    void reset() override;
+
+private:
+    std::atomic<float> target_gain{1.0f};
+    float current_gain = 1.0f;
+};
+
+/**
+ * @brief Spectral-subtraction noise reducer
+ *
+ * Runs a 1024-point STFT with 75% overlap; two channels share each complex
+ * FFT. Per bin, the noise floor is the minimum of the smoothed magnitude over
+ * the last ~1.6 s (minimum statistics), so it follows a changing background
+ * but not speech or music. Each bin is attenuated by its estimated noise
+ * share, down to a fixed floor, and gains are smoothed over time against
+ * "musical noise". Strength 0 skips the FFT but keeps the same latency.
+ */
+class NoiseReducer : public Processor {
+public:
+    static constexpr size_t kFftSize = 1024;
+    static constexpr size_t kHopSize = kFftSize / 4;
+    
+    // 0 = off, 1 = full reduction
+    void setStrength(float strength) { target_strength.store(strength, std::memory_order_relaxed); }
+    float strength() const { return target_strength.load(std::memory_order_relaxed); }
+    
+    void prepare(double sample_rate, int channels, size_t max_frames) override;
+    void process(const AudioBlock& block) override;
+    void reset() override;
+    size_t latency() const override { return kFftSize; }
+
+private:
+    static constexpr size_t kBins = kFftSize / 2 + 1;
+    static constexpr size_t kMinimumWindows = 4;
+    
+    struct ChannelState {
+        std::vector<float> input;          // Last kFftSize input samples
+        std::vector<float> output;         // Overlap-add accumulator
+        std::vector<float> smoothed;       // Per-bin magnitude, smoothed over frames
+        std::vector<float> minimum;        // Per-bin minimum in the current window
+        std::vector<float> past_minimum;   // Per-bin minimum over the previous windows
+        std::vector<float> window_minima;  // kMinimumWindows minima per bin
+        std::vector<float> gains;          // Per-bin gains of the previous frame
+        std::vector<std::complex<float>> bins;
+    };
+    
+    // Processes one hop for a channel and an optional second channel packed into the same FFT
+    void processPair(ChannelState& first, ChannelState* second, float strength);
+    void updateGains(ChannelState& state, float strength);
+    void fft(std::complex<float>* data) const;
+    void endMinimumWindow();
+    
+    std::atomic<float> target_strength{0.0f};
+    std::vector<ChannelState> states;
+    std::vector<float> window;                 // sqrt-Hann, used for analysis and synthesis
+    std::vector<std::complex<float>> spectrum;  // FFT scratch
+    std::vector<std::complex<float>> twiddles;
+    std::vector<uint32_t> bit_reverse;
+    size_t fill = 0;               // Samples of the current hop already taken
+    size_t frames_per_window = 1;  // Minimum-statistics window, in hops
+    size_t frames_in_window = 0;
+    size_t window_index = 0;
+};
+
+/**
+ * @brief Real-time pitch shifter built on a modulated delay line
+ *
+ * Two read taps sweep through a 40 ms delay line at the pitch ratio and are
+ * crossfaded with complementary sin^2 windows, so the output stays continuous
+ * with no FFT and no added latency beyond the sweep. A shift of 0 bypasses it.
+ */
+class PitchShifter : public Processor {
+public:
+    void setSemitones(float semitones) { target_semitones.store(semitones, std::memory_order_relaxed); }
+    float semitones() const { return target_semitones.load(std::memory_order_relaxed); }
+    
+    void prepare(double sample_rate, int channels, size_t max_frames) override;
+    void process(const AudioBlock& block) override;
+    void reset() override;
+
+private:
+    std::atomic<float> target_semitones{0.0f};
+    std::vector<std::vector<float>> delay_lines;
+    size_t mask = 0;
+    size_t write_position = 0;
+    double window = 0.0;  // Sweep length in samples
+    double phase = 0.0;   // Position in the sweep, [0, 1)
+};
+
+/**
+ * @brief Parameters of an EffectChain, e.g. to configure an offline render
+ */
+struct EffectSettings {
+    float gain = 1.0f;            // Linear
+    float noise_reduction = 0.0f; // 0 to 1
+    float semitones = 0.0f;
+};
+
+/**
+ * @brief Gain, then noise reduction, then pitch shift, on planar blocks
+ *
+ * processInterleaved() lets a device callback use the chain directly: the
+ * samples are converted through a buffer allocated in prepare().
+ */
+class EffectChain {
+public:
+    static constexpr size_t kDefaultBlockFrames = 4096;
+    
+    // False for a channel count the chain cannot process; processing is then a no-op
+    bool prepare(double sample_rate, int channels, size_t max_frames = kDefaultBlockFrames);
+    bool prepared() const { return planar.channels() > 0; }
+    void reset();
+    
+    void apply(const EffectSettings& settings);
+    EffectSettings settings() const;
+    
+    // Any number of frames; processed in blocks of at most max_frames
+    void process(AudioBuffer& buffer);
+    void processInterleaved(float* samples, size_t frames);
+    
+    size_t latency() const;
+    
+    GainProcessor& gain() { return gain_stage; }
+    NoiseReducer& noiseReducer() { return noise_reducer; }
+    PitchShifter& pitchShifter() { return pitch_shifter; }
+
+private:
+    void processBlock(const AudioBlock& block);
+    
+    GainProcessor gain_stage;
+    NoiseReducer noise_reducer;
+    PitchShifter pitch_shifter;
+    AudioBuffer planar;
+    size_t block_frames = 0;
+};
+
+} // namespace xeno::dsp
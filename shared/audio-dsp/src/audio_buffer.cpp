@@ -0,0 +1,51 @@
+#include "audio_dsp.h"
+#include <algorithm>
+
+namespace xeno::dsp {
+
+void AudioBuffer::allocate(int channels, size_t capacity) {
+    channel_count = std::clamp(channels, 0, kMaxChannels);
+    frame_capacity = capacity;
+    frame_count = 0;
+    samples.assign(static_cast<size_t>(channel_count) * frame_capacity, 0.0f);
+}
+
+void AudioBuffer::setFrames(size_t frames) {
+    frame_count = std::min(frames, frame_capacity);
+}
+
+AudioBlock AudioBuffer::block(size_t offset, size_t frames) {
+    AudioBlock view;
+    offset = std::min(offset, frame_count);
+    view.channels = channel_count;
+    view.frames = std::min(frames, frame_count - offset);
+    for (int c = 0; c < channel_count; ++c) {
+        view.data[c] = channel(c) + offset;
+    }
+    return view;
+}
+
+void AudioBuffer::clear() {
+    std::fill(samples.begin(), samples.end(), 0.0f);
+}
+
+void AudioBuffer::deinterleave(const float* interleaved, size_t frames) {
+    setFrames(frames);
+    for (int c = 0; c < channel_count; ++c) {
+        float* destination = channel(c);
+        for (size_t i = 0; i < frame_count; ++i) {
+            destination[i] = interleaved[i * channel_count + c];
+        }
+    }
+}
+
+void AudioBuffer::interleave(float* interleaved) const {
+    for (int c = 0; c < channel_count; ++c) {
+        const float* source = channel(c);
+        for (size_t i = 0; i < frame_count; ++i) {
+            interleaved[i * channel_count + c] = source[i];
+        }
+    }
+}
+
+} // namespace xeno::dsp
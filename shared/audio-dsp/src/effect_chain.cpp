@@ -0,0 +1,96 @@
+#include "audio_dsp.h"
+#include <algorithm>
+
+#include "media_kernels.h"
+
+namespace xeno::dsp {
+
+void GainProcessor::prepare(double, int, size_t) {
+    reset();
+}
+
+void GainProcessor::process(const AudioBlock& block) {
+    float target = target_gain.load(std::memory_order_relaxed);
+    if (block.frames == 0 || (target == 1.0f && current_gain == 1.0f)) {
+        return;
+    }
+    
+    // Ramp across the block so a slider move never steps the signal
+    float step = (target - current_gain) / static_cast<float>(block.frames);
+    for (int c = 0; c < block.channels; ++c) {
+        media::applyGainRamp(block.channel(c), block.frames, current_gain, step);
+    }
+    current_gain = target;
+}
+
+void GainProcessor::reset() {
+    current_gain = target_gain.load(std::memory_order_relaxed);
+}
+
+bool EffectChain::prepare(double sample_rate, int channels, size_t max_frames) {
+    if (channels < 1 || channels > kMaxChannels || max_frames == 0) {
+        planar.allocate(0, 0);
+        return false;
+    }
+    
+    block_frames = max_frames;
+    planar.allocate(channels, max_frames);
+    gain_stage.prepare(sample_rate, channels, max_frames);
+    noise_reducer.prepare(sample_rate, channels, max_frames);
+    pitch_shifter.prepare(sample_rate, channels, max_frames);
+    return true;
+}
+
+void EffectChain::reset() {
+    gain_stage.reset();
+    noise_reducer.reset();
+    pitch_shifter.reset();
+}
+
+void EffectChain::apply(const EffectSettings& settings) {
+    gain_stage.setGain(settings.gain);
+    noise_reducer.setStrength(settings.noise_reduction);
+    pitch_shifter.setSemitones(settings.semitones);
+}
+
+EffectSettings EffectChain::settings() const {
+    EffectSettings settings;
+    settings.gain = gain_stage.gain();
+    settings.noise_reduction = noise_reducer.strength();
+    settings.semitones = pitch_shifter.semitones();
+    return settings;
+}
+
+void EffectChain::process(AudioBuffer& buffer) {
+    if (!prepared() || buffer.channels() != planar.channels()) {
+        return;
+    }
+    for (size_t offset = 0; offset < buffer.frames(); offset += block_frames) {
+        processBlock(buffer.block(offset, block_frames));
+    }
+}
+
+void EffectChain::processInterleaved(float* samples, size_t frames) {
+    if (!prepared()) {
+        return;
+    }
+    size_t channels = static_cast<size_t>(planar.channels());
+    for (size_t offset = 0; offset < frames; offset += block_frames) {
+        size_t count = std::min(block_frames, frames - offset);
+        planar.deinterleave(samples + offset * channels, count);
+        processBlock(planar.block(0, count));
+        planar.interleave(samples + offset * channels);
+    }
+}
+
+size_t EffectChain::latency() const {
+    return gain_stage.latency() + noise_reducer.latency() + pitch_shifter.latency();
+}
+
+void EffectChain::processBlock(const AudioBlock& block) {
+    gain_stage.process(block);
+    noise_reducer.process(block);
+    pitch_shifter.process(block);
+}
+
+} // namespace xeno::dsp
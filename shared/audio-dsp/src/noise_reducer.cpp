@@ -0,0 +1,238 @@
+#include "audio_dsp.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace xeno::dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kOverlapScale = 0.5f;       // sqrt-Hann squared sums to 2 at 75% overlap
+constexpr float kOverSubtraction = 2.0f;    // Minimum statistics underestimate the mean noise level
+constexpr float kGainFloor = 0.1f;          // -20 dB; deeper cuts sound watery
+constexpr float kGainSmoothing = 0.5f;      // Share of the previous frame's gain
+constexpr float kMagnitudeSmoothing = 0.7f; // Share of the previous frame's magnitude
+constexpr double kMinimumWindowSeconds = 0.4;
+
+// std::complex multiplication handles NaN/infinity operands through a slow library call
+inline std::complex<float> multiply(std::complex<float> a, std::complex<float> b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+} // namespace
+
+void NoiseReducer::prepare(double sample_rate, int channels, size_t) {
+    window.resize(kFftSize);
+    for (size_t n = 0; n < kFftSize; ++n) {
+        window[n] = static_cast<float>(std::sqrt(0.5 * (1.0 - std::cos(2.0 * kPi * n / kFftSize))));
+    }
+    
+    twiddles.resize(kFftSize / 2);
+    for (size_t k = 0; k < kFftSize / 2; ++k) {
+        double angle = -2.0 * kPi * k / kFftSize;
+        twiddles[k] = {static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+    }
+    
+    bit_reverse.resize(kFftSize);
+    size_t bits = 0;
+    while ((size_t(1) << bits) < kFftSize) {
+        ++bits;
+    }
+    for (size_t i = 0; i < kFftSize; ++i) {
+        uint32_t reversed = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        bit_reverse[i] = reversed;
+    }
+    
+    spectrum.resize(kFftSize);
+    states.assign(std::max(channels, 0), ChannelState{});
+    for (auto& state : states) {
+        state.input.resize(kFftSize);
+        state.output.resize(kFftSize);
+        state.smoothed.resize(kBins);
+        state.minimum.resize(kBins);
+        state.past_minimum.resize(kBins);
+        state.window_minima.resize(kBins * kMinimumWindows);
+        state.gains.resize(kBins);
+        state.bins.resize(kBins);
+    }
+    frames_per_window = std::max<size_t>(1, static_cast<size_t>(kMinimumWindowSeconds * sample_rate / kHopSize));
+    reset();
+}
+
+void NoiseReducer::reset() {
+    for (auto& state : states) {
+        std::fill(state.input.begin(), state.input.end(), 0.0f);
+        std::fill(state.output.begin(), state.output.end(), 0.0f);
+        std::fill(state.smoothed.begin(), state.smoothed.end(), 0.0f);
+        std::fill(state.minimum.begin(), state.minimum.end(), FLT_MAX);
+        std::fill(state.past_minimum.begin(), state.past_minimum.end(), FLT_MAX);
+        std::fill(state.window_minima.begin(), state.window_minima.end(), FLT_MAX);
+        std::fill(state.gains.begin(), state.gains.end(), 1.0f);
+    }
+    fill = 0;
+    frames_in_window = 0;
+    window_index = 0;
+}
+
+void NoiseReducer::process(const AudioBlock& block) {
+    int channels = std::min(block.channels, static_cast<int>(states.size()));
+    size_t done = 0;
+    while (done < block.frames) {
+        // Take new input into the end of the frame and hand out finished output
+        size_t count = std::min(kHopSize - fill, block.frames - done);
+        for (int c = 0; c < channels; ++c) {
+            ChannelState& state = states[c];
+            float* samples = block.channel(c) + done;
+            float* input = state.input.data() + (kFftSize - kHopSize) + fill;
+            const float* output = state.output.data() + fill;
+            for (size_t i = 0; i < count; ++i) {
+                input[i] = samples[i];
+                samples[i] = output[i];
+            }
+        }
+        fill += count;
+        done += count;
+        
+        if (fill == kHopSize) {
+            float strength = std::clamp(target_strength.load(std::memory_order_relaxed), 0.0f, 1.0f);
+            for (int c = 0; c < channels; c += 2) {
+                processPair(states[c], c + 1 < channels ? &states[c + 1] : nullptr, strength);
+            }
+            if (++frames_in_window == frames_per_window) {
+                endMinimumWindow();
+            }
+            fill = 0;
+        }
+    }
+}
+
+void NoiseReducer::processPair(ChannelState& first, ChannelState* second, float strength) {
+    ChannelState* pair[2] = {&first, second};
+    for (ChannelState* state : pair) {
+        if (state) {
+            std::move(state->output.begin() + kHopSize, state->output.end(), state->output.begin());
+            std::fill(state->output.end() - kHopSize, state->output.end(), 0.0f);
+        }
+    }
+    
+    if (strength <= 0.0f) {
+        // The FFT round trip is the identity, so only the windows remain
+        for (ChannelState* state : pair) {
+            if (state) {
+                for (size_t n = 0; n < kFftSize; ++n) {
+                    state->output[n] += state->input[n] * window[n] * window[n] * kOverlapScale;
+                }
+            }
+        }
+    } else {
+        // Two real channels share one complex FFT: z = a + i b
+        for (size_t n = 0; n < kFftSize; ++n) {
+            float b = second ? second->input[n] : 0.0f;
+            spectrum[n] = {first.input[n] * window[n], b * window[n]};
+        }
+        fft(spectrum.data());
+        
+        for (size_t k = 0; k < kBins; ++k) {
+            std::complex<float> z = spectrum[k];
+            std::complex<float> mirror = std::conj(spectrum[(kFftSize - k) % kFftSize]);
+            first.bins[k] = (z + mirror) * 0.5f;
+            if (second) {
+                std::complex<float> difference = (z - mirror) * 0.5f;
+                second->bins[k] = {difference.imag(), -difference.real()}; // Divides by i
+            }
+        }
+        
+        updateGains(first, strength);
+        if (second) {
+            updateGains(*second, strength);
+        }
+        
+        // Rebuild the packed spectrum from both Hermitian halves, conjugated for the inverse
+        for (size_t k = 0; k < kBins; ++k) {
+            std::complex<float> a = first.bins[k] * first.gains[k];
+            std::complex<float> b = second ? second->bins[k] * second->gains[k] : std::complex<float>();
+            std::complex<float> ib(-b.imag(), b.real());
+            spectrum[k] = std::conj(a + ib);
+            if (k > 0 && k < kFftSize / 2) {
+                std::complex<float> ib_mirror(b.imag(), b.real()); // i * conj(b)
+                spectrum[kFftSize - k] = std::conj(std::conj(a) + ib_mirror);
+            }
+        }
+        fft(spectrum.data());
+        
+        float scale = kOverlapScale / kFftSize;
+        for (size_t n = 0; n < kFftSize; ++n) {
+            // conj() of the forward transform: real part is a, negated imaginary part is b
+            first.output[n] += spectrum[n].real() * window[n] * scale;
+            if (second) {
+                second->output[n] -= spectrum[n].imag() * window[n] * scale;
+            }
+        }
+    }
+    
+    for (ChannelState* state : pair) {
+        if (state) {
+            std::move(state->input.begin() + kHopSize, state->input.end(), state->input.begin());
+        }
+    }
+}
+
+void NoiseReducer::updateGains(ChannelState& state, float strength) {
+    for (size_t k = 0; k < kBins; ++k) {
+        float magnitude = std::abs(state.bins[k]);
+        float smoothed = kMagnitudeSmoothing * state.smoothed[k] + (1.0f - kMagnitudeSmoothing) * magnitude;
+        state.smoothed[k] = smoothed;
+        state.minimum[k] = std::min(state.minimum[k], smoothed);
+        
+        float noise = std::min(state.minimum[k], state.past_minimum[k]);
+        float gain = 1.0f - strength * kOverSubtraction * noise / std::max(magnitude, 1e-12f);
+        gain = std::clamp(gain, kGainFloor, 1.0f);
+        state.gains[k] = kGainSmoothing * state.gains[k] + (1.0f - kGainSmoothing) * gain;
+    }
+}
+
+void NoiseReducer::endMinimumWindow() {
+    // Keeps the last kMinimumWindows window minima; the oldest drops out
+    for (auto& state : states) {
+        float* slot = state.window_minima.data() + window_index * kBins;
+        std::copy(state.minimum.begin(), state.minimum.end(), slot);
+        for (size_t k = 0; k < kBins; ++k) {
+            float lowest = FLT_MAX;
+            for (size_t w = 0; w < kMinimumWindows; ++w) {
+                lowest = std::min(lowest, state.window_minima[w * kBins + k]);
+            }
+            state.past_minimum[k] = lowest;
+        }
+        std::fill(state.minimum.begin(), state.minimum.end(), FLT_MAX);
+    }
+    window_index = (window_index + 1) % kMinimumWindows;
+    frames_in_window = 0;
+}
+
+void NoiseReducer::fft(std::complex<float>* data) const {
+    for (size_t i = 0; i < kFftSize; ++i) {
+        size_t j = bit_reverse[i];
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    
+    for (size_t length = 2; length <= kFftSize; length <<= 1) {
+        size_t half = length / 2;
+        size_t stride = kFftSize / length;
+        for (size_t start = 0; start < kFftSize; start += length) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<float> even = data[start + k];
+                std::complex<float> odd = multiply(data[start + k + half], twiddles[k * stride]);
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+} // namespace xeno::dsp
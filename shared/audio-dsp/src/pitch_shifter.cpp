@@ -0,0 +1,86 @@
+#include "audio_dsp.h"
+#include <algorithm>
+#include <cmath>
+
+namespace xeno::dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSweepSeconds = 0.04;
+constexpr float kBypassSemitones = 0.01f;
+
+} // namespace
+
+void PitchShifter::prepare(double sample_rate, int channels, size_t) {
+    window = std::max(64.0, std::round(kSweepSeconds * sample_rate));
+    size_t size = 1;
+    while (size < static_cast<size_t>(window) + 2) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    delay_lines.assign(std::max(channels, 0), std::vector<float>(size, 0.0f));
+    reset();
+}
+
+void PitchShifter::reset() {
+    for (auto& line : delay_lines) {
+        std::fill(line.begin(), line.end(), 0.0f);
+    }
+    write_position = 0;
+    phase = 0.0;
+}
+
+void PitchShifter::process(const AudioBlock& block) {
+    int channels = std::min(block.channels, static_cast<int>(delay_lines.size()));
+    float semitones = target_semitones.load(std::memory_order_relaxed);
+    
+    if (std::abs(semitones) < kBypassSemitones) {
+        // Keep the delay lines current so switching on does not replay stale audio
+        for (size_t i = 0; i < block.frames; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                delay_lines[c][(write_position + i) & mask] = block.channel(c)[i];
+            }
+        }
+        write_position = (write_position + block.frames) & mask;
+        return;
+    }
+    
+    // Tap delays change by (1 - ratio) samples per sample, which plays them back at ratio
+    double ratio = std::pow(2.0, semitones / 12.0);
+    double increment = (1.0 - ratio) / window;
+    double size = static_cast<double>(mask + 1);
+    
+    for (size_t i = 0; i < block.frames; ++i) {
+        double second_phase = phase + 0.5 >= 1.0 ? phase - 0.5 : phase + 0.5;
+        double shape = std::sin(kPi * phase);
+        float first_gain = static_cast<float>(shape * shape); // Complements the second tap's gain to 1
+        double first_read = write_position + size - phase * window;
+        double second_read = write_position + size - second_phase * window;
+        
+        for (int c = 0; c < channels; ++c) {
+            std::vector<float>& line = delay_lines[c];
+            float* sample = block.channel(c) + i;
+            line[write_position] = *sample;
+            
+            auto tap = [&](double position) {
+                size_t index = static_cast<size_t>(position);
+                float fraction = static_cast<float>(position - static_cast<double>(index));
+                float a = line[index & mask];
+                float b = line[(index + 1) & mask];
+                return a + (b - a) * fraction;
+            };
+            *sample = first_gain * tap(first_read) + (1.0f - first_gain) * tap(second_read);
+        }
+        
+        write_position = (write_position + 1) & mask;
+        phase += increment;
+        if (phase >= 1.0) {
+            phase -= 1.0;
+        } else if (phase < 0.0) {
+            phase += 1.0;
+        }
+    }
+}
+
+} // namespace xeno::dsp
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace xeno::media {
+
+/**
+ * @brief Instruction sets the kernels can run on
+ *
+ * The best level the CPU supports is chosen at runtime, so one binary runs
+ * everywhere and still uses AVX2 where it is available.
+ */
+enum class SimdLevel {
+    Scalar,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+SimdLevel detectedSimdLevel();
+SimdLevel activeSimdLevel();
+// Restricts kernels to a level, e.g. to compare against Scalar; false if the CPU lacks it
+bool setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * @brief 8-bit lookup table for point operations
+ *
+ * Brightness, contrast and gamma fold into one table, so any combination of
+ * them costs a single pass over the pixels.
+ */
+using Lut = std::array<uint8_t, 256>;
+
+// out = contrast * (255 * (in / 255)^(1 / gamma)) + brightness, rounded and saturated
+Lut makeLut(double contrast, double brightness, double gamma = 1.0);
+
+/*
+ * Kernels process packed 8-bit data in one pass. dst may be the same buffer
+ * as a source (in place) but must not partially overlap one. Image rows are
+ * processed one call per row when they are not contiguous.
+ */
+
+// dst[i] = lut[src[i]] for count bytes
+void applyLut(const uint8_t* src, uint8_t* dst, size_t count, const Lut& lut);
+
+// dst = a * weight + b * (1 - weight) over count bytes; weight is quantized to 1/256
+void blend(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, float weight);
+
+// Swaps the first and third channel of packed 3-channel pixels (BGR <-> RGB)
+void swizzleRGB(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// Multiplies the colour channels of packed 4-channel pixels by alpha (the fourth channel)
+void premultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// data[i] *= start + i * step over one channel of float samples; a nonzero step
+// ramps between gains so a change does not click
+void applyGainRamp(float* data, size_t count, float start, float step);
+
+} // namespace xeno::media
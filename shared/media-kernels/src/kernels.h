@@ -0,0 +1,43 @@
+#pragma once
+
+#include "media_kernels.h"
+
+namespace xeno::media::detail {
+
+/**
+ * @brief One implementation of every kernel for a given instruction set
+ */
+struct KernelTable {
+    void (*apply_lut)(const uint8_t* src, uint8_t* dst, size_t count, const Lut& lut);
+    void (*blend)(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, uint16_t weight);
+    void (*swizzle_rgb)(const uint8_t* src, uint8_t* dst, size_t pixels);
+    void (*premultiply_alpha)(const uint8_t* src, uint8_t* dst, size_t pixels);
+    void (*gain_ramp)(float* data, size_t count, float start, float step);
+};
+
+// Blend weights are 8.8 fixed point: dst = (a * w + b * (256 - w) + 128) >> 8
+constexpr uint16_t kBlendOne = 256;
+
+inline uint8_t blendPixel(uint8_t a, uint8_t b, uint16_t weight) {
+    return static_cast<uint8_t>((a * weight + b * (kBlendOne - weight) + 128) >> 8);
+}
+
+// round(c * alpha / 255) without a division
+inline uint8_t premultiplyChannel(uint8_t c, uint8_t alpha) {
+    unsigned t = c * alpha + 128u;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+// gain_ramp over elements [first, count), so SIMD versions finish with the scalar arithmetic
+void gainRampTail(float* data, size_t first, size_t count, float start, float step);
+
+const KernelTable& scalarKernels();
+#if defined(XENO_KERNELS_X86)
+const KernelTable& sse41Kernels();
+const KernelTable& avx2Kernels();
+#endif
+#if defined(XENO_KERNELS_NEON)
+const KernelTable& neonKernels();
+#endif
+
+} // namespace xeno::media::detail
@@ -0,0 +1,85 @@
+#include "kernels.h"
+#include <immintrin.h>
+
+// Built with AVX2 enabled; only called once the CPU reports support. The
+// algorithms match kernels_sse41.cpp, 32 bytes at a time; AVX2 shuffles and
+// packs work within each 128-bit lane, which these kernels never cross.
+// Lookups and the RGB swizzle (whose pixels cross lanes) use the SSE4.1 code.
+
+namespace xeno::media::detail {
+
+namespace {
+
+__m256i blendHalf(__m256i a, __m256i b, __m256i weight, __m256i inverse) {
+    const __m256i round = _mm256_set1_epi16(128);
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(a, weight), _mm256_mullo_epi16(b, inverse));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, round), 8);
+}
+
+void blendAVX2(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, uint16_t weight) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i w = _mm256_set1_epi16(static_cast<short>(weight));
+    const __m256i inverse = _mm256_set1_epi16(static_cast<short>(kBlendOne - weight));
+    
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i lo = blendHalf(_mm256_unpacklo_epi8(va, zero), _mm256_unpacklo_epi8(vb, zero), w, inverse);
+        __m256i hi = blendHalf(_mm256_unpackhi_epi8(va, zero), _mm256_unpackhi_epi8(vb, zero), w, inverse);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    sse41Kernels().blend(a + i, b + i, dst + i, count - i, weight);
+}
+
+__m256i premultiplyHalf(__m256i colour, __m256i alpha) {
+    const __m256i round = _mm256_set1_epi16(128);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(colour, alpha), round);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+void premultiplyAlphaAVX2(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha_lo = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+                                              3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m256i alpha_hi = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+                                              11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m256i keep_alpha = _mm256_setr_epi8(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1,
+                                                0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+    
+    size_t bytes = pixels * 4;
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i lo = premultiplyHalf(_mm256_unpacklo_epi8(value, zero), _mm256_shuffle_epi8(value, alpha_lo));
+        __m256i hi = premultiplyHalf(_mm256_unpackhi_epi8(value, zero), _mm256_shuffle_epi8(value, alpha_hi));
+        __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), value, keep_alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), result);
+    }
+    sse41Kernels().premultiply_alpha(src + i, dst + i, (bytes - i) / 4);
+}
+
+void gainRampAVX2(float* data, size_t count, float start, float step) {
+    const __m256 base = _mm256_set1_ps(start);
+    const __m256 slope = _mm256_set1_ps(step);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 gain = _mm256_add_ps(base, _mm256_mul_ps(index, slope));
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), gain));
+        index = _mm256_add_ps(index, eight);
+    }
+    gainRampTail(data, i, count, start, step);
+}
+
+} // namespace
+
+const KernelTable& avx2Kernels() {
+    static const KernelTable table{sse41Kernels().apply_lut, blendAVX2, sse41Kernels().swizzle_rgb,
+                                   premultiplyAlphaAVX2, gainRampAVX2};
+    return table;
+}
+
+} // namespace xeno::media::detail
@@ -0,0 +1,105 @@
+#include "kernels.h"
+#include <arm_neon.h>
+
+// NEON is part of the AArch64 baseline, so this table is always usable there
+
+namespace xeno::media::detail {
+
+namespace {
+
+void applyLutNEON(const uint8_t* src, uint8_t* dst, size_t count, const Lut& lut) {
+    // tbl looks up 64 entries at once and yields zero for out-of-range indices, so four
+    // lookups over index, index - 64, ... cover the table
+    uint8x16x4_t tables[4];
+    for (int i = 0; i < 4; ++i) {
+        tables[i] = vld1q_u8_x4(lut.data() + 64 * i);
+    }
+    const uint8x16_t step = vdupq_n_u8(64);
+    
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t index = vld1q_u8(src + i);
+        uint8x16_t result = vqtbl4q_u8(tables[0], index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, tables[1], index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, tables[2], index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, tables[3], index);
+        vst1q_u8(dst + i, result);
+    }
+    scalarKernels().apply_lut(src + i, dst + i, count - i, lut);
+}
+
+void blendNEON(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, uint16_t weight) {
+    size_t i = 0;
+    // The 8-bit multipliers cannot hold a weight of 256, so the two end points stay scalar
+    if (weight > 0 && weight < kBlendOne) {
+        const uint8x8_t wa = vdup_n_u8(static_cast<uint8_t>(weight));
+        const uint8x8_t wb = vdup_n_u8(static_cast<uint8_t>(kBlendOne - weight));
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t va = vld1q_u8(a + i);
+            uint8x16_t vb = vld1q_u8(b + i);
+            uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+            uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+            // Rounding narrow: (x + 128) >> 8
+            vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+    }
+    scalarKernels().blend(a + i, b + i, dst + i, count - i, weight);
+}
+
+void swizzleRGBNEON(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t value = vld3q_u8(src + i * 3);
+        uint8x16_t first = value.val[0];
+        value.val[0] = value.val[2];
+        value.val[2] = first;
+        vst3q_u8(dst + i * 3, value);
+    }
+    scalarKernels().swizzle_rgb(src + i * 3, dst + i * 3, pixels - i);
+}
+
+uint8x8_t premultiplyLane(uint8x8_t colour, uint8x8_t alpha) {
+    // t = c * a + 128; (t + (t >> 8)) >> 8
+    uint16x8_t t = vmlal_u8(vdupq_n_u16(128), colour, alpha);
+    return vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+}
+
+void premultiplyAlphaNEON(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        uint8x8x4_t value = vld4_u8(src + i * 4);
+        value.val[0] = premultiplyLane(value.val[0], value.val[3]);
+        value.val[1] = premultiplyLane(value.val[1], value.val[3]);
+        value.val[2] = premultiplyLane(value.val[2], value.val[3]);
+        vst4_u8(dst + i * 4, value);
+    }
+    scalarKernels().premultiply_alpha(src + i * 4, dst + i * 4, pixels - i);
+}
+
+void gainRampNEON(float* data, size_t count, float start, float step) {
+    const float32x4_t base = vdupq_n_f32(start);
+    const float32x4_t slope = vdupq_n_f32(step);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const float lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t index = vld1q_f32(lanes);
+    
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t gain = vaddq_f32(base, vmulq_f32(index, slope));
+        vst1q_f32(data + i, vmulq_f32(vld1q_f32(data + i), gain));
+        index = vaddq_f32(index, four);
+    }
+    gainRampTail(data, i, count, start, step);
+}
+
+} // namespace
+
+const KernelTable& neonKernels() {
+    static const KernelTable table{applyLutNEON, blendNEON, swizzleRGBNEON, premultiplyAlphaNEON, gainRampNEON};
+    return table;
+}
+
+} // namespace xeno::media::detail
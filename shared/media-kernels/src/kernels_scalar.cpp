@@ -0,0 +1,70 @@
+#include "kernels.h"
+
+namespace xeno::media::detail {
+
+namespace {
+
+void applyLutScalar(const uint8_t* src, uint8_t* dst, size_t count, const Lut& lut) {
+    size_t i = 0;
+    // Unrolled so the independent loads can overlap
+    for (; i + 4 <= count; i += 4) {
+        uint8_t v0 = lut[src[i]];
+        uint8_t v1 = lut[src[i + 1]];
+        uint8_t v2 = lut[src[i + 2]];
+        uint8_t v3 = lut[src[i + 3]];
+        dst[i] = v0;
+        dst[i + 1] = v1;
+        dst[i + 2] = v2;
+        dst[i + 3] = v3;
+    }
+    for (; i < count; ++i) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+void blendScalar(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, uint16_t weight) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = blendPixel(a[i], b[i], weight);
+    }
+}
+
+void swizzleRGBScalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    for (size_t i = 0; i < pixels * 3; i += 3) {
+        uint8_t first = src[i];
+        uint8_t second = src[i + 1];
+        uint8_t third = src[i + 2];
+        dst[i] = third;
+        dst[i + 1] = second;
+        dst[i + 2] = first;
+    }
+}
+
+void premultiplyAlphaScalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    for (size_t i = 0; i < pixels * 4; i += 4) {
+        uint8_t alpha = src[i + 3];
+        dst[i] = premultiplyChannel(src[i], alpha);
+        dst[i + 1] = premultiplyChannel(src[i + 1], alpha);
+        dst[i + 2] = premultiplyChannel(src[i + 2], alpha);
+        dst[i + 3] = alpha;
+    }
+}
+
+void gainRampScalar(float* data, size_t count, float start, float step) {
+    gainRampTail(data, 0, count, start, step);
+}
+
+} // namespace
+
+void gainRampTail(float* data, size_t first, size_t count, float start, float step) {
+    for (size_t i = first; i < count; ++i) {
+        data[i] *= start + static_cast<float>(i) * step;
+    }
+}
+
+const KernelTable& scalarKernels() {
+    static const KernelTable table{applyLutScalar, blendScalar, swizzleRGBScalar, premultiplyAlphaScalar,
+                                   gainRampScalar};
+    return table;
+}
+
+} // namespace xeno::media::detail
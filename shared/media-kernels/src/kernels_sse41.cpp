@@ -0,0 +1,112 @@
+#include "kernels.h"
+#include <immintrin.h>
+
+// Built with SSE4.1 enabled; only called once the CPU reports support.
+// Table lookups stay scalar on x86: without a byte gather, shuffle-based
+// lookups of a 256-entry table are slower than plain loads.
+
+namespace xeno::media::detail {
+
+namespace {
+
+__m128i blendHalf(__m128i a, __m128i b, __m128i weight, __m128i inverse) {
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, weight), _mm_mullo_epi16(b, inverse));
+    return _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+}
+
+void blendSSE41(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, uint16_t weight) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_set1_epi16(static_cast<short>(weight));
+    const __m128i inverse = _mm_set1_epi16(static_cast<short>(kBlendOne - weight));
+    
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i lo = blendHalf(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero), w, inverse);
+        __m128i hi = blendHalf(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero), w, inverse);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    scalarKernels().blend(a + i, b + i, dst + i, count - i, weight);
+}
+
+void swizzleRGBSSE41(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    // Sixteen pixels (three registers) per iteration. Pixels straddle register
+    // boundaries, so each output register gathers from up to three inputs.
+    const __m128i m00 = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+    const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1);
+    const __m128i m10 = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m11 = _mm_setr_epi8(0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15);
+    const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1);
+    const __m128i m21 = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m22 = _mm_setr_epi8(-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+    
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(src + i * 3);
+        __m128i v0 = _mm_loadu_si128(in);
+        __m128i v1 = _mm_loadu_si128(in + 1);
+        __m128i v2 = _mm_loadu_si128(in + 2);
+        __m128i o0 = _mm_or_si128(_mm_shuffle_epi8(v0, m00), _mm_shuffle_epi8(v1, m01));
+        __m128i o1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, m10), _mm_shuffle_epi8(v1, m11)),
+                                  _mm_shuffle_epi8(v2, m12));
+        __m128i o2 = _mm_or_si128(_mm_shuffle_epi8(v1, m21), _mm_shuffle_epi8(v2, m22));
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i * 3);
+        _mm_storeu_si128(out, o0);
+        _mm_storeu_si128(out + 1, o1);
+        _mm_storeu_si128(out + 2, o2);
+    }
+    scalarKernels().swizzle_rgb(src + i * 3, dst + i * 3, pixels - i);
+}
+
+__m128i premultiplyHalf(__m128i colour, __m128i alpha) {
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(colour, alpha), round);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+void premultiplyAlphaSSE41(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    const __m128i zero = _mm_setzero_si128();
+    // Spread each pixel's alpha over its four 16-bit channels
+    const __m128i alpha_lo = _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m128i alpha_hi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m128i keep_alpha = _mm_setr_epi8(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+    
+    size_t bytes = pixels * 4;
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = premultiplyHalf(_mm_unpacklo_epi8(value, zero), _mm_shuffle_epi8(value, alpha_lo));
+        __m128i hi = premultiplyHalf(_mm_unpackhi_epi8(value, zero), _mm_shuffle_epi8(value, alpha_hi));
+        __m128i result = _mm_blendv_epi8(_mm_packus_epi16(lo, hi), value, keep_alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+    }
+    scalarKernels().premultiply_alpha(src + i, dst + i, (bytes - i) / 4);
+}
+
+// The gain is start + index * step, computed from the index like the scalar loop
+void gainRampSSE41(float* data, size_t count, float start, float step) {
+    const __m128 base = _mm_set1_ps(start);
+    const __m128 slope = _mm_set1_ps(step);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 gain = _mm_add_ps(base, _mm_mul_ps(index, slope));
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), gain));
+        index = _mm_add_ps(index, four);
+    }
+    gainRampTail(data, i, count, start, step);
+}
+
+} // namespace
+
+const KernelTable& sse41Kernels() {
+    static const KernelTable table{scalarKernels().apply_lut, blendSSE41, swizzleRGBSSE41, premultiplyAlphaSSE41,
+                                   gainRampSSE41};
+    return table;
+}
+
+} // namespace xeno::media::detail
@@ -0,0 +1,137 @@
+#include "media_kernels.h"
+#include "kernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(XENO_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace xeno::media {
+
+namespace {
+
+SimdLevel detect() {
+#if defined(XENO_KERNELS_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    // AVX needs OS support for saving the YMM registers, reported through XGETBV
+    bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) {
+        return SimdLevel::AVX2;
+    }
+    if (sse41) {
+        return SimdLevel::SSE41;
+    }
+#elif defined(XENO_KERNELS_NEON)
+    return SimdLevel::NEON;
+#endif
+    return SimdLevel::Scalar;
+}
+
+struct Dispatch {
+    SimdLevel detected = detect();
+    std::atomic<SimdLevel> active{detected};
+};
+
+Dispatch& dispatch() {
+    static Dispatch instance;
+    return instance;
+}
+
+const detail::KernelTable& kernels() {
+    switch (dispatch().active.load(std::memory_order_relaxed)) {
+#if defined(XENO_KERNELS_X86)
+    case SimdLevel::AVX2:
+        return detail::avx2Kernels();
+    case SimdLevel::SSE41:
+        return detail::sse41Kernels();
+#endif
+#if defined(XENO_KERNELS_NEON)
+    case SimdLevel::NEON:
+        return detail::neonKernels();
+#endif
+    default:
+        return detail::scalarKernels();
+    }
+}
+
+} // namespace
+
+SimdLevel detectedSimdLevel() {
+    return dispatch().detected;
+}
+
+SimdLevel activeSimdLevel() {
+    return dispatch().active.load(std::memory_order_relaxed);
+}
+
+bool setSimdLevel(SimdLevel level) {
+    SimdLevel detected = dispatch().detected;
+    bool supported = level == SimdLevel::Scalar || level == detected ||
+                     (level == SimdLevel::SSE41 && detected == SimdLevel::AVX2);
+    if (!supported) {
+        return false;
+    }
+    dispatch().active.store(level, std::memory_order_relaxed);
+    return true;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE41:
+        return "sse4.1";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::NEON:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
+
+Lut makeLut(double contrast, double brightness, double gamma) {
+    Lut lut{};
+    for (int value = 0; value < 256; ++value) {
+        double corrected = value;
+        if (gamma > 0.0 && gamma != 1.0) {
+            corrected = 255.0 * std::pow(value / 255.0, 1.0 / gamma);
+        }
+        long adjusted = std::lround(contrast * corrected + brightness);
+        lut[value] = static_cast<uint8_t>(std::clamp(adjusted, 0L, 255L));
+    }
+    return lut;
+}
+
+void applyLut(const uint8_t* src, uint8_t* dst, size_t count, const Lut& lut) {
+    kernels().apply_lut(src, dst, count, lut);
+}
+
+void blend(const uint8_t* a, const uint8_t* b, uint8_t* dst, size_t count, float weight) {
+    auto fixed = static_cast<uint16_t>(std::lround(std::clamp(weight, 0.0f, 1.0f) * detail::kBlendOne));
+    kernels().blend(a, b, dst, count, fixed);
+}
+
+void swizzleRGB(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    kernels().swizzle_rgb(src, dst, pixels);
+}
+
+void premultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    kernels().premultiply_alpha(src, dst, pixels);
+}
+
+void applyGainRamp(float* data, size_t count, float start, float step) {
+    kernels().gain_ramp(data, count, start, step);
+}
+
+} // namespace xeno::media
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace xeno::utils {
+
+/**
+ * @brief Blocking multi-producer, multi-consumer queue with a fixed capacity
+ *
+ * Connects pipeline stages: a full queue blocks producers, which bounds the
+ * memory held between stages. After close(), pushes fail and consumers
+ * drain what is left before pop() reports the end.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : max_size(capacity > 0 ? capacity : 1) {}
+    
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+    
+    // Blocks while the queue is full; false once the queue is closed
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return closed || items.size() < max_size; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(value));
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+    
+    // Blocks while the queue is empty; nullopt once it is closed and drained
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+        return takeLocked(lock);
+    }
+    
+    // Never blocks; nullopt when nothing is queued
+    std::optional<T> tryPop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return takeLocked(lock);
+    }
+    
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+    
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+    
+    size_t capacity() const { return max_size; }
+
+private:
+    std::optional<T> takeLocked(std::unique_lock<std::mutex>& lock) {
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(items.front()));
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return value;
+    }
+    
+    const size_t max_size;
+    mutable std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    bool closed = false;
+};
+
+} // namespace xeno::utils
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace xeno::utils {
+
+/**
+ * @brief Half-open intervals [start, end) with logarithmic lookup by point or range
+ *
+ * An AVL tree ordered by (start, value), where every node also stores the
+ * largest end in its subtree. A query skips any subtree that ends before the
+ * queried point, so finding what covers a point costs O(log n) plus one step
+ * per match. Values must be ordered with <, and each (start, value) pair may
+ * appear once.
+ */
+template <typename T, typename Value>
+class IntervalTree {
+public:
+    IntervalTree() = default;
+    IntervalTree(const IntervalTree& other) : root(clone(other.root)), count(other.count) {}
+    IntervalTree& operator=(const IntervalTree& other) {
+        if (this != &other) {
+            root = clone(other.root);
+            count = other.count;
+        }
+        return *this;
+    }
+    IntervalTree(IntervalTree&&) noexcept = default;
+    IntervalTree& operator=(IntervalTree&&) noexcept = default;
+    
+    // false if (start, value) is already present or the interval is empty
+    bool insert(T start, T end, Value value) {
+        if (!(start < end)) {
+            return false;
+        }
+        bool added = false;
+        root = insertAt(std::move(root), start, end, std::move(value), added);
+        count += added ? 1 : 0;
+        return added;
+    }
+    
+    bool erase(T start, const Value& value) {
+        bool removed = false;
+        root = eraseAt(std::move(root), start, value, removed);
+        count -= removed ? 1 : 0;
+        return removed;
+    }
+    
+    void clear() {
+        root.reset();
+        count = 0;
+    }
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    
+    // Calls visit(start, end, value) for each interval containing point, in start order
+    template <typename Visit>
+    void visitAt(T point, Visit&& visit) const {
+        visitNode(root.get(), point, point, true, visit);
+    }
+    
+    // Calls visit(start, end, value) for each interval overlapping [start, end), in start order
+    template <typename Visit>
+    void visitOverlapping(T start, T end, Visit&& visit) const {
+        if (start < end) {
+            visitNode(root.get(), start, end, false, visit);
+        }
+    }
+    
+    std::vector<Value> at(T point) const {
+        std::vector<Value> values;
+        visitAt(point, [&values](T, T, const Value& value) { values.push_back(value); });
+        return values;
+    }
+    
+    std::vector<Value> overlapping(T start, T end) const {
+        std::vector<Value> values;
+        visitOverlapping(start, end, [&values](T, T, const Value& value) { values.push_back(value); });
+        return values;
+    }
+    
+    // Largest end of any interval; fallback when empty
+    T maxEnd(T fallback) const { return root ? root->max_end : fallback; }
+
+private:
+    struct Node {
+        T start;
+        T end;
+        T max_end;
+        Value value;
+        int height = 1;
+        std::unique_ptr<Node> left;
+        std::unique_ptr<Node> right;
+    };
+    
+    using NodePtr = std::unique_ptr<Node>;
+    
+    static bool before(T start, const Value& value, const Node& node) {
+        return start < node.start || (!(node.start < start) && value < node.value);
+    }
+    
+    static NodePtr clone(const NodePtr& node) {
+        if (!node) {
+            return nullptr;
+        }
+        auto copy = std::make_unique<Node>();
+        copy->start = node->start;
+        copy->end = node->end;
+        copy->max_end = node->max_end;
+        copy->value = node->value;
+        copy->height = node->height;
+        copy->left = clone(node->left);
+        copy->right = clone(node->right);
+        return copy;
+    }
+    
+    static int height(const NodePtr& node) { return node ? node->height : 0; }
+    
+    static void update(Node& node) {
+        node.height = 1 + std::max(height(node.left), height(node.right));
+        node.max_end = node.end;
+        if (node.left && node.max_end < node.left->max_end) {
+            node.max_end = node.left->max_end;
+        }
+        if (node.right && node.max_end < node.right->max_end) {
+            node.max_end = node.right->max_end;
+        }
+    }
+    
+    static NodePtr rotateRight(NodePtr node) {
+        NodePtr pivot = std::move(node->left);
+        node->left = std::move(pivot->right);
+        update(*node);
+        pivot->right = std::move(node);
+        update(*pivot);
+        return pivot;
+    }
+    
+    static NodePtr rotateLeft(NodePtr node) {
+        NodePtr pivot = std::move(node->right);
+        node->right = std::move(pivot->left);
+        update(*node);
+        pivot->left = std::move(node);
+        update(*pivot);
+        return pivot;
+    }
+    
+    static NodePtr balance(NodePtr node) {
+        update(*node);
+        int skew = height(node->left) - height(node->right);
+        if (skew > 1) {
+            if (height(node->left->left) < height(node->left->right)) {
+                node->left = rotateLeft(std::move(node->left));
+            }
+            return rotateRight(std::move(node));
+        }
+        if (skew < -1) {
+            if (height(node->right->right) < height(node->right->left)) {
+                node->right = rotateRight(std::move(node->right));
+            }
+            return rotateLeft(std::move(node));
+        }
+        return node;
+    }
+    
+    static NodePtr insertAt(NodePtr node, T start, T end, Value value, bool& added) {
+        if (!node) {
+            added = true;
+            auto leaf = std::make_unique<Node>();
+            leaf->start = start;
+            leaf->end = end;
+            leaf->max_end = end;
+            leaf->value = std::move(value);
+            return leaf;
+        }
+        if (before(start, value, *node)) {
+            node->left = insertAt(std::move(node->left), start, end, std::move(value), added);
+        } else if (node->start < start || node->value < value) {
+            node->right = insertAt(std::move(node->right), start, end, std::move(value), added);
+        } else {
+            return node;
+        }
+        return balance(std::move(node));
+    }
+    
+    // Detaches the leftmost node of a subtree into smallest
+    static NodePtr takeSmallest(NodePtr node, NodePtr& smallest) {
+        if (!node->left) {
+            NodePtr rest = std::move(node->right);
+            smallest = std::move(node);
+            return rest;
+        }
+        node->left = takeSmallest(std::move(node->left), smallest);
+        return balance(std::move(node));
+    }
+    
+    static NodePtr eraseAt(NodePtr node, T start, const Value& value, bool& removed) {
+        if (!node) {
+            return node;
+        }
+        if (before(start, value, *node)) {
+            node->left = eraseAt(std::move(node->left), start, value, removed);
+        } else if (node->start < start || node->value < value) {
+            node->right = eraseAt(std::move(node->right), start, value, removed);
+        } else {
+            removed = true;
+            if (!node->left || !node->right) {
+                return std::move(node->left ? node->left : node->right);
+            }
+            NodePtr successor;
+            NodePtr right = takeSmallest(std::move(node->right), successor);
+            successor->left = std::move(node->left);
+            successor->right = std::move(right);
+            node = std::move(successor);
+        }
+        return balance(std::move(node));
+    }
+    
+    // A point query matches start <= point < end; a range query start < high && low < end
+    template <typename Visit>
+    static void visitNode(const Node* node, T low, T high, bool point, Visit& visit) {
+        if (!node || !(low < node->max_end)) {
+            return;
+        }
+        visitNode(node->left.get(), low, high, point, visit);
+        bool starts_in_range = point ? !(high < node->start) : node->start < high;
+        if (!starts_in_range) {
+            return; // Everything to the right starts later still
+        }
+        if (low < node->end) {
+            visit(node->start, node->end, node->value);
+        }
+        visitNode(node->right.get(), low, high, point, visit);
+    }
+    
+    NodePtr root;
+    size_t count = 0;
+};
+
+} // namespace xeno::utils
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace xeno::utils {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Opening costs the same for any file size: pages are read by the OS as
+ * data() is touched, and shared with the page cache rather than copied.
+ * The view stays valid until close(), another open() or destruction, so
+ * anything holding on to it (a PieceTable, say) must not outlive the
+ * mapping. Empty files open successfully with an empty view.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    // Maps path, replacing any file mapped before; false with error_message set on failure
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const { return is_open; }
+    std::string_view data() const { return {view, length}; }
+    size_t size() const { return length; }
+    const std::string& path() const { return file_path; }
+    const std::string& errorMessage() const { return error_message; }
+
+private:
+    const char* view = nullptr;
+    size_t length = 0;
+    bool is_open = false;
+    std::string file_path;
+    std::string error_message;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+} // namespace xeno::utils
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xeno::utils {
+
+// Small number per thread, used to spread a metric's writes over its stripes
+inline uint32_t metricsThreadIndex() {
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+/**
+ * @brief Count of events, safe to bump from any thread including real-time ones
+ *
+ * Each thread adds to one of kStripes slots on its own cache line, so threads
+ * rarely write the same line; reading adds the slots up. Nothing allocates or
+ * locks after construction.
+ */
+class Counter {
+public:
+    static constexpr size_t kStripes = 8;
+    
+    explicit Counter(std::string name) : metric_name(std::move(name)) {}
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+    
+    void add(uint64_t amount = 1) {
+        stripes[metricsThreadIndex() % kStripes].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+    const std::string& name() const { return metric_name; }
+
+private:
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+    
+    std::string metric_name;
+    std::array<Stripe, kStripes> stripes;
+};
+
+/**
+ * @brief Distribution of durations in microseconds, in HDR-style log-linear buckets
+ *
+ * Every power of two is split into kSubBuckets equal buckets, so each value
+ * up to 2^kMaxBits us (about 19 hours) is counted within 1/kSubBuckets of
+ * itself and percentiles need no samples kept. Values are spread over
+ * stripes like Counter's; recording is a few relaxed atomic adds, with no
+ * locks or allocation, and is safe on a real-time thread.
+ */
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kMaxBits = 36;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    static constexpr size_t kBucketCount = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+    static constexpr size_t kStripes = 4;
+    
+    struct Summary {
+        uint64_t count = 0;
+        double mean_us = 0;
+        uint64_t p50_us = 0;
+        uint64_t p90_us = 0;
+        uint64_t p99_us = 0;
+        uint64_t max_us = 0;
+    };
+    
+    explicit Histogram(std::string name);
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+    
+    void record(uint64_t micros);
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> elapsed) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record(static_cast<uint64_t>(micros > 0 ? micros : 0));
+    }
+    
+    // Highest value in the bucket holding the given fraction of samples, 0 when empty
+    uint64_t percentile(double fraction) const;
+    Summary summarize() const;
+    const std::string& name() const { return metric_name; }
+    
+    static size_t bucketFor(uint64_t micros);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+    
+    std::array<uint64_t, kBucketCount> mergedBuckets() const;
+    uint64_t percentileOf(const std::array<uint64_t, kBucketCount>& buckets, uint64_t count, double fraction) const;
+    
+    std::string metric_name;
+    std::unique_ptr<std::array<Stripe, kStripes>> stripes;
+    std::atomic<uint64_t> max_value{0};
+};
+
+/**
+ * @brief Times a scope into a histogram and, while tracing is on, records it as a span
+ *
+ * Spans opened inside another on the same thread become its children. With
+ * tracing off the cost is two clock reads and a histogram record.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(Histogram& histogram);
+    ~TraceSpan();
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+    uint64_t span_id = 0;   // Zero when the span is not traced
+    uint64_t parent_id = 0;
+    uint64_t trace_id = 0;
+    TraceSpan* parent = nullptr;
+};
+
+/**
+ * @brief Process-wide registry of counters and histograms, and the trace buffer
+ *
+ * Looking a metric up by name takes a lock, so call sites keep the returned
+ * reference (typically in a function-local static); metrics live until the
+ * process exits. Tracing keeps the latest spans in a fixed-size buffer that
+ * exports as Chrome trace JSON (chrome://tracing, Perfetto) or OTLP/JSON
+ * for an OpenTelemetry collector.
+ */
+class Metrics {
+public:
+    struct Snapshot {
+        std::map<std::string, uint64_t> counters;
+        std::map<std::string, Histogram::Summary> histograms;
+    };
+    
+    static Metrics& getInstance();
+    
+    // The same name always returns the same metric
+    Counter& counter(const std::string& name);
+    Histogram& histogram(const std::string& name);
+    Snapshot snapshot() const;
+    
+    // Starts a new trace holding the latest capacity spans
+    void startTracing(size_t capacity = 64 * 1024);
+    void stopTracing();
+    bool isTracing() const { return tracing.load(std::memory_order_relaxed); }
+    size_t spanCount() const;
+    
+    bool writeChromeTrace(const std::string& path) const;
+    bool writeOpenTelemetry(const std::string& path, const std::string& service_name) const;
+
+private:
+    friend class TraceSpan;
+    
+    struct SpanRecord {
+        const std::string* name = nullptr;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration duration{};
+        uint64_t span_id = 0;
+        uint64_t parent_id = 0;
+        uint64_t trace_id = 0;
+        uint32_t thread = 0;
+    };
+    
+    Metrics() = default;
+    
+    uint64_t nextSpanId() { return next_span_id.fetch_add(1, std::memory_order_relaxed); }
+    void addSpan(const SpanRecord& span);
+    // Spans in the buffer, oldest first
+    std::vector<SpanRecord> spansInOrder() const;
+    
+    mutable std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    
+    std::atomic<bool> tracing{false};
+    std::atomic<uint64_t> next_span_id{1};
+    mutable std::mutex trace_mutex;
+    std::vector<SpanRecord> spans;   // Ring of the latest spans
+    size_t span_capacity = 0;
+    size_t span_total = 0;          // Spans added since tracing started
+    std::chrono::steady_clock::time_point trace_start;
+    std::chrono::system_clock::time_point trace_wall_start;
+};
+
+} // namespace xeno::utils
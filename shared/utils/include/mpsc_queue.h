@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace xeno::utils {
+
+/**
+ * @brief Lock-free queue for any number of producer threads and one consumer
+ *
+ * push() is a single compare-and-swap onto a linked stack, so producers never
+ * wait on each other or on the consumer. The consumer takes everything at
+ * once with drain(), which returns the elements in push order; pushes that
+ * are ordered between threads (e.g. made under the same lock) come out in
+ * that order.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    ~MpscQueue() { release(head.exchange(nullptr, std::memory_order_acquire)); }
+    
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    
+    // Any thread
+    void push(T value) {
+        Node* node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+    
+    bool empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+    
+    // Consumer thread only; oldest first
+    std::vector<T> drain() {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        std::vector<T> values;
+        for (Node* it = node; it; it = it->next) {
+            values.push_back(std::move(it->value));
+        }
+        release(node);
+        // The stack holds the newest first
+        std::reverse(values.begin(), values.end());
+        return values;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+    
+    static void release(Node* node) {
+        while (node) {
+            delete std::exchange(node, node->next);
+        }
+    }
+    
+    std::atomic<Node*> head{nullptr};
+};
+
+} // namespace xeno::utils
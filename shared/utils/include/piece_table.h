@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xeno::utils {
+
+/**
+ * @brief Editable text over a read-only original, without copying it
+ *
+ * The document is a sequence of pieces, each a span of either the original
+ * text or an append-only buffer of inserted text. Edits split and drop
+ * pieces and never move text, so the original can be a MappedFile of any
+ * size and opening it costs nothing. Typing at the end of the last insert
+ * grows that piece rather than adding one, so the piece count follows the
+ * number of places edited, not the number of keystrokes.
+ *
+ * Offsets are in bytes. Locating an offset is a binary search over the
+ * piece ends; an edit renumbers the pieces after it. The original must
+ * outlive the table or the next reset().
+ */
+class PieceTable {
+public:
+    static constexpr size_t npos = std::string_view::npos;
+    
+    PieceTable() = default;
+    explicit PieceTable(std::string_view original);
+    
+    // Starts over from original, dropping every edit
+    void reset(std::string_view original);
+    
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+    size_t pieceCount() const { return pieces.size(); }
+    
+    char at(size_t offset) const;
+    // The bytes in [offset, offset + length), clamped to the document
+    std::string text(size_t offset, size_t length) const;
+    std::string text() const { return text(0, total); }
+    // Passes the stored spans making up [offset, offset + length) in order, until visit returns false
+    void forEachChunk(size_t offset, size_t length, const std::function<bool(std::string_view)>& visit) const;
+    
+    // First c in [from, from + limit), or npos
+    size_t find(char c, size_t from, size_t limit = npos) const;
+    // Last c in [before - limit, before), or npos
+    size_t rfind(char c, size_t before, size_t limit = npos) const;
+    
+    void insert(size_t offset, std::string_view text);
+    void erase(size_t offset, size_t length);
+
+private:
+    struct Piece {
+        bool added = false;  // In added rather than original
+        size_t start = 0;
+        size_t length = 0;
+    };
+    
+    std::string_view pieceText(const Piece& piece) const;
+    // The piece holding offset, or pieces.size() at the end, and offset's position within it
+    size_t locate(size_t offset, size_t& within) const;
+    // Recomputes piece_ends from piece first on
+    void updateEnds(size_t first);
+    
+    std::string_view original;
+    std::string added;
+    std::vector<Piece> pieces;
+    std::vector<size_t> piece_ends;  // Document offset just past each piece
+    size_t total = 0;
+};
+
+} // namespace xeno::utils
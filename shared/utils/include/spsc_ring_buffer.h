@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace xeno::utils {
+
+/**
+ * @brief Lock-free ring buffer for exactly one producer and one consumer thread
+ *
+ * read() and write() never block, allocate or take locks, so the consumer can
+ * be a real-time audio callback. Each operation moves as many elements as fit
+ * and returns the count. The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRingBuffer elements are copied with memcpy semantics");
+
+public:
+    explicit SpscRingBuffer(size_t min_capacity) {
+        size_t capacity = 1;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+        }
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+    
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+    
+    size_t capacity() const { return buffer.size(); }
+    
+    size_t readAvailable() const {
+        return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire);
+    }
+    
+    size_t writeAvailable() const { return capacity() - readAvailable(); }
+    
+    // Producer thread only
+    size_t write(const T* data, size_t count) {
+        size_t write_position = write_index.load(std::memory_order_relaxed);
+        size_t read_position = read_index.load(std::memory_order_acquire);
+        count = std::min(count, capacity() - (write_position - read_position));
+        
+        size_t offset = write_position & mask;
+        size_t first = std::min(count, capacity() - offset);
+        std::copy(data, data + first, buffer.begin() + offset);
+        std::copy(data + first, data + count, buffer.begin());
+        
+        write_index.store(write_position + count, std::memory_order_release);
+        return count;
+    }
+    
+    // Consumer thread only
+    size_t read(T* data, size_t count) {
+        size_t read_position = read_index.load(std::memory_order_relaxed);
+        size_t write_position = write_index.load(std::memory_order_acquire);
+        count = std::min(count, write_position - read_position);
+        
+        size_t offset = read_position & mask;
+        size_t first = std::min(count, capacity() - offset);
+        std::copy(buffer.begin() + offset, buffer.begin() + offset + first, data);
+        std::copy(buffer.begin(), buffer.begin() + (count - first), data + first);
+        
+        read_index.store(read_position + count, std::memory_order_release);
+        return count;
+    }
+    
+    // Empties the buffer; only valid while neither side is running
+    void reset() {
+        read_index.store(0, std::memory_order_relaxed);
+        write_index.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<T> buffer;
+    size_t mask = 0;
+    // Each side owns one index; keeping them on separate cache lines avoids false sharing
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+};
+
+} // namespace xeno::utils
@@ -1,36 +1,136 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 #include <map>
+#include <nlohmann/json_fwd.hpp>
 
 namespace xeno::utils {
 
 /**
- * @brief Configuration manager for application settings
+ * @brief Configuration manager for application settings: the suite's config file and run-time values
+ *
+ * Values are parsed once, when a file loads or a value is set, into typed
+ * slots of an immutable Snapshot, and the current snapshot is swapped in
+ * atomically. Readers never wait for a load or parse, and keys are found by
+ * hash straight from a std::string_view. Code reading several values, or
+ * reading on a hot path, should hold one snapshot() rather than go through
+ * the getters each time. Nested JSON objects are addressed with dotted keys
+ * ("ollama.endpoint"); the whole document, arrays included, is available as
+ * JSON. Files in the older key=value format still load. With watch() on,
+ * edits to the loaded file are picked up while the app runs and passed to
+ * subscribers.
  */
 class ConfigManager {
 public:
+    using Value = std::variant<bool, int64_t, double, std::string>;
+    
+    class Snapshot {
+    public:
+        bool contains(std::string_view key) const { return find(key) != nullptr; }
+        // Any value as text: numbers and booleans as they would appear in JSON
+        std::string_view getString(std::string_view key, std::string_view default_value = "") const;
+        // Numbers and booleans convert; text does not
+        int64_t getInt(std::string_view key, int64_t default_value = 0) const;
+        double getDouble(std::string_view key, double default_value = 0) const;
+        bool getBool(std::string_view key, bool default_value = false) const;
+        
+        // The file's contents with run-time values applied
+        const nlohmann::json& document() const { return *json; }
+        // The file the snapshot was read from, empty before any load
+        const std::string& sourcePath() const { return source_path; }
+        // Increases with every change
+        uint64_t version() const { return snapshot_version; }
+    
+    private:
+        friend class ConfigManager;
+        
+        struct Slot {
+            Value value;
+            std::string text;
+        };
+        
+        struct KeyHash {
+            using is_transparent = void;
+            size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+        };
+        
+        const Slot* find(std::string_view key) const {
+            auto it = slots.find(key);
+            return it == slots.end() ? nullptr : &it->second;
+        }
+        
+        std::unordered_map<std::string, Slot, KeyHash, std::equal_to<>> slots;
+        std::shared_ptr<const nlohmann::json> json;
+        std::string source_path;
+        uint64_t snapshot_version = 0;
+    };
+    
+    using Listener = std::function<void(const Snapshot&)>;
+    
     static ConfigManager& getInstance();
+    ~ConfigManager();
     
+    // Replaces what an earlier load read; values set at run time are kept
     bool loadConfig(const std::string& config_path);
     bool saveConfig(const std::string& config_path);
     
-    std::string getString(const std::string& key, const std::string& default_value = "");
-    int getInt(const std::string& key, int default_value = 0);
-    bool getBool(const std::string& key, bool default_value = false);
+    std::shared_ptr<const Snapshot> snapshot() const;
+    
+    std::string getString(std::string_view key, std::string_view default_value = "") const;
+    int getInt(std::string_view key, int default_value = 0) const;
+    double getDouble(std::string_view key, double default_value = 0) const;
+    bool getBool(std::string_view key, bool default_value = false) const;
     
     void setString(const std::string& key, const std::string& value);
     void setInt(const std::string& key, int value);
+    void setDouble(const std::string& key, double value);
     void setBool(const std::string& key, bool value);
+    
+    // Reloads the loaded file whenever it changes, checking every interval from a background thread
+    void watch(std::chrono::milliseconds interval = std::chrono::seconds(1));
+    void stopWatching();
+    // Reloads the file if it changed since it was read; true if it did. A file that no longer
+    // parses is reported and the values read before are kept.
+    bool reloadIfChanged();
+    
+    // Listeners run after every change, on the thread that made it, and only ever see newer
+    // snapshots: one overtaken by a later change is skipped. A listener may change the config,
+    // subscribe or unsubscribe. unsubscribe() waits for a listener running on another thread.
+    int subscribe(Listener listener);
+    void unsubscribe(int id);
 
 private:
-    ConfigManager() = default;
-    std::map<std::string, std::string> config_data;
+    ConfigManager();
+    
+    struct Impl;
+    std::unique_ptr<Impl> pImpl;
 };
 
 /**
  * @brief Logging utility
+ *
+ * Logging never waits on I/O. Each thread appends its messages to its own
+ * lock-free ring buffer; a background thread collects them, adds the time
+ * and level, and writes them in batches to the console and, once configured,
+ * to a log file under Platform::getAppDataPath() that rotates by size. The
+ * parts of a message are passed separately (info("Loaded ", count, " files"))
+ * and copied straight into the ring without building a string. When a ring
+ * is full the message is dropped and counted, or with Overflow::Block the
+ * caller waits for room. Debug messages compile away in release (NDEBUG)
+ * builds. A thread's first message allocates its ring.
  */
 class Logger {
 public:
@@ -41,18 +141,82 @@ public:
         ERROR = 3
     };
     
+    enum class Overflow {
+        Drop,  // Lose the message; droppedCount() and the log say how many were lost
+        Block  // Wait for the writer; never use from a real-time thread
+    };
+    
+    struct Options {
+        std::string file_name;  // Logs to <directory>/<file_name>.log; empty logs to the console only
+        std::string directory;  // Defaults to the "logs" folder under Platform::getAppDataPath()
+        size_t max_file_bytes = 4 * 1024 * 1024;
+        int max_files = 3;      // Rotated files kept besides the current one
+        bool console = true;
+        Overflow overflow = Overflow::Drop;
+    };
+
+#ifdef NDEBUG
+    static constexpr bool kDebugEnabled = false;
+#else
+    static constexpr bool kDebugEnabled = true;
+#endif
+
+    // One piece of a message: text, or a number formatted in place
+    class Part {
+    public:
+        Part(std::string_view text) : view(text) {}
+        Part(const char* text) : view(text) {}
+        Part(const std::string& text) : view(text) {}
+        Part(bool value) : view(value ? "true" : "false") {}
+        Part(char value) : digits{value}, view(digits, 1) {}
+        template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+        Part(T value) {
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            view = std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+        }
+        Part(const Part&) = delete;
+        Part& operator=(const Part&) = delete;
+        
+        std::string_view text() const { return view; }
+    
+    private:
+        char digits[32] = {};
+        std::string_view view;
+    };
+    
     static Logger& getInstance();
+    ~Logger();
     
+    // Opens the log file, if any, and applies the options to later messages
+    void configure(const Options& options);
     void setLevel(Level level);
-    void log(Level level, const std::string& message);
-    void debug(const std::string& message);
-    void info(const std::string& message);
-    void warning(const std::string& message);
-    void error(const std::string& message);
+    bool isEnabled(Level level) const { return level >= current_level.load(std::memory_order_relaxed); }
+    
+    void log(Level level, const std::string& message) { log(level, {Part(message)}); }
+    void log(Level level, std::initializer_list<Part> parts);
+    template <typename... Parts>
+    void debug(const Parts&... parts) {
+        if constexpr (kDebugEnabled) {
+            log(DEBUG, {parts...});
+        }
+    }
+    template <typename... Parts>
+    void info(const Parts&... parts) { log(INFO, {parts...}); }
+    template <typename... Parts>
+    void warning(const Parts&... parts) { log(WARNING, {parts...}); }
+    template <typename... Parts>
+    void error(const Parts&... parts) { log(ERROR, {parts...}); }
+    
+    // Waits until every message logged before the call has been written
+    void flush();
+    uint64_t droppedCount() const;
 
 private:
-    Logger() = default;
-    Level current_level = INFO;
+    Logger();
+    
+    struct Impl;
+    std::unique_ptr<Impl> pImpl;
+    std::atomic<Level> current_level{INFO};
 };
 
 /**
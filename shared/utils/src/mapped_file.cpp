@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <filesystem>
+    #include <system_error>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <cstring>
+#endif
+
+namespace xeno::utils {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    error_message.clear();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_message = "Cannot open " + path + ": " + std::system_category().message(GetLastError());
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        error_message = "Cannot read the size of " + path + ": " + std::system_category().message(GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+    if (file_size.QuadPart > 0) {
+        // A mapping of an empty file is an error on Windows, so those keep an empty view
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* address = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!address) {
+            error_message = "Cannot map " + path + ": " + std::system_category().message(GetLastError());
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return false;
+        }
+        mapping_handle = mapping;
+        view = static_cast<const char*>(address);
+        length = static_cast<size_t>(file_size.QuadPart);
+    }
+    file_handle = file;
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        error_message = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        error_message = "Cannot read the size of " + path + ": " + std::strerror(errno);
+        ::close(descriptor);
+        return false;
+    }
+    if (status.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+        if (address == MAP_FAILED) {
+            error_message = "Cannot map " + path + ": " + std::strerror(errno);
+            ::close(descriptor);
+            return false;
+        }
+        view = static_cast<const char*>(address);
+        length = static_cast<size_t>(status.st_size);
+        // Pages are read as the view is touched, mostly in order
+        madvise(address, length, MADV_SEQUENTIAL);
+    }
+    // The mapping keeps the file referenced on its own
+    ::close(descriptor);
+#endif
+
+    file_path = path;
+    is_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (!is_open) {
+        return;
+    }
+#ifdef _WIN32
+    if (view) {
+        UnmapViewOfFile(view);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    CloseHandle(file_handle);
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    if (view) {
+        munmap(const_cast<char*>(view), length);
+    }
+#endif
+    view = nullptr;
+    length = 0;
+    is_open = false;
+    file_path.clear();
+}
+
+} // namespace xeno::utils
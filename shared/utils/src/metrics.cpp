@@ -0,0 +1,347 @@
+#include "metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace xeno::utils {
+
+namespace {
+
+// The innermost traced span open on this thread
+thread_local TraceSpan* current_span = nullptr;
+
+uint32_t processId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+}
+
+std::string hexId(uint64_t high, uint64_t low, bool wide) {
+    char buffer[33];
+    if (wide) {
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", static_cast<unsigned long long>(high),
+                      static_cast<unsigned long long>(low));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(low));
+    }
+    return buffer;
+}
+
+bool writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << content;
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+// Counter implementation
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& stripe : stripes) {
+        total += stripe.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// Histogram implementation
+Histogram::Histogram(std::string name)
+    : metric_name(std::move(name)), stripes(std::make_unique<std::array<Stripe, kStripes>>()) {}
+
+size_t Histogram::bucketFor(uint64_t micros) {
+    if (micros < kSubBuckets) {
+        return static_cast<size_t>(micros);
+    }
+    micros = std::min<uint64_t>(micros, (uint64_t{1} << kMaxBits) - 1);
+    int shift = std::bit_width(micros) - 1 - kSubBucketBits;
+    size_t sub = static_cast<size_t>(micros >> shift) - kSubBuckets;
+    return (static_cast<size_t>(shift) + 1) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    size_t shift = bucket / kSubBuckets - 1;
+    uint64_t lower = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+void Histogram::record(uint64_t micros) {
+    Stripe& stripe = (*stripes)[metricsThreadIndex() % kStripes];
+    stripe.buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    stripe.sum.fetch_add(micros, std::memory_order_relaxed);
+    
+    uint64_t seen = max_value.load(std::memory_order_relaxed);
+    while (micros > seen && !max_value.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+std::array<uint64_t, Histogram::kBucketCount> Histogram::mergedBuckets() const {
+    std::array<uint64_t, kBucketCount> merged{};
+    for (const auto& stripe : *stripes) {
+        for (size_t i = 0; i < kBucketCount; i++) {
+            merged[i] += stripe.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return merged;
+}
+
+uint64_t Histogram::percentile(double fraction) const {
+    auto buckets = mergedBuckets();
+    uint64_t count = 0;
+    for (uint64_t bucket : buckets) {
+        count += bucket;
+    }
+    return percentileOf(buckets, count, fraction);
+}
+
+Histogram::Summary Histogram::summarize() const {
+    Summary summary;
+    uint64_t sum = 0;
+    for (const auto& stripe : *stripes) {
+        sum += stripe.sum.load(std::memory_order_relaxed);
+    }
+    auto buckets = mergedBuckets();
+    for (uint64_t bucket : buckets) {
+        summary.count += bucket;
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean_us = static_cast<double>(sum) / static_cast<double>(summary.count);
+    summary.p50_us = percentileOf(buckets, summary.count, 0.50);
+    summary.p90_us = percentileOf(buckets, summary.count, 0.90);
+    summary.p99_us = percentileOf(buckets, summary.count, 0.99);
+    summary.max_us = max_value.load(std::memory_order_relaxed);
+    return summary;
+}
+
+uint64_t Histogram::percentileOf(const std::array<uint64_t, kBucketCount>& buckets, uint64_t count,
+                                 double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Nearest rank, reported as the top of its bucket but never above the largest value seen
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::clamp<uint64_t>(rank, 1, count);
+    uint64_t highest = max_value.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), highest);
+        }
+    }
+    return highest;
+}
+
+// TraceSpan implementation
+TraceSpan::TraceSpan(Histogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {
+    Metrics& metrics = Metrics::getInstance();
+    if (!metrics.isTracing()) {
+        return;
+    }
+    span_id = metrics.nextSpanId();
+    parent = current_span;
+    if (parent) {
+        parent_id = parent->span_id;
+        trace_id = parent->trace_id;
+    } else {
+        trace_id = span_id;
+    }
+    current_span = this;
+}
+
+TraceSpan::~TraceSpan() {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    histogram.record(elapsed);
+    if (span_id == 0) {
+        return;
+    }
+    current_span = parent;
+    Metrics::SpanRecord record;
+    record.name = &histogram.name();
+    record.start = start;
+    record.duration = elapsed;
+    record.span_id = span_id;
+    record.parent_id = parent_id;
+    record.trace_id = trace_id;
+    record.thread = metricsThreadIndex();
+    Metrics::getInstance().addSpan(record);
+}
+
+// Metrics implementation
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+Counter& Metrics::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = counters[name];
+    if (!slot) {
+        slot = std::make_unique<Counter>(name);
+    }
+    return *slot;
+}
+
+Histogram& Metrics::histogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = histograms[name];
+    if (!slot) {
+        slot = std::make_unique<Histogram>(name);
+    }
+    return *slot;
+}
+
+Metrics::Snapshot Metrics::snapshot() const {
+    Snapshot snapshot;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [name, counter] : counters) {
+        snapshot.counters[name] = counter->value();
+    }
+    for (const auto& [name, histogram] : histograms) {
+        snapshot.histograms[name] = histogram->summarize();
+    }
+    return snapshot;
+}
+
+void Metrics::startTracing(size_t capacity) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    spans.assign(std::max<size_t>(capacity, 1), SpanRecord{});
+    span_capacity = spans.size();
+    span_total = 0;
+    trace_start = std::chrono::steady_clock::now();
+    trace_wall_start = std::chrono::system_clock::now();
+    tracing.store(true, std::memory_order_relaxed);
+}
+
+void Metrics::stopTracing() {
+    tracing.store(false, std::memory_order_relaxed);
+}
+
+size_t Metrics::spanCount() const {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    return std::min(span_total, span_capacity);
+}
+
+void Metrics::addSpan(const SpanRecord& span) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    // Spans still open when tracing stopped are kept; ones from before it started are not
+    if (span_capacity == 0 || span.start < trace_start) {
+        return;
+    }
+    spans[span_total % span_capacity] = span;
+    span_total++;
+}
+
+std::vector<Metrics::SpanRecord> Metrics::spansInOrder() const {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    std::vector<SpanRecord> ordered;
+    size_t kept = std::min(span_total, span_capacity);
+    ordered.reserve(kept);
+    for (size_t i = span_total - kept; i < span_total; i++) {
+        ordered.push_back(spans[i % span_capacity]);
+    }
+    return ordered;
+}
+
+bool Metrics::writeChromeTrace(const std::string& path) const {
+    auto recorded = spansInOrder();
+    std::chrono::steady_clock::time_point origin;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        origin = trace_start;
+    }
+    
+    // Complete ("X") events with microsecond timestamps from the start of the trace
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char numbers[96];
+    uint32_t pid = processId();
+    for (size_t i = 0; i < recorded.size(); i++) {
+        const SpanRecord& span = recorded[i];
+        out += i == 0 ? "{\"name\":\"" : ",{\"name\":\"";
+        appendEscaped(out, *span.name);
+        double ts = std::chrono::duration<double, std::micro>(span.start - origin).count();
+        double dur = std::chrono::duration<double, std::micro>(span.duration).count();
+        std::snprintf(numbers, sizeof(numbers), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}", ts,
+                      dur, pid, span.thread);
+        out += numbers;
+    }
+    out += "]}";
+    return writeFile(path, out);
+}
+
+bool Metrics::writeOpenTelemetry(const std::string& path, const std::string& service_name) const {
+    auto recorded = spansInOrder();
+    std::chrono::steady_clock::time_point origin;
+    std::chrono::system_clock::time_point wall_origin;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        origin = trace_start;
+        wall_origin = trace_wall_start;
+    }
+    auto unixNanos = [&](std::chrono::steady_clock::time_point time) {
+        auto wall = wall_origin + std::chrono::duration_cast<std::chrono::system_clock::duration>(time - origin);
+        return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(wall.time_since_epoch()).count());
+    };
+    
+    // OTLP/JSON: ids are hex, 64-bit integers are strings. Trace ids only need to be unique
+    // within this export, so the process id fills their upper half.
+    uint32_t pid = processId();
+    std::string out = "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":"
+                      "{\"stringValue\":\"";
+    appendEscaped(out, service_name);
+    out += "\"}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"xeno.utils.metrics\"},\"spans\":[";
+    for (size_t i = 0; i < recorded.size(); i++) {
+        const SpanRecord& span = recorded[i];
+        out += i == 0 ? "{" : ",{";
+        out += "\"traceId\":\"" + hexId(pid, span.trace_id, true) + "\",\"spanId\":\"" +
+               hexId(0, span.span_id, false) + "\",";
+        if (span.parent_id != 0) {
+            out += "\"parentSpanId\":\"" + hexId(0, span.parent_id, false) + "\",";
+        }
+        out += "\"name\":\"";
+        appendEscaped(out, *span.name);
+        out += "\",\"kind\":1,\"startTimeUnixNano\":\"" + unixNanos(span.start) + "\",\"endTimeUnixNano\":\"" +
+               unixNanos(span.start + span.duration) + "\",\"attributes\":[{\"key\":\"thread.id\",\"value\":" +
+               "{\"intValue\":\"" + std::to_string(span.thread) + "\"}}]}";
+    }
+    out += "]}]}]}";
+    return writeFile(path, out);
+}
+
+} // namespace xeno::utils
@@ -0,0 +1,183 @@
+#include "piece_table.h"
+#include <algorithm>
+
+namespace xeno::utils {
+
+PieceTable::PieceTable(std::string_view original) {
+    reset(original);
+}
+
+void PieceTable::reset(std::string_view original) {
+    this->original = original;
+    added.clear();
+    pieces.clear();
+    if (!original.empty()) {
+        pieces.push_back({false, 0, original.size()});
+    }
+    updateEnds(0);
+}
+
+char PieceTable::at(size_t offset) const {
+    size_t within = 0;
+    size_t index = locate(offset, within);
+    return index < pieces.size() ? pieceText(pieces[index])[within] : '\0';
+}
+
+std::string PieceTable::text(size_t offset, size_t length) const {
+    std::string result;
+    offset = std::min(offset, total);
+    result.reserve(std::min(length, total - offset));
+    forEachChunk(offset, length, [&](std::string_view chunk) {
+        result.append(chunk);
+        return true;
+    });
+    return result;
+}
+
+void PieceTable::forEachChunk(size_t offset, size_t length,
+                              const std::function<bool(std::string_view)>& visit) const {
+    if (offset >= total || length == 0) {
+        return;
+    }
+    length = std::min(length, total - offset);
+    size_t within = 0;
+    for (size_t index = locate(offset, within); length > 0 && index < pieces.size(); index++) {
+        std::string_view chunk = pieceText(pieces[index]).substr(within, length);
+        within = 0;
+        length -= chunk.size();
+        if (!visit(chunk)) {
+            return;
+        }
+    }
+}
+
+size_t PieceTable::find(char c, size_t from, size_t limit) const {
+    if (from >= total) {
+        return npos;
+    }
+    size_t remaining = std::min(limit, total - from);
+    size_t within = 0;
+    size_t position = from;
+    for (size_t index = locate(from, within); remaining > 0 && index < pieces.size(); index++) {
+        std::string_view chunk = pieceText(pieces[index]).substr(within, remaining);
+        size_t found = chunk.find(c);
+        if (found != std::string_view::npos) {
+            return position + found;
+        }
+        position += chunk.size();
+        remaining -= chunk.size();
+        within = 0;
+    }
+    return npos;
+}
+
+size_t PieceTable::rfind(char c, size_t before, size_t limit) const {
+    before = std::min(before, total);
+    if (before == 0) {
+        return npos;
+    }
+    size_t remaining = std::min(limit, before);
+    size_t within = 0;
+    size_t index = locate(before - 1, within);
+    size_t chunk_end = before;  // Document offset just past the part of the piece searched
+    while (remaining > 0) {
+        // The piece up to and including within, cut to what is left of the limit
+        std::string_view chunk = pieceText(pieces[index]).substr(0, within + 1);
+        size_t skip = chunk.size() > remaining ? chunk.size() - remaining : 0;
+        size_t found = chunk.substr(skip).rfind(c);
+        if (found != std::string_view::npos) {
+            return chunk_end - (chunk.size() - skip) + found;
+        }
+        remaining -= chunk.size() - skip;
+        chunk_end -= chunk.size() - skip;
+        if (index == 0) {
+            break;
+        }
+        index--;
+        within = pieces[index].length - 1;
+    }
+    return npos;
+}
+
+void PieceTable::insert(size_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, total);
+    size_t start = added.size();
+    added.append(text);
+    Piece piece{true, start, text.size()};
+    
+    // Typing straight after the previous insert extends its piece
+    if (offset > 0) {
+        size_t within = 0;
+        size_t index = locate(offset - 1, within);
+        Piece& previous = pieces[index];
+        if (within + 1 == previous.length && previous.added && previous.start + previous.length == start) {
+            previous.length += text.size();
+            updateEnds(index);
+            return;
+        }
+    }
+    
+    size_t within = 0;
+    size_t index = locate(offset, within);
+    if (within == 0) {
+        pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(index), piece);
+    } else {
+        Piece& split = pieces[index];
+        Piece right{split.added, split.start + within, split.length - within};
+        split.length = within;
+        pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(index) + 1, {piece, right});
+    }
+    updateEnds(index);
+}
+
+void PieceTable::erase(size_t offset, size_t length) {
+    if (offset >= total || length == 0) {
+        return;
+    }
+    length = std::min(length, total - offset);
+    size_t first_within = 0;
+    size_t last_within = 0;
+    size_t first = locate(offset, first_within);
+    size_t last = locate(offset + length - 1, last_within);
+    
+    // What survives of the first and last pieces touched
+    std::vector<Piece> kept;
+    if (first_within > 0) {
+        kept.push_back({pieces[first].added, pieces[first].start, first_within});
+    }
+    const Piece& end = pieces[last];
+    if (last_within + 1 < end.length) {
+        kept.push_back({end.added, end.start + last_within + 1, end.length - last_within - 1});
+    }
+    auto erase_begin = pieces.begin() + static_cast<std::ptrdiff_t>(first);
+    pieces.erase(erase_begin, pieces.begin() + static_cast<std::ptrdiff_t>(last) + 1);
+    pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(first), kept.begin(), kept.end());
+    updateEnds(first);
+}
+
+std::string_view PieceTable::pieceText(const Piece& piece) const {
+    std::string_view buffer = piece.added ? std::string_view(added) : original;
+    return buffer.substr(piece.start, piece.length);
+}
+
+size_t PieceTable::locate(size_t offset, size_t& within) const {
+    auto found = std::upper_bound(piece_ends.begin(), piece_ends.end(), offset);
+    size_t index = static_cast<size_t>(found - piece_ends.begin());
+    within = offset - (index > 0 ? piece_ends[index - 1] : 0);
+    return index;
+}
+
+void PieceTable::updateEnds(size_t first) {
+    piece_ends.resize(pieces.size());
+    size_t end = first > 0 ? piece_ends[first - 1] : 0;
+    for (size_t index = first; index < pieces.size(); index++) {
+        end += pieces[index].length;
+        piece_ends[index] = end;
+    }
+    total = end;
+}
+
+} // namespace xeno::utils
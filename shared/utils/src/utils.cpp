@@ -1,8 +1,21 @@
 #include "utils.h"
+#include "spsc_ring_buffer.h"
+#include <nlohmann/json.hpp>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -20,117 +33,737 @@
 namespace xeno::utils {
 
 // ConfigManager implementation
-ConfigManager& ConfigManager::getInstance() {
-    static ConfigManager instance;
-    return instance;
+namespace {
+
+// The value at a dotted key, made with any objects on the way to it
+nlohmann::json& entryAt(nlohmann::json& document, const std::string& key) {
+    nlohmann::json* node = &document;
+    size_t start = 0;
+    while (true) {
+        if (!node->is_object()) {
+            *node = nlohmann::json::object();
+        }
+        size_t dot = key.find('.', start);
+        node = &(*node)[key.substr(start, dot == std::string::npos ? std::string::npos : dot - start)];
+        if (dot == std::string::npos) {
+            return *node;
+        }
+        start = dot + 1;
+    }
 }
 
-bool ConfigManager::loadConfig(const std::string& config_path) {
-    try {
-        std::ifstream file(config_path);
-        if (!file.is_open()) {
-            return false;
+// The older format: one key=value per line, values typed the way they read
+nlohmann::json parseKeyValues(const std::string& text) {
+    nlohmann::json document = nlohmann::json::object();
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t pos = line.find('=');
+        if (pos == std::string::npos) {
+            continue;
         }
-        
-        std::string line;
-        while (std::getline(file, line)) {
-            size_t pos = line.find('=');
-            if (pos != std::string::npos) {
-                std::string key = line.substr(0, pos);
-                std::string value = line.substr(pos + 1);
-                config_data[key] = value;
-            }
+        std::string value = line.substr(pos + 1);
+        const char* value_end = value.data() + value.size();
+        int64_t number = 0;
+        double real = 0.0;
+        auto parsed_int = std::from_chars(value.data(), value_end, number);
+        auto parsed_real = std::from_chars(value.data(), value_end, real);
+        nlohmann::json& entry = entryAt(document, line.substr(0, pos));
+        if (value == "true" || value == "false") {
+            entry = value == "true";
+        } else if (!value.empty() && parsed_int.ec == std::errc() && parsed_int.ptr == value_end) {
+            entry = number;
+        } else if (!value.empty() && parsed_real.ec == std::errc() && parsed_real.ptr == value_end &&
+                   std::isfinite(real)) {
+            entry = real;
+        } else {
+            entry = value;
         }
-        return true;
-    } catch (const std::exception&) {
-        return false;
     }
+    return document;
 }
 
-bool ConfigManager::saveConfig(const std::string& config_path) {
-    try {
-        std::ofstream file(config_path);
+// Changes to a file, as far as its size and modification time tell
+struct FileStamp {
+    std::filesystem::file_time_type modified;
+    uintmax_t size = 0;
+    
+    bool operator==(const FileStamp&) const = default;
+};
+
+std::optional<FileStamp> stampOf(const std::string& path) {
+    std::error_code error;
+    FileStamp stamp;
+    stamp.modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    stamp.size = std::filesystem::file_size(path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    return stamp;
+}
+
+} // namespace
+
+std::string_view ConfigManager::Snapshot::getString(std::string_view key, std::string_view default_value) const {
+    const Slot* slot = find(key);
+    return slot ? std::string_view(slot->text) : default_value;
+}
+
+int64_t ConfigManager::Snapshot::getInt(std::string_view key, int64_t default_value) const {
+    const Slot* slot = find(key);
+    if (!slot) {
+        return default_value;
+    }
+    return std::visit([default_value](const auto& value) -> int64_t {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return default_value;
+        } else {
+            return static_cast<int64_t>(value);
+        }
+    }, slot->value);
+}
+
+double ConfigManager::Snapshot::getDouble(std::string_view key, double default_value) const {
+    const Slot* slot = find(key);
+    if (!slot) {
+        return default_value;
+    }
+    return std::visit([default_value](const auto& value) -> double {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return default_value;
+        } else {
+            return static_cast<double>(value);
+        }
+    }, slot->value);
+}
+
+bool ConfigManager::Snapshot::getBool(std::string_view key, bool default_value) const {
+    const Slot* slot = find(key);
+    if (!slot) {
+        return default_value;
+    }
+    return std::visit([default_value](const auto& value) -> bool {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return default_value;
+        } else {
+            return value != 0;
+        }
+    }, slot->value);
+}
+
+struct ConfigManager::Impl {
+    // Writers take this lock; readers only load the current snapshot
+    std::mutex write_mutex;
+    nlohmann::json file_document = nlohmann::json::object();
+    nlohmann::json overrides = nlohmann::json::object();  // Values set at run time
+    std::string source_path;
+    std::optional<FileStamp> source_stamp;
+    uint64_t version = 0;
+    std::atomic<std::shared_ptr<const Snapshot>> current;
+    
+    std::mutex listeners_mutex; // Guards the map only; listeners run without it
+    std::map<int, std::shared_ptr<const Listener>> listeners;
+    int next_listener = 1;
+    // Held while listeners run, so they run one at a time and unsubscribe() can wait for them.
+    // Recursive, since a listener may itself change the config, subscribe or unsubscribe.
+    std::recursive_mutex delivery_mutex;
+    uint64_t notified_version = 0; // Newest snapshot passed to listeners; guarded by delivery_mutex
+    
+    std::mutex watch_mutex;
+    std::condition_variable watch_cv;
+    std::thread watcher;
+    bool watch_stopping = false;
+    
+    // Typed slots for every scalar under node, keyed by dotted path
+    static void flatten(const nlohmann::json& node, const std::string& key, decltype(Snapshot::slots)& slots) {
+        using Slot = Snapshot::Slot;
+        if (node.is_object()) {
+            for (const auto& [name, child] : node.items()) {
+                flatten(child, key.empty() ? name : key + "." + name, slots);
+            }
+        } else if (node.is_boolean()) {
+            slots[key] = Slot{node.get<bool>(), node.get<bool>() ? "true" : "false"};
+        } else if (node.is_number_integer()) {
+            slots[key] = Slot{node.get<int64_t>(), node.dump()};
+        } else if (node.is_number_float()) {
+            slots[key] = Slot{node.get<double>(), node.dump()};
+        } else if (node.is_string()) {
+            slots[key] = Slot{node.get<std::string>(), node.get<std::string>()};
+        }
+    }
+    
+    // Parses a config file, JSON or key=value
+    static std::optional<nlohmann::json> readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
         if (!file.is_open()) {
-            return false;
+            return std::nullopt;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos || text[first] != '{') {
+            return parseKeyValues(text);
+        }
+        auto document = nlohmann::json::parse(text, nullptr, false);
+        if (document.is_discarded()) {
+            Logger::getInstance().warning("Cannot parse config file ", path);
+            return std::nullopt;
+        }
+        return document;
+    }
+    
+    // Builds the next snapshot from the file and overrides. The caller holds write_mutex.
+    std::shared_ptr<const Snapshot> buildSnapshot() {
+        auto document = std::make_shared<nlohmann::json>(file_document);
+        document->merge_patch(overrides);
+        auto snapshot = std::make_shared<Snapshot>();
+        flatten(*document, "", snapshot->slots);
+        snapshot->json = std::move(document);
+        snapshot->source_path = source_path;
+        snapshot->snapshot_version = ++version;
+        return snapshot;
+    }
+    
+    // Makes the next snapshot current. The caller holds write_mutex, so snapshots go out in order.
+    std::shared_ptr<const Snapshot> publishLocked() {
+        auto snapshot = buildSnapshot();
+        current.store(snapshot, std::memory_order_release);
+        return snapshot;
+    }
+    
+    void set(const std::string& key, nlohmann::json value) {
+        std::shared_ptr<const Snapshot> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            entryAt(overrides, key) = std::move(value);
+            snapshot = publishLocked();
         }
+        notify(*snapshot);
+    }
+    
+    void notify(const Snapshot& snapshot) {
+        std::lock_guard<std::recursive_mutex> delivery(delivery_mutex);
+        // Writers notify after releasing write_mutex, so a newer snapshot can get here first;
+        // the older one would take listeners back to stale values
+        if (snapshot.version() <= notified_version) {
+            return;
+        }
+        notified_version = snapshot.version();
         
-        for (const auto& [key, value] : config_data) {
-            file << key << "=" << value << std::endl;
+        std::vector<std::pair<int, std::shared_ptr<const Listener>>> targets;
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex);
+            targets.assign(listeners.begin(), listeners.end());
+        }
+        for (const auto& [id, listener] : targets) {
+            // A listener that changed the config has already passed the newer snapshot on
+            if (notified_version != snapshot.version()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(listeners_mutex);
+                if (!listeners.contains(id)) {
+                    continue; // Unsubscribed by a listener that ran before it
+                }
+            }
+            (*listener)(snapshot);
         }
-        return true;
-    } catch (const std::exception&) {
-        return false;
     }
+};
+
+ConfigManager& ConfigManager::getInstance() {
+    static ConfigManager instance;
+    return instance;
 }
 
-std::string ConfigManager::getString(const std::string& key, const std::string& default_value) {
-    auto it = config_data.find(key);
-    return it != config_data.end() ? it->second : default_value;
+ConfigManager::ConfigManager() : pImpl(std::make_unique<Impl>()) {
+    // Reloads log from the watcher thread, so the logger has to outlive this
+    Logger::getInstance();
+    std::lock_guard<std::mutex> lock(pImpl->write_mutex);
+    pImpl->publishLocked();
 }
 
-int ConfigManager::getInt(const std::string& key, int default_value) {
-    auto it = config_data.find(key);
-    if (it != config_data.end()) {
-        try {
-            return std::stoi(it->second);
-        } catch (const std::exception&) {
-            return default_value;
+ConfigManager::~ConfigManager() {
+    stopWatching();
+}
+
+bool ConfigManager::loadConfig(const std::string& config_path) {
+    std::shared_ptr<const Snapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->write_mutex);
+        auto stamp = stampOf(config_path);
+        auto document = Impl::readFile(config_path);
+        if (!document) {
+            return false;
         }
+        pImpl->file_document = std::move(*document);
+        pImpl->source_path = config_path;
+        pImpl->source_stamp = stamp;
+        snapshot = pImpl->publishLocked();
     }
-    return default_value;
+    pImpl->notify(*snapshot);
+    return true;
 }
 
-bool ConfigManager::getBool(const std::string& key, bool default_value) {
-    auto it = config_data.find(key);
-    if (it != config_data.end()) {
-        return it->second == "true" || it->second == "1";
+bool ConfigManager::saveConfig(const std::string& config_path) {
+    std::ofstream file(config_path);
+    if (!file.is_open()) {
+        return false;
     }
-    return default_value;
+    file << snapshot()->document().dump(4) << std::endl;
+    return static_cast<bool>(file);
+}
+
+std::string ConfigManager::getString(std::string_view key, std::string_view default_value) const {
+    return std::string(snapshot()->getString(key, default_value));
+}
+
+int ConfigManager::getInt(std::string_view key, int default_value) const {
+    return static_cast<int>(snapshot()->getInt(key, default_value));
+}
+
+double ConfigManager::getDouble(std::string_view key, double default_value) const {
+    return snapshot()->getDouble(key, default_value);
+}
+
+bool ConfigManager::getBool(std::string_view key, bool default_value) const {
+    return snapshot()->getBool(key, default_value);
+}
+
+std::shared_ptr<const ConfigManager::Snapshot> ConfigManager::snapshot() const {
+    return pImpl->current.load(std::memory_order_acquire);
 }
 
 void ConfigManager::setString(const std::string& key, const std::string& value) {
-    config_data[key] = value;
+    pImpl->set(key, value);
 }
 
 void ConfigManager::setInt(const std::string& key, int value) {
-    config_data[key] = std::to_string(value);
+    pImpl->set(key, value);
+}
+
+void ConfigManager::setDouble(const std::string& key, double value) {
+    pImpl->set(key, value);
 }
 
 void ConfigManager::setBool(const std::string& key, bool value) {
-    config_data[key] = value ? "true" : "false";
+    pImpl->set(key, value);
+}
+
+bool ConfigManager::reloadIfChanged() {
+    std::shared_ptr<const Snapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->write_mutex);
+        if (pImpl->source_path.empty()) {
+            return false;
+        }
+        auto stamp = stampOf(pImpl->source_path);
+        if (!stamp || stamp == pImpl->source_stamp) {
+            return false;
+        }
+        // Remembered even when the file does not parse, so a broken edit is reported once
+        pImpl->source_stamp = stamp;
+        auto document = Impl::readFile(pImpl->source_path);
+        if (!document) {
+            return false;
+        }
+        pImpl->file_document = std::move(*document);
+        snapshot = pImpl->publishLocked();
+    }
+    Logger::getInstance().info("Reloaded ", snapshot->sourcePath());
+    pImpl->notify(*snapshot);
+    return true;
+}
+
+void ConfigManager::watch(std::chrono::milliseconds interval) {
+    stopWatching();
+    std::lock_guard<std::mutex> lock(pImpl->watch_mutex);
+    pImpl->watch_stopping = false;
+    pImpl->watcher = std::thread([this, interval]() {
+        std::unique_lock<std::mutex> lock(pImpl->watch_mutex);
+        while (!pImpl->watch_cv.wait_for(lock, interval, [this]() { return pImpl->watch_stopping; })) {
+            lock.unlock();
+            reloadIfChanged();
+            lock.lock();
+        }
+    });
+}
+
+void ConfigManager::stopWatching() {
+    std::thread watcher;
+    {
+        std::lock_guard<std::mutex> lock(pImpl->watch_mutex);
+        pImpl->watch_stopping = true;
+        watcher = std::move(pImpl->watcher);
+    }
+    pImpl->watch_cv.notify_all();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+}
+
+int ConfigManager::subscribe(Listener listener) {
+    std::lock_guard<std::mutex> lock(pImpl->listeners_mutex);
+    int id = pImpl->next_listener++;
+    pImpl->listeners[id] = std::make_shared<const Listener>(std::move(listener));
+    return id;
+}
+
+void ConfigManager::unsubscribe(int id) {
+    {
+        std::lock_guard<std::mutex> lock(pImpl->listeners_mutex);
+        pImpl->listeners.erase(id);
+    }
+    // Waits for a delivery running on another thread; from inside a listener this returns at once
+    std::lock_guard<std::recursive_mutex> delivery(pImpl->delivery_mutex);
 }
 
 // Logger implementation
+namespace {
+
+constexpr size_t kRingBytes = 64 * 1024;                   // Per thread
+constexpr auto kWriteInterval = std::chrono::milliseconds(50);  // Longest a message waits to be written
+const char* const kLevelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+// Precedes each message's text in a thread's ring
+struct RecordHeader {
+    int32_t level;
+    uint32_t length;
+    int64_t time_ns;  // system_clock
+};
+
+} // namespace
+
+struct Logger::Impl {
+    struct Record {
+        Level level;
+        int64_t time_ns;
+        uint32_t thread;
+        std::string text;
+    };
+    
+    // Messages of one thread. The logging thread is the only producer, the writer the only consumer.
+    struct ThreadRing {
+        explicit ThreadRing(uint32_t thread) : thread(thread) {}
+        
+        // Writer only: the next complete message, if one has arrived
+        bool take(Record& record) {
+            if (!has_header) {
+                if (bytes.readAvailable() < sizeof(RecordHeader)) {
+                    return false;
+                }
+                bytes.read(reinterpret_cast<char*>(&header), sizeof(RecordHeader));
+                has_header = true;
+                text.clear();
+            }
+            // The text follows its header in separate writes, so it may still be arriving
+            size_t have = text.size();
+            text.resize(header.length);
+            text.resize(have + bytes.read(text.data() + have, header.length - have));
+            if (text.size() < header.length) {
+                return false;
+            }
+            has_header = false;
+            record.level = static_cast<Level>(header.level);
+            record.time_ns = header.time_ns;
+            record.thread = thread;
+            record.text = std::move(text);
+            return true;
+        }
+        
+        SpscRingBuffer<char> bytes{kRingBytes};
+        uint32_t thread;
+        std::atomic<bool> retired{false};  // The thread has exited
+        
+        RecordHeader header{};
+        bool has_header = false;
+        std::string text;
+    };
+    
+    // Marks the thread's ring retired when the thread exits, so the writer can drain and drop it
+    struct RingHolder {
+        std::shared_ptr<ThreadRing> ring;
+        ~RingHolder() {
+            if (ring) {
+                ring->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+    
+    Impl() : writer(&Impl::writerLoop, this) {}
+    
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+    
+    // Wakes the writer without taking its lock
+    void nudge() {
+        nudged.store(true, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+    
+    ThreadRing& threadRing() {
+        thread_local RingHolder holder;
+        if (!holder.ring) {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            holder.ring = std::make_shared<ThreadRing>(next_thread++);
+            rings.push_back(holder.ring);
+        }
+        return *holder.ring;
+    }
+    
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait_for(lock, kWriteInterval, [this]() {
+                return stopping || nudged.load(std::memory_order_relaxed) || flush_requested > flush_done;
+            });
+            nudged.store(false, std::memory_order_relaxed);
+            bool stop = stopping;
+            uint64_t requested = flush_requested;
+            lock.unlock();
+            drain();
+            lock.lock();
+            flush_done = requested;
+            flushed.notify_all();
+            if (stop) {
+                return;
+            }
+        }
+    }
+    
+    // Writes out everything the rings hold, in time order, as one batch per output
+    void drain() {
+        std::vector<std::shared_ptr<ThreadRing>> current;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            current = rings;
+        }
+        std::vector<Record> batch;
+        Record record;
+        for (const auto& ring : current) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            while (ring->take(record)) {
+                batch.push_back(std::move(record));
+            }
+            if (retired && ring->bytes.readAvailable() == 0) {
+                std::lock_guard<std::mutex> lock(rings_mutex);
+                rings.erase(std::find(rings.begin(), rings.end(), ring));
+            }
+        }
+        std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+            return a.time_ns < b.time_ns;
+        });
+        
+        uint64_t dropped_now = dropped.load(std::memory_order_relaxed);
+        if (dropped_now > dropped_reported) {
+            Record note{WARNING, batch.empty() ? nowNanos() : batch.back().time_ns, 0,
+                        std::to_string(dropped_now - dropped_reported) + " log messages dropped: buffer full"};
+            batch.push_back(std::move(note));
+            dropped_reported = dropped_now;
+        }
+        if (batch.empty()) {
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        std::string console_text;
+        std::string file_text;
+        std::string line;
+        for (const Record& entry : batch) {
+            if (options.console) {
+                console_text += std::string("[") + kLevelNames[entry.level] + "] " + entry.text + "\n";
+            }
+            if (file.is_open()) {
+                line.clear();
+                appendFileLine(line, entry);
+                // Files rotate between lines, so each stays within max_file_bytes unless one line is larger
+                if (file_bytes + file_text.size() > 0 &&
+                    file_bytes + file_text.size() + line.size() > options.max_file_bytes) {
+                    writeFile(file_text);
+                    rotate();
+                }
+                file_text += line;
+            }
+        }
+        if (!console_text.empty()) {
+            std::cout.write(console_text.data(), static_cast<std::streamsize>(console_text.size()));
+            std::cout.flush();
+        }
+        writeFile(file_text);
+    }
+    
+    // Appends text to the file and clears it. The caller holds sink_mutex.
+    void writeFile(std::string& text) {
+        if (text.empty() || !file.is_open()) {
+            return;
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        file.flush();
+        file_bytes += text.size();
+        text.clear();
+    }
+    
+    // "2026-01-31 14:05:09.042 [INFO] [3] message"
+    static void appendFileLine(std::string& out, const Record& entry) {
+        std::time_t seconds = static_cast<std::time_t>(entry.time_ns / 1000000000);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char stamp[48];
+        size_t length = std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+        std::snprintf(stamp + length, sizeof(stamp) - length, ".%03d [%s] [%u] ",
+                      static_cast<int>(entry.time_ns / 1000000 % 1000), kLevelNames[entry.level], entry.thread);
+        out += stamp;
+        out += entry.text;
+        out += '\n';
+    }
+    
+    static int64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    std::filesystem::path logPath(int generation) const {
+        std::string name = options.file_name + (generation > 0 ? "." + std::to_string(generation) : "") + ".log";
+        return std::filesystem::path(directory) / name;
+    }
+    
+    // The caller holds sink_mutex
+    void openFile() {
+        file.close();
+        file_bytes = 0;
+        if (options.file_name.empty()) {
+            return;
+        }
+        directory = options.directory.empty() ? Platform::getAppDataPath() + "/logs" : options.directory;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        file.open(logPath(0), std::ios::binary | std::ios::app);
+        if (file.is_open()) {
+            file_bytes = static_cast<size_t>(std::filesystem::file_size(logPath(0), error));
+        }
+    }
+    
+    // Shifts name.log to name.1.log and so on, dropping the oldest. The caller holds sink_mutex.
+    void rotate() {
+        file.close();
+        std::error_code error;
+        if (options.max_files > 0) {
+            std::filesystem::remove(logPath(options.max_files), error);
+            for (int generation = options.max_files - 1; generation >= 0; generation--) {
+                std::filesystem::rename(logPath(generation), logPath(generation + 1), error);
+            }
+        } else {
+            std::filesystem::remove(logPath(0), error);
+        }
+        file.open(logPath(0), std::ios::binary | std::ios::trunc);
+        file_bytes = 0;
+    }
+    
+    std::atomic<Overflow> overflow{Overflow::Drop};
+    std::atomic<uint64_t> dropped{0};
+    uint64_t dropped_reported = 0;  // Writer only
+    
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    uint32_t next_thread = 1;  // 0 marks the logger's own notes
+    
+    std::mutex sink_mutex;  // Guards the options and the file
+    Options options;
+    std::string directory;
+    std::ofstream file;
+    size_t file_bytes = 0;
+    
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> nudged{false};  // A producer wants a batch written now
+    uint64_t flush_requested = 0;
+    uint64_t flush_done = 0;
+    std::thread writer;  // Last, so it starts after everything it uses
+};
+
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
-void Logger::setLevel(Level level) {
-    current_level = level;
-}
+Logger::Logger() : pImpl(std::make_unique<Impl>()) {}
 
-void Logger::log(Level level, const std::string& message) {
-    if (level >= current_level) {
-        const char* level_strings[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
-        std::cout << "[" << level_strings[level] << "] " << message << std::endl;
-    }
+Logger::~Logger() = default;
+
+void Logger::configure(const Options& options) {
+    std::lock_guard<std::mutex> lock(pImpl->sink_mutex);
+    pImpl->options = options;
+    pImpl->overflow.store(options.overflow, std::memory_order_relaxed);
+    pImpl->openFile();
 }
 
-void Logger::debug(const std::string& message) {
-    log(DEBUG, message);
+void Logger::setLevel(Level level) {
+    current_level.store(level, std::memory_order_relaxed);
 }
 
-void Logger::info(const std::string& message) {
-    log(INFO, message);
+void Logger::log(Level level, std::initializer_list<Part> parts) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    Impl::ThreadRing& ring = pImpl->threadRing();
+    
+    size_t length = 0;
+    for (const Part& part : parts) {
+        length += part.text().size();
+    }
+    // A message longer than the whole ring is cut to fit
+    length = std::min(length, ring.bytes.capacity() - sizeof(RecordHeader));
+    size_t needed = sizeof(RecordHeader) + length;
+    while (ring.bytes.writeAvailable() < needed) {
+        // Nobody is left to make room once the writer has stopped
+        if (pImpl->overflow.load(std::memory_order_relaxed) == Overflow::Drop || pImpl->stopping) {
+            pImpl->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pImpl->nudge();
+        std::this_thread::yield();
+    }
+    
+    RecordHeader header{level, static_cast<uint32_t>(length), Impl::nowNanos()};
+    ring.bytes.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t left = length;
+    for (const Part& part : parts) {
+        size_t count = std::min(part.text().size(), left);
+        ring.bytes.write(part.text().data(), count);
+        left -= count;
+    }
+    // Errors are written promptly in case the process is about to go down
+    if (level >= ERROR) {
+        pImpl->nudge();
+    }
 }
 
-void Logger::warning(const std::string& message) {
-    log(WARNING, message);
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(pImpl->mutex);
+    uint64_t ticket = ++pImpl->flush_requested;
+    pImpl->wake.notify_one();
+    pImpl->flushed.wait(lock, [&]() { return pImpl->flush_done >= ticket; });
 }
 
-void Logger::error(const std::string& message) {
-    log(ERROR, message);
+uint64_t Logger::droppedCount() const {
+    return pImpl->dropped.load(std::memory_order_relaxed);
 }
 
 // Platform implementation
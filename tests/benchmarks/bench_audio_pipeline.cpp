@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+#include "benchmark_fixtures.h"
+#include "../../apps/audio-edit/src/audio_file.h"
+#include "../../apps/audio-edit/src/waveform_peaks.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <numbers>
+#include <string>
+#include <vector>
+
+using namespace xeno::audio;
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kChannels = 2;
+constexpr int64_t kFixtureSeconds = 10 * 60;
+
+// Ten minutes of 24-bit stereo: a slow sweep over noise, so every bucket holds a different peak
+const std::string& recordingFixture() {
+    static const std::string path = xeno::benchmarks::fixture("recording-10min.wav", [](const std::string& path) {
+        AudioFile file;
+        if (!file.create(path, kSampleRate, kChannels)) {
+            return false;
+        }
+        constexpr int64_t block = 65536;
+        std::vector<float> samples(block * kChannels);
+        uint32_t noise = 1;
+        double phase = 0.0;
+        for (int64_t start = 0; start < kFixtureSeconds * kSampleRate; start += block) {
+            for (int64_t i = 0; i < block; i++) {
+                double seconds = static_cast<double>(start + i) / kSampleRate;
+                phase += 2.0 * std::numbers::pi * (110.0 + 20.0 * seconds) / kSampleRate;
+                noise = noise * 1664525u + 1013904223u;
+                float hiss = static_cast<float>(noise >> 8) / static_cast<float>(1 << 24) - 0.5f;
+                float tone = static_cast<float>(0.6 * std::sin(phase) * (0.5 + 0.5 * std::sin(seconds * 0.7)));
+                samples[i * kChannels] = tone + 0.05f * hiss;
+                samples[i * kChannels + 1] = 0.8f * tone - 0.05f * hiss;
+            }
+            if (file.write(samples.data(), block) != block) {
+                return false;
+            }
+        }
+        file.close();
+        return true;
+    });
+    return path;
+}
+
+// Full scan of the file, as opening it for the first time does
+void BM_WaveformPeaksBuild(benchmark::State& state) {
+    const std::string& path = recordingFixture();
+    if (path.empty()) {
+        state.SkipWithError("Could not create the recording fixture");
+        return;
+    }
+    for (auto _ : state) {
+        WaveformPeaks peaks;
+        if (!peaks.build(path)) {
+            state.SkipWithError(peaks.lastError().c_str());
+            return;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+}
+BENCHMARK(BM_WaveformPeaksBuild)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Reopening a file already summarised reads the sidecar instead
+void BM_WaveformPeaksLoadCached(benchmark::State& state) {
+    const std::string& path = recordingFixture();
+    WaveformPeaks cached;
+    if (path.empty() || !cached.loadOrBuild(path)) {
+        state.SkipWithError("Could not summarise the recording fixture");
+        return;
+    }
+    for (auto _ : state) {
+        WaveformPeaks peaks;
+        benchmark::DoNotOptimize(peaks.loadOrBuild(path));
+    }
+}
+BENCHMARK(BM_WaveformPeaksLoadCached)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// The per-pixel reduction the waveform view runs on every repaint, 1920 pixels wide, with the
+// argument giving the seconds in view
+void BM_WaveformRender(benchmark::State& state) {
+    const std::string& path = recordingFixture();
+    WaveformPeaks peaks;
+    if (path.empty() || !peaks.loadOrBuild(path)) {
+        state.SkipWithError("Could not summarise the recording fixture");
+        return;
+    }
+    constexpr int pixels = 1920;
+    int channels = peaks.channels();
+    int64_t view_frames = std::min<int64_t>(state.range(0) * peaks.sampleRate(), peaks.frames());
+    int64_t view_start = (peaks.frames() - view_frames) / 2;
+    double frames_per_pixel = static_cast<double>(view_frames) / pixels;
+    std::vector<WaveformPeaks::Bucket> columns(static_cast<size_t>(pixels) * channels);
+    
+    for (auto _ : state) {
+        const auto& level = peaks.levelFor(frames_per_pixel);
+        auto bucket_count = static_cast<int64_t>(level.bucketCount(channels));
+        for (int c = 0; c < channels; c++) {
+            for (int x = 0; x < pixels; x++) {
+                int64_t first = view_start + static_cast<int64_t>(x * frames_per_pixel);
+                int64_t last = view_start + static_cast<int64_t>((x + 1) * frames_per_pixel);
+                first /= level.frames_per_bucket;
+                last /= level.frames_per_bucket;
+                last = std::min(std::max(last, first + 1), bucket_count);
+                WaveformPeaks::Bucket column{1.0f, -1.0f, 0.0f};
+                for (int64_t b = first; b < last; b++) {
+                    const auto& bucket = level.buckets[b * channels + c];
+                    column.min = std::min(column.min, bucket.min);
+                    column.max = std::max(column.max, bucket.max);
+                    column.rms = std::max(column.rms, bucket.rms);
+                }
+                columns[static_cast<size_t>(x) * channels + c] = column;
+            }
+        }
+        benchmark::DoNotOptimize(columns.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * pixels * channels);
+}
+BENCHMARK(BM_WaveformRender)->ArgName("seconds")->Arg(1)->Arg(60)->Arg(kFixtureSeconds)->Unit(benchmark::kMicrosecond);
+
+} // namespace
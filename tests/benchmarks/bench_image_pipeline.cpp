@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include "benchmark_fixtures.h"
+#include "../../apps/image-edit/src/image_engine.h"
+#include "../../shared/ai-integration/include/ai_integration.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace xeno::image;
+
+namespace {
+
+// A 48-megapixel photo: gradients under noise, so the codecs and enhance have real work to do
+const std::string& photoFixture() {
+    static const std::string path = xeno::benchmarks::fixture("photo-8000x6000.jpg", [](const std::string& path) {
+        cv::Mat image(6000, 8000, CV_8UC3);
+        for (int y = 0; y < image.rows; y++) {
+            auto* row = image.ptr<cv::Vec3b>(y);
+            for (int x = 0; x < image.cols; x++) {
+                row[x] = cv::Vec3b(static_cast<uint8_t>(x * 255 / image.cols),
+                                   static_cast<uint8_t>(y * 255 / image.rows),
+                                   static_cast<uint8_t>((x + y) % 256));
+            }
+        }
+        cv::Mat noise(image.size(), CV_8UC3);
+        cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(32));
+        image += noise;
+        return cv::imwrite(path, image, {cv::IMWRITE_JPEG_QUALITY, 92});
+    });
+    return path;
+}
+
+Recipe adjustmentRecipe() {
+    Recipe recipe;
+    recipe.loadFromJSON(nlohmann::json::parse(
+        R"({"steps": [{"op": "enhance"}, {"op": "brightness_contrast", "brightness": 10, "contrast": 15}]})"));
+    return recipe;
+}
+
+// Compute stage alone, on a decoded image
+void BM_ImageRecipeApply(benchmark::State& state) {
+    const std::string& path = photoFixture();
+    cv::Mat image = path.empty() ? cv::Mat() : cv::imread(path, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        state.SkipWithError("Could not create the photo fixture");
+        return;
+    }
+    auto operations = ImageEngine::buildOperations(adjustmentRecipe(), image.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ImageEngine::apply(image, operations));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(image.total() * image.elemSize()));
+}
+BENCHMARK(BM_ImageRecipeApply)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Decode, compute and encode overlapped across a batch of files, as xeno-image-batch runs them
+void BM_ImageEngineBatch(benchmark::State& state) {
+    const std::string& path = photoFixture();
+    if (path.empty()) {
+        state.SkipWithError("Could not create the photo fixture");
+        return;
+    }
+    std::vector<ImageEngine::Job> jobs;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        jobs.push_back({path, xeno::benchmarks::outputPath("photo-" + std::to_string(i) + ".jpg")});
+    }
+    
+    xeno::ai::AIIntegration ai;
+    ImageEngine engine(ai, ImageEngine::Options{});
+    Recipe recipe = adjustmentRecipe();
+    for (auto _ : state) {
+        for (const auto& result : engine.run(recipe, jobs)) {
+            if (!result.success) {
+                state.SkipWithError(result.error_message.c_str());
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+                            static_cast<int64_t>(std::filesystem::file_size(path)));
+}
+BENCHMARK(BM_ImageEngineBatch)->ArgName("files")->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,181 @@
+#include <benchmark/benchmark.h>
+#include "../../shared/ai-integration/include/ai_integration.h"
+#include <httplib.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace xeno::ai;
+
+namespace {
+
+/**
+ * @brief Local stand-in for an Ollama server with a fixed response time
+ *
+ * Answers /api/generate after sleeping for the configured latency, so a
+ * benchmark measures how many calls the integration keeps in flight and what
+ * it adds on top of the provider, without a model or the network.
+ */
+class MockProvider {
+public:
+    MockProvider(std::chrono::milliseconds latency, size_t threads) {
+        server.new_task_queue = [threads]() { return new httplib::ThreadPool(threads); };
+        server.Get("/api/version", [](const httplib::Request&, httplib::Response& response) {
+            response.set_content(R"({"version": "mock"})", "application/json");
+        });
+        server.Post("/api/generate", [latency](const httplib::Request&, httplib::Response& response) {
+            std::this_thread::sleep_for(latency);
+            response.set_content(R"({"model": "mock", "response": "return 0; }", "done": true})", "application/json");
+        });
+        port = server.bind_to_any_port("127.0.0.1");
+        if (port > 0) {
+            listener = std::thread([this]() { server.listen_after_bind(); });
+            server.wait_until_ready();
+        }
+    }
+    
+    ~MockProvider() {
+        server.stop();
+        if (listener.joinable()) {
+            listener.join();
+        }
+    }
+    
+    bool isListening() const { return port > 0; }
+    std::string endpoint() const { return "http://127.0.0.1:" + std::to_string(port); }
+
+private:
+    httplib::Server server;
+    std::thread listener;
+    int port = -1;
+};
+
+double percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// Arguments: requests in flight, and the provider's latency in milliseconds. Each iteration sends
+// one wave of requests and waits for all of them; counters report per-request latency including
+// the time spent queued for a connection or a worker.
+void BM_MockProviderCompletions(benchmark::State& state) {
+    auto concurrency = static_cast<size_t>(state.range(0));
+    MockProvider provider(std::chrono::milliseconds(state.range(1)), concurrency);
+    if (!provider.isListening()) {
+        state.SkipWithError("Could not start the mock provider on 127.0.0.1");
+        return;
+    }
+    
+    AIIntegration ai;
+    AIIntegration::CacheConfig cache;
+    cache.enabled = false;
+    ai.configureCache(cache);
+    AIIntegration::APIConfig config;
+    config.endpoint = provider.endpoint();
+    config.max_connections = concurrency;
+    config.timeout_seconds = 10;
+    ai.configure(AIIntegration::AIProvider::Ollama, config);
+    
+    AIIntegration::AIRequest request;
+    request.prompt = "int main() {";
+    request.operation_type = "code_completion";
+    request.cacheable = false;
+    
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> latencies;
+    std::vector<double> wave(concurrency);
+    std::vector<AIIntegration::AITask> tasks;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        tasks.clear();
+        for (size_t i = 0; i < concurrency; i++) {
+            auto started = Clock::now();
+            // The callback runs before the task is ready, so its sample is in place once get() returns
+            tasks.push_back(ai.completeCodeAsync(request, AIIntegration::AIProvider::Ollama,
+                [&wave, i, started](const AIIntegration::AIResponse&) {
+                    wave[i] = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+                }));
+        }
+        for (const auto& task : tasks) {
+            if (!task.get().success) {
+                failures++;
+            }
+        }
+        latencies.insert(latencies.end(), wave.begin(), wave.end());
+    }
+    
+    if (failures > 0) {
+        state.SkipWithError("The mock provider failed some requests");
+        return;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(concurrency));
+    state.counters["p50_ms"] = percentile(latencies, 0.50);
+    state.counters["p95_ms"] = percentile(latencies, 0.95);
+    state.counters["p99_ms"] = percentile(latencies, 0.99);
+}
+BENCHMARK(BM_MockProviderCompletions)
+    ->ArgNames({"in_flight", "latency_ms"})
+    ->ArgsProduct({{1, 8, 32}, {0, 20}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Streaming replies arrive as JSON lines; the mock sends them in one body, so this measures parsing
+// and chunk delivery rather than the provider
+void BM_MockProviderStreamedCompletion(benchmark::State& state) {
+    httplib::Server server;
+    std::string body;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        body += R"({"model": "mock", "response": "token ", "done": false})";
+        body += '\n';
+    }
+    body += R"({"model": "mock", "response": "", "done": true})";
+    body += '\n';
+    server.Post("/api/generate", [&body](const httplib::Request&, httplib::Response& response) {
+        response.set_content(body, "application/x-ndjson");
+    });
+    int port = server.bind_to_any_port("127.0.0.1");
+    if (port <= 0) {
+        state.SkipWithError("Could not start the mock provider on 127.0.0.1");
+        return;
+    }
+    std::thread listener([&server]() { server.listen_after_bind(); });
+    server.wait_until_ready();
+    
+    {
+        AIIntegration ai;
+        AIIntegration::APIConfig config;
+        config.endpoint = "http://127.0.0.1:" + std::to_string(port);
+        ai.configure(AIIntegration::AIProvider::Ollama, config);
+        
+        AIIntegration::AIRequest request;
+        request.prompt = "int main() {";
+        request.operation_type = "code_completion";
+        request.cacheable = false;
+        
+        int64_t chunks = 0;
+        for (auto _ : state) {
+            auto response = ai.completeCodeStream(request, [&chunks](const std::string&) {
+                chunks++;
+                return true;
+            }, AIIntegration::AIProvider::Ollama);
+            if (!response.success) {
+                state.SkipWithError("The mock provider failed a streamed request");
+                break;
+            }
+        }
+        state.SetItemsProcessed(chunks);
+    }
+    
+    server.stop();
+    listener.join();
+}
+BENCHMARK(BM_MockProviderStreamedCompletion)->ArgName("tokens")->Arg(64)->Arg(1024)->UseRealTime();
+
+} // namespace
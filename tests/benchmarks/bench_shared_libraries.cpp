@@ -0,0 +1,246 @@
+#include <benchmark/benchmark.h>
+#include "../../shared/ai-integration/include/ai_integration.h"
+#include "../../shared/media-kernels/include/media_kernels.h"
+#include "../../shared/utils/include/utils.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace xeno::ai;
+using namespace xeno::utils;
+using namespace xeno::media;
+
+namespace {
+
+// Shared by every thread of a multithreaded benchmark, as one app's integration is
+AIIntegration& sharedIntegration() {
+    static AIIntegration ai;
+    return ai;
+}
+
+AIIntegration::AIRequest completionRequest() {
+    AIIntegration::AIRequest request;
+    request.prompt = "int main() {";
+    request.operation_type = "code_completion";
+    return request;
+}
+
+// An unconfigured Ollama answers in demo mode, without the network or a credit charge, so these
+// measure what the integration itself adds to every request
+void BM_AIDispatchSync(benchmark::State& state) {
+    AIIntegration& ai = sharedIntegration();
+    auto request = completionRequest();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ai.completeCode(request, AIIntegration::AIProvider::Ollama));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AIDispatchSync)->ThreadRange(1, 8)->UseRealTime();
+
+// Adds the hop through the worker pool and the task's promise
+void BM_AIDispatchAsync(benchmark::State& state) {
+    AIIntegration& ai = sharedIntegration();
+    auto request = completionRequest();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ai.completeCodeAsync(request, AIIntegration::AIProvider::Ollama).get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AIDispatchAsync)->ThreadRange(1, 8)->UseRealTime();
+
+// Submits a burst of requests before waiting on any, as a batch of edits does
+void BM_AIDispatchBurst(benchmark::State& state) {
+    AIIntegration& ai = sharedIntegration();
+    auto request = completionRequest();
+    std::vector<AIIntegration::AITask> tasks;
+    for (auto _ : state) {
+        tasks.clear();
+        for (int64_t i = 0; i < state.range(0); i++) {
+            tasks.push_back(ai.completeCodeAsync(request, AIIntegration::AIProvider::Ollama));
+        }
+        for (const auto& task : tasks) {
+            benchmark::DoNotOptimize(task.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AIDispatchBurst)->Arg(16)->Arg(256)->UseRealTime();
+
+// An anonymous wallet with enough credits that no run drains it
+CreditWallet& sharedWallet() {
+    static CreditWallet wallet;
+    static bool funded = wallet.addCredits(1'000'000'000);
+    benchmark::DoNotOptimize(funded);
+    return wallet;
+}
+
+void BM_CreditWalletReserveCommit(benchmark::State& state) {
+    CreditWallet& wallet = sharedWallet();
+    for (auto _ : state) {
+        auto reservation = wallet.reserveCredits(1);
+        reservation.commit("benchmark");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreditWalletReserveCommit)->ThreadRange(1, 16)->UseRealTime();
+
+// Reservations that are refunded leave no transaction behind, isolating the balance itself
+void BM_CreditWalletReserveRefund(benchmark::State& state) {
+    CreditWallet& wallet = sharedWallet();
+    for (auto _ : state) {
+        auto reservation = wallet.reserveCredits(1);
+        reservation.refund();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreditWalletReserveRefund)->ThreadRange(1, 16)->UseRealTime();
+
+void BM_CreditWalletGetBalance(benchmark::State& state) {
+    CreditWallet& wallet = sharedWallet();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wallet.getBalance());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreditWalletGetBalance)->ThreadRange(1, 16)->UseRealTime();
+
+ConfigManager& populatedConfig() {
+    ConfigManager& config = ConfigManager::getInstance();
+    static bool populated = [&config]() {
+        for (int i = 0; i < 64; i++) {
+            config.setInt("benchmark.section" + std::to_string(i) + ".value", i);
+        }
+        config.setString("benchmark.ollama.endpoint", "http://localhost:11434");
+        return true;
+    }();
+    benchmark::DoNotOptimize(populated);
+    return config;
+}
+
+// How hot paths read settings: one snapshot, many typed lookups
+void BM_ConfigSnapshotLookup(benchmark::State& state) {
+    auto snapshot = populatedConfig().snapshot();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(snapshot->getInt("benchmark.section42.value"));
+        benchmark::DoNotOptimize(snapshot->getString("benchmark.ollama.endpoint"));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_ConfigSnapshotLookup)->ThreadRange(1, 8)->UseRealTime();
+
+// The convenience getters take a fresh snapshot per call and copy strings out
+void BM_ConfigManagerGet(benchmark::State& state) {
+    ConfigManager& config = populatedConfig();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(config.getInt("benchmark.section42.value"));
+        benchmark::DoNotOptimize(config.getString("benchmark.ollama.endpoint"));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_ConfigManagerGet)->ThreadRange(1, 8)->UseRealTime();
+
+// One 4K frame of packed RGBA; the 3-channel kernels use the first three quarters
+constexpr size_t kFramePixels = 3840 * 2160;
+
+const std::vector<uint8_t>& framePixels() {
+    static const std::vector<uint8_t> pixels = []() {
+        std::vector<uint8_t> data(kFramePixels * 4);
+        std::mt19937 random(7);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(random());
+        }
+        return data;
+    }();
+    return pixels;
+}
+
+// Every instruction set this CPU runs, each as its own benchmark argument
+void simdLevels(benchmark::internal::Benchmark* benchmark) {
+    SimdLevel active = activeSimdLevel();
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if (setSimdLevel(level)) {
+            benchmark->Arg(static_cast<int>(level));
+        }
+    }
+    setSimdLevel(active);
+    benchmark->ArgName("simd");
+}
+
+// Runs the kernels at the level named by the benchmark's argument until the run ends
+class SimdScope {
+public:
+    explicit SimdScope(benchmark::State& state) : previous(activeSimdLevel()) {
+        auto level = static_cast<SimdLevel>(state.range(0));
+        setSimdLevel(level);
+        state.SetLabel(simdLevelName(level));
+    }
+    ~SimdScope() { setSimdLevel(previous); }
+
+private:
+    SimdLevel previous;
+};
+
+void BM_ApplyLut(benchmark::State& state) {
+    SimdScope scope(state);
+    const auto& source = framePixels();
+    std::vector<uint8_t> destination(kFramePixels * 3);
+    Lut lut = makeLut(1.2, 10.0, 0.9);
+    for (auto _ : state) {
+        applyLut(source.data(), destination.data(), destination.size(), lut);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(destination.size()));
+}
+BENCHMARK(BM_ApplyLut)->Apply(simdLevels);
+
+void BM_Blend(benchmark::State& state) {
+    SimdScope scope(state);
+    const auto& source = framePixels();
+    size_t count = kFramePixels * 3;
+    std::vector<uint8_t> destination(count);
+    for (auto _ : state) {
+        blend(source.data(), source.data() + kFramePixels, destination.data(), count, 0.35f);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_Blend)->Apply(simdLevels);
+
+void BM_SwizzleRGB(benchmark::State& state) {
+    SimdScope scope(state);
+    const auto& source = framePixels();
+    std::vector<uint8_t> destination(kFramePixels * 3);
+    for (auto _ : state) {
+        swizzleRGB(source.data(), destination.data(), kFramePixels);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(destination.size()));
+}
+BENCHMARK(BM_SwizzleRGB)->Apply(simdLevels);
+
+void BM_PremultiplyAlpha(benchmark::State& state) {
+    SimdScope scope(state);
+    const auto& source = framePixels();
+    std::vector<uint8_t> destination(source.size());
+    for (auto _ : state) {
+        premultiplyAlpha(source.data(), destination.data(), kFramePixels);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(destination.size()));
+}
+BENCHMARK(BM_PremultiplyAlpha)->Apply(simdLevels);
+
+// One second of 48 kHz audio per channel, processed in place
+void BM_ApplyGainRamp(benchmark::State& state) {
+    SimdScope scope(state);
+    std::vector<float> samples(48000, 0.5f);
+    for (auto _ : state) {
+        applyGainRamp(samples.data(), samples.size(), 1.0f, 0.0f);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(samples.size() * sizeof(float)));
+}
+BENCHMARK(BM_ApplyGainRamp)->Apply(simdLevels);
+
+} // namespace
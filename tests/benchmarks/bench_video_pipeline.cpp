@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+#include "benchmark_fixtures.h"
+#include "../../apps/video-edit/src/video_pipeline.h"
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+using namespace xeno::video;
+
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+constexpr int kFrameRate = 30;
+constexpr int kFrameCount = 20 * kFrameRate;
+
+// Encodes moving gradients with FFmpeg's built-in MPEG-4 encoder, which every FFmpeg build has
+bool writeClip(const std::string& path) {
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    AVFormatContext* format = nullptr;
+    if (!codec || avformat_alloc_output_context2(&format, nullptr, "mp4", path.c_str()) < 0) {
+        return false;
+    }
+    AVCodecContext* context = avcodec_alloc_context3(codec);
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* packet = av_packet_alloc();
+    AVStream* stream = avformat_new_stream(format, nullptr);
+    
+    context->width = kWidth;
+    context->height = kHeight;
+    context->pix_fmt = AV_PIX_FMT_YUV420P;
+    context->time_base = AVRational{1, kFrameRate};
+    context->framerate = AVRational{kFrameRate, 1};
+    context->bit_rate = 12'000'000;
+    context->gop_size = kFrameRate;
+    if (format->oformat->flags & AVFMT_GLOBALHEADER) {
+        context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    frame->format = context->pix_fmt;
+    frame->width = kWidth;
+    frame->height = kHeight;
+    
+    bool ok = stream && avcodec_open2(context, codec, nullptr) >= 0 &&
+              avcodec_parameters_from_context(stream->codecpar, context) >= 0 &&
+              av_frame_get_buffer(frame, 0) >= 0 && avio_open(&format->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0;
+    if (ok) {
+        stream->time_base = context->time_base;
+        ok = avformat_write_header(format, nullptr) >= 0;
+    }
+    
+    auto drain = [&]() {
+        while (ok && avcodec_receive_packet(context, packet) >= 0) {
+            av_packet_rescale_ts(packet, context->time_base, stream->time_base);
+            packet->stream_index = stream->index;
+            ok = av_interleaved_write_frame(format, packet) >= 0;
+        }
+    };
+    for (int i = 0; ok && i < kFrameCount; i++) {
+        ok = av_frame_make_writable(frame) >= 0;
+        for (int y = 0; ok && y < kHeight; y++) {
+            uint8_t* luma = frame->data[0] + y * frame->linesize[0];
+            for (int x = 0; x < kWidth; x++) {
+                luma[x] = static_cast<uint8_t>(x + y + i * 3);
+            }
+        }
+        for (int y = 0; ok && y < kHeight / 2; y++) {
+            uint8_t* u = frame->data[1] + y * frame->linesize[1];
+            uint8_t* v = frame->data[2] + y * frame->linesize[2];
+            for (int x = 0; x < kWidth / 2; x++) {
+                u[x] = static_cast<uint8_t>(128 + y + i * 2);
+                v[x] = static_cast<uint8_t>(64 + x + i * 5);
+            }
+        }
+        frame->pts = i;
+        ok = ok && avcodec_send_frame(context, frame) >= 0;
+        drain();
+    }
+    if (ok) {
+        avcodec_send_frame(context, nullptr);
+        drain();
+        ok = ok && av_write_trailer(format) >= 0;
+    }
+    
+    if (format->pb) {
+        avio_closep(&format->pb);
+    }
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+    avformat_free_context(format);
+    return ok;
+}
+
+// Twenty seconds of 1080p30
+const std::string& clipFixture() {
+    static const std::string path = xeno::benchmarks::fixture("clip-1080p30-20s.mp4", writeClip);
+    return path;
+}
+
+// Argument 0 runs in software, so runs compare across machines; 1 lets the pipeline pick a device
+void BM_VideoTranscode(benchmark::State& state) {
+    const std::string& input = clipFixture();
+    if (input.empty()) {
+        state.SkipWithError("Could not create the clip fixture");
+        return;
+    }
+    VideoPipeline::Options options;
+    options.hardware_decode = state.range(0) != 0;
+    options.hardware_encode = state.range(0) != 0;
+    VideoPipeline pipeline(options);
+    std::string output = xeno::benchmarks::outputPath("transcoded.mp4");
+    
+    int64_t frames = 0;
+    for (auto _ : state) {
+        auto result = pipeline.transcode(input, output);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            return;
+        }
+        frames += result.frames;
+        state.SetLabel(result.decoder + " -> " + result.encoder);
+    }
+    state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_VideoTranscode)->ArgName("hardware")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Scaling to 720p moves the cost into the processing stage
+void BM_VideoTranscodeScaled(benchmark::State& state) {
+    const std::string& input = clipFixture();
+    if (input.empty()) {
+        state.SkipWithError("Could not create the clip fixture");
+        return;
+    }
+    VideoPipeline::Options options;
+    options.hardware_decode = false;
+    options.hardware_encode = false;
+    options.max_height = 720;
+    VideoPipeline pipeline(options);
+    std::string output = xeno::benchmarks::outputPath("transcoded-720p.mp4");
+    
+    int64_t frames = 0;
+    for (auto _ : state) {
+        auto result = pipeline.transcode(input, output);
+        if (!result.success) {
+            state.SkipWithError(result.error_message.c_str());
+            return;
+        }
+        frames += result.frames;
+    }
+    state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_VideoTranscodeScaled)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../shared/utils/include/utils.h"
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace xeno::benchmarks {
+
+// Large inputs are generated on first use and kept between runs, in
+// $XENO_BENCHMARK_FIXTURES or a folder under the temp directory
+inline std::string fixtureDirectory() {
+    std::string directory;
+    if (const char* configured = std::getenv("XENO_BENCHMARK_FIXTURES"); configured && *configured) {
+        directory = configured;
+    } else {
+        directory = (std::filesystem::path(utils::Platform::getTempPath()) / "xeno-benchmarks").string();
+    }
+    utils::Platform::createDirectory(directory);
+    return directory;
+}
+
+// Path of fixture name, written by generate when it is missing. generate writes to the path it is
+// given, which is renamed into place only once it returns true, so an interrupted run never leaves
+// a truncated fixture behind. Empty if generating failed.
+inline std::string fixture(const std::string& name, const std::function<bool(const std::string& path)>& generate) {
+    std::filesystem::path directory = fixtureDirectory();
+    std::filesystem::path path = directory / name;
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        return path.string();
+    }
+    
+    // The name keeps its extension, since writers pick the format from it
+    std::filesystem::path partial = directory / ("partial-" + name);
+    if (!generate(partial.string())) {
+        std::filesystem::remove(partial, error);
+        return {};
+    }
+    std::filesystem::rename(partial, path, error);
+    return error ? std::string() : path.string();
+}
+
+// Scratch path for a benchmark's output, overwritten on every run
+inline std::string outputPath(const std::string& name) {
+    std::filesystem::path directory = std::filesystem::path(fixtureDirectory()) / "output";
+    utils::Platform::createDirectory(directory.string());
+    return (directory / name).string();
+}
+
+} // namespace xeno::benchmarks